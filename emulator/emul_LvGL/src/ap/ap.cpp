@@ -12,6 +12,10 @@
 #include "lvgl.h"
 #include "lvgl/porting/lv_port_disp.h"
 #include "lvgl/porting/lv_port_indev.h"
+#include "lvgl/porting/lv_port_fs.h"
+#include "lvgl/porting/lv_port_img.h"
+#include "lvgl/porting/lv_port_mem.h"
+#include "lv_bench.h"
 
 
 
@@ -103,8 +107,12 @@ static void threadEmul(void const *argument)
 
 
   lv_init();
+  lv_port_mem_init();
   lv_port_disp_init();
   lv_port_indev_init();
+  lv_port_fs_init();
+  lv_port_img_init();
+  lv_bench_init();
 
   lv_obj_t * btn = lv_btn_create(lv_scr_act(), NULL);     /*Add a button the current screen*/
   lv_obj_set_pos(btn, 10, 10);                            /*Set its position*/
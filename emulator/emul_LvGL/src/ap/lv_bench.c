@@ -0,0 +1,679 @@
+/*
+ * lv_bench.c
+ *
+ *  Rendering benchmark: fixed LittlevGL scenes drawn into an offscreen
+ *  320x240 RGB565 frame, timed per scene and per object type.
+ *
+ *  Every scene is rendered LV_BENCH_FRAMES times with the whole screen
+ *  invalidated. The time of each object type is taken by wrapping the
+ *  design callbacks of the scene's objects. The final frame of every
+ *  scene is checked against a golden FNV-1a checksum taken from a CPU
+ *  rendering, so GPU runs are expected to differ where they blend.
+ *
+ *  Define LV_BENCH_HOST to build it on a PC: time is taken with
+ *  clock_gettime() and the GPU can't be used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lv_bench.h"
+
+#ifdef LV_BENCH_HOST
+#include <time.h>
+#else
+#include "hw.h"
+#include "lvgl/porting/lv_port_disp.h"
+#endif
+
+
+#define BENCH_VDB_LINES     40
+#define BENCH_TYPE_MAX      16
+#define BENCH_OBJ_MAX       160
+#define BENCH_IMG_SIZE      64
+
+
+typedef struct
+{
+  const char     *name;
+  lv_design_cb_t  design;
+  uint32_t        objs;
+  uint32_t        calls;
+  uint64_t        count;
+} bench_type_t;
+
+typedef struct
+{
+  lv_obj_t     *obj;
+  bench_type_t *type;
+} bench_obj_t;
+
+typedef struct
+{
+  const char *name;
+  void (*create)(lv_obj_t *scr);
+  void (*frame)(int frame);
+} bench_scene_t;
+
+
+static void sceneRect(lv_obj_t *scr);
+static void sceneGrad(lv_obj_t *scr);
+static void sceneArc(lv_obj_t *scr);
+static void sceneLabel(lv_obj_t *scr);
+static void sceneImage(lv_obj_t *scr);
+static void scenePage(lv_obj_t *scr);
+static void scenePageFrame(int frame);
+
+static const bench_scene_t bench_scenes[] =
+{
+  {"rect",   sceneRect,  NULL},
+  {"grad",   sceneGrad,  NULL},
+  {"arc",    sceneArc,   NULL},
+  {"label",  sceneLabel, NULL},
+  {"image",  sceneImage, NULL},
+  {"scroll", scenePage,  scenePageFrame},
+};
+
+#define BENCH_SCENE_CNT     (sizeof(bench_scenes)/sizeof(bench_scenes[0]))
+
+// Checksums of the final frames rendered by the CPU, [aa][scene].
+// test/lv_bench_test.c checks them on a PC and prints a new table.
+static const uint32_t bench_golden[2][BENCH_SCENE_CNT] =
+{
+  {0x723C8BBB, 0x18A14E8D, 0x395CC0E2, 0x8356D2F5, 0x2FEBF303, 0x1018F0A4},
+  {0x0DEA5CEA, 0x180E3434, 0x912E9066, 0x8356D2F5, 0x2FEBF303, 0x73883DC6},
+};
+
+
+static lv_disp_t    *bench_disp = NULL;
+static lv_obj_t     *bench_idle_scr;
+static lv_color_t   *bench_vdb;
+static lv_color_t   *bench_fb;
+static lv_color_t   *bench_img_px;
+static uint8_t      *bench_img_alpha_px;
+static lv_img_dsc_t  bench_img;
+static lv_img_dsc_t  bench_img_alpha;
+static lv_obj_t     *bench_page;
+
+static bench_type_t  bench_types[BENCH_TYPE_MAX];
+static uint32_t      bench_type_cnt;
+static bench_obj_t   bench_objs[BENCH_OBJ_MAX];
+static uint32_t      bench_obj_cnt;
+
+static uint32_t      bench_flush_bytes;
+static uint32_t      bench_gpu_bytes;
+
+#if LV_USE_GPU && !defined(LV_BENCH_HOST)
+static void (*bench_port_blend)(lv_disp_drv_t *disp_drv, lv_color_t *dest, const lv_color_t *src, uint32_t length, lv_opa_t opa);
+static void (*bench_port_fill)(lv_disp_drv_t *disp_drv, lv_color_t *dest_buf, lv_coord_t dest_width, const lv_area_t *fill_area, lv_color_t color);
+#endif
+
+#ifndef LV_BENCH_HOST
+static volatile bool bench_request = false;
+static bool          bench_req_gpu;
+static bool          bench_req_aa;
+
+static void benchCmdif(void);
+#endif
+
+
+
+#ifdef LV_BENCH_HOST
+
+static inline uint32_t benchCounter(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static uint32_t benchCountsPerUs(void)
+{
+  return 1000;
+}
+
+static void benchStartCounter(void)
+{
+}
+
+#else
+
+static inline uint32_t benchCounter(void)
+{
+  return DWT->CYCCNT;
+}
+
+static uint32_t benchCountsPerUs(void)
+{
+  return SystemCoreClock / 1000000;
+}
+
+static void benchStartCounter(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->LAR = 0xC5ACCE55;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#endif
+
+
+
+static void benchFlush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
+{
+  lv_coord_t w = lv_area_get_width(area);
+  lv_coord_t y;
+
+  for (y=area->y1; y<=area->y2; y++)
+  {
+    memcpy(&bench_fb[y * LV_BENCH_HOR_RES + area->x1], color_p, w * sizeof(lv_color_t));
+    color_p += w;
+  }
+  bench_flush_bytes += lv_area_get_size(area) * sizeof(lv_color_t);
+
+  lv_disp_flush_ready(disp_drv);
+}
+
+#if LV_USE_GPU && !defined(LV_BENCH_HOST)
+static void benchGpuBlend(lv_disp_drv_t *disp_drv, lv_color_t *dest, const lv_color_t *src, uint32_t length, lv_opa_t opa)
+{
+  // src and dest read, dest written
+  bench_gpu_bytes += length * 3 * sizeof(lv_color_t);
+  bench_port_blend(disp_drv, dest, src, length, opa);
+}
+
+static void benchGpuFill(lv_disp_drv_t *disp_drv, lv_color_t *dest_buf, lv_coord_t dest_width, const lv_area_t *fill_area, lv_color_t color)
+{
+  bench_gpu_bytes += lv_area_get_size(fill_area) * sizeof(lv_color_t);
+  bench_port_fill(disp_drv, dest_buf, dest_width, fill_area, color);
+}
+#endif
+
+static bool benchDisplayInit(void)
+{
+  static lv_disp_buf_t disp_buf;
+  lv_disp_drv_t disp_drv;
+  uint32_t i, x, y;
+
+  if (bench_disp != NULL)
+  {
+    return true;
+  }
+
+  bench_vdb          = malloc(LV_BENCH_HOR_RES * BENCH_VDB_LINES * sizeof(lv_color_t));
+  bench_fb           = malloc(LV_BENCH_HOR_RES * LV_BENCH_VER_RES * sizeof(lv_color_t));
+  bench_img_px       = malloc(BENCH_IMG_SIZE * BENCH_IMG_SIZE * sizeof(lv_color_t));
+  bench_img_alpha_px = malloc(BENCH_IMG_SIZE * BENCH_IMG_SIZE * LV_IMG_PX_SIZE_ALPHA_BYTE);
+  if (bench_vdb == NULL || bench_fb == NULL || bench_img_px == NULL || bench_img_alpha_px == NULL)
+  {
+    free(bench_vdb);
+    free(bench_fb);
+    free(bench_img_px);
+    free(bench_img_alpha_px);
+    return false;
+  }
+
+  // Test images: a color ramp and the same ramp with a radial alpha
+  for (y=0; y<BENCH_IMG_SIZE; y++)
+  {
+    for (x=0; x<BENCH_IMG_SIZE; x++)
+    {
+      int32_t dx = (int32_t)x - BENCH_IMG_SIZE/2;
+      int32_t dy = (int32_t)y - BENCH_IMG_SIZE/2;
+      int32_t a  = 255 - (dx*dx + dy*dy) * 255 / (BENCH_IMG_SIZE*BENCH_IMG_SIZE/4);
+      lv_color_t c = LV_COLOR_MAKE(x*4, y*4, (x+y)*2);
+
+      i = y * BENCH_IMG_SIZE + x;
+      bench_img_px[i] = c;
+      bench_img_alpha_px[i*3 + 0] = c.full & 0xFF;
+      bench_img_alpha_px[i*3 + 1] = c.full >> 8;
+      bench_img_alpha_px[i*3 + 2] = a < 0 ? 0 : a;
+    }
+  }
+
+  memset(&bench_img, 0, sizeof(bench_img));
+  bench_img.header.cf = LV_IMG_CF_TRUE_COLOR;
+  bench_img.header.w  = BENCH_IMG_SIZE;
+  bench_img.header.h  = BENCH_IMG_SIZE;
+  bench_img.data_size = BENCH_IMG_SIZE * BENCH_IMG_SIZE * sizeof(lv_color_t);
+  bench_img.data      = (const uint8_t *)bench_img_px;
+
+  bench_img_alpha           = bench_img;
+  bench_img_alpha.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+  bench_img_alpha.data_size = BENCH_IMG_SIZE * BENCH_IMG_SIZE * LV_IMG_PX_SIZE_ALPHA_BYTE;
+  bench_img_alpha.data      = bench_img_alpha_px;
+
+  lv_disp_buf_init(&disp_buf, bench_vdb, NULL, LV_BENCH_HOR_RES * BENCH_VDB_LINES);
+
+  lv_disp_drv_init(&disp_drv);
+  disp_drv.hor_res  = LV_BENCH_HOR_RES;
+  disp_drv.ver_res  = LV_BENCH_VER_RES;
+  disp_drv.flush_cb = benchFlush;
+  disp_drv.buffer   = &disp_buf;
+
+  bench_disp = lv_disp_drv_register(&disp_drv);
+  if (bench_disp == NULL)
+  {
+    return false;
+  }
+
+  bench_idle_scr = lv_disp_get_scr_act(bench_disp);
+
+  // Only refreshed by lv_refr_now()
+  lv_task_set_prio(bench_disp->refr_task, LV_TASK_PRIO_OFF);
+
+  return true;
+}
+
+static void benchSetDriver(bool gpu, bool aa)
+{
+  lv_disp_drv_t *drv = &bench_disp->driver;
+
+#if LV_ANTIALIAS
+  drv->antialiasing = aa ? 1 : 0;
+#else
+  (void)aa;
+#endif
+
+#if LV_USE_GPU
+  drv->gpu_blend_cb = NULL;
+  drv->gpu_fill_cb  = NULL;
+#ifndef LV_BENCH_HOST
+  if (gpu == true)
+  {
+    lv_port_disp_set_gpu(drv, true);
+    bench_port_blend  = drv->gpu_blend_cb;
+    bench_port_fill   = drv->gpu_fill_cb;
+    drv->gpu_blend_cb = benchGpuBlend;
+    drv->gpu_fill_cb  = benchGpuFill;
+  }
+#endif
+#endif
+  (void)gpu;
+}
+
+
+
+static bench_obj_t *benchFindObj(const lv_obj_t *obj)
+{
+  uint32_t i;
+
+  for (i=0; i<bench_obj_cnt; i++)
+  {
+    if (bench_objs[i].obj == obj)
+    {
+      return &bench_objs[i];
+    }
+  }
+  return NULL;
+}
+
+static bool benchDesign(lv_obj_t *obj, const lv_area_t *mask_p, lv_design_mode_t mode)
+{
+  bench_obj_t *p_obj = benchFindObj(obj);
+  bench_type_t *p_type = p_obj->type;
+  uint32_t start;
+  bool ret;
+
+  if (mode == LV_DESIGN_COVER_CHK)
+  {
+    return p_type->design(obj, mask_p, mode);
+  }
+
+  start = benchCounter();
+  ret = p_type->design(obj, mask_p, mode);
+  p_type->count += benchCounter() - start;
+  p_type->calls++;
+
+  return ret;
+}
+
+// Wrap the design callback of obj and all its children
+static void benchHookObj(lv_obj_t *obj)
+{
+  lv_obj_type_t types;
+  lv_design_cb_t design = lv_obj_get_design_cb(obj);
+  bench_type_t *p_type = NULL;
+  lv_obj_t *child;
+  uint32_t i;
+
+  lv_obj_get_type(obj, &types);
+
+  for (i=0; i<bench_type_cnt; i++)
+  {
+    if (bench_types[i].design == design && strcmp(bench_types[i].name, types.type[0]) == 0)
+    {
+      p_type = &bench_types[i];
+      break;
+    }
+  }
+  if (p_type == NULL && bench_type_cnt < BENCH_TYPE_MAX)
+  {
+    p_type = &bench_types[bench_type_cnt++];
+    memset(p_type, 0, sizeof(bench_type_t));
+    p_type->name   = types.type[0][0] != 0 ? types.type[0] : "?";
+    p_type->design = design;
+  }
+
+  if (p_type != NULL && bench_obj_cnt < BENCH_OBJ_MAX)
+  {
+    bench_objs[bench_obj_cnt].obj  = obj;
+    bench_objs[bench_obj_cnt].type = p_type;
+    bench_obj_cnt++;
+    p_type->objs++;
+
+    lv_obj_set_design_cb(obj, benchDesign);
+  }
+
+  child = lv_obj_get_child(obj, NULL);
+  while (child != NULL)
+  {
+    benchHookObj(child);
+    child = lv_obj_get_child(obj, child);
+  }
+}
+
+static uint32_t benchChecksum(void)
+{
+  const uint8_t *p = (const uint8_t *)bench_fb;
+  uint32_t hash = 2166136261UL;
+  uint32_t i;
+
+  for (i=0; i<LV_BENCH_HOR_RES * LV_BENCH_VER_RES * sizeof(lv_color_t); i++)
+  {
+    hash = (hash ^ p[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+
+
+int lv_bench_run(lv_bench_print_t out, bool gpu, bool aa)
+{
+  lv_disp_t *disp_def = lv_disp_get_default();
+  uint32_t per_us;
+  uint32_t i, t;
+  uint32_t start;
+  uint32_t checksum;
+  uint64_t scene_count;
+  uint64_t scene_bytes;
+  uint64_t scene_gpu_bytes;
+  int frame;
+  int fails = 0;
+  lv_obj_t *scr;
+
+  if (benchDisplayInit() == false)
+  {
+    out("no memory for the offscreen frame\n");
+    return BENCH_SCENE_CNT;
+  }
+  benchStartCounter();
+  benchSetDriver(gpu, aa);
+  per_us = benchCountsPerUs();
+
+  out("%-8s %10s %10s %10s %10s %s\n", "scene", "us/frame", "flush B/f", "gpu B/f", "checksum", "golden");
+
+  for (i=0; i<BENCH_SCENE_CNT; i++)
+  {
+    bench_type_cnt  = 0;
+    bench_obj_cnt   = 0;
+    scene_count     = 0;
+    scene_bytes     = 0;
+    scene_gpu_bytes = 0;
+
+    lv_disp_set_default(bench_disp);
+    scr = lv_obj_create(NULL, NULL);
+    lv_obj_set_style(scr, &lv_style_scr);
+    bench_scenes[i].create(scr);
+    lv_disp_load_scr(scr);
+    lv_disp_set_default(disp_def);
+
+    benchHookObj(scr);
+
+    for (frame=0; frame<LV_BENCH_FRAMES; frame++)
+    {
+      if (bench_scenes[i].frame != NULL)
+      {
+        bench_scenes[i].frame(frame);
+      }
+      lv_obj_invalidate(scr);
+
+      bench_flush_bytes = 0;
+      bench_gpu_bytes   = 0;
+
+      start = benchCounter();
+      lv_refr_now(bench_disp);
+      scene_count += benchCounter() - start;
+
+      scene_bytes     += bench_flush_bytes;
+      scene_gpu_bytes += bench_gpu_bytes;
+    }
+
+    checksum = benchChecksum();
+    if (checksum != bench_golden[aa ? 1 : 0][i])
+    {
+      fails++;
+    }
+
+    out("%-8s %10u %10u %10u   %08X %s\n",
+        bench_scenes[i].name,
+        (unsigned int)(scene_count / LV_BENCH_FRAMES / per_us),
+        (unsigned int)(scene_bytes / LV_BENCH_FRAMES),
+        (unsigned int)(scene_gpu_bytes / LV_BENCH_FRAMES),
+        (unsigned int)checksum,
+        checksum == bench_golden[aa ? 1 : 0][i] ? "ok" : "DIFF");
+
+    for (t=0; t<bench_type_cnt; t++)
+    {
+      out("  %-14s %4u objs %6u calls %8u us/frame\n",
+          bench_types[t].name,
+          (unsigned int)bench_types[t].objs,
+          (unsigned int)(bench_types[t].calls / LV_BENCH_FRAMES),
+          (unsigned int)(bench_types[t].count / LV_BENCH_FRAMES / per_us));
+    }
+
+    // Switch to an empty screen before the scene goes away
+    lv_disp_load_scr(bench_idle_scr);
+    lv_obj_del(scr);
+  }
+
+  return fails;
+}
+
+
+
+static void sceneRect(lv_obj_t *scr)
+{
+  static lv_style_t style[4];
+  lv_obj_t *obj;
+  int i;
+
+  for (i=0; i<4; i++)
+  {
+    lv_style_copy(&style[i], &lv_style_plain);
+    style[i].body.main_color = LV_COLOR_MAKE(60*i, (255-60*i), 40);
+    style[i].body.grad_color = style[i].body.main_color;
+    style[i].body.radius     = i == 3 ? 6 : 0;
+  }
+
+  for (i=0; i<24; i++)
+  {
+    obj = lv_obj_create(scr, NULL);
+    lv_obj_set_style(obj, &style[i % 4]);
+    lv_obj_set_size(obj, 70, 50);
+    lv_obj_set_pos(obj, (i % 6) * 50, (i / 6) * 55 + (i % 3) * 4);
+  }
+}
+
+static void sceneGrad(lv_obj_t *scr)
+{
+  static lv_style_t style[3];
+  lv_obj_t *obj;
+  int i;
+
+  for (i=0; i<3; i++)
+  {
+    lv_style_copy(&style[i], &lv_style_pretty_color);
+    style[i].body.radius       = 4 + i * 6;
+    style[i].body.border.width = i;
+    style[i].body.shadow.width = i == 2 ? 6 : 0;
+  }
+
+  for (i=0; i<12; i++)
+  {
+    obj = lv_obj_create(scr, NULL);
+    lv_obj_set_style(obj, &style[i % 3]);
+    lv_obj_set_size(obj, 90, 60);
+    lv_obj_set_pos(obj, (i % 4) * 78 + 4, (i / 4) * 76 + 6);
+  }
+}
+
+static void sceneArc(lv_obj_t *scr)
+{
+  static lv_style_t style;
+  lv_obj_t *obj;
+  int i;
+
+  lv_style_copy(&style, &lv_style_plain);
+  style.line.color   = LV_COLOR_MAKE(0x20, 0x80, 0xE0);
+  style.line.width   = 6;
+  style.line.rounded = 1;
+
+  for (i=0; i<8; i++)
+  {
+    obj = lv_arc_create(scr, NULL);
+    lv_arc_set_style(obj, LV_ARC_STYLE_MAIN, &style);
+    lv_arc_set_angles(obj, i * 30, 180 + i * 20);
+    lv_obj_set_size(obj, 70, 70);
+    lv_obj_set_pos(obj, (i % 4) * 78 + 6, (i / 4) * 110 + 20);
+  }
+}
+
+static void sceneLabel(lv_obj_t *scr)
+{
+  static const char *text =
+      "The quick brown fox jumps over the lazy dog. "
+      "0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+  lv_obj_t *obj;
+  int i;
+
+  for (i=0; i<6; i++)
+  {
+    obj = lv_label_create(scr, NULL);
+    lv_label_set_long_mode(obj, LV_LABEL_LONG_BREAK);
+    lv_obj_set_width(obj, 150);
+    lv_label_set_text(obj, text);
+    lv_obj_set_pos(obj, (i % 2) * 160 + 4, (i / 2) * 80);
+  }
+}
+
+static void sceneImage(lv_obj_t *scr)
+{
+  static lv_style_t style[3];
+  lv_obj_t *obj;
+  int i;
+
+  for (i=0; i<3; i++)
+  {
+    lv_style_copy(&style[i], &lv_style_plain);
+    style[i].image.opa = i == 0 ? LV_OPA_COVER : i == 1 ? LV_OPA_70 : LV_OPA_30;
+  }
+
+  for (i=0; i<12; i++)
+  {
+    obj = lv_img_create(scr, NULL);
+    lv_img_set_src(obj, i < 6 ? &bench_img : &bench_img_alpha);
+    lv_img_set_style(obj, LV_IMG_STYLE_MAIN, &style[i % 3]);
+    lv_obj_set_pos(obj, (i % 6) * 50, (i / 6) * 100 + (i % 2) * 20);
+  }
+}
+
+static void scenePage(lv_obj_t *scr)
+{
+  lv_obj_t *obj;
+  char text[16];
+  int i;
+
+  bench_page = lv_page_create(scr, NULL);
+  lv_obj_set_size(bench_page, LV_BENCH_HOR_RES - 20, LV_BENCH_VER_RES - 20);
+  lv_obj_set_pos(bench_page, 10, 10);
+  lv_page_set_scrl_layout(bench_page, LV_LAYOUT_COL_M);
+
+  for (i=0; i<20; i++)
+  {
+    obj = lv_btn_create(bench_page, NULL);
+    lv_obj_set_size(obj, 200, 40);
+    obj = lv_label_create(obj, NULL);
+    snprintf(text, sizeof(text), "Item %d", i);
+    lv_label_set_text(obj, text);
+  }
+}
+
+static void scenePageFrame(int frame)
+{
+  lv_obj_set_y(lv_page_get_scrl(bench_page), -frame * 12);
+}
+
+
+
+#ifndef LV_BENCH_HOST
+
+static void benchTask(lv_task_t *task)
+{
+  (void)task;
+
+  if (bench_request == true)
+  {
+    lv_bench_run(cmdifPrintf, bench_req_gpu, bench_req_aa);
+    bench_request = false;
+  }
+}
+
+void lv_bench_init(void)
+{
+  lv_task_create(benchTask, 100, LV_TASK_PRIO_LOW, NULL);
+
+  if (cmdifIsInit() == false)
+  {
+    cmdifInit();
+  }
+  cmdifAdd("lvbench", benchCmdif);
+}
+
+static void benchCmdif(void)
+{
+  bool ret = true;
+  uint32_t i;
+
+  if (cmdifGetParamCnt() >= 1 && cmdifHasString("run", 0) == true)
+  {
+    bench_req_gpu = false;
+    bench_req_aa  = true;
+    for (i=1; i<cmdifGetParamCnt(); i++)
+    {
+      if (cmdifHasString("gpu", i) == true)  bench_req_gpu = true;
+      if (cmdifHasString("noaa", i) == true) bench_req_aa  = false;
+    }
+    bench_request = true;
+
+    // The benchmark runs in the LittlevGL thread
+    while (bench_request == true)
+    {
+      delay(10);
+    }
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "lvbench run [gpu] [noaa] \n");
+  }
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * lv_bench.h
+ *
+ *  Rendering benchmark: fixed LittlevGL scenes drawn into an offscreen
+ *  320x240 RGB565 frame, timed per scene and per object type.
+ */
+
+#ifndef SRC_AP_LV_BENCH_H_
+#define SRC_AP_LV_BENCH_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "lvgl/lvgl.h"
+
+
+#define LV_BENCH_HOR_RES      320
+#define LV_BENCH_VER_RES      240
+#define LV_BENCH_FRAMES       20
+
+
+typedef void (*lv_bench_print_t)(const char *fmt, ...);
+
+
+// Register the "lvbench" cmdif command. The benchmark itself runs
+// from an lv_task, so call this from the LittlevGL thread.
+void lv_bench_init(void);
+
+// Render all scenes and print the results. Returns the number of
+// scenes whose final frame differs from the golden checksum.
+// gpu is ignored on a host build.
+int lv_bench_run(lv_bench_print_t out, bool gpu, bool aa);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_AP_LV_BENCH_H_ */
@@ -51,7 +51,11 @@
 
 /* Default display refresh period.
  * Can be changed in the display driver (`lv_disp_drv_t`).*/
-#define LV_DISP_DEF_REFR_PERIOD      30      /*[ms]*/
+#define LV_DISP_DEF_REFR_PERIOD      16      /*[ms]*/
+
+/* 1: With two screen sized buffers copy the refreshed areas to the other buffer after flushing
+ * 0: The display driver keeps the two buffers in sync (lv_port_disp.c does it with DMA2D)*/
+#define LV_DISP_TRUE_DOUBLE_BUF_SYNC 0
 
 /* Dot Per Inch: used to initialize default sizes.
  * E.g. a button with width = LV_DPI / 2 -> half inch wide
@@ -69,7 +73,7 @@ typedef int16_t lv_coord_t;
  * The graphical objects and other related data are stored here. */
 
 /* 1: use custom malloc/free, 0: use the built-in `lv_mem_alloc` and `lv_mem_free` */
-#define LV_MEM_CUSTOM      0
+#define LV_MEM_CUSTOM      1
 #if LV_MEM_CUSTOM == 0
 /* Size of the memory used by `lv_mem_alloc` in bytes (>= 2kB)*/
 #  define LV_MEM_SIZE    (32U * 1024U)
@@ -84,9 +88,9 @@ typedef int16_t lv_coord_t;
 /* Automatically defrag. on free. Defrag. means joining the adjacent free cells. */
 #  define LV_MEM_AUTO_DEFRAG  1
 #else       /*LV_MEM_CUSTOM*/
-#  define LV_MEM_CUSTOM_INCLUDE <stdlib.h>   /*Header for the dynamic memory function*/
-#  define LV_MEM_CUSTOM_ALLOC   malloc       /*Wrapper to malloc*/
-#  define LV_MEM_CUSTOM_FREE    free         /*Wrapper to free*/
+#  define LV_MEM_CUSTOM_INCLUDE "lvgl/porting/lv_port_mem.h"   /*Header for the dynamic memory function*/
+#  define LV_MEM_CUSTOM_ALLOC   lv_port_mem_alloc   /*Size class slabs in SRAM, then SDRAM*/
+#  define LV_MEM_CUSTOM_FREE    lv_port_mem_free
 #endif     /*LV_MEM_CUSTOM*/
 
 /* Garbage Collector settings
@@ -145,7 +149,7 @@ typedef void * lv_group_user_data_t;
 #endif  /*LV_USE_GROUP*/
 
 /* 1: Enable GPU interface*/
-#define LV_USE_GPU              0
+#define LV_USE_GPU              1
 
 /* 1: Enable file system (might be required for images */
 #define LV_USE_FILESYSTEM       1
@@ -172,8 +176,9 @@ typedef void * lv_fs_drv_user_data_t;
  * (I.e. no new image decoder is added)
  * With complex image decoders (e.g. PNG or JPG) caching can save the continuous open/decode of images.
  * However the opened images might consume additional RAM.
- * LV_IMG_CACHE_DEF_SIZE must be >= 1 */
-#define LV_IMG_CACHE_DEF_SIZE       1
+ * LV_IMG_CACHE_DEF_SIZE must be >= 1
+ * The SD card decoder (lv_port_img.c) keeps its pixels in SDRAM, an open image costs only a descriptor here */
+#define LV_IMG_CACHE_DEF_SIZE       8
 
 /*Declare the type of the user data of image decoder (can be e.g. `void *`, `int`, `struct`)*/
 typedef void * lv_img_decoder_user_data_t;
@@ -15,6 +15,14 @@
 /*********************
  *      DEFINES
  *********************/
+#define DMA2D_MODE_M2M          (0UL << DMA2D_CR_MODE_Pos)
+#define DMA2D_MODE_M2M_BLEND    (2UL << DMA2D_CR_MODE_Pos)
+#define DMA2D_MODE_R2M          (3UL << DMA2D_CR_MODE_Pos)
+#define DMA2D_CM_RGB565         (2UL)
+#define DMA2D_AM_REPLACE        (1UL << DMA2D_FGPFCCR_AM_Pos)
+
+/*Shorter runs are blended by the CPU, it is faster than setting up DMA2D*/
+#define GPU_BLEND_MIN_LENGTH    32
 
 /**********************
  *      TYPEDEFS
@@ -26,9 +34,14 @@
 static void disp_init(void);
 
 static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+static void disp_sync_areas(lv_disp_drv_t * disp_drv, const lv_color_t * front);
+static void dma2d_copy(lv_color_t * dest, const lv_color_t * src, lv_coord_t w, lv_coord_t h, lv_coord_t stride);
+static void dma2d_run(lv_color_t * dest, lv_coord_t w, lv_coord_t h, lv_coord_t stride);
+static void dma2d_cache(const lv_color_t * p, lv_coord_t w, lv_coord_t h, lv_coord_t stride, bool clean, bool invalidate);
 #if LV_USE_GPU
-static void gpu_blend(lv_color_t * dest, const lv_color_t * src, uint32_t length, lv_opa_t opa);
-static void gpu_fill(lv_color_t * dest, uint32_t length, lv_color_t color);
+static void gpu_blend(lv_disp_drv_t * disp_drv, lv_color_t * dest, const lv_color_t * src, uint32_t length, lv_opa_t opa);
+static void gpu_fill(lv_disp_drv_t * disp_drv, lv_color_t * dest_buf, lv_coord_t dest_width,
+                     const lv_area_t * fill_area, lv_color_t color);
 #endif
 
 /**********************
@@ -124,16 +137,27 @@ void lv_port_disp_init(void)
     /*Optionally add functions to access the GPU. (Only in buffered mode, LV_VDB_SIZE != 0)*/
 
     /*Blend two color array using opacity*/
-    disp_drv.gpu_blend = gpu_blend;
+    disp_drv.gpu_blend_cb = gpu_blend;
 
     /*Fill a memory array with a color*/
-    disp_drv.gpu_fill = gpu_fill;
+    disp_drv.gpu_fill_cb = gpu_fill;
 #endif
 
     /*Finally register the driver*/
     lv_disp_drv_register(&disp_drv);
 }
 
+void lv_port_disp_set_gpu(lv_disp_drv_t * disp_drv, bool en)
+{
+#if LV_USE_GPU
+    disp_drv->gpu_blend_cb = en ? gpu_blend : NULL;
+    disp_drv->gpu_fill_cb = en ? gpu_fill : NULL;
+#else
+    (void) disp_drv;
+    (void) en;
+#endif
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -149,68 +173,147 @@ static void disp_init(void)
  * 'lv_disp_flush_ready()' has to be called when finished. */
 static void disp_flush(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
 {
-    /*The most simple case (but also the slowest) to put all pixels to the screen one-by-one*/
-#if 0
-    uint16_t *p_buf = lcdGetCurrentFrameBuffer();
-
-    int32_t x;
-    int32_t y;
-    int32_t offset;
-    for(y = area->y1; y <= area->y2; y++) {
-        offset = y*lcdGetWidth();
-        for(x = area->x1; x <= area->x2; x++) {
-            /* Put a pixel to the display. For example: */
-            /* put_px(x, y, *color_p)*/
-            p_buf[offset + x] = color_p->full;
-            color_p++;
-        }
-    }
-#else
+    (void) area;    /*Always the whole screen with two screen sized buffers*/
 
+    /*'color_p' is the LTDC back buffer: show it from the next line event on*/
     lcdRequestDraw();
 
+    while(lcdDrawAvailable() != true) {
+        delay(1);
+    }
 
-    while(!lcdDrawAvailable());
-
-    //disp_drv->buffer->buf1 = lcdGetFrameBuffer();
-    //disp_drv->buffer->buf_act = lcdGetFrameBuffer();
+    /*The buffer drawn next is a frame behind, bring the refreshed areas over*/
+    disp_sync_areas(disp_drv, color_p);
 
-#endif
     /* IMPORTANT!!!
      * Inform the graphics library that you are ready with the flushing*/
     lv_disp_flush_ready(disp_drv);
 }
 
+/* Copy the areas refreshed in this frame from the buffer just put on the screen
+ * to the new back buffer, so only the next frame's invalid areas have to be redrawn.
+ * LV_DISP_TRUE_DOUBLE_BUF_SYNC is 0, so LittlevGL leaves this to the driver. */
+static void disp_sync_areas(lv_disp_drv_t * disp_drv, const lv_color_t * front)
+{
+    lv_disp_t * disp    = lv_refr_get_disp_refreshing();
+    lv_disp_buf_t * vdb = disp_drv->buffer;
+    lv_color_t * back   = front == vdb->buf1 ? vdb->buf2 : vdb->buf1;
+    lv_coord_t hres     = disp_drv->hor_res;
+    const lv_area_t * a;
+    uint32_t offset;
+    uint16_t i;
+
+    for(i = 0; i < disp->inv_p; i++) {
+        if(disp->inv_area_joined[i]) continue;
+
+        a      = &disp->inv_areas[i];
+        offset = hres * a->y1 + a->x1;
+        dma2d_copy(back + offset, front + offset, lv_area_get_width(a), lv_area_get_height(a), hres);
+    }
+}
+
+/* Copy a 'w' x 'h' rectangle between two buffers that are 'stride' pixels wide */
+static void dma2d_copy(lv_color_t * dest, const lv_color_t * src, lv_coord_t w, lv_coord_t h, lv_coord_t stride)
+{
+    dma2d_cache(src, w, h, stride, true, false);
+
+    DMA2D->CR      = DMA2D_MODE_M2M;
+    DMA2D->FGMAR   = (uint32_t)src;
+    DMA2D->FGOR    = stride - w;
+    DMA2D->FGPFCCR = DMA2D_CM_RGB565;
+    DMA2D->OMAR    = (uint32_t)dest;
+    DMA2D->OOR     = stride - w;
+    DMA2D->OPFCCR  = DMA2D_CM_RGB565;
+    DMA2D->NLR     = ((uint32_t)w << 16) | (uint32_t)h;
+
+    dma2d_run(dest, w, h, stride);
+}
+
+/* Start the configured transfer writing the 'w' x 'h' rectangle at 'dest' and wait until it is done.
+ * The frame buffers (SDRAM_ADDR_IMAGE) are cached write-through and other buffers, e.g. a
+ * malloc'd VDB, write-back: dirty lines of 'dest' are written back first so they can't be
+ * evicted over the result, and the lines are dropped afterwards so the CPU reads the result.*/
+static void dma2d_run(lv_color_t * dest, lv_coord_t w, lv_coord_t h, lv_coord_t stride)
+{
+    dma2d_cache(dest, w, h, stride, true, true);
+
+    DMA2D->CR |= DMA2D_CR_START;
+
+    while(DMA2D->CR & DMA2D_CR_START) {
+    }
+
+    dma2d_cache(dest, w, h, stride, false, true);
+}
+
+/* Clean and/or invalidate the D-cache lines of a 'w' x 'h' rectangle, 'stride' pixels per line */
+static void dma2d_cache(const lv_color_t * p, lv_coord_t w, lv_coord_t h, lv_coord_t stride, bool clean, bool invalidate)
+{
+    uint32_t addr = (uint32_t)p & ~31UL;
+    int32_t size  = (int32_t)((uint32_t)(p + (uint32_t)(h - 1) * stride + w) - addr);
+
+    if(clean && invalidate) SCB_CleanInvalidateDCache_by_Addr((uint32_t *)addr, size);
+    else if(clean) SCB_CleanDCache_by_Addr((uint32_t *)addr, size);
+    else SCB_InvalidateDCache_by_Addr((uint32_t *)addr, size);
+}
+
 
 /*OPTIONAL: GPU INTERFACE*/
 #if LV_USE_GPU
 
-/* If your MCU has hardware accelerator (GPU) then you can use it to blend to memories using opacity
- * It can be used only in buffered mode (LV_VDB_SIZE != 0 in lv_conf.h)*/
+/* Blend 'length' pixels of 'src' over 'dest' with DMA2D.
+ * 'src' may be in cached SRAM (e.g. LittlevGL's fill line), so clean it first.
+ * 'dest' is kept coherent by `dma2d_run`.*/
 static void gpu_blend(lv_disp_drv_t * disp_drv, lv_color_t * dest, const lv_color_t * src, uint32_t length, lv_opa_t opa)
 {
-    /*It's an example code which should be done by your GPU*/
+    (void) disp_drv;    /*Unused*/
+
     uint32_t i;
-    for(i = 0; i < length; i++) {
-        dest[i] = lv_color_mix(dest[i], src[i], opa);
+
+    if(length < GPU_BLEND_MIN_LENGTH) {
+        for(i = 0; i < length; i++) {
+            dest[i] = opa >= LV_OPA_MAX ? src[i] : lv_color_mix(src[i], dest[i], opa);
+        }
+        return;
+    }
+
+    if(opa >= LV_OPA_MAX) {
+        dma2d_copy(dest, src, length, 1, length);
+        return;
     }
+
+    DMA2D->CR      = DMA2D_MODE_M2M_BLEND;
+    DMA2D->FGMAR   = (uint32_t)src;
+    DMA2D->FGOR    = 0;
+    DMA2D->FGPFCCR = ((uint32_t)opa << DMA2D_FGPFCCR_ALPHA_Pos) | DMA2D_AM_REPLACE | DMA2D_CM_RGB565;
+    DMA2D->BGMAR   = (uint32_t)dest;
+    DMA2D->BGOR    = 0;
+    DMA2D->BGPFCCR = DMA2D_CM_RGB565;
+    DMA2D->OMAR    = (uint32_t)dest;
+    DMA2D->OOR     = 0;
+    DMA2D->OPFCCR  = DMA2D_CM_RGB565;
+    DMA2D->NLR     = (length << 16) | 1;
+
+    dma2d_cache(src, length, 1, length, true, false);
+    dma2d_run(dest, length, 1, length);
 }
 
-/* If your MCU has hardware accelerator (GPU) then you can use it to fill a memory with a color
- * It can be used only in buffered mode (LV_VDB_SIZE != 0 in lv_conf.h)*/
-static void gpu_fill_cb(lv_disp_drv_t * disp_drv, lv_color_t * dest_buf, lv_coord_t dest_width,
-                    const lv_area_t * fill_area, lv_color_t color);
+/* Fill 'fill_area' of 'dest_buf' (inclusive coordinates, 'dest_width' pixels per line)
+ * with 'color' using DMA2D register-to-memory mode.*/
+static void gpu_fill(lv_disp_drv_t * disp_drv, lv_color_t * dest_buf, lv_coord_t dest_width,
+                     const lv_area_t * fill_area, lv_color_t color)
 {
-    /*It's an example code which should be done by your GPU*/
-    uint32_t x, y;
-    dest_buf += dest_width * fill_area->y1; /*Go to the first line*/
+    (void) disp_drv;    /*Unused*/
 
-    for(y = fill_area->y1; y < fill_area->y2; y++) {
-        for(x = fill_area->x1; x < fill_area->x2; x++) {
-            dest_buf[x] = color;
-        }
-        dest_buf+=dest_width;    /*Go to the next line*/
-    }
+    lv_coord_t w = lv_area_get_width(fill_area);
+
+    DMA2D->CR      = DMA2D_MODE_R2M;
+    DMA2D->OCOLR   = color.full;
+    DMA2D->OMAR    = (uint32_t)(dest_buf + dest_width * fill_area->y1 + fill_area->x1);
+    DMA2D->OOR     = dest_width - w;
+    DMA2D->OPFCCR  = DMA2D_CM_RGB565;
+    DMA2D->NLR     = ((uint32_t)w << 16) | (uint32_t)lv_area_get_height(fill_area);
+
+    dma2d_run(dest_buf + dest_width * fill_area->y1 + fill_area->x1, w, lv_area_get_height(fill_area), dest_width);
 }
 
 #endif  /*LV_USE_GPU*/
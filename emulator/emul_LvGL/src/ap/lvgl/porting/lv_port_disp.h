@@ -31,6 +31,13 @@ extern "C" {
  **********************/
 void lv_port_disp_init(void);
 
+/**
+ * Attach or detach the DMA2D fill and blend callbacks of a display driver
+ * @param disp_drv pointer to a display driver (also one not registered by `lv_port_disp_init`)
+ * @param en true: draw with DMA2D; false: draw with the CPU
+ */
+void lv_port_disp_set_gpu(lv_disp_drv_t * disp_drv, bool en);
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,567 @@
+/**
+ * @file lv_port_fs.c
+ *
+ */
+
+#if 1
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_fs.h"
+#include "hw.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FS_SECTOR_SIZE          512
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* A file of the SD card. It is allocated from the SDRAM heap because
+ * the read-ahead buffer would not fit into LittlevGL's own memory.
+ * `pos` is the logical read/write position; the FatFs file pointer
+ * is only moved to it when the card is really accessed.*/
+typedef struct {
+    FIL fil;
+    uint32_t pos;           /*Logical read/write position*/
+    uint32_t buf_pos;       /*File offset of `buf[0]`*/
+    uint32_t buf_len;       /*Valid bytes in `buf`, 0: empty*/
+    uint8_t buf[LV_PORT_FS_READ_AHEAD];
+} fs_file_t;
+
+typedef fs_file_t * file_t;
+
+typedef DIR dir_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void fs_init(void);
+
+static bool fs_ready(lv_fs_drv_t * drv);
+static lv_fs_res_t fs_open (lv_fs_drv_t * drv, void * file_p, const char * path, lv_fs_mode_t mode);
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos);
+static lv_fs_res_t fs_size (lv_fs_drv_t * drv, void * file_p, uint32_t * size_p);
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static lv_fs_res_t fs_remove (lv_fs_drv_t * drv, const char *path);
+static lv_fs_res_t fs_trunc (lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_rename (lv_fs_drv_t * drv, const char * oldname, const char * newname);
+static lv_fs_res_t fs_free (lv_fs_drv_t * drv, uint32_t * total_p, uint32_t * free_p);
+static lv_fs_res_t fs_dir_open (lv_fs_drv_t * drv, void * rddir_p, const char *path);
+static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * rddir_p, char *fn);
+static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * rddir_p);
+
+static lv_fs_res_t fs_res(FRESULT fres);
+static lv_fs_res_t fs_sync_pos(fs_file_t * fp);
+static lv_fs_res_t fs_fill(fs_file_t * fp);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_port_fs_init(void)
+{
+    /*----------------------------------------------------
+     * Initialize your storage device and File System
+     * -------------------------------------------------*/
+    fs_init();
+
+    /*---------------------------------------------------
+     * Register the file system interface  in LittlevGL
+     *--------------------------------------------------*/
+
+    /* Add a simple drive to open images */
+    static lv_fs_drv_t fs_drv;                  /*A driver descriptor*/
+    lv_fs_drv_init(&fs_drv);
+
+    /*Set up fields...*/
+    fs_drv.file_size = sizeof(file_t);
+    fs_drv.letter = LV_PORT_FS_LETTER;
+    fs_drv.ready_cb = fs_ready;
+    fs_drv.open_cb = fs_open;
+    fs_drv.close_cb = fs_close;
+    fs_drv.read_cb = fs_read;
+    fs_drv.write_cb = fs_write;
+    fs_drv.seek_cb = fs_seek;
+    fs_drv.tell_cb = fs_tell;
+    fs_drv.free_space_cb = fs_free;
+    fs_drv.size_cb = fs_size;
+    fs_drv.remove_cb = fs_remove;
+    fs_drv.rename_cb = fs_rename;
+    fs_drv.trunc_cb = fs_trunc;
+
+    fs_drv.rddir_size = sizeof(dir_t);
+    fs_drv.dir_close_cb = fs_dir_close;
+    fs_drv.dir_open_cb = fs_dir_open;
+    fs_drv.dir_read_cb = fs_dir_read;
+
+    lv_fs_drv_register(&fs_drv);
+}
+
+lv_fs_res_t lv_port_fs_stat(const char * path, uint32_t * size_p, uint32_t * mtime_p)
+{
+    FILINFO fno;
+    lv_fs_res_t res;
+
+    if(path[0] != LV_PORT_FS_LETTER || path[1] != ':') return LV_FS_RES_NOT_EX;
+
+    res = fs_res(f_stat(&path[2], &fno));
+    if(res != LV_FS_RES_OK) return res;
+
+    if(size_p != NULL) *size_p = fno.fsize;
+    if(mtime_p != NULL) *mtime_p = ((uint32_t)fno.fdate << 16) | fno.ftime;
+
+    return LV_FS_RES_OK;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* Initialize your Storage device and File system. */
+static void fs_init(void)
+{
+    /*The SD card and FatFs are mounted by hwInit()*/
+}
+
+/**
+ * Tell whether the SD card can be used
+ * @param drv pointer to a driver where this function belongs
+ * @return true: the card is inserted
+ */
+static bool fs_ready(lv_fs_drv_t * drv)
+{
+    (void) drv;
+
+    return gpioPinRead(_PIN_GPIO_SDCARD_DETECT) == _DEF_LOW;
+}
+
+/**
+ * Open a file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @param path path to the file beginning with the driver letter (e.g. S:/folder/file.txt)
+ * @param mode read: FS_MODE_RD, write: FS_MODE_WR, both: FS_MODE_RD | FS_MODE_WR
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_open (lv_fs_drv_t * drv, void * file_p, const char * path, lv_fs_mode_t mode)
+{
+    (void) drv;
+
+    fs_file_t * fp;
+    BYTE flags = 0;
+    lv_fs_res_t res;
+
+    if(mode == LV_FS_MODE_WR) flags = FA_WRITE | FA_OPEN_ALWAYS;
+    else if(mode == LV_FS_MODE_RD) flags = FA_READ;
+    else if(mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) flags = FA_READ | FA_WRITE | FA_OPEN_ALWAYS;
+    else return LV_FS_RES_INV_PARAM;
+
+    fp = malloc(sizeof(fs_file_t));
+    if(fp == NULL) return LV_FS_RES_OUT_OF_MEM;
+
+    res = fs_res(f_open(&fp->fil, path, flags));
+    if(res != LV_FS_RES_OK) {
+        free(fp);
+        return res;
+    }
+
+    fp->pos = 0;
+    fp->buf_pos = 0;
+    fp->buf_len = 0;
+
+    *(file_t *)file_p = fp;
+
+    return LV_FS_RES_OK;
+}
+
+
+/**
+ * Close an opened file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable. (opened with lv_ufs_open)
+ * @return LV_FS_RES_OK: no error, the file is read
+ *         any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_close (lv_fs_drv_t * drv, void * file_p)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+    lv_fs_res_t res;
+
+    res = fs_res(f_close(&fp->fil));
+    free(fp);
+
+    return res;
+}
+
+/**
+ * Read data from an opened file.
+ * Small reads are served from a read-ahead buffer which is refilled
+ * from the sector boundary below the read position. Reads at least as
+ * large as the buffer go directly into `buf`.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable.
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK: no error, the file is read
+ *         any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_read (lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+    uint8_t * dst = buf;
+    lv_fs_res_t res = LV_FS_RES_OK;
+    uint32_t n;
+    UINT rd;
+
+    *br = 0;
+
+    while(btr > 0) {
+        if(fp->pos >= fp->buf_pos && fp->pos < fp->buf_pos + fp->buf_len) {
+            n = fp->buf_pos + fp->buf_len - fp->pos;
+            if(n > btr) n = btr;
+            memcpy(dst, &fp->buf[fp->pos - fp->buf_pos], n);
+        } else if(btr >= LV_PORT_FS_READ_AHEAD) {
+            res = fs_sync_pos(fp);
+            if(res != LV_FS_RES_OK) break;
+
+            res = fs_res(f_read(&fp->fil, dst, btr, &rd));
+            if(res != LV_FS_RES_OK || rd == 0) break;
+            n = rd;
+        } else {
+            res = fs_fill(fp);
+            if(res != LV_FS_RES_OK) break;
+
+            /*End of file*/
+            if(fp->pos >= fp->buf_pos + fp->buf_len) break;
+            continue;
+        }
+
+        fp->pos += n;
+        dst += n;
+        btr -= n;
+        *br += n;
+    }
+
+    return res;
+}
+
+/**
+ * Write into a file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @param buf pointer to a buffer with the bytes to write
+ * @param btr Bytes To Write
+ * @param br the number of real written bytes (Bytes Written). NULL if unused.
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+    lv_fs_res_t res;
+    UINT wr = 0;
+
+    /*The read-ahead data might be overwritten*/
+    fp->buf_len = 0;
+
+    res = fs_sync_pos(fp);
+    if(res == LV_FS_RES_OK) {
+        res = fs_res(f_write(&fp->fil, buf, btw, &wr));
+        fp->pos += wr;
+        if(res == LV_FS_RES_OK && wr < btw) res = LV_FS_RES_FULL;
+    }
+
+    if(bw != NULL) *bw = wr;
+
+    return res;
+}
+
+/**
+ * Set the read write pointer. The file is expanded by the next write if necessary.
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable. (opened with lv_ufs_open )
+ * @param pos the new position of read write pointer
+ * @return LV_FS_RES_OK: no error, the file is read
+ *         any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_seek (lv_fs_drv_t * drv, void * file_p, uint32_t pos)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+
+    fp->pos = pos;
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the size of a file bytes
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable
+ * @param size pointer to a variable to store the size
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_size (lv_fs_drv_t * drv, void * file_p, uint32_t * size_p)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+
+    *size_p = f_size(&fp->fil);
+
+    return LV_FS_RES_OK;
+}
+/**
+ * Give the position of the read write pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a file_t variable.
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK: no error, the file is read
+ *         any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_tell (lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+
+    *pos_p = fp->pos;
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Delete a file
+ * @param drv pointer to a driver where this function belongs
+ * @param path path of the file to delete
+ * @return  LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_remove (lv_fs_drv_t * drv, const char *path)
+{
+    (void) drv;
+
+    return fs_res(f_unlink(path));
+}
+
+/**
+ * Truncate the file size to the current position of the read write pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to an 'ufs_file_t' variable. (opened with lv_fs_open )
+ * @return LV_FS_RES_OK: no error, the file is read
+ *         any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_trunc (lv_fs_drv_t * drv, void * file_p)
+{
+    (void) drv;
+
+    fs_file_t * fp = *(file_t *)file_p;
+    lv_fs_res_t res;
+
+    fp->buf_len = 0;
+
+    res = fs_sync_pos(fp);
+    if(res != LV_FS_RES_OK) return res;
+
+    return fs_res(f_truncate(&fp->fil));
+}
+
+/**
+ * Rename a file
+ * @param drv pointer to a driver where this function belongs
+ * @param oldname path to the file
+ * @param newname path with the new name
+ * @return LV_FS_RES_OK or any error from 'fs_res_t'
+ */
+static lv_fs_res_t fs_rename (lv_fs_drv_t * drv, const char * oldname, const char * newname)
+{
+    (void) drv;
+
+    return fs_res(f_rename(oldname, newname));
+}
+
+/**
+ * Get the free and total size of a driver in kB
+ * @param drv pointer to a driver where this function belongs
+ * @param total_p pointer to store the total size [kB]
+ * @param free_p pointer to store the free size [kB]
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_free (lv_fs_drv_t * drv, uint32_t * total_p, uint32_t * free_p)
+{
+    (void) drv;
+
+    FATFS * fs;
+    DWORD fre_clust;
+    lv_fs_res_t res;
+
+    res = fs_res(f_getfree("", &fre_clust, &fs));
+    if(res != LV_FS_RES_OK) return res;
+
+    /*512 byte sectors: 2 per kB*/
+    *total_p = (fs->n_fatent - 2) * fs->csize / 2;
+    *free_p = fre_clust * fs->csize / 2;
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Initialize a 'fs_read_dir_t' variable for directory reading
+ * @param drv pointer to a driver where this function belongs
+ * @param rddir_p pointer to a 'fs_read_dir_t' variable
+ * @param path path to a directory
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_open (lv_fs_drv_t * drv, void * rddir_p, const char *path)
+{
+    (void) drv;
+
+    return fs_res(f_opendir(rddir_p, path));
+}
+
+/**
+ * Read the next filename form a directory.
+ * The name of the directories will begin with '/'
+ * @param drv pointer to a driver where this function belongs
+ * @param rddir_p pointer to an initialized 'fs_read_dir_t' variable
+ * @param fn pointer to a buffer to store the filename
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_read (lv_fs_drv_t * drv, void * rddir_p, char *fn)
+{
+    (void) drv;
+
+    FILINFO fno;
+    lv_fs_res_t res;
+    uint32_t i = 0;
+
+    do {
+        res = fs_res(f_readdir(rddir_p, &fno));
+        if(res != LV_FS_RES_OK) {
+            fn[0] = '\0';
+            return res;
+        }
+    } while(strcmp(fno.fname, ".") == 0 || strcmp(fno.fname, "..") == 0);
+
+    /*An empty name means there are no more entries*/
+    if(fno.fname[0] != '\0' && (fno.fattrib & AM_DIR)) fn[i++] = '/';
+
+    strncpy(&fn[i], fno.fname, LV_FS_MAX_FN_LENGTH - 1 - i);
+    fn[LV_FS_MAX_FN_LENGTH - 1] = '\0';
+
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Close the directory reading
+ * @param drv pointer to a driver where this function belongs
+ * @param rddir_p pointer to an initialized 'fs_read_dir_t' variable
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_dir_close (lv_fs_drv_t * drv, void * rddir_p)
+{
+    (void) drv;
+
+    return fs_res(f_closedir(rddir_p));
+}
+
+/**
+ * Convert a FatFs result to LittlevGL's
+ * @param fres result of a FatFs function
+ * @return the matching lv_fs_res_t
+ */
+static lv_fs_res_t fs_res(FRESULT fres)
+{
+    switch(fres) {
+        case FR_OK:                  return LV_FS_RES_OK;
+        case FR_DISK_ERR:
+        case FR_NOT_READY:           return LV_FS_RES_HW_ERR;
+        case FR_INT_ERR:
+        case FR_NO_FILESYSTEM:
+        case FR_NOT_ENABLED:
+        case FR_INVALID_OBJECT:      return LV_FS_RES_FS_ERR;
+        case FR_NO_FILE:
+        case FR_NO_PATH:
+        case FR_INVALID_DRIVE:       return LV_FS_RES_NOT_EX;
+        case FR_DENIED:
+        case FR_EXIST:
+        case FR_WRITE_PROTECTED:     return LV_FS_RES_DENIED;
+        case FR_LOCKED:
+        case FR_TOO_MANY_OPEN_FILES: return LV_FS_RES_LOCKED;
+        case FR_TIMEOUT:             return LV_FS_RES_TOUT;
+        case FR_NOT_ENOUGH_CORE:     return LV_FS_RES_OUT_OF_MEM;
+        case FR_INVALID_NAME:
+        case FR_INVALID_PARAMETER:   return LV_FS_RES_INV_PARAM;
+        default:                     return LV_FS_RES_UNKNOWN;
+    }
+}
+
+/**
+ * Move the FatFs file pointer to the logical position
+ * @param fp pointer to an opened file
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_sync_pos(fs_file_t * fp)
+{
+    if(f_tell(&fp->fil) == fp->pos) return LV_FS_RES_OK;
+
+    return fs_res(f_lseek(&fp->fil, fp->pos));
+}
+
+/**
+ * Refill the read-ahead buffer from the sector which holds the logical position
+ * @param fp pointer to an opened file
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_fill(fs_file_t * fp)
+{
+    lv_fs_res_t res;
+    UINT rd = 0;
+
+    fp->buf_len = 0;
+    fp->buf_pos = fp->pos & ~(FS_SECTOR_SIZE - 1);
+
+    if(f_tell(&fp->fil) != fp->buf_pos) {
+        res = fs_res(f_lseek(&fp->fil, fp->buf_pos));
+        if(res != LV_FS_RES_OK) return res;
+    }
+
+    res = fs_res(f_read(&fp->fil, fp->buf, LV_PORT_FS_READ_AHEAD, &rd));
+    fp->buf_len = rd;
+
+    return res;
+}
+
+#else /* Enable this file at the top */
+
+/* This dummy typedef exists purely to silence -Wpedantic. */
+typedef int keep_pedantic_happy;
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file lv_port_fs.h
+ *
+ */
+
+#if 1
+
+#ifndef LV_PORT_FS_H
+#define LV_PORT_FS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Drive letter of the SD card, e.g. "S:roms/boxart.bmp"*/
+#define LV_PORT_FS_LETTER       'S'
+
+/*Bytes read ahead on every SD access. Small reads are served from this buffer*/
+#define LV_PORT_FS_READ_AHEAD   4096
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void lv_port_fs_init(void);
+
+/**
+ * Get the size and modification time of a file on the SD card drive
+ * @param path path with the driver letter (e.g. "S:folder/img.bmp")
+ * @param size_p pointer to store the size in bytes (NULL if unused)
+ * @param mtime_p pointer to store the FAT date (high half) and time (low half) (NULL if unused)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+lv_fs_res_t lv_port_fs_stat(const char * path, uint32_t * size_p, uint32_t * mtime_p);
+
+/**********************
+ *      MACROS
+ **********************/
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_PORT_FS_H*/
+
+#endif /*Disable/Enable content*/
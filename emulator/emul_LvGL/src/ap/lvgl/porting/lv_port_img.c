@@ -0,0 +1,751 @@
+/**
+ * @file lv_port_img.c
+ *
+ */
+
+#if 1
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_img.h"
+#include "lv_port_fs.h"
+#include "hw.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define IMG_PATH_MAX            96
+#define IMG_HEADER_SIZE         70          /*BMP file header + info header up to the alpha mask*/
+
+#define IMG_BLOB_MAGIC          0x434C564CUL  /*"LVLC"*/
+#define IMG_BLOB_EXT            ".lvc"
+
+#define BMP_RGB                 0
+#define BMP_BITFIELDS           3
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum {
+    IMG_KIND_BIN,
+    IMG_KIND_BMP,
+} img_kind_t;
+
+/*What the header of a source file tells*/
+typedef struct {
+    img_kind_t kind;
+    lv_img_header_t header;
+    uint32_t data_ofs;      /*File offset of the pixels*/
+    uint16_t bpp;           /*BMP only*/
+    bool top_down;          /*BMP only*/
+} img_info_t;
+
+/*A decoded image in SDRAM*/
+typedef struct {
+    char path[IMG_PATH_MAX];
+    uint32_t src_size;
+    uint32_t src_mtime;
+    lv_img_header_t header;
+    uint8_t * data;
+    uint32_t data_size;
+    uint32_t stamp;         /*Last use for LRU*/
+    uint16_t refs;          /*Open decoder sessions. Not dropped while > 0*/
+} img_entry_t;
+
+/*Header of a "<file>.lvc" blob. The decoded pixels follow it*/
+typedef struct {
+    uint32_t magic;
+    uint32_t src_size;
+    uint32_t src_mtime;
+    lv_img_header_t header;
+    uint32_t data_size;
+} img_blob_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static lv_res_t img_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header);
+static lv_res_t img_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+static void img_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc);
+
+static lv_res_t img_probe(const char * path, img_info_t * info);
+static uint8_t * img_decode(const char * path, const img_info_t * info, lv_img_header_t * header, uint32_t * size_p);
+static bool img_decode_bmp(lv_fs_file_t * f, const img_info_t * info, uint8_t * dst, bool * alpha_p);
+static uint8_t * img_drop_alpha(uint8_t * data, uint32_t px_cnt, lv_img_header_t * header, uint32_t * size_p);
+
+static uint8_t * img_blob_load(const char * path, uint32_t src_size, uint32_t src_mtime, lv_img_header_t * header, uint32_t * size_p);
+static bool img_blob_check(const img_blob_t * blob, uint32_t file_size);
+static void img_blob_save(const char * path, uint32_t src_size, uint32_t src_mtime, const lv_img_header_t * header, const uint8_t * data, uint32_t size);
+
+static img_entry_t * img_cache_find(const char * path, uint32_t src_size, uint32_t src_mtime);
+static img_entry_t * img_cache_insert(const char * path, uint32_t src_size, uint32_t src_mtime, const lv_img_header_t * header, uint8_t * data, uint32_t size);
+static void img_cache_drop(img_entry_t * e);
+
+static void img_cmdif(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static img_entry_t img_cache[LV_PORT_IMG_CACHE_CNT];
+static uint32_t img_cache_bytes;
+static uint32_t img_stamp;
+static bool img_disk_cache = LV_PORT_IMG_DISK_CACHE;
+
+/*Statistics reported by the "img" command*/
+static uint32_t img_hits;
+static uint32_t img_misses;
+static uint32_t img_blob_hits;
+static uint32_t img_evictions;
+static uint32_t img_decode_ms;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_port_img_init(void)
+{
+    lv_img_decoder_t * dec = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(dec, img_info);
+    lv_img_decoder_set_open_cb(dec, img_open);
+    lv_img_decoder_set_close_cb(dec, img_close);
+
+    if (cmdifIsInit() == false)
+    {
+      cmdifInit();
+    }
+    cmdifAdd("img", img_cmdif);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Get info about an image of the SD card drive
+ * @param decoder pointer to this decoder
+ * @param src the image source. Only file names are handled
+ * @param header store the info here
+ * @return LV_RES_OK: the image can be opened by this decoder
+ */
+static lv_res_t img_info(lv_img_decoder_t * decoder, const void * src, lv_img_header_t * header)
+{
+    (void) decoder;
+
+    img_info_t info;
+    img_entry_t * e;
+    uint32_t size;
+    uint32_t mtime;
+
+    if(lv_img_src_get_type(src) != LV_IMG_SRC_FILE) return LV_RES_INV;
+    if(lv_port_fs_stat(src, &size, &mtime) != LV_FS_RES_OK) return LV_RES_INV;
+
+    e = img_cache_find(src, size, mtime);
+    if(e != NULL) {
+        *header = e->header;
+        return LV_RES_OK;
+    }
+
+    if(img_probe(src, &info) != LV_RES_OK) return LV_RES_INV;
+
+    *header = info.header;
+
+    return LV_RES_OK;
+}
+
+/**
+ * Open an image: take it from the SDRAM cache, the blob next to the file or decode it
+ * @param decoder pointer to this decoder
+ * @param dsc the decoder session. `img_data` will point to the decoded pixels
+ * @return LV_RES_OK: opened; LV_RES_INV: this decoder can't open the image
+ */
+static lv_res_t img_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    (void) decoder;
+
+    const char * path = dsc->src;
+    img_info_t info;
+    img_entry_t * e;
+    lv_img_header_t header;
+    uint8_t * data = NULL;
+    uint32_t data_size;
+    uint32_t size;
+    uint32_t mtime;
+    uint32_t t;
+
+    if(dsc->src_type != LV_IMG_SRC_FILE) return LV_RES_INV;
+    if(lv_port_fs_stat(path, &size, &mtime) != LV_FS_RES_OK) return LV_RES_INV;
+
+    e = img_cache_find(path, size, mtime);
+    if(e == NULL) {
+        img_misses++;
+
+        if(img_disk_cache == true) {
+            data = img_blob_load(path, size, mtime, &header, &data_size);
+            if(data != NULL) img_blob_hits++;
+        }
+
+        if(data == NULL) {
+            if(img_probe(path, &info) != LV_RES_OK) return LV_RES_INV;
+
+            t = millis();
+            data = img_decode(path, &info, &header, &data_size);
+            if(data == NULL) return LV_RES_INV;
+            img_decode_ms += millis() - t;
+
+            if(img_disk_cache == true) img_blob_save(path, size, mtime, &header, data, data_size);
+        }
+
+        e = img_cache_insert(path, size, mtime, &header, data, data_size);
+    } else {
+        img_hits++;
+    }
+
+    if(e != NULL) {
+        e->refs++;
+        e->stamp = ++img_stamp;
+        dsc->header = e->header;
+        dsc->img_data = e->data;
+    } else {
+        /*Does not fit into the cache: owned by this session only*/
+        dsc->header = header;
+        dsc->img_data = data;
+    }
+    dsc->user_data = e;
+
+    return LV_RES_OK;
+}
+
+/**
+ * Close an image. It stays in the SDRAM cache until it gets evicted.
+ * @param decoder pointer to this decoder
+ * @param dsc the decoder session
+ */
+static void img_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc)
+{
+    (void) decoder;
+
+    img_entry_t * e = dsc->user_data;
+
+    if(e != NULL) {
+        if(e->refs > 0) e->refs--;
+    } else {
+        free((void *)dsc->img_data);
+    }
+
+    dsc->img_data = NULL;
+    dsc->user_data = NULL;
+}
+
+/**
+ * Read the header of a ".bin" or ".bmp" file
+ * @param path path of the file with the driver letter
+ * @param info store the result here
+ * @return LV_RES_OK: it is a supported image
+ */
+static lv_res_t img_probe(const char * path, img_info_t * info)
+{
+    lv_fs_file_t f;
+    uint8_t buf[IMG_HEADER_SIZE];
+    uint32_t br = 0;
+    const char * ext = lv_fs_get_ext(path);
+    int32_t w;
+    int32_t h;
+    uint32_t comp;
+    uint32_t hdr_size;
+
+    memset(buf, 0, sizeof(buf));
+    memset(info, 0, sizeof(img_info_t));
+
+    if(!strcmp(ext, "bin") || !strcmp(ext, "BIN")) info->kind = IMG_KIND_BIN;
+    else if(!strcmp(ext, "bmp") || !strcmp(ext, "BMP")) info->kind = IMG_KIND_BMP;
+    else return LV_RES_INV;
+
+    if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return LV_RES_INV;
+    lv_fs_read(&f, buf, sizeof(buf), &br);
+    lv_fs_close(&f);
+
+    if(info->kind == IMG_KIND_BIN) {
+        if(br < sizeof(lv_img_header_t)) return LV_RES_INV;
+
+        memcpy(&info->header, buf, sizeof(lv_img_header_t));
+        info->data_ofs = sizeof(lv_img_header_t);
+
+        /*Palette and alpha only images are left to the built-in decoder*/
+        if(info->header.cf != LV_IMG_CF_TRUE_COLOR &&
+           info->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA &&
+           info->header.cf != LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED) {
+            return LV_RES_INV;
+        }
+        return LV_RES_OK;
+    }
+
+    if(br < 54 || buf[0] != 'B' || buf[1] != 'M') return LV_RES_INV;
+
+    info->data_ofs = buf[10] | (buf[11] << 8) | (buf[12] << 16) | ((uint32_t)buf[13] << 24);
+    hdr_size = buf[14] | (buf[15] << 8);
+    w = (int32_t)(buf[18] | (buf[19] << 8) | (buf[20] << 16) | ((uint32_t)buf[21] << 24));
+    h = (int32_t)(buf[22] | (buf[23] << 8) | (buf[24] << 16) | ((uint32_t)buf[25] << 24));
+    info->bpp = buf[28] | (buf[29] << 8);
+    comp = buf[30] | (buf[31] << 8);
+
+    info->top_down = h < 0;
+    if(h < 0) h = -h;
+    if(w <= 0 || w > 2047 || h == 0 || h > 2047) return LV_RES_INV;
+
+    if(info->bpp == 24 && comp == BMP_RGB) {
+        info->header.cf = LV_IMG_CF_TRUE_COLOR;
+    } else if(info->bpp == 32 && (comp == BMP_RGB || comp == BMP_BITFIELDS)) {
+        /*Bitfields are expected as BGRA. Without an alpha mask the 4th byte might be unused,
+         *`img_decode_bmp` finds that out*/
+        if(comp == BMP_BITFIELDS && (buf[54] != 0x00 || buf[55] != 0x00 || buf[56] != 0xFF || buf[62] != 0xFF)) {
+            return LV_RES_INV;
+        }
+        info->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    } else if(info->bpp == 16 && comp == BMP_BITFIELDS && hdr_size >= 40) {
+        /*Only RGB565 is stored as it is*/
+        if(buf[54] != 0x00 || buf[55] != 0xF8 || buf[58] != 0xE0 || buf[59] != 0x07 || buf[62] != 0x1F) {
+            return LV_RES_INV;
+        }
+        info->header.cf = LV_IMG_CF_TRUE_COLOR;
+    } else {
+        return LV_RES_INV;
+    }
+
+    info->header.always_zero = 0;
+    info->header.w = w;
+    info->header.h = h;
+
+    return LV_RES_OK;
+}
+
+/**
+ * Decode a whole image into SDRAM
+ * @param path path of the file with the driver letter
+ * @param info what `img_probe` found
+ * @param header store the header of the decoded image here
+ * @param size_p store the size of the decoded pixels here
+ * @return the decoded pixels (allocated with `malloc`) or NULL on error
+ */
+static uint8_t * img_decode(const char * path, const img_info_t * info, lv_img_header_t * header, uint32_t * size_p)
+{
+    lv_fs_file_t f;
+    uint8_t * data;
+    uint32_t px_cnt = (uint32_t)info->header.w * info->header.h;
+    uint32_t px_size;
+    uint32_t br = 0;
+    bool alpha = false;
+    bool ok;
+
+    *header = info->header;
+
+    px_size = header->cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    *size_p = px_cnt * px_size;
+
+    data = malloc(*size_p);
+    if(data == NULL) return NULL;
+
+    if(lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        free(data);
+        return NULL;
+    }
+    lv_fs_seek(&f, info->data_ofs);
+
+    if(info->kind == IMG_KIND_BIN) {
+        ok = lv_fs_read(&f, data, *size_p, &br) == LV_FS_RES_OK && br == *size_p;
+        alpha = header->cf == LV_IMG_CF_TRUE_COLOR_ALPHA;
+    } else {
+        ok = img_decode_bmp(&f, info, data, &alpha);
+    }
+    lv_fs_close(&f);
+
+    if(ok == false) {
+        free(data);
+        return NULL;
+    }
+
+    if(header->cf == LV_IMG_CF_TRUE_COLOR_ALPHA && alpha == false) {
+        data = img_drop_alpha(data, px_cnt, header, size_p);
+    }
+
+    return data;
+}
+
+/**
+ * Convert the pixels of a BMP file to LittlevGL's true color format.
+ * Color of fully transparent pixels is cleared.
+ * @param f BMP file, its position is at the pixels
+ * @param info what `img_probe` found
+ * @param dst store the decoded pixels here
+ * @param alpha_p set to true if any pixel is not fully opaque
+ * @return true: success
+ */
+static bool img_decode_bmp(lv_fs_file_t * f, const img_info_t * info, uint8_t * dst, bool * alpha_p)
+{
+    uint32_t w = info->header.w;
+    uint32_t h = info->header.h;
+    uint32_t row_bytes = ((w * info->bpp + 31) / 32) * 4;
+    uint32_t px_size = info->bpp == 32 ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    uint8_t * row;
+    uint8_t * d;
+    const uint8_t * s;
+    uint32_t x;
+    uint32_t y;
+    uint32_t br;
+    uint8_t a;
+    bool any_alpha = false;
+    bool all_clear = true;
+    lv_color_t c;
+
+    row = malloc(row_bytes);
+    if(row == NULL) return false;
+
+    for(y = 0; y < h; y++) {
+        if(lv_fs_read(f, row, row_bytes, &br) != LV_FS_RES_OK || br != row_bytes) {
+            free(row);
+            return false;
+        }
+
+        /*Rows are stored bottom-up unless the height is negative*/
+        d = &dst[(info->top_down ? y : h - 1 - y) * w * px_size];
+        s = row;
+
+        if(info->bpp == 16) {
+            memcpy(d, s, w * 2);
+        } else if(info->bpp == 24) {
+            for(x = 0; x < w; x++) {
+                c = LV_COLOR_MAKE(s[2], s[1], s[0]);
+                d[0] = c.full & 0xFF;
+                d[1] = c.full >> 8;
+                d += 2;
+                s += 3;
+            }
+        } else {
+            for(x = 0; x < w; x++) {
+                a = s[3];
+                c = LV_COLOR_MAKE(s[2], s[1], s[0]);
+                d[0] = c.full & 0xFF;
+                d[1] = c.full >> 8;
+                d[2] = a;
+                if(a != 0xFF) any_alpha = true;
+                if(a != 0x00) all_clear = false;
+                d += 3;
+                s += 4;
+            }
+        }
+    }
+    free(row);
+
+    /*An all zero 4th byte is only padding (XRGB)*/
+    *alpha_p = any_alpha && !all_clear;
+
+    if(*alpha_p) {
+        d = dst;
+        for(x = 0; x < w * h; x++) {
+            if(d[2] == 0) {
+                d[0] = 0;
+                d[1] = 0;
+            }
+            d += 3;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Convert an opaque true color + alpha image to true color in place.
+ * Without per pixel alpha the image can be drawn by plain (DMA2D) copies.
+ * @param data pixels allocated with `malloc`
+ * @param px_cnt number of pixels
+ * @param header header of the image, its color format is updated
+ * @param size_p size of the pixels, it is updated
+ * @return the (possibly moved) pixels
+ */
+static uint8_t * img_drop_alpha(uint8_t * data, uint32_t px_cnt, lv_img_header_t * header, uint32_t * size_p)
+{
+    uint8_t * shrunk;
+    uint32_t i;
+
+    for(i = 0; i < px_cnt; i++) {
+        data[i * 2]     = data[i * 3];
+        data[i * 2 + 1] = data[i * 3 + 1];
+    }
+
+    header->cf = LV_IMG_CF_TRUE_COLOR;
+    *size_p = px_cnt * sizeof(lv_color_t);
+
+    shrunk = realloc(data, *size_p);
+
+    return shrunk != NULL ? shrunk : data;
+}
+
+/**
+ * Load the decoded pixels from the blob next to the source file if it is up to date
+ * @param path path of the source file with the driver letter
+ * @param src_size size of the source file
+ * @param src_mtime modification time of the source file
+ * @param header store the header of the decoded image here
+ * @param size_p store the size of the decoded pixels here
+ * @return the decoded pixels (allocated with `malloc`) or NULL if there is no valid blob
+ */
+static uint8_t * img_blob_load(const char * path, uint32_t src_size, uint32_t src_mtime, lv_img_header_t * header, uint32_t * size_p)
+{
+    char blob_path[LV_FS_MAX_PATH_LENGTH];
+    lv_fs_file_t f;
+    img_blob_t blob;
+    uint8_t * data = NULL;
+    uint32_t br = 0;
+    uint32_t file_size = 0;
+
+    snprintf(blob_path, sizeof(blob_path), "%s" IMG_BLOB_EXT, path);
+
+    if(lv_fs_open(&f, blob_path, LV_FS_MODE_RD) != LV_FS_RES_OK) return NULL;
+
+    if(lv_fs_size(&f, &file_size) == LV_FS_RES_OK &&
+       lv_fs_read(&f, &blob, sizeof(blob), &br) == LV_FS_RES_OK && br == sizeof(blob) &&
+       blob.magic == IMG_BLOB_MAGIC && blob.src_size == src_size && blob.src_mtime == src_mtime &&
+       img_blob_check(&blob, file_size) == true) {
+        data = malloc(blob.data_size);
+        if(data != NULL) {
+            if(lv_fs_read(&f, data, blob.data_size, &br) != LV_FS_RES_OK || br != blob.data_size) {
+                free(data);
+                data = NULL;
+            }
+        }
+    }
+    lv_fs_close(&f);
+
+    if(data != NULL) {
+        *header = blob.header;
+        *size_p = blob.data_size;
+    }
+
+    return data;
+}
+
+/**
+ * Check that a blob describes an image `img_decode` could have made and that
+ * the file holds exactly its pixels. A damaged or truncated blob is decoded again.
+ * @param blob header read from the blob
+ * @param file_size size of the blob file
+ * @return true: the pixels can be read as they are
+ */
+static bool img_blob_check(const img_blob_t * blob, uint32_t file_size)
+{
+    uint32_t px_size;
+
+    if(blob->header.always_zero != 0) return false;
+    if(blob->header.cf != LV_IMG_CF_TRUE_COLOR &&
+       blob->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA &&
+       blob->header.cf != LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED) {
+        return false;
+    }
+    if(blob->header.w == 0 || blob->header.w > 2047 || blob->header.h == 0 || blob->header.h > 2047) return false;
+
+    px_size = blob->header.cf == LV_IMG_CF_TRUE_COLOR_ALPHA ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+    if(blob->data_size != (uint32_t)blob->header.w * blob->header.h * px_size) return false;
+
+    return file_size == sizeof(img_blob_t) + blob->data_size;
+}
+
+/**
+ * Store the decoded pixels next to the source file. Errors are ignored:
+ * the image is simply decoded again next time.
+ * @param path path of the source file with the driver letter
+ * @param src_size size of the source file
+ * @param src_mtime modification time of the source file
+ * @param header header of the decoded image
+ * @param data the decoded pixels
+ * @param size size of the decoded pixels
+ */
+static void img_blob_save(const char * path, uint32_t src_size, uint32_t src_mtime, const lv_img_header_t * header, const uint8_t * data, uint32_t size)
+{
+    char blob_path[LV_FS_MAX_PATH_LENGTH];
+    lv_fs_file_t f;
+    img_blob_t blob;
+    uint32_t bw = 0;
+
+    snprintf(blob_path, sizeof(blob_path), "%s" IMG_BLOB_EXT, path);
+
+    blob.magic = IMG_BLOB_MAGIC;
+    blob.src_size = src_size;
+    blob.src_mtime = src_mtime;
+    blob.header = *header;
+    blob.data_size = size;
+
+    if(lv_fs_open(&f, blob_path, LV_FS_MODE_WR) != LV_FS_RES_OK) return;
+
+    if(lv_fs_write(&f, &blob, sizeof(blob), &bw) == LV_FS_RES_OK && bw == sizeof(blob)) {
+        lv_fs_write(&f, data, size, &bw);
+    }
+    lv_fs_trunc(&f);
+    lv_fs_close(&f);
+}
+
+/**
+ * Find an up to date decoded image
+ * @param path path of the source file with the driver letter
+ * @param src_size size of the source file
+ * @param src_mtime modification time of the source file
+ * @return the cache entry or NULL if not found
+ */
+static img_entry_t * img_cache_find(const char * path, uint32_t src_size, uint32_t src_mtime)
+{
+    img_entry_t * e;
+    uint32_t i;
+
+    for(i = 0; i < LV_PORT_IMG_CACHE_CNT; i++) {
+        e = &img_cache[i];
+        if(e->data == NULL || strcmp(e->path, path)) continue;
+
+        if(e->src_size == src_size && e->src_mtime == src_mtime) return e;
+
+        /*The file has changed*/
+        if(e->refs == 0) img_cache_drop(e);
+    }
+
+    return NULL;
+}
+
+/**
+ * Add a decoded image to the cache. Unused images are dropped in LRU order to make room.
+ * @param path path of the source file with the driver letter
+ * @param src_size size of the source file
+ * @param src_mtime modification time of the source file
+ * @param header header of the decoded image
+ * @param data the decoded pixels, the cache takes them over
+ * @param size size of the decoded pixels
+ * @return the new entry or NULL if the image can't be cached
+ */
+static img_entry_t * img_cache_insert(const char * path, uint32_t src_size, uint32_t src_mtime, const lv_img_header_t * header, uint8_t * data, uint32_t size)
+{
+    img_entry_t * e;
+    img_entry_t * free_e;
+    img_entry_t * lru;
+    uint32_t i;
+
+    if(strlen(path) >= IMG_PATH_MAX || size > LV_PORT_IMG_CACHE_SIZE) return NULL;
+
+    while(1) {
+        free_e = NULL;
+        lru = NULL;
+
+        for(i = 0; i < LV_PORT_IMG_CACHE_CNT; i++) {
+            e = &img_cache[i];
+            if(e->data == NULL) {
+                if(free_e == NULL) free_e = e;
+            } else if(e->refs == 0 && (lru == NULL || (int32_t)(e->stamp - lru->stamp) < 0)) {
+                lru = e;
+            }
+        }
+
+        if(free_e != NULL && img_cache_bytes + size <= LV_PORT_IMG_CACHE_SIZE) break;
+        if(lru == NULL) return NULL;
+
+        img_cache_drop(lru);
+        img_evictions++;
+    }
+
+    e = free_e;
+    strcpy(e->path, path);
+    e->src_size = src_size;
+    e->src_mtime = src_mtime;
+    e->header = *header;
+    e->data = data;
+    e->data_size = size;
+    e->refs = 0;
+    e->stamp = ++img_stamp;
+
+    img_cache_bytes += size;
+
+    return e;
+}
+
+/**
+ * Free a decoded image
+ * @param e pointer to an unused cache entry
+ */
+static void img_cache_drop(img_entry_t * e)
+{
+    img_cache_bytes -= e->data_size;
+
+    free(e->data);
+    e->data = NULL;
+    e->data_size = 0;
+    e->path[0] = '\0';
+}
+
+static void img_cmdif(void)
+{
+  bool ret = true;
+  uint32_t i;
+  uint32_t cnt = 0;
+
+  if (cmdifGetParamCnt() == 1 && cmdifHasString("info", 0) == true)
+  {
+    for (i=0; i<LV_PORT_IMG_CACHE_CNT; i++)
+    {
+      if (img_cache[i].data != NULL) cnt++;
+    }
+    cmdifPrintf("images       : %d/%d\n", cnt, LV_PORT_IMG_CACHE_CNT);
+    cmdifPrintf("bytes        : %d/%d KB\n", img_cache_bytes/1024, LV_PORT_IMG_CACHE_SIZE/1024);
+    cmdifPrintf("hits         : %d\n", img_hits);
+    cmdifPrintf("misses       : %d (from blob %d)\n", img_misses, img_blob_hits);
+    cmdifPrintf("evictions    : %d\n", img_evictions);
+    cmdifPrintf("decode ms    : %d\n", img_decode_ms);
+    cmdifPrintf("disk cache   : %d\n", img_disk_cache);
+  }
+  else if (cmdifGetParamCnt() == 1 && cmdifHasString("list", 0) == true)
+  {
+    for (i=0; i<LV_PORT_IMG_CACHE_CNT; i++)
+    {
+      if (img_cache[i].data == NULL) continue;
+
+      cmdifPrintf("%4dx%-4d %7d %2d %s\n",
+                  img_cache[i].header.w,
+                  img_cache[i].header.h,
+                  img_cache[i].data_size,
+                  img_cache[i].refs,
+                  img_cache[i].path);
+    }
+  }
+  else if (cmdifGetParamCnt() == 2 && cmdifHasString("disk", 0) == true)
+  {
+    img_disk_cache = cmdifHasString("on", 1) == true;
+  }
+  else if (cmdifGetParamCnt() == 1 && cmdifHasString("reset", 0) == true)
+  {
+    img_hits      = 0;
+    img_misses    = 0;
+    img_blob_hits = 0;
+    img_evictions = 0;
+    img_decode_ms = 0;
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "img info \n");
+    cmdifPrintf( "img list \n");
+    cmdifPrintf( "img disk on/off \n");
+    cmdifPrintf( "img reset \n");
+  }
+}
+
+#else /* Enable this file at the top */
+
+/* This dummy typedef exists purely to silence -Wpedantic. */
+typedef int keep_pedantic_happy;
+#endif
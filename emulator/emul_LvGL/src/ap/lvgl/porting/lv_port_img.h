@@ -0,0 +1,58 @@
+/**
+ * @file lv_port_img.h
+ *
+ */
+
+#if 1
+
+#ifndef LV_PORT_IMG_H
+#define LV_PORT_IMG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lvgl/lvgl.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Bytes of decoded pixels kept in SDRAM. Least recently used images are dropped first*/
+#define LV_PORT_IMG_CACHE_SIZE      (4 * 1024 * 1024)
+
+/*Max. number of decoded images kept in SDRAM*/
+#define LV_PORT_IMG_CACHE_CNT       32
+
+/*1: Store decoded images as "<file>.lvc" next to the source and load them from there*/
+#define LV_PORT_IMG_DISK_CACHE      1
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Register a decoder for ".bmp" and true color ".bin" files of the SD card drive.
+ * Decoded images are kept in SDRAM, so they are read and converted only once.
+ * `lv_port_fs_init()` has to be called first.
+ */
+void lv_port_img_init(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_PORT_IMG_H*/
+
+#endif /*Disable/Enable content*/
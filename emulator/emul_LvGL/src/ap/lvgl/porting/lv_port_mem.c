@@ -0,0 +1,385 @@
+/**
+ * @file lv_port_mem.c
+ *
+ */
+
+#if 1
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_mem.h"
+#include "hw.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define MEM_PAGE_SIZE           2048
+#define MEM_CLASS_CNT           8
+#define MEM_CLASS_MAX           256         /*Larger blocks go to the heap*/
+
+#define MEM_SRAM_PAGE_CNT       (LV_PORT_MEM_SRAM_SIZE / MEM_PAGE_SIZE)
+#define MEM_SDRAM_PAGE_CNT      (LV_PORT_MEM_SDRAM_SIZE / MEM_PAGE_SIZE)
+
+#define MEM_NONE                0xFFFF      /*End of a page list*/
+#define MEM_CLASS_FREE          0xFF        /*Page not assigned to a class*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+/*One page of a region. All of its slots have the same size class*/
+typedef struct {
+    void * free;            /*Freed slots, linked through their first word*/
+    uint16_t next;          /*Next page in the partial or free page list*/
+    uint16_t used;          /*Slots handed out*/
+    uint16_t carved;        /*Slots taken from the never used end of the page*/
+    uint8_t cls;
+} mem_page_t;
+
+typedef struct {
+    const char * name;
+    uint8_t * base;
+    mem_page_t * page;
+    uint16_t page_cnt;
+    uint16_t page_used;
+    uint16_t free_page;     /*Never used pages are taken from 'page_top'*/
+    uint16_t page_top;
+    uint16_t partial[MEM_CLASS_CNT];    /*Pages with free slots. A full page is unlinked*/
+} mem_region_t;
+
+typedef struct {
+    uint32_t used;
+    uint32_t peak;
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t allocs_last;   /*'allocs' at the previous "info" for the rate*/
+} mem_stat_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void mem_setup(void);
+static void mem_region_init(mem_region_t * r, const char * name, void * base, uint32_t size);
+static void * mem_region_alloc(mem_region_t * r, uint8_t cls);
+static void mem_region_free(mem_region_t * r, void * p);
+static inline uint8_t mem_class_of(size_t size);
+static inline mem_region_t * mem_region_of(void * p);
+
+static void mem_cmdif(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+/*Sizes of LittlevGL's small blocks (+4 bytes header): styles, labels, objects, ext. attributes, ...*/
+static const uint16_t mem_class_size[MEM_CLASS_CNT] = {16, 32, 48, 64, 96, 128, 192, 256};
+
+static mem_page_t mem_sram_page[MEM_SRAM_PAGE_CNT];
+static mem_page_t mem_sdram_page[MEM_SDRAM_PAGE_CNT];
+
+static mem_region_t mem_sram;
+static mem_region_t mem_sdram;
+static bool mem_is_setup = false;
+
+/*Statistics reported by the "lvmem" command*/
+static mem_stat_t mem_stat[MEM_CLASS_CNT];
+static mem_stat_t mem_heap_stat;
+static uint32_t mem_fallback;       /*Small blocks which went to the heap as both regions were full*/
+static uint32_t mem_rate_ms;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_port_mem_init(void)
+{
+    if(mem_is_setup == false) mem_setup();
+
+    if (cmdifIsInit() == false)
+    {
+      cmdifInit();
+    }
+    cmdifAdd("lvmem", mem_cmdif);
+}
+
+void * lv_port_mem_alloc(size_t size)
+{
+    void * p = NULL;
+    mem_stat_t * stat = &mem_heap_stat;
+
+    /*lv_init() allocates before anything could call lv_port_mem_init()*/
+    if(mem_is_setup == false) mem_setup();
+
+    if(size <= MEM_CLASS_MAX) {
+        uint8_t cls = mem_class_of(size);
+
+        p = mem_region_alloc(&mem_sram, cls);
+        if(p == NULL) p = mem_region_alloc(&mem_sdram, cls);
+
+        if(p != NULL) stat = &mem_stat[cls];
+        else mem_fallback++;
+    }
+
+    if(p == NULL) {
+        p = malloc(size);
+        if(p == NULL) return NULL;
+    }
+
+    stat->allocs++;
+    stat->used++;
+    if(stat->used > stat->peak) stat->peak = stat->used;
+
+    return p;
+}
+
+void lv_port_mem_free(void * p)
+{
+    mem_region_t * r;
+
+    if(p == NULL) return;
+
+    r = mem_region_of(p);
+    if(r != NULL) {
+        mem_region_free(r, p);
+        return;
+    }
+
+    free(p);
+    mem_heap_stat.frees++;
+    mem_heap_stat.used--;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/* The SRAM region takes what is left of the AXI SRAM after .data and .sram_d1
+ * (the image runs from SDRAM, so .bss and the stacks are not there).
+ * The SDRAM region is a block of the heap, used only when SRAM is full.*/
+static void mem_setup(void)
+{
+    extern uint32_t _esram_d1;
+    uintptr_t sram_start;
+    uintptr_t sram_end;
+    uint32_t sram_size;
+    void * sdram;
+
+    sram_start = ((uintptr_t)&_esram_d1 + 31) & ~31UL;
+    sram_end   = SRAM_D1_ADDR_START + SRAM_D1_SIZE;
+    sram_size  = sram_end > sram_start ? sram_end - sram_start : 0;
+    if(sram_size > LV_PORT_MEM_SRAM_SIZE) sram_size = LV_PORT_MEM_SRAM_SIZE;
+
+    mem_region_init(&mem_sram, "sram", (void *)sram_start, sram_size);
+
+    sdram = malloc(LV_PORT_MEM_SDRAM_SIZE);
+    mem_region_init(&mem_sdram, "sdram", sdram, sdram != NULL ? LV_PORT_MEM_SDRAM_SIZE : 0);
+
+    mem_rate_ms = millis();
+    mem_is_setup = true;
+}
+
+static void mem_region_init(mem_region_t * r, const char * name, void * base, uint32_t size)
+{
+    uint8_t i;
+
+    r->name      = name;
+    r->base      = base;
+    r->page      = r == &mem_sram ? mem_sram_page : mem_sdram_page;
+    r->page_cnt  = size / MEM_PAGE_SIZE;
+    r->page_used = 0;
+    r->free_page = MEM_NONE;
+    r->page_top  = 0;
+
+    for(i = 0; i < MEM_CLASS_CNT; i++) {
+        r->partial[i] = MEM_NONE;
+    }
+}
+
+static void * mem_region_alloc(mem_region_t * r, uint8_t cls)
+{
+    uint16_t id = r->partial[cls];
+    uint16_t slot_size = mem_class_size[cls];
+    mem_page_t * pg;
+    void * p;
+
+    if(id == MEM_NONE) {
+        /*Start a new page: a released one or a never used one*/
+        if(r->free_page != MEM_NONE) {
+            id = r->free_page;
+            r->free_page = r->page[id].next;
+        } else if(r->page_top < r->page_cnt) {
+            id = r->page_top++;
+        } else {
+            return NULL;
+        }
+
+        pg = &r->page[id];
+        pg->free   = NULL;
+        pg->used   = 0;
+        pg->carved = 0;
+        pg->cls    = cls;
+        pg->next   = MEM_NONE;
+        r->partial[cls] = id;
+        r->page_used++;
+    }
+
+    pg = &r->page[id];
+
+    if(pg->free != NULL) {
+        p = pg->free;
+        pg->free = *(void **)p;
+    } else {
+        p = r->base + (uint32_t)id * MEM_PAGE_SIZE + (uint32_t)pg->carved * slot_size;
+        pg->carved++;
+    }
+    pg->used++;
+
+    /*Always the head of the list is used, so a full page is unlinked from there*/
+    if(pg->used == MEM_PAGE_SIZE / slot_size) {
+        r->partial[cls] = pg->next;
+        pg->next = MEM_NONE;
+    }
+
+    return p;
+}
+
+static void mem_region_free(mem_region_t * r, void * p)
+{
+    uint16_t id = ((uint8_t *)p - r->base) / MEM_PAGE_SIZE;
+    mem_page_t * pg = &r->page[id];
+    uint8_t cls = pg->cls;
+    bool was_full = pg->used == MEM_PAGE_SIZE / mem_class_size[cls];
+
+    *(void **)p = pg->free;
+    pg->free = p;
+    pg->used--;
+
+    mem_stat[cls].frees++;
+    mem_stat[cls].used--;
+
+    if(pg->used == 0) {
+        /*Give the empty page back, so an other class can use it*/
+        uint16_t * link = &r->partial[cls];
+        while(*link != MEM_NONE && *link != id) link = &r->page[*link].next;
+        if(*link == id) *link = pg->next;
+
+        pg->cls  = MEM_CLASS_FREE;
+        pg->next = r->free_page;
+        r->free_page = id;
+        r->page_used--;
+    } else if(was_full) {
+        pg->next = r->partial[cls];
+        r->partial[cls] = id;
+    }
+}
+
+static inline uint8_t mem_class_of(size_t size)
+{
+    uint8_t cls = 0;
+
+    while(mem_class_size[cls] < size) cls++;
+
+    return cls;
+}
+
+static inline mem_region_t * mem_region_of(void * p)
+{
+    uint8_t * b = p;
+
+    if(b >= mem_sram.base && b < mem_sram.base + (uint32_t)mem_sram.page_cnt * MEM_PAGE_SIZE) return &mem_sram;
+    if(b >= mem_sdram.base && b < mem_sdram.base + (uint32_t)mem_sdram.page_cnt * MEM_PAGE_SIZE) return &mem_sdram;
+
+    return NULL;
+}
+
+static void mem_cmdif(void)
+{
+  bool ret = true;
+  uint8_t i;
+  uint16_t id;
+  uint32_t ms;
+  uint32_t pages[2];
+
+  if (cmdifGetParamCnt() == 1 && cmdifHasString("info", 0) == true)
+  {
+    ms = millis() - mem_rate_ms;
+    if (ms == 0)
+    {
+      ms = 1;
+    }
+
+    cmdifPrintf("class  pages(sram/sdram)    used    peak    allocs   allocs/s\n");
+    for (i=0; i<MEM_CLASS_CNT; i++)
+    {
+      pages[0] = 0;
+      pages[1] = 0;
+      for (id=0; id<mem_sram.page_top; id++)
+      {
+        if (mem_sram.page[id].cls == i) pages[0]++;
+      }
+      for (id=0; id<mem_sdram.page_top; id++)
+      {
+        if (mem_sdram.page[id].cls == i) pages[1]++;
+      }
+
+      cmdifPrintf("%5d  %8d/%-8d  %7d %7d %9d %10d\n",
+                  mem_class_size[i],
+                  pages[0], pages[1],
+                  mem_stat[i].used,
+                  mem_stat[i].peak,
+                  mem_stat[i].allocs,
+                  (mem_stat[i].allocs - mem_stat[i].allocs_last) * 1000 / ms);
+      mem_stat[i].allocs_last = mem_stat[i].allocs;
+    }
+    cmdifPrintf(" heap  %17s  %7d %7d %9d %10d\n",
+                "",
+                mem_heap_stat.used,
+                mem_heap_stat.peak,
+                mem_heap_stat.allocs,
+                (mem_heap_stat.allocs - mem_heap_stat.allocs_last) * 1000 / ms);
+    mem_heap_stat.allocs_last = mem_heap_stat.allocs;
+    mem_rate_ms = millis();
+
+    cmdifPrintf("sram pages   : %d/%d (0x%X)\n", mem_sram.page_used, mem_sram.page_cnt, (uint32_t)mem_sram.base);
+    cmdifPrintf("sdram pages  : %d/%d (0x%X)\n", mem_sdram.page_used, mem_sdram.page_cnt, (uint32_t)mem_sdram.base);
+    cmdifPrintf("fallback     : %d\n", mem_fallback);
+  }
+  else if (cmdifGetParamCnt() == 1 && cmdifHasString("reset", 0) == true)
+  {
+    for (i=0; i<MEM_CLASS_CNT; i++)
+    {
+      mem_stat[i].peak        = mem_stat[i].used;
+      mem_stat[i].allocs      = 0;
+      mem_stat[i].frees       = 0;
+      mem_stat[i].allocs_last = 0;
+    }
+    mem_heap_stat.peak        = mem_heap_stat.used;
+    mem_heap_stat.allocs      = 0;
+    mem_heap_stat.frees       = 0;
+    mem_heap_stat.allocs_last = 0;
+    mem_fallback = 0;
+    mem_rate_ms  = millis();
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "lvmem info \n");
+    cmdifPrintf( "lvmem reset \n");
+  }
+}
+
+#else /* Enable this file at the top */
+
+/* This dummy typedef exists purely to silence -Wpedantic. */
+typedef int keep_pedantic_happy;
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file lv_port_mem.h
+ *
+ */
+
+#if 1
+
+#ifndef LV_PORT_MEM_H
+#define LV_PORT_MEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+/*Included by lv_mem.c through LV_MEM_CUSTOM_INCLUDE, so it must not include lvgl.h*/
+#include <stdint.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Max. bytes taken from the unused end of the AXI SRAM (SRAM_D1)*/
+#define LV_PORT_MEM_SRAM_SIZE       (128U * 1024U)
+
+/*Bytes of the SDRAM arena used when the SRAM is full*/
+#define LV_PORT_MEM_SDRAM_SIZE      (1024U * 1024U)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Register the "lvmem" command. The arenas themselves are set up on the first allocation.
+ */
+void lv_port_mem_init(void);
+
+/**
+ * Allocate memory for LittlevGL (LV_MEM_CUSTOM_ALLOC).
+ * Small blocks come from size class slabs in SRAM, then in SDRAM;
+ * larger ones and overflow from the SDRAM heap.
+ * @param size size of the block in bytes
+ * @return pointer to the block (8 byte aligned) or NULL
+ */
+void * lv_port_mem_alloc(size_t size);
+
+/**
+ * Free a block allocated with `lv_port_mem_alloc` (LV_MEM_CUSTOM_FREE)
+ * @param p pointer to the block, NULL is ignored
+ */
+void lv_port_mem_free(void * p);
+
+/**********************
+ *      MACROS
+ **********************/
+
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_PORT_MEM_H*/
+
+#endif /*Disable/Enable content*/
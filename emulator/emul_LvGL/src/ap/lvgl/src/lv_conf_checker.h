@@ -66,6 +66,12 @@
 #define LV_DISP_DEF_REFR_PERIOD      30      /*[ms]*/
 #endif
 
+/* 1: With two screen sized buffers copy the refreshed areas to the other buffer after flushing
+ * 0: The display driver keeps the two buffers in sync*/
+#ifndef LV_DISP_TRUE_DOUBLE_BUF_SYNC
+#define LV_DISP_TRUE_DOUBLE_BUF_SYNC 1
+#endif
+
 /* Dot Per Inch: used to initialize default sizes.
  * E.g. a button with width = LV_DPI / 2 -> half inch wide
  * (Not so important, you can adjust it to modify default sizes and spaces)*/
@@ -186,6 +186,7 @@ void lv_disp_refr_task(lv_task_t * task)
             while(vdb->flushing)
                 ;
 
+#if LV_DISP_TRUE_DOUBLE_BUF_SYNC
             uint8_t * buf_act = (uint8_t *)vdb->buf_act;
             uint8_t * buf_ina = (uint8_t *)vdb->buf_act == vdb->buf1 ? vdb->buf2 : vdb->buf1;
 
@@ -204,6 +205,7 @@ void lv_disp_refr_task(lv_task_t * task)
                     }
                 }
             }
+#endif
         } /*End of true double buffer handling*/
 
         /*Clean up*/
@@ -0,0 +1,119 @@
+/*
+ * lv_bench_test.c
+ *
+ *  Host run of the LittlevGL benchmark (src/ap/lv_bench.c built with
+ *  LV_BENCH_HOST). Renders every scene with and without antialiasing on
+ *  the CPU and checks the final frames against bench_golden[][].
+ *
+ *  The checksums of the run are printed as a C initializer, so after an
+ *  intended rendering change bench_golden[][] can be refreshed from it.
+ *
+ *  Build and run from this directory :
+ *    gcc -O2 -w -DLV_BENCH_HOST -DLV_CONF_INCLUDE_SIMPLE -I. -I../src/ap \
+ *        -I../src/ap/lvgl -o lv_bench_test lv_bench_test.c \
+ *        ../src/ap/lv_bench.c $(find ../src/ap/lvgl/src -name "*.c") && ./lv_bench_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "lv_bench.h"
+#include "lvgl/porting/lv_port_mem.h"
+
+
+
+#define SCENE_MAX     16
+
+static uint32_t scene_sum[2][SCENE_MAX];
+static uint32_t scene_cnt[2];
+static int      run_aa;
+
+
+// lv_conf.h uses the port's allocator and millis(), plain ones do on a PC.
+//
+void *lv_port_mem_alloc(size_t size)
+{
+  return malloc(size);
+}
+
+void lv_port_mem_free(void *p)
+{
+  free(p);
+}
+
+uint32_t millis(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+// Prints the benchmark and takes the checksum from every scene line,
+// "name us/frame flush gpu checksum ok|DIFF".
+//
+static void benchOut(const char *fmt, ...)
+{
+  char line[256];
+  char name[32];
+  char result[8];
+  unsigned int us, flush, gpu, sum;
+  va_list args;
+
+
+  va_start(args, fmt);
+  vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+
+  fputs(line, stdout);
+
+  if (sscanf(line, "%31s %u %u %u %x %7s", name, &us, &flush, &gpu, &sum, result) == 6
+      && (strcmp(result, "ok") == 0 || strcmp(result, "DIFF") == 0)
+      && scene_cnt[run_aa] < SCENE_MAX)
+  {
+    scene_sum[run_aa][scene_cnt[run_aa]++] = sum;
+  }
+}
+
+
+int main(void)
+{
+  int fails = 0;
+  int aa;
+  uint32_t i;
+
+
+  lv_init();
+
+  for (aa=0; aa<2; aa++)
+  {
+    run_aa = aa;
+    printf("\nlv_bench cpu %s\n", aa ? "aa" : "noaa");
+    fails += lv_bench_run(benchOut, false, aa ? true : false);
+  }
+
+  printf("\nstatic const uint32_t bench_golden[2][BENCH_SCENE_CNT] =\n{\n");
+  for (aa=0; aa<2; aa++)
+  {
+    printf("  {");
+    for (i=0; i<scene_cnt[aa]; i++)
+    {
+      printf("%s0x%08X", i ? ", " : "", (unsigned int)scene_sum[aa][i]);
+    }
+    printf("},\n");
+  }
+  printf("};\n\n");
+
+  if (scene_cnt[0] == 0 || scene_cnt[0] != scene_cnt[1])
+  {
+    printf("no scene results\n");
+    fails++;
+  }
+
+  printf("%s\n", fails == 0 ? "lv_bench_test : OK" : "lv_bench_test : FAIL");
+
+  return fails == 0 ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+/*
+ * millis.h
+ *
+ *  Host stand-in for the SDK millis.h named by LV_TICK_CUSTOM_INCLUDE
+ *  in lv_conf.h, used by lv_bench_test.c.
+ */
+
+#ifndef TEST_MILLIS_H_
+#define TEST_MILLIS_H_
+
+#include <stdint.h>
+
+uint32_t millis(void);
+
+#endif /* TEST_MILLIS_H_ */
@@ -40,7 +40,7 @@ __attribute__((section(".tag"))) flash_tag_t fw_tag =
 
 extern "C"
 {
-void D_DoomMain (void);
+void I_Main (void);
 }
 
 static void threadEmul(void const *argument);
@@ -95,7 +95,7 @@ static void threadEmul(void const *argument)
   UNUSED(argument);
 
 
-  D_DoomMain();
+  I_Main();
 
 
   while(1)
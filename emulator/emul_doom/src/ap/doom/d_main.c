@@ -53,6 +53,7 @@
 #include "p_saveg.h"
 
 #include "i_endoom.h"
+#include "i_profile.h"
 #include "i_input.h"
 #include "i_joystick.h"
 #include "i_system.h"
@@ -476,12 +477,16 @@ void D_DoomLoop (void)
 
     while (1)
     {
+      I_ProfileFrame ();
+
       // frame syncronous IO operations
       I_StartFrame ();
 
       TryRunTics (); // will run at least one tic
 
+      PROF_BEGIN(PROF_SOUND);
       S_UpdateSounds (players[consoleplayer].mo);// move positional sounds
+      PROF_END();
 
       // Update display, next frame, with current state.
       if (screenvisible)
@@ -1248,6 +1253,8 @@ void D_DoomMain (void)
     DEH_printf("Z_Init: Init zone memory allocation daemon. \n");
     Z_Init ();
 
+    I_ProfileInit();
+
 
 #ifdef FEATURE_MULTIPLAYER
     //!
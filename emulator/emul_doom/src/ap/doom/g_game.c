@@ -38,6 +38,7 @@
 #include "i_system.h"
 #include "i_timer.h"
 #include "i_input.h"
+#include "i_profile.h"
 #include "i_video.h"
 
 #include "p_setup.h"
@@ -1006,7 +1007,9 @@ void G_Ticker (void)
     switch (gamestate) 
     { 
       case GS_LEVEL: 
+	PROF_BEGIN(PROF_TICKER);
 	P_Ticker (); 
+	PROF_END();
 	ST_Ticker (); 
 	AM_Ticker (); 
 	HU_Ticker ();            
@@ -2319,6 +2322,11 @@ void G_DoPlayDemo (void)
     precache = true; 
     starttime = I_GetTime (); 
 
+    if (timingdemo)
+    {
+        I_ProfileReset();
+    }
+
     usergame = false; 
     demoplayback = true; 
 } 
@@ -2339,6 +2347,7 @@ void G_TimeDemo (char* name)
 
     timingdemo = true; 
     singletics = true; 
+    profiling = true;
 
     defdemoname = name; 
     gameaction = ga_playdemo; 
@@ -2372,6 +2381,8 @@ boolean G_CheckDemoStatus (void)
         timingdemo = false;
         demoplayback = false;
 
+        I_ProfileReport(gametic, realtics);
+
 	I_Error ("timed %i gametics in %i realtics (%f fps)",
                  gametic, realtics, fps);
     } 
@@ -52,4 +52,31 @@ int main(int argc, char **argv)
 
     return 0;
 }
+#else
+
+// There is no command line on the device; arguments are taken from
+// an optional response file next to the WADs instead.
+
+#define RESPONSE_FILE FILES_DIR "/doom.rsp"
+
+static char *device_argv[] = { "doom", "@" RESPONSE_FILE, NULL };
+
+void I_Main(void)
+{
+    FILINFO fno;
+
+    myargc = 1;
+    myargv = device_argv;
+
+    if (f_stat(RESPONSE_FILE, &fno) == FR_OK)
+    {
+        myargc = 2;
+    }
+
+    M_FindResponseFile();
+
+    // start doom
+
+    D_DoomMain ();
+}
 #endif
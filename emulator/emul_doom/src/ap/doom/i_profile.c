@@ -0,0 +1,358 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-subsystem frame profiler.  Counts DWT cycles on the device
+//      and clock_gettime() nanoseconds on a host build.
+//
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef ORIGCODE
+#include <time.h>
+#endif
+
+#include "doomtype.h"
+#include "i_profile.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "z_zone.h"
+
+#define PROF_MAX_DEPTH  8
+
+typedef void (*profprint_t)(const char *fmt, ...);
+
+boolean profiling = false;
+
+static const char *prof_names[NUMPROFSECTIONS] =
+{
+    "other",
+    "R_RenderBSPNode",
+    "R_DrawPlanes",
+    "R_DrawMasked",
+    "colfunc",
+    "spanfunc",
+    "P_Ticker",
+    "S_UpdateSounds",
+    "I_FinishUpdate",
+};
+
+// What the table is printed from.  The "prof" command runs on the cmdif
+// thread, so it prints a copy taken in a critical section and leaves the
+// clearing to the next frame boundary.  The zone usage is taken on the
+// Doom thread as well, the block lists change under any other thread.
+
+typedef struct
+{
+    uint64_t total[NUMPROFSECTIONS];
+    uint32_t frames;
+    uint32_t frame_min;
+    uint32_t frame_max;
+    uint64_t frame_sum;
+    int gametics;
+    int realtics;
+    unsigned int zone_size[NUM_ZONES];
+    unsigned int zone_used[NUM_ZONES];
+    unsigned int zone_purgable[NUM_ZONES];
+} profstats_t;
+
+static uint32_t prof_last;
+static profsection_t prof_stack[PROF_MAX_DEPTH];
+static int prof_depth;
+
+static boolean prof_frame_started;
+static uint32_t prof_frame_start;
+
+static profstats_t prof;
+static volatile boolean prof_reset_pending;
+
+#ifdef ORIGCODE
+
+static inline uint32_t ProfileCounter(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t) (ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static uint32_t ProfileCountsPerUs(void)
+{
+    return 1000;
+}
+
+static void ProfileStartCounter(void)
+{
+}
+
+#else
+
+static inline uint32_t ProfileCounter(void)
+{
+    return DWT->CYCCNT;
+}
+
+static uint32_t ProfileCountsPerUs(void)
+{
+    return SystemCoreClock / 1000000;
+}
+
+static void ProfileStartCounter(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static void I_ProfileCmdif(void);
+
+#endif
+
+void I_ProfileInit(void)
+{
+    //!
+    // @category obscure
+    //
+    // Collect per-subsystem frame timings while playing.  They are
+    // reported at the end of a -timedemo and over the "prof" command.
+    //
+
+    profiling = M_CheckParm("-profile") > 0;
+
+    ProfileStartCounter();
+    I_ProfileReset();
+
+#ifndef ORIGCODE
+    if (cmdifIsInit() == false)
+    {
+        cmdifInit();
+    }
+    cmdifAdd("prof", I_ProfileCmdif);
+#endif
+}
+
+void I_ProfileReset(void)
+{
+    memset(&prof, 0, sizeof(prof));
+    prof.frame_min = UINT32_MAX;
+
+    prof_depth = 0;
+    prof_stack[0] = PROF_OTHER;
+    prof_last = ProfileCounter();
+
+    prof_frame_started = false;
+    prof_reset_pending = false;
+}
+
+void I_ProfileBegin(profsection_t section)
+{
+    uint32_t now = ProfileCounter();
+
+    prof.total[prof_stack[prof_depth]] += now - prof_last;
+    prof_last = now;
+
+    if (prof_depth < PROF_MAX_DEPTH - 1)
+    {
+        prof_stack[++prof_depth] = section;
+    }
+}
+
+void I_ProfileEnd(void)
+{
+    uint32_t now = ProfileCounter();
+
+    prof.total[prof_stack[prof_depth]] += now - prof_last;
+    prof_last = now;
+
+    if (prof_depth > 0)
+    {
+        --prof_depth;
+    }
+}
+
+void I_ProfileFrame(void)
+{
+    uint32_t now;
+    uint32_t frame;
+    int i;
+
+    // A reset from the "prof" command, done here between two frames.
+    if (prof_reset_pending)
+    {
+        I_ProfileReset();
+    }
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+        Z_ZoneUsage(i, &prof.zone_size[i], &prof.zone_used[i],
+                    &prof.zone_purgable[i]);
+    }
+
+    if (!profiling)
+    {
+        return;
+    }
+
+    now = ProfileCounter();
+
+    if (prof_frame_started)
+    {
+        frame = now - prof_frame_start;
+
+        if (frame < prof.frame_min)
+            prof.frame_min = frame;
+        if (frame > prof.frame_max)
+            prof.frame_max = frame;
+
+        prof.frame_sum += frame;
+        prof.frames++;
+    }
+
+    prof_frame_start = now;
+    prof_frame_started = true;
+}
+
+static void ProfilePrintf(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+static void PrintZones(profprint_t out, const profstats_t *stats)
+{
+    static const char *zone_names[NUM_ZONES] = { "main", "fast" };
+    int i;
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+        out("zone %-5s %7u KB, used %7u KB, purgable %7u KB\n",
+            zone_names[i], stats->zone_size[i] / 1024,
+            stats->zone_used[i] / 1024, stats->zone_purgable[i] / 1024);
+    }
+}
+
+static void PrintTable(profprint_t out, const profstats_t *stats)
+{
+    uint32_t per_us = ProfileCountsPerUs();
+    uint64_t sum = 0;
+    uint32_t share;
+    int i;
+
+    if (stats->realtics > 0)
+    {
+        out("timed %d gametics in %d realtics (%d.%d fps)\n",
+            stats->gametics, stats->realtics,
+            (stats->gametics * TICRATE) / stats->realtics,
+            ((stats->gametics * TICRATE * 10) / stats->realtics) % 10);
+    }
+
+    PrintZones(out, stats);
+
+    if (stats->frames == 0)
+    {
+        out("no frames profiled\n");
+        return;
+    }
+
+    out("frames %u, frame us min %u avg %u max %u\n",
+        (unsigned int) stats->frames,
+        (unsigned int) (stats->frame_min / per_us),
+        (unsigned int) (stats->frame_sum / stats->frames / per_us),
+        (unsigned int) (stats->frame_max / per_us));
+
+    for (i = 0; i < NUMPROFSECTIONS; ++i)
+    {
+        sum += stats->total[i];
+    }
+    if (sum == 0)
+    {
+        sum = 1;
+    }
+
+    out("%-16s %10s %10s %7s\n", "section", "total ms", "us/frame", "share");
+
+    for (i = 0; i < NUMPROFSECTIONS; ++i)
+    {
+        share = (uint32_t) (stats->total[i] * 1000 / sum);
+
+        out("%-16s %10u %10u %4u.%u%%\n",
+            prof_names[i],
+            (unsigned int) (stats->total[i] / per_us / 1000),
+            (unsigned int) (stats->total[i] / stats->frames / per_us),
+            (unsigned int) (share / 10), (unsigned int) (share % 10));
+    }
+}
+
+void I_ProfileReport(int gametics, int realtics)
+{
+    // Close the partial frame so the table adds up.
+    I_ProfileFrame();
+
+    prof.gametics = gametics;
+    prof.realtics = realtics;
+
+    PrintTable(ProfilePrintf, &prof);
+}
+
+#ifndef ORIGCODE
+
+static void I_ProfileCmdif(void)
+{
+    bool ret = true;
+    profstats_t stats;
+
+    if (cmdifGetParamCnt() == 1 && cmdifHasString("info", 0) == true)
+    {
+        taskENTER_CRITICAL();
+        stats = prof;
+        taskEXIT_CRITICAL();
+
+        cmdifPrintf("profiling    : %d\n", profiling);
+        PrintTable(cmdifPrintf, &stats);
+    }
+    else if (cmdifGetParamCnt() == 1 && cmdifHasString("on", 0) == true)
+    {
+        prof_reset_pending = true;
+        profiling = true;
+    }
+    else if (cmdifGetParamCnt() == 1 && cmdifHasString("off", 0) == true)
+    {
+        profiling = false;
+    }
+    else if (cmdifGetParamCnt() == 1 && cmdifHasString("reset", 0) == true)
+    {
+        prof_reset_pending = true;
+    }
+    else
+    {
+        ret = false;
+    }
+
+    if (ret == false)
+    {
+        cmdifPrintf( "prof info \n");
+        cmdifPrintf( "prof on/off \n");
+        cmdifPrintf( "prof reset \n");
+    }
+}
+
+#endif
+
@@ -0,0 +1,64 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-subsystem frame profiler, used by -timedemo and -profile.
+//
+
+
+#ifndef __I_PROFILE__
+#define __I_PROFILE__
+
+#include "doomtype.h"
+
+// Sections are exclusive: time spent in a nested section (eg. the
+// column drawers called from R_RenderBSPNode) is only charged to the
+// innermost one.  Everything outside a section is PROF_OTHER.
+
+typedef enum
+{
+    PROF_OTHER,
+    PROF_BSP,
+    PROF_PLANES,
+    PROF_MASKED,
+    PROF_COLUMN,
+    PROF_SPAN,
+    PROF_TICKER,
+    PROF_SOUND,
+    PROF_PRESENT,
+    NUMPROFSECTIONS
+} profsection_t;
+
+extern boolean profiling;
+
+// Read -profile and register the "prof" cmdif command.
+void I_ProfileInit(void);
+
+// Clear all counters; called when a timedemo starts playing.
+void I_ProfileReset(void);
+
+void I_ProfileBegin(profsection_t section);
+void I_ProfileEnd(void);
+
+// Called once per pass through D_DoomLoop.
+void I_ProfileFrame(void);
+
+// Print the table of frame times and per-section shares.
+void I_ProfileReport(int gametics, int realtics);
+
+#define PROF_BEGIN(section) do { if (profiling) I_ProfileBegin(section); } while (0)
+#define PROF_END()          do { if (profiling) I_ProfileEnd(); } while (0)
+
+#endif
+
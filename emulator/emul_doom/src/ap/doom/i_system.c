@@ -167,6 +167,32 @@ byte *I_ZoneBase (int *size)
     return zonemem;
 }
 
+//
+// I_FastZoneBase
+// The fast zone takes whatever AXI SRAM is left after .data and
+// .sram_d1; the firmware image runs from SDRAM, so the stack and
+// .bss live there and the rest of SRAM_D1 is unused.
+//
+byte *I_FastZoneBase (int *size)
+{
+#ifdef ORIGCODE
+    *size = 0;
+
+    return NULL;
+#else
+    extern uint32_t _esram_d1;
+    byte *zonemem;
+
+    zonemem = (byte *) (((uintptr_t) &_esram_d1 + 31) & ~31);
+    *size = (SRAM_D1_ADDR_START + SRAM_D1_SIZE) - (uintptr_t) zonemem;
+
+    printf("fast zone memory: %p, %x allocated for zone\n",
+           zonemem, *size);
+
+    return zonemem;
+#endif
+}
+
 void I_PrintBanner(const char *msg)
 {
     int i;
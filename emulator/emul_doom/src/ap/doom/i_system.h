@@ -34,6 +34,9 @@ void I_Init (void);
 // for the zone management.
 byte*	I_ZoneBase (int *size);
 
+// Called by Z_Init; returns NULL if there is no fast memory zone.
+byte*	I_FastZoneBase (int *size);
+
 boolean I_ConsoleStdout(void);
 
 
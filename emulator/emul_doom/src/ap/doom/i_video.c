@@ -36,6 +36,7 @@
 #include "doomtype.h"
 #include "i_input.h"
 #include "i_joystick.h"
+#include "i_profile.h"
 #include "i_system.h"
 #include "i_timer.h"
 #include "i_video.h"
@@ -112,7 +113,7 @@ int vanilla_keyboard_mapping = true;
 
 // Palette converted to RGB565
 
-static uint16_t rgb565_palette[256] __attribute__((section(".RamBuffer")));
+static uint16_t rgb565_palette[256] __attribute__((section(".sram_d1")));
 
 
 // display has been set up?
@@ -780,27 +781,168 @@ void drvLcdCopyLineBuffer(uint16_t x_pos, uint16_t y_pos, uint8_t *p_dst, uint32
 }
 #endif
 
-uint8_t fullscreen_buffer[400*240];
+// Fused present path
+//
+// The 320x200 frame only needs its rows stretched to fill the 320x240 LCD,
+// so the scale is a row map (every 5th source row is drawn twice) and the
+// palette lookup is done on the way out, with no intermediate buffer.
+//
+// PRESENT_USE_DMA2D selects the DMA2D L8 -> RGB565 CLUT conversion instead
+// of the CPU lookup in rgb565_palette.
+
+#define PRESENT_USE_DMA2D     0
+
+
+static uint8_t  present_row_map[HW_LCD_HEIGHT];
+static boolean  present_row_map_init = false;
+static volatile boolean present_palette_dirty = true;
+
+#if PRESENT_USE_DMA2D == 1
+static uint32_t present_clut[256] __attribute__((aligned(32)));
+#endif
 
 
-static void resizePixels(uint8_t *p_in, uint8_t *p_out,int w1,int h1,int w2,int h2)
+static void presentInitRowMap(void)
 {
-  // EDIT: added +1 to account for an early rounding problem
-  int x_ratio = (int)((w1<<16)/w2) +1;
-  int y_ratio = (int)((h1<<16)/h2) +1;
-  int x2, y2 ;
+  for (int y=0; y<HW_LCD_HEIGHT; y++)
+  {
+    present_row_map[y] = (y * SCREENHEIGHT) / HW_LCD_HEIGHT;
+  }
+  present_row_map_init = true;
+}
 
-  for (int i=0;i<h2;i++)
+#if PRESENT_USE_DMA2D == 1
+static void presentUpdatePalette(void)
+{
+  for (int i=0; i<256; i++)
   {
-    for (int j=0;j<w2;j++)
+    uint16_t c = rgb565_palette[i];
+
+    present_clut[i] = 0xFF000000
+                    | ((GFX_RGB565_R(c) << 3) << 16)
+                    | ((GFX_RGB565_G(c) << 2) << 8)
+                    | ((GFX_RGB565_B(c) << 3) << 0);
+  }
+  SCB_CleanDCache_by_Addr((uint32_t *)present_clut, sizeof(present_clut));
+
+  // load the CLUT, ARGB8888, 256 entries
+  DMA2D->FGCMAR  = (uint32_t)present_clut;
+  DMA2D->FGPFCCR = LTDC_PIXEL_FORMAT_L8 | (255 << 8);
+  DMA2D->FGPFCCR |= DMA2D_FGPFCCR_START;
+
+  while (DMA2D->FGPFCCR & DMA2D_FGPFCCR_START)
+  {
+  }
+}
+
+static void presentRows(const byte *p_src, uint16_t *p_dst, uint32_t lines)
+{
+  DMA2D->CR      = 0x00010000UL;        // memory to memory with PFC
+  DMA2D->FGMAR   = (uint32_t)p_src;
+  DMA2D->OMAR    = (uint32_t)p_dst;
+  DMA2D->FGOR    = 0;
+  DMA2D->OOR     = HW_LCD_WIDTH - SCREENWIDTH;
+  DMA2D->FGPFCCR = LTDC_PIXEL_FORMAT_L8 | (255 << 8);
+  DMA2D->OPFCCR  = LTDC_PIXEL_FORMAT_RGB565;
+  DMA2D->NLR     = (uint32_t)(SCREENWIDTH << 16) | lines;
+
+  DMA2D->CR     |= DMA2D_CR_START;
+
+  while (DMA2D->CR & DMA2D_CR_START)
+  {
+  }
+}
+
+static void presentFrame(uint16_t *p_buf, int y_offset, boolean stretch)
+{
+  SCB_CleanDCache_by_Addr((uint32_t *)I_VideoBuffer, SCREENWIDTH*SCREENHEIGHT);
+
+  if (stretch == false)
+  {
+    presentRows(I_VideoBuffer, &p_buf[y_offset * HW_LCD_WIDTH], SCREENHEIGHT);
+    return;
+  }
+
+  // convert runs of consecutive source rows in one transfer and
+  // emit a repeated row as its own single line transfer
+  int y = 0;
+
+  while (y < HW_LCD_HEIGHT)
+  {
+    int lines = 1;
+
+    while (y + lines < HW_LCD_HEIGHT
+           && present_row_map[y + lines] == present_row_map[y + lines - 1] + 1)
     {
-      x2 = ((j*x_ratio)>>16) ;
-      y2 = ((i*y_ratio)>>16) ;
-      p_out[(i*w2)+j] = p_in[(y2*w1)+x2] ;
+      lines++;
     }
+    presentRows(&I_VideoBuffer[present_row_map[y] * SCREENWIDTH],
+                &p_buf[y * HW_LCD_WIDTH],
+                lines);
+    y += lines;
+  }
+}
+#else
+// Four indices per load, two RGB565 pixels per store. The palette is the
+// 512 byte rgb565_palette itself, nothing to rebuild when it changes.
+static void presentRow(const byte *p_src, uint16_t *p_dst)
+{
+  const uint32_t *p_in  = (const uint32_t *)p_src;
+  const uint16_t *p_pal = rgb565_palette;
+  uint32_t       *p_out = (uint32_t *)p_dst;
+
+  for (int x=0; x<SCREENWIDTH/4; x++)
+  {
+    uint32_t index = p_in[x];
+
+    p_out[x*2 + 0] = p_pal[(index >>  0) & 0xFF] | ((uint32_t)p_pal[(index >>  8) & 0xFF] << 16);
+    p_out[x*2 + 1] = p_pal[(index >> 16) & 0xFF] | ((uint32_t)p_pal[(index >> 24) & 0xFF] << 16);
   }
 }
 
+static void presentFrame(uint16_t *p_buf, int y_offset, boolean stretch)
+{
+  if (stretch == false)
+  {
+    for (int y=0; y<SCREENHEIGHT; y++)
+    {
+      presentRow(&I_VideoBuffer[y * SCREENWIDTH], &p_buf[(y+y_offset) * HW_LCD_WIDTH]);
+    }
+    return;
+  }
+
+  for (int y=0; y<HW_LCD_HEIGHT; y++)
+  {
+    uint16_t *p_dst = &p_buf[y * HW_LCD_WIDTH];
+
+    if (y > 0 && present_row_map[y] == present_row_map[y-1])
+    {
+      // repeated row, copy the already converted line
+      memcpy(p_dst, p_dst - HW_LCD_WIDTH, SCREENWIDTH * sizeof(uint16_t));
+    }
+    else
+    {
+      presentRow(&I_VideoBuffer[present_row_map[y] * SCREENWIDTH], p_dst);
+    }
+  }
+}
+#endif
+
+static void presentPrepare(void)
+{
+  if (present_row_map_init == false)
+  {
+    presentInitRowMap();
+  }
+#if PRESENT_USE_DMA2D == 1
+  if (present_palette_dirty == true)
+  {
+    present_palette_dirty = false;
+    presentUpdatePalette();
+  }
+#endif
+}
+
 /*
 static void resizeBilinearPixels(uint8_t *p_in, uint8_t *p_out, int w, int h, int w2, int h2)
 {
@@ -843,73 +985,29 @@ static void resizeBilinearPixels(uint8_t *p_in, uint8_t *p_out, int w, int h, in
 
 static void drawScreenNormal(void)
 {
-  int x, y;
-  byte index;
-  uint16_t rgb565;
-
   if (lcdDrawAvailable() == false)
   {
     return;
   }
 
-  int x_offset;
   int y_offset;
 
-  x_offset = (320 - SCREENWIDTH)/2;
   y_offset = (240 - SCREENHEIGHT)/2;
 
-
-  uint16_t *p_buf = lcdGetFrameBuffer();
-
-
-  for (y = 0; y < SCREENHEIGHT; y++)
-  {
-    for (x = 0; x < SCREENWIDTH; x++)
-    {
-      index  = I_VideoBuffer[y * SCREENWIDTH + x];
-      rgb565 = rgb565_palette[index];
-
-
-      p_buf[(y+y_offset) * HW_LCD_WIDTH + x] = rgb565;
-    }
-  }
+  presentPrepare();
+  presentFrame(lcdGetFrameBuffer(), y_offset, false);
   lcdRequestDraw();
 }
 
 static void drawScreenFull(void)
 {
-  int x, y;
-  byte index;
-  uint16_t rgb565;
-
   if (lcdDrawAvailable() == false)
   {
     return;
   }
 
-  int x_offset;
-  int y_offset;
-
-  x_offset = 0;
-  y_offset = 0;
-
-
-  resizePixels(I_VideoBuffer, fullscreen_buffer, 320, 200, HW_LCD_WIDTH, HW_LCD_HEIGHT);
-
-
-  uint16_t *p_buf = lcdGetFrameBuffer();
-
-
-  for (y = 0; y < HW_LCD_HEIGHT; y++)
-  {
-    for (x = 0; x < HW_LCD_WIDTH; x++)
-    {
-      index  = fullscreen_buffer[y * HW_LCD_WIDTH + x];
-      rgb565 = rgb565_palette[index];
-
-      p_buf[(y+y_offset) * HW_LCD_WIDTH + x] = rgb565;
-    }
-  }
+  presentPrepare();
+  presentFrame(lcdGetFrameBuffer(), 0, true);
   lcdRequestDraw();
 }
 
@@ -1031,6 +1129,11 @@ void I_FinishUpdate (void)
     V_RestoreDiskBackground();
 #else
 
+    if (noblit)
+        return;
+
+    PROF_BEGIN(PROF_PRESENT);
+
 #if 0
     int x, y;
     byte index;
@@ -1089,6 +1192,7 @@ void I_FinishUpdate (void)
     pre_time = millis();
 
 #endif
+    PROF_END();
 #endif
 }
 
@@ -1136,6 +1240,9 @@ void I_SetPalette (byte *doompalette)
 
       doompalette += 3;
     }
+
+    // the DMA2D CLUT is reloaded on the next frame
+    present_palette_dirty = true;
 #endif
 }
 
@@ -1399,6 +1506,15 @@ void I_GraphicsCheckCommandLine(void)
     {
         SetScaleFactor(3);
     }
+#else
+    //!
+    // @category video
+    // @vanilla
+    //
+    // Disable blitting the screen.
+    //
+
+    noblit = M_CheckParm ("-noblit");
 #endif
 }
 
@@ -1771,8 +1887,9 @@ void I_InitGraphics(void)
     I_AtExit(I_ShutdownGraphics, true);
 #endif
 
-    //I_VideoBuffer = (byte*)Z_Malloc (SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
-    I_VideoBuffer = (byte*)malloc (SCREENWIDTH * SCREENHEIGHT);
+    // Every column and span drawer writes here; keep it in the fast
+    // zone.  It is AXI SRAM, so DMA2D can still read it for present.
+    I_VideoBuffer = (byte*)Z_MallocHint (SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL, ZONE_FAST);
 
     printf("I_VideoBuffer : %X\n", (int)I_VideoBuffer);
     initialized = true;
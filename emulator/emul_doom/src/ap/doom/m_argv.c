@@ -76,6 +76,10 @@ static void LoadResponseFile(int argv_index)
 {
 #ifdef ORIGCODE
     FILE *handle;
+#else
+    FIL handle;
+    UINT count;
+#endif
     int size;
     char *infile;
     char *file;
@@ -86,6 +90,7 @@ static void LoadResponseFile(int argv_index)
 
     response_filename = myargv[argv_index] + 1;
 
+#ifdef ORIGCODE
     // Read the response file into memory
     handle = fopen(response_filename, "rb");
 
@@ -121,6 +126,29 @@ static void LoadResponseFile(int argv_index)
     }
 
     fclose(handle);
+#else
+    // Read the response file into memory
+    if (f_open(&handle, response_filename, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    {
+        printf ("\nNo such response file!");
+        return;
+    }
+
+    printf("Found response file %s!\n", response_filename);
+
+    size = M_FileLength(&handle);
+
+    // Allocate one byte extra, as above.
+
+    file = malloc(size + 1);
+
+    if (f_read(&handle, file, size, &count) != FR_OK || count != size)
+    {
+        I_Error("Failed to read full contents of '%s'", response_filename);
+    }
+
+    f_close(&handle);
+#endif
 
     // Create new arguments list array
 
@@ -223,7 +251,6 @@ static void LoadResponseFile(int argv_index)
         printf("'%s'\n", myargv[k]);
     }
 #endif
-#endif
 }
 
 //
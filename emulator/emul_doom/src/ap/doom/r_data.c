@@ -239,9 +239,10 @@ void R_GenerateComposite (int texnum)
 	
     texture = textures[texnum];
 
-    block = Z_Malloc (texturecompositesize[texnum],
-		      PU_STATIC, 
-		      &texturecomposite[texnum]);	
+    block = Z_MallocHint (texturecompositesize[texnum],
+			  PU_STATIC, 
+			  &texturecomposite[texnum],
+			  ZONE_FAST);	
 
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
@@ -689,7 +690,11 @@ void R_InitColormaps (void)
     // Load in the light tables, 
     //  256 byte align tables.
     lump = W_GetNumForName(DEH_String("COLORMAP"));
-    colormaps = W_CacheLumpNum(lump, PU_STATIC);
+
+    // Copy rather than cache: every drawn pixel goes through these
+    // tables, so they live in the fast zone instead of the WAD.
+    colormaps = Z_MallocHint(W_LumpLength(lump), PU_STATIC, NULL, ZONE_FAST);
+    W_ReadLump(lump, colormaps);
 }
 
 
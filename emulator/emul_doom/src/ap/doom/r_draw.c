@@ -60,8 +60,8 @@ int		scaledviewwidth;
 int		viewheight;
 int		viewwindowx;
 int		viewwindowy; 
-pixel_t*		ylookup[MAXHEIGHT];
-int		columnofs[MAXWIDTH]; 
+pixel_t**		ylookup;
+int*		columnofs;
 
 // Color tables for different players,
 //  translate a limited part to another
@@ -780,6 +780,14 @@ R_InitBuffer
 { 
     int		i; 
 
+    if (ylookup == NULL)
+    {
+        ylookup = Z_MallocHint(MAXHEIGHT * sizeof(*ylookup),
+                               PU_STATIC, NULL, ZONE_FAST);
+        columnofs = Z_MallocHint(MAXWIDTH * sizeof(*columnofs),
+                                 PU_STATIC, NULL, ZONE_FAST);
+    }
+
     // Handle resize,
     //  e.g. smaller view windows
     //  with border and/or status bar.
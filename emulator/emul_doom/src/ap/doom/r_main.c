@@ -28,6 +28,7 @@
 
 #include "doomdef.h"
 #include "d_loop.h"
+#include "i_profile.h"
 
 #include "m_bbox.h"
 #include "m_menu.h"
@@ -876,17 +877,23 @@ void R_RenderPlayerView (player_t* player)
     NetUpdate ();
 
     // The head node is the last node output.
+    PROF_BEGIN(PROF_BSP);
     R_RenderBSPNode (numnodes-1);
+    PROF_END();
     
     // Check for new console commands.
     NetUpdate ();
     
+    PROF_BEGIN(PROF_PLANES);
     R_DrawPlanes ();
+    PROF_END();
     
     // Check for new console commands.
     NetUpdate ();
     
+    PROF_BEGIN(PROF_MASKED);
     R_DrawMasked ();
+    PROF_END();
 
     // Check for new console commands.
     NetUpdate ();
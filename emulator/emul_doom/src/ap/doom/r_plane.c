@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "i_profile.h"
 #include "i_system.h"
 #include "z_zone.h"
 #include "w_wad.h"
@@ -43,14 +44,14 @@ planefunction_t		ceilingfunc;
 
 // Here comes the obnoxious "visplane".
 #define MAXVISPLANES	128
-visplane_t		visplanes[MAXVISPLANES];
+visplane_t*		visplanes;
 visplane_t*		lastvisplane;
 visplane_t*		floorplane;
 visplane_t*		ceilingplane;
 
 // ?
 #define MAXOPENINGS	SCREENWIDTH*64
-short			openings[MAXOPENINGS];
+short*			openings;
 short*			lastopening;
 
 
@@ -93,7 +94,41 @@ fixed_t			cachedystep[SCREENHEIGHT];
 //
 void R_InitPlanes (void)
 {
-  // Doh!
+    // The per-frame render arrays go in the fast zone.
+    drawsegs = Z_MallocHint(MAXDRAWSEGS * sizeof(*drawsegs),
+                            PU_STATIC, NULL, ZONE_FAST);
+    visplanes = Z_MallocHint(MAXVISPLANES * sizeof(*visplanes),
+                             PU_STATIC, NULL, ZONE_FAST);
+    openings = Z_MallocHint(MAXOPENINGS * sizeof(*openings),
+                            PU_STATIC, NULL, ZONE_FAST);
+}
+
+
+//
+// R_GetFlat
+// Flats are copied into the fast zone as PU_CACHE blocks, so the
+// zone purges the least recently allocated ones when it fills up.
+//
+static byte **flatcache;
+
+static byte *R_GetFlat (int flatnum)
+{
+    if (flatcache == NULL)
+    {
+        flatcache = Z_Malloc(numflats * sizeof(*flatcache), PU_STATIC, NULL);
+        memset(flatcache, 0, numflats * sizeof(*flatcache));
+    }
+
+    if (flatcache[flatnum] == NULL)
+    {
+        int lumpnum = firstflat + flatnum;
+
+        Z_MallocHint(W_LumpLength(lumpnum), PU_CACHE,
+                     &flatcache[flatnum], ZONE_FAST);
+        W_ReadLump(lumpnum, flatcache[flatnum]);
+    }
+
+    return flatcache[flatnum];
 }
 
 
@@ -167,7 +202,9 @@ R_MapPlane
     ds_x2 = x2;
 
     // high or low detail
-    spanfunc ();	
+    PROF_BEGIN(PROF_SPAN);
+    spanfunc ();
+    PROF_END();
 }
 
 
@@ -366,7 +403,6 @@ void R_DrawPlanes (void)
     int			x;
     int			stop;
     int			angle;
-    int                 lumpnum;
 				
 #ifdef RANGECHECK
     if (ds_p - drawsegs > MAXDRAWSEGS)
@@ -409,15 +445,16 @@ void R_DrawPlanes (void)
 		    angle = (viewangle + xtoviewangle[x])>>ANGLETOSKYSHIFT;
 		    dc_x = x;
 		    dc_source = R_GetColumn(skytexture, angle);
+		    PROF_BEGIN(PROF_COLUMN);
 		    colfunc ();
+		    PROF_END();
 		}
 	    }
 	    continue;
 	}
 	
 	// regular flat
-        lumpnum = firstflat + flattranslation[pl->picnum];
-	ds_source = W_CacheLumpNum(lumpnum, PU_STATIC);
+	ds_source = R_GetFlat(flattranslation[pl->picnum]);
 	
 	planeheight = abs(pl->height-viewz);
 	light = (pl->lightlevel >> LIGHTSEGSHIFT)+extralight;
@@ -442,7 +479,5 @@ void R_DrawPlanes (void)
 			pl->top[x],
 			pl->bottom[x]);
 	}
-	
-        W_ReleaseLumpNum(lumpnum);
     }
 }
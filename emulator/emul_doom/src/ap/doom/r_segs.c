@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "i_profile.h"
 #include "i_system.h"
 
 #include "doomdef.h"
@@ -281,7 +282,9 @@ void R_RenderSegLoop (void)
 	    dc_yh = yh;
 	    dc_texturemid = rw_midtexturemid;
 	    dc_source = R_GetColumn(midtexture,texturecolumn);
+	    PROF_BEGIN(PROF_COLUMN);
 	    colfunc ();
+	    PROF_END();
 	    ceilingclip[rw_x] = viewheight;
 	    floorclip[rw_x] = -1;
 	}
@@ -303,7 +306,9 @@ void R_RenderSegLoop (void)
 		    dc_yh = mid;
 		    dc_texturemid = rw_toptexturemid;
 		    dc_source = R_GetColumn(toptexture,texturecolumn);
+		    PROF_BEGIN(PROF_COLUMN);
 		    colfunc ();
+		    PROF_END();
 		    ceilingclip[rw_x] = mid;
 		}
 		else
@@ -333,7 +338,9 @@ void R_RenderSegLoop (void)
 		    dc_texturemid = rw_bottomtexturemid;
 		    dc_source = R_GetColumn(bottomtexture,
 					    texturecolumn);
+		    PROF_BEGIN(PROF_COLUMN);
 		    colfunc ();
+		    PROF_END();
 		    floorclip[rw_x] = mid;
 		}
 		else
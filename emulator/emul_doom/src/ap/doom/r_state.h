@@ -50,6 +50,7 @@ extern int		scaledviewwidth;
 extern int		viewheight;
 
 extern int		firstflat;
+extern int		numflats;
 
 // for global animation
 extern int*		flattranslation;	
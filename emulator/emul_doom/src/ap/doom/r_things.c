@@ -27,6 +27,7 @@
 #include "doomdef.h"
 
 #include "i_swap.h"
+#include "i_profile.h"
 #include "i_system.h"
 #include "z_zone.h"
 #include "w_wad.h"
@@ -371,7 +372,9 @@ void R_DrawMaskedColumn (column_t* column)
 
 	    // Drawn by either R_DrawColumn
 	    //  or (SHADOW) R_DrawFuzzColumn.
-	    colfunc ();	
+	    PROF_BEGIN(PROF_COLUMN);
+	    colfunc ();
+	    PROF_END();
 	}
 	column = (column_t *)(  (byte *)column + column->length + 4);
     }
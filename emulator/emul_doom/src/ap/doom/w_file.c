@@ -27,6 +27,10 @@
 
 extern wad_file_class_t stdc_wad_file;
 
+#ifndef ORIGCODE
+extern wad_file_class_t qspi_wad_file;
+#endif
+
 #ifdef _WIN32
 extern wad_file_class_t win32_wad_file;
 #endif
@@ -42,6 +46,9 @@ static wad_file_class_t *wad_file_classes[] =
 #endif
 #ifdef HAVE_MMAP
     &posix_wad_file,
+#endif
+#ifndef ORIGCODE
+    &qspi_wad_file,
 #endif
     &stdc_wad_file,
 };
@@ -58,10 +65,26 @@ wad_file_t *W_OpenFile(char *path)
     // directly into memory.
     //
 
+#ifdef ORIGCODE
     if (!M_CheckParm("-mmap"))
     {
         return stdc_wad_file.OpenFile(path);
     }
+#else
+    // On the device WADs are mapped from QSPI by default.
+
+    //!
+    // @category obscure
+    //
+    // Read WAD files from the SD card instead of mapping them
+    // from QSPI flash.
+    //
+
+    if (M_CheckParm("-nomap"))
+    {
+        return stdc_wad_file.OpenFile(path);
+    }
+#endif
 
     // Try all classes in order until we find one that works
 
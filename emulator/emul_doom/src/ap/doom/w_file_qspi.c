@@ -0,0 +1,339 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	WAD I/O functions for a WAD mirrored into memory-mapped QSPI
+//	flash.  The first time a WAD is opened it is copied from the SD
+//	card into the QSPI data region; afterwards lumps are returned as
+//	pointers straight into the mapped flash and W_CacheLumpNum()
+//	never copies.  If the flash is unusable the whole WAD is loaded
+//	into SDRAM instead, which is still mapped as far as w_wad.c is
+//	concerned.
+//
+
+#include <stdio.h>
+
+#include "m_argv.h"
+#include "m_misc.h"
+#include "sha1.h"
+#include "w_file.h"
+#include "z_zone.h"
+
+#ifndef ORIGCODE
+
+#define QSPI_WAD_MAGIC      0x44415751      // "QWAD"
+#define QSPI_WAD_VERSION    1
+#define QSPI_WAD_HDR_SIZE   4096
+#define QSPI_WAD_ADDR       QSPI_DATA_ADDR
+#define QSPI_WAD_MAX        (QSPI_DATA_SIZE - QSPI_WAD_HDR_SIZE)
+#define QSPI_WAD_CHUNK      (32*1024)
+
+typedef struct
+{
+    uint32_t      magic;
+    uint32_t      version;
+    uint32_t      length;
+    uint16_t      fdate;
+    uint16_t      ftime;
+    char          path[64];
+    sha1_digest_t digest;
+} qspi_wad_header_t;
+
+typedef struct
+{
+    wad_file_t wad;
+    byte      *sdram_copy;
+} qspi_wad_file_t;
+
+extern wad_file_class_t qspi_wad_file;
+
+// There is a single QSPI slot; once it backs an open WAD any further
+// WADs (PWADs) are left to the stdc class.
+
+static boolean qspi_slot_in_use = false;
+
+static const qspi_wad_header_t *QSPI_Header(void)
+{
+    return (const qspi_wad_header_t *) (QSPI_ADDR_START + QSPI_WAD_ADDR);
+}
+
+static byte *QSPI_Image(void)
+{
+    return (byte *) (QSPI_ADDR_START + QSPI_WAD_ADDR + QSPI_WAD_HDR_SIZE);
+}
+
+// Cheap check: the mirrored image belongs to this file if the name,
+// size and timestamp recorded when it was installed still match.
+
+static boolean QSPI_HeaderMatches(const qspi_wad_header_t *hdr,
+                                  char *path, FILINFO *fno)
+{
+    return hdr->magic == QSPI_WAD_MAGIC
+        && hdr->version == QSPI_WAD_VERSION
+        && hdr->length == fno->fsize
+        && hdr->fdate == fno->fdate
+        && hdr->ftime == fno->ftime
+        && strncmp(hdr->path, path, sizeof(hdr->path)) == 0;
+}
+
+static boolean QSPI_VerifyImage(const qspi_wad_header_t *hdr)
+{
+    sha1_context_t sha1;
+    sha1_digest_t digest;
+
+    SHA1_Init(&sha1);
+    SHA1_Update(&sha1, QSPI_Image(), hdr->length);
+    SHA1_Final(digest, &sha1);
+
+    return memcmp(digest, hdr->digest, sizeof(sha1_digest_t)) == 0;
+}
+
+// Copy the WAD from the SD card into QSPI.  The header is written
+// last, so an interrupted install is never mistaken for a valid one.
+
+static boolean QSPI_Install(FIL *file, char *path, FILINFO *fno)
+{
+    qspi_wad_header_t hdr;
+    sha1_context_t sha1;
+    byte *buf;
+    uint32_t addr;
+    uint32_t pre_time;
+    UINT count;
+    boolean ret = false;
+
+    buf = malloc(QSPI_WAD_CHUNK);
+    if (buf == NULL)
+    {
+        return false;
+    }
+
+    printf("W_QSPI: installing %s (%u bytes) to QSPI\n",
+           path, (unsigned int) fno->fsize);
+    pre_time = millis();
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic   = QSPI_WAD_MAGIC;
+    hdr.version = QSPI_WAD_VERSION;
+    hdr.length  = fno->fsize;
+    hdr.fdate   = fno->fdate;
+    hdr.ftime   = fno->ftime;
+    M_StringCopy(hdr.path, path, sizeof(hdr.path));
+
+    SHA1_Init(&sha1);
+
+    // qspiInit() drops the controller out of memory-mapped mode; it
+    // must be re-enabled before anything touches the 0x90000000 window.
+
+    if (!qspiInit()
+     || !qspiErase(QSPI_WAD_ADDR, QSPI_WAD_HDR_SIZE + hdr.length))
+    {
+        goto done;
+    }
+
+    addr = QSPI_WAD_ADDR + QSPI_WAD_HDR_SIZE;
+    f_lseek(file, 0);
+
+    while (addr < QSPI_WAD_ADDR + QSPI_WAD_HDR_SIZE + hdr.length)
+    {
+        if (f_read(file, buf, QSPI_WAD_CHUNK, &count) != FR_OK || count == 0)
+        {
+            goto done;
+        }
+
+        SHA1_Update(&sha1, buf, count);
+
+        if (!qspiWrite(addr, buf, count))
+        {
+            goto done;
+        }
+        addr += count;
+    }
+
+    SHA1_Final(hdr.digest, &sha1);
+
+    if (!qspiEnableMemoryMappedMode())
+    {
+        goto done;
+    }
+    SCB_InvalidateDCache();
+
+    if (!QSPI_VerifyImage(&hdr))
+    {
+        goto done;
+    }
+
+    if (!qspiInit()
+     || !qspiWrite(QSPI_WAD_ADDR, (uint8_t *) &hdr, sizeof(hdr)))
+    {
+        goto done;
+    }
+
+    ret = true;
+    printf("W_QSPI: installed in %u ms\n",
+           (unsigned int) (millis() - pre_time));
+
+done:
+    if (!qspiEnableMemoryMappedMode())
+    {
+        ret = false;
+    }
+    // Lines of the old image may still sit in the D-cache.
+    SCB_InvalidateDCache();
+    free(buf);
+
+    return ret;
+}
+
+// Fallback when the QSPI mirror can not be used: read the whole WAD
+// into SDRAM.
+
+static byte *QSPI_LoadToSdram(FIL *file, uint32_t length)
+{
+    byte *buf;
+    UINT count;
+
+    buf = malloc(length);
+    if (buf == NULL)
+    {
+        return NULL;
+    }
+
+    f_lseek(file, 0);
+
+    if (f_read(file, buf, length, &count) != FR_OK || count != length)
+    {
+        free(buf);
+        return NULL;
+    }
+
+    return buf;
+}
+
+static wad_file_t *W_QSPI_OpenFile(char *path)
+{
+    qspi_wad_file_t *result;
+    const qspi_wad_header_t *hdr;
+    FILINFO fno;
+    FIL file;
+    byte *mapped = NULL;
+    byte *sdram_copy = NULL;
+
+    if (qspi_slot_in_use || f_stat(path, &fno) != FR_OK)
+    {
+        return NULL;
+    }
+
+    hdr = QSPI_Header();
+
+    if (fno.fsize <= QSPI_WAD_MAX && QSPI_HeaderMatches(hdr, path, &fno))
+    {
+        //!
+        // @category obscure
+        //
+        // Re-hash the QSPI copy of the WAD before using it.
+        //
+
+        if (!M_CheckParm("-wadverify") || QSPI_VerifyImage(hdr))
+        {
+            mapped = QSPI_Image();
+        }
+    }
+
+    if (mapped == NULL)
+    {
+        if (f_open(&file, path, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+        {
+            return NULL;
+        }
+
+        if (fno.fsize <= QSPI_WAD_MAX && QSPI_Install(&file, path, &fno))
+        {
+            mapped = QSPI_Image();
+        }
+        else
+        {
+            printf("W_QSPI: QSPI install failed, loading %s to SDRAM\n", path);
+            sdram_copy = QSPI_LoadToSdram(&file, fno.fsize);
+            mapped = sdram_copy;
+        }
+
+        f_close(&file);
+
+        if (mapped == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    result = Z_Malloc(sizeof(qspi_wad_file_t), PU_STATIC, 0);
+    result->wad.file_class = &qspi_wad_file;
+    result->wad.mapped = mapped;
+    result->wad.length = fno.fsize;
+    result->wad.path = M_StringDuplicate(path);
+    result->sdram_copy = sdram_copy;
+
+    if (sdram_copy == NULL)
+    {
+        qspi_slot_in_use = true;
+    }
+
+    return &result->wad;
+}
+
+static void W_QSPI_CloseFile(wad_file_t *wad)
+{
+    qspi_wad_file_t *qspi_wad;
+
+    qspi_wad = (qspi_wad_file_t *) wad;
+
+    if (qspi_wad->sdram_copy != NULL)
+    {
+        free(qspi_wad->sdram_copy);
+    }
+    else
+    {
+        qspi_slot_in_use = false;
+    }
+    Z_Free(qspi_wad);
+}
+
+// Read data from the specified position in the file into the
+// provided buffer.  Returns the number of bytes read.
+
+size_t W_QSPI_Read(wad_file_t *wad, unsigned int offset,
+                   void *buffer, size_t buffer_len)
+{
+    if (offset >= wad->length)
+    {
+        return 0;
+    }
+    if (buffer_len > wad->length - offset)
+    {
+        buffer_len = wad->length - offset;
+    }
+
+    memcpy(buffer, wad->mapped + offset, buffer_len);
+
+    return buffer_len;
+}
+
+
+wad_file_class_t qspi_wad_file =
+{
+    W_QSPI_OpenFile,
+    W_QSPI_CloseFile,
+    W_QSPI_Read,
+};
+
+#endif
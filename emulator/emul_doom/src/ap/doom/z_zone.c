@@ -64,7 +64,13 @@ typedef struct
 
 
 
-static memzone_t *mainzone;
+// Zones indexed by zonehint_t.  The fast zone may be NULL, in which
+// case every allocation goes to the main zone.
+
+static memzone_t *zones[NUM_ZONES];
+
+#define mainzone zones[ZONE_MAIN]
+
 static boolean zero_on_free;
 static boolean scan_on_free;
 
@@ -100,27 +106,31 @@ void Z_ClearZone (memzone_t* zone)
 //
 void Z_Init (void)
 {
-    memblock_t*	block;
     int		size;
 
     mainzone = (memzone_t *)I_ZoneBase (&size);
     mainzone->size = size;
+    Z_ClearZone (mainzone);
 
-    // set the entire zone to one free block
-    mainzone->blocklist.next =
-	mainzone->blocklist.prev =
-	block = (memblock_t *)( (byte *)mainzone + sizeof(memzone_t) );
-
-    mainzone->blocklist.user = (void *)mainzone;
-    mainzone->blocklist.tag = PU_STATIC;
-    mainzone->rover = block;
+    //!
+    // @category obscure
+    //
+    // Don't use the fast internal memory zone; everything is
+    // allocated from the main zone.
+    //
 
-    block->prev = block->next = &mainzone->blocklist;
+    zones[ZONE_FAST] = NULL;
 
-    // free block
-    block->tag = PU_FREE;
+    if (!M_ParmExists("-nofastzone"))
+    {
+        zones[ZONE_FAST] = (memzone_t *)I_FastZoneBase (&size);
+    }
 
-    block->size = mainzone->size - sizeof(memzone_t);
+    if (zones[ZONE_FAST] != NULL)
+    {
+        zones[ZONE_FAST]->size = size;
+        Z_ClearZone (zones[ZONE_FAST]);
+    }
 
     // [Deliberately undocumented]
     // Zone memory debugging flag. If set, memory is zeroed after it is freed
@@ -137,15 +147,15 @@ void Z_Init (void)
 
 // Scan the zone heap for pointers within the specified range, and warn about
 // any remaining pointers.
-static void ScanForBlock(void *start, void *end)
+static void ScanZoneForBlock(memzone_t *zone, void *start, void *end)
 {
     memblock_t *block;
     void **mem;
     int i, len, tag;
 
-    block = mainzone->blocklist.next;
+    block = zone->blocklist.next;
 
-    while (block->next != &mainzone->blocklist)
+    while (block->next != &zone->blocklist)
     {
         tag = block->tag;
 
@@ -172,11 +182,43 @@ static void ScanForBlock(void *start, void *end)
     }
 }
 
+static void ScanForBlock(void *start, void *end)
+{
+    int i;
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+        if (zones[i] != NULL)
+        {
+            ScanZoneForBlock(zones[i], start, end);
+        }
+    }
+}
+
+//
+// ZoneForBlock
+// Find the zone a block was allocated from.
+//
+static memzone_t *ZoneForBlock (memblock_t *block)
+{
+    memzone_t *zone = zones[ZONE_FAST];
+
+    if (zone != NULL
+     && (byte *) block > (byte *) zone
+     && (byte *) block < (byte *) zone + zone->size)
+    {
+        return zone;
+    }
+
+    return mainzone;
+}
+
 //
 // Z_Free
 //
 void Z_Free (void* ptr)
 {
+    memzone_t*		zone;
     memblock_t*		block;
     memblock_t*		other;
 
@@ -185,6 +227,8 @@ void Z_Free (void* ptr)
     if (block->id != ZONEID)
 	I_Error ("Z_Free: freed a pointer without ZONEID");
 
+    zone = ZoneForBlock (block);
+
     if (block->tag != PU_FREE && block->user != NULL)
     {
     	// clear the user's mark
@@ -217,8 +261,8 @@ void Z_Free (void* ptr)
         other->next = block->next;
         other->next->prev = other;
 
-        if (block == mainzone->rover)
-            mainzone->rover = other;
+        if (block == zone->rover)
+            zone->rover = other;
 
         block = other;
     }
@@ -231,23 +275,24 @@ void Z_Free (void* ptr)
         block->next = other->next;
         block->next->prev = block;
 
-        if (other == mainzone->rover)
-            mainzone->rover = block;
+        if (other == zone->rover)
+            zone->rover = block;
     }
 }
 
 
 
 //
-// Z_Malloc
-// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+// ZoneMalloc
+// Allocate from one zone; returns NULL if it does not fit.
 //
 #define MINFRAGMENT		64
 
 
-void*
-Z_Malloc
-( int		size,
+static void*
+ZoneMalloc
+( memzone_t*	zone,
+  int		size,
   int		tag,
   void*		user )
 {
@@ -270,7 +315,7 @@ Z_Malloc
     
     // if there is a free block behind the rover,
     //  back up over them
-    base = mainzone->rover;
+    base = zone->rover;
     
     if (base->prev->tag == PU_FREE)
         base = base->prev;
@@ -283,7 +328,7 @@ Z_Malloc
         if (rover == start)
         {
             // scanned all the way around the list
-            I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+            return NULL;
         }
 	
         if (rover->tag != PU_FREE)
@@ -346,7 +391,7 @@ Z_Malloc
     }
 
     // next allocation will start looking here
-    mainzone->rover = base->next;	
+    zone->rover = base->next;	
 	
     base->id = ZONEID;
    
@@ -354,6 +399,90 @@ Z_Malloc
 }
 
 
+//
+// ZoneFits
+// True if a run of free and purgable blocks in the zone could hold
+// the allocation, so ZoneMalloc can't fail after purging on the way.
+//
+static boolean ZoneFits(memzone_t *zone, int size)
+{
+    memblock_t*	block;
+    int		run;
+
+    size = ((size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1)) + sizeof(memblock_t);
+    run = 0;
+
+    for (block = zone->blocklist.next ;
+         block != &zone->blocklist;
+         block = block->next)
+    {
+        if (block->tag == PU_FREE || block->tag >= PU_PURGELEVEL)
+        {
+            run += block->size;
+
+            if (run >= size)
+                return true;
+        }
+        else
+        {
+            run = 0;
+        }
+    }
+
+    return false;
+}
+
+
+//
+// Z_MallocHint
+// Allocate from the zone named by the hint, falling back to the
+// main zone when the fast zone is missing or full.
+//
+void*
+Z_MallocHint
+( int		size,
+  int		tag,
+  void*		user,
+  zonehint_t	hint )
+{
+    void *result = NULL;
+
+    // A fast zone that can't hold it is left alone, its cache
+    // would be purged for nothing.
+    if (hint != ZONE_MAIN && zones[hint] != NULL
+     && ZoneFits (zones[hint], size))
+    {
+        result = ZoneMalloc (zones[hint], size, tag, user);
+    }
+
+    if (result == NULL)
+    {
+        result = ZoneMalloc (mainzone, size, tag, user);
+    }
+
+    if (result == NULL)
+    {
+        I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+    }
+
+    return result;
+}
+
+
+//
+// Z_Malloc
+// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+//
+void*
+Z_Malloc
+( int		size,
+  int		tag,
+  void*		user )
+{
+    return Z_MallocHint (size, tag, user, ZONE_MAIN);
+}
+
+
 
 //
 // Z_FreeTags
@@ -363,22 +492,32 @@ Z_FreeTags
 ( int		lowtag,
   int		hightag )
 {
+    memzone_t*	zone;
     memblock_t*	block;
     memblock_t*	next;
-	
-    for (block = mainzone->blocklist.next ;
-	 block != &mainzone->blocklist ;
-	 block = next)
+    int		i;
+
+    for (i = 0; i < NUM_ZONES; ++i)
     {
-	// get link before freeing
-	next = block->next;
+	zone = zones[i];
 
-	// free block?
-	if (block->tag == PU_FREE)
+	if (zone == NULL)
 	    continue;
-	
-	if (block->tag >= lowtag && block->tag <= hightag)
-	    Z_Free ( (byte *)block+sizeof(memblock_t));
+
+	for (block = zone->blocklist.next ;
+	     block != &zone->blocklist ;
+	     block = next)
+	{
+	    // get link before freeing
+	    next = block->next;
+
+	    // free block?
+	    if (block->tag == PU_FREE)
+		continue;
+
+	    if (block->tag >= lowtag && block->tag <= hightag)
+		Z_Free ( (byte *)block+sizeof(memblock_t));
+	}
     }
 }
 
@@ -388,26 +527,27 @@ Z_FreeTags
 // Z_DumpHeap
 // Note: TFileDumpHeap( stdout ) ?
 //
-void
-Z_DumpHeap
-( int		lowtag,
+static void
+DumpZone
+( memzone_t*	zone,
+  int		lowtag,
   int		hightag )
 {
     memblock_t*	block;
 	
     printf ("zone size: %i  location: %p\n",
-	    mainzone->size,mainzone);
+	    zone->size,zone);
     
     printf ("tag range: %i to %i\n",
 	    lowtag, hightag);
 	
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+    for (block = zone->blocklist.next ; ; block = block->next)
     {
 	if (block->tag >= lowtag && block->tag <= hightag)
 	    printf ("block:%p    size:%7i    user:%p    tag:%3i\n",
 		    block, block->size, block->user, block->tag);
 		
-	if (block->next == &mainzone->blocklist)
+	if (block->next == &zone->blocklist)
 	{
 	    // all blocks have been hit
 	    break;
@@ -424,22 +564,36 @@ Z_DumpHeap
     }
 }
 
+void
+Z_DumpHeap
+( int		lowtag,
+  int		hightag )
+{
+    int		i;
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+	if (zones[i] != NULL)
+	    DumpZone (zones[i], lowtag, hightag);
+    }
+}
+
 
 //
 // Z_FileDumpHeap
 //
-void Z_FileDumpHeap (FILE* f)
+static void FileDumpZone (memzone_t* zone, FILE* f)
 {
     memblock_t*	block;
 	
-    fprintf (f,"zone size: %i  location: %p\n",mainzone->size,mainzone);
+    fprintf (f,"zone size: %i  location: %p\n",zone->size,zone);
 	
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+    for (block = zone->blocklist.next ; ; block = block->next)
     {
 	fprintf (f,"block:%p    size:%7i    user:%p    tag:%3i\n",
 		 block, block->size, block->user, block->tag);
 		
-	if (block->next == &mainzone->blocklist)
+	if (block->next == &zone->blocklist)
 	{
 	    // all blocks have been hit
 	    break;
@@ -456,18 +610,29 @@ void Z_FileDumpHeap (FILE* f)
     }
 }
 
+void Z_FileDumpHeap (FILE* f)
+{
+    int		i;
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+	if (zones[i] != NULL)
+	    FileDumpZone (zones[i], f);
+    }
+}
+
 
 
 //
 // Z_CheckHeap
 //
-void Z_CheckHeap (void)
+static void CheckZone (memzone_t* zone)
 {
     memblock_t*	block;
 	
-    for (block = mainzone->blocklist.next ; ; block = block->next)
+    for (block = zone->blocklist.next ; ; block = block->next)
     {
-	if (block->next == &mainzone->blocklist)
+	if (block->next == &zone->blocklist)
 	{
 	    // all blocks have been hit
 	    break;
@@ -484,6 +649,17 @@ void Z_CheckHeap (void)
     }
 }
 
+void Z_CheckHeap (void)
+{
+    int		i;
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+	if (zones[i] != NULL)
+	    CheckZone (zones[i]);
+    }
+}
+
 
 
 
@@ -529,17 +705,18 @@ void Z_ChangeUser(void *ptr, void **user)
 //
 int Z_FreeMemory (void)
 {
-    memblock_t*		block;
+    unsigned int	size;
+    unsigned int	used;
+    unsigned int	purgable;
     int			free;
+    int			i;
 	
     free = 0;
-    
-    for (block = mainzone->blocklist.next ;
-         block != &mainzone->blocklist;
-         block = block->next)
+
+    for (i = 0; i < NUM_ZONES; ++i)
     {
-        if (block->tag == PU_FREE || block->tag >= PU_PURGELEVEL)
-            free += block->size;
+        Z_ZoneUsage(i, &size, &used, &purgable);
+        free += size - used;
     }
 
     return free;
@@ -547,6 +724,54 @@ int Z_FreeMemory (void)
 
 unsigned int Z_ZoneSize(void)
 {
-    return mainzone->size;
+    unsigned int	size;
+    unsigned int	used;
+    unsigned int	purgable;
+    unsigned int	total;
+    int			i;
+
+    total = 0;
+
+    for (i = 0; i < NUM_ZONES; ++i)
+    {
+        Z_ZoneUsage(i, &size, &used, &purgable);
+        total += size;
+    }
+
+    return total;
+}
+
+//
+// Z_ZoneUsage
+// Bytes in use in one zone.  Purgable blocks count as free in
+// Z_FreeMemory, so they are not included in 'used'.
+//
+void Z_ZoneUsage(zonehint_t zone, unsigned int *size,
+                 unsigned int *used, unsigned int *purgable)
+{
+    memzone_t*		z = zones[zone];
+    memblock_t*		block;
+
+    *size = 0;
+    *used = 0;
+    *purgable = 0;
+
+    if (z == NULL)
+    {
+        return;
+    }
+
+    *size = z->size;
+    *used = sizeof(memzone_t);
+
+    for (block = z->blocklist.next ;
+         block != &z->blocklist;
+         block = block->next)
+    {
+        if (block->tag >= PU_PURGELEVEL)
+            *purgable += block->size;
+        else if (block->tag != PU_FREE)
+            *used += block->size;
+    }
 }
 
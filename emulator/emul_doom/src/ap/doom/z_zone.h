@@ -50,8 +50,21 @@ enum
 };
         
 
+// Placement hints.  The fast zone is a small arena in internal SRAM
+// for data the renderer touches every frame; allocations that do not
+// fit there fall back to the main zone.
+
+typedef enum
+{
+    ZONE_MAIN,
+    ZONE_FAST,
+
+    NUM_ZONES
+} zonehint_t;
+
 void	Z_Init (void);
 void*	Z_Malloc (int size, int tag, void *ptr);
+void*	Z_MallocHint (int size, int tag, void *ptr, zonehint_t hint);
 void    Z_Free (void *ptr);
 void    Z_FreeTags (int lowtag, int hightag);
 void    Z_DumpHeap (int lowtag, int hightag);
@@ -61,6 +74,8 @@ void    Z_ChangeTag2 (void *ptr, int tag, const char *file, int line);
 void    Z_ChangeUser(void *ptr, void **user);
 int     Z_FreeMemory (void);
 unsigned int Z_ZoneSize(void);
+void    Z_ZoneUsage(zonehint_t zone, unsigned int *size,
+                    unsigned int *used, unsigned int *purgable);
 
 //
 // This is used to get the local FILE:LINE info from CPP
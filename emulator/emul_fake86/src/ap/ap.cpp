@@ -39,8 +39,11 @@ __attribute__((section(".tag"))) flash_tag_t fw_tag =
 
 
 
-extern "C" void fake86Main(void);
+extern "C" void fake86Main(int argc, const char *argv[]);
+extern "C" void fake86RequestLockstep(uint32_t steps);
+extern "C" void fake86RequestBench(uint32_t steps);
 static void threadEmul(void const *argument);
+static void fake86Cmdif(void);
 
 
 void apInit(void)
@@ -48,6 +51,7 @@ void apInit(void)
   uartOpen(_DEF_UART1, 57600);
   uartOpen(_DEF_UART2, 57600);
   cmdifOpen(_DEF_UART1, 57600);
+  cmdifAdd("fake86", fake86Cmdif);
 
 
   osThreadDef(threadEmul, threadEmul, _HW_DEF_RTOS_THREAD_PRI_EMUL, 0, _HW_DEF_RTOS_THREAD_MEM_EMUL);
@@ -87,10 +91,39 @@ static void threadEmul(void const *argument)
 {
   UNUSED(argument);
 
-  fake86Main();
+  fake86Main(0, NULL);
 
   while(1)
   {
     delay(100);
   }
 }
+
+// The device starts fake86Main() without arguments, the lockstep and bench
+// modes of the host command line are asked for here and run by the
+// emulation loop before its next frame.
+//
+static void fake86Cmdif(void)
+{
+  bool ret = true;
+
+
+  if (cmdifGetParamCnt() == 2 && cmdifHasString("lockstep", 0) == true)
+  {
+    fake86RequestLockstep(cmdifGetParam(1));
+  }
+  else if (cmdifGetParamCnt() == 2 && cmdifHasString("bench", 0) == true)
+  {
+    fake86RequestBench(cmdifGetParam(1));
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "fake86 lockstep [instructions]\n");
+    cmdifPrintf( "fake86 bench [instructions]\n");
+  }
+}
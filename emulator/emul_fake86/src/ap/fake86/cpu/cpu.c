@@ -45,11 +45,14 @@ static uint32_t temp1, temp2, temp3, temp32, ea;
 static bool _use_udis_emu = false;
 
 bool cpu_running;
+bool cpu_redux_enable = USE_CPU_REDUX;
+uint64_t cpu_instructions = 0;
 bool cpu_halt = false;
 bool cpu_step = false;
 
 static uint64_t _cycles;
 static uint32_t _delay_cycles;
+static uint16_t _trap_toggle;
 
 uint64_t cpu_slice_ticks(void) {
   return _cycles;
@@ -1325,7 +1328,6 @@ int32_t cpu_exec86(int32_t target) {
     return 0;
   }
 
-  static uint16_t trap_toggle = 0;
   _cycles = 0;
 
   const bool in_cpu_halt = cpu_halt;
@@ -1346,14 +1348,14 @@ int32_t cpu_exec86(int32_t target) {
 #endif
 
     // if trap is asserted
-    if (trap_toggle) {
+    if (_trap_toggle) {
       _cpu_io.int_call(1);
     }
 
-    trap_toggle = cpu_flags.tf;
+    _trap_toggle = cpu_flags.tf;
 
     const bool pending_irq = cpu_flags.ifl && i8259_irq_pending();
-    if (!trap_toggle && pending_irq) {
+    if (!_trap_toggle && pending_irq) {
       in_hlt_state = false;
       const int next_int = i8259_nextintr();
       // get next interrupt from the i8259, if any
@@ -1376,9 +1378,10 @@ int32_t cpu_exec86(int32_t target) {
     }
 #endif
 
-    if (USE_CPU_REDUX) {
+    if (cpu_redux_enable) {
       if (cpu_redux_exec()) {
         ++_cycles;
+        ++cpu_instructions;
         continue;
       }
     }
@@ -1435,6 +1438,7 @@ int32_t cpu_exec86(int32_t target) {
     } // while
 
     ++_cycles;
+    ++cpu_instructions;
 
     switch (opcode) {
     case 0x0: /* 00 ADD Eb Gb */
@@ -3471,6 +3475,24 @@ void cpu_state_load(FILE *fd) {
   fread(&_delay_cycles, 1, sizeof(_delay_cycles), fd);
 }
 
+void cpu_snapshot_save(struct cpu_snapshot_t *out) {
+  out->regs = cpu_regs;
+  out->flags = cpu_flags;
+  out->hlt_state = in_hlt_state;
+  out->trap_toggle = _trap_toggle;
+  out->delay_cycles = _delay_cycles;
+  out->redux_sti_sr = cpu_redux_get_sti_sr();
+}
+
+void cpu_snapshot_load(const struct cpu_snapshot_t *in) {
+  cpu_regs = in->regs;
+  cpu_flags = in->flags;
+  in_hlt_state = in->hlt_state;
+  _trap_toggle = in->trap_toggle;
+  _delay_cycles = in->delay_cycles;
+  cpu_redux_set_sti_sr(in->redux_sti_sr);
+}
+
 void cpu_dump_state(FILE *fd) {
   fprintf(fd, "CPU state:\n");
   fprintf(fd, "  AX %04x\n", (int)cpu_regs.ax);
@@ -77,6 +77,29 @@ void cpu_delay(uint32_t cycles);
 // state save/load
 void cpu_state_save(FILE *fd);
 void cpu_state_load(FILE *fd);
+void cpu_dump_state(FILE *fd);
+
+// select the redux fast path at runtime (defaults to USE_CPU_REDUX)
+extern bool cpu_redux_enable;
+
+// instructions executed by either core, each REP iteration counts as one
+extern uint64_t cpu_instructions;
+
+// in-memory cpu state used to rewind single steps (see lockstep.c)
+struct cpu_snapshot_t {
+  struct cpu_regs_t regs;
+  union cpu_flags_t flags;
+  bool hlt_state;
+  uint16_t trap_toggle;
+  uint32_t delay_cycles;
+  uint8_t redux_sti_sr;
+};
+
+void cpu_snapshot_save(struct cpu_snapshot_t *out);
+void cpu_snapshot_load(const struct cpu_snapshot_t *in);
+
+// disassemble one instruction into 'out', return its length in bytes
+uint32_t cpu_disasm(const uint8_t *code, char *out, size_t size);
 
 extern bool cpu_halt;
 extern bool cpu_step;
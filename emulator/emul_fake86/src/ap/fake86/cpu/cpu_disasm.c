@@ -0,0 +1,458 @@
+/*
+  Fake86: A portable, open-source 8086 PC emulator.
+  Copyright (C)2010-2013 Mike Chambers
+               2019      Aidan Dodds
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+  USA.
+*/
+
+/* cpu_disasm.c: a small table driven 8086/80186 disassembler, used to
+ * annotate divergence reports. it is not used by the cpu cores. */
+
+#include "../common/common.h"
+#include "cpu.h"
+
+
+// operand formats
+enum {
+  F_NONE,   // no operands
+  F_EbGb,   // r/m8, reg8
+  F_EvGv,   // r/m16, reg16
+  F_GbEb,   // reg8, r/m8
+  F_GvEv,   // reg16, r/m16
+  F_ALIb,   // al, imm8
+  F_AXIv,   // ax, imm16
+  F_R16,    // reg16 from low opcode bits
+  F_AXR16,  // ax, reg16 from low opcode bits
+  F_R8Ib,   // reg8 from low opcode bits, imm8
+  F_R16Iv,  // reg16 from low opcode bits, imm16
+  F_Jb,     // rel8
+  F_Jv,     // rel16
+  F_Ib,     // imm8
+  F_Iw,     // imm16
+  F_IwIb,   // imm16, imm8
+  F_Ap,     // seg:off
+  F_ALOb,   // al, [moffs]
+  F_AXOv,   // ax, [moffs]
+  F_ObAL,   // [moffs], al
+  F_OvAX,   // [moffs], ax
+  F_EwSw,   // r/m16, sreg
+  F_SwEw,   // sreg, r/m16
+  F_GvM,    // reg16, mem
+  F_Ev,     // r/m16
+  F_EbIb,   // r/m8, imm8
+  F_EvIv,   // r/m16, imm16
+  F_EvIb,   // r/m16, simm8
+  F_GvEvIv, // reg16, r/m16, imm16
+  F_GvEvIb, // reg16, r/m16, simm8
+  F_ALDX,   // al, dx
+  F_AXDX,   // ax, dx
+  F_DXAL,   // dx, al
+  F_DXAX,   // dx, ax
+  F_IbAL,   // imm8, al
+  F_IbAX,   // imm8, ax
+  F_ALIbP,  // al, imm8 port
+  F_AXIbP,  // ax, imm8 port
+  F_GRP1b,  // group 1 r/m8, imm8
+  F_GRP1v,  // group 1 r/m16, imm16
+  F_GRP1s,  // group 1 r/m16, simm8
+  F_GRP2b1, // group 2 r/m8, 1
+  F_GRP2v1, // group 2 r/m16, 1
+  F_GRP2bC, // group 2 r/m8, cl
+  F_GRP2vC, // group 2 r/m16, cl
+  F_GRP2bI, // group 2 r/m8, imm8
+  F_GRP2vI, // group 2 r/m16, imm8
+  F_GRP3b,  // group 3 r/m8
+  F_GRP3v,  // group 3 r/m16
+  F_GRP4,   // group 4 r/m8
+  F_GRP5,   // group 5 r/m16
+  F_PFX,    // prefix byte
+};
+
+struct disasm_op_t {
+  const char *name;
+  uint8_t fmt;
+};
+
+static const struct disasm_op_t _ops[256] = {
+  // 00
+  {"add", F_EbGb}, {"add", F_EvGv}, {"add", F_GbEb}, {"add", F_GvEv},
+  {"add", F_ALIb}, {"add", F_AXIv}, {"push es", F_NONE}, {"pop es", F_NONE},
+  {"or", F_EbGb}, {"or", F_EvGv}, {"or", F_GbEb}, {"or", F_GvEv},
+  {"or", F_ALIb}, {"or", F_AXIv}, {"push cs", F_NONE}, {"pop cs", F_NONE},
+  // 10
+  {"adc", F_EbGb}, {"adc", F_EvGv}, {"adc", F_GbEb}, {"adc", F_GvEv},
+  {"adc", F_ALIb}, {"adc", F_AXIv}, {"push ss", F_NONE}, {"pop ss", F_NONE},
+  {"sbb", F_EbGb}, {"sbb", F_EvGv}, {"sbb", F_GbEb}, {"sbb", F_GvEv},
+  {"sbb", F_ALIb}, {"sbb", F_AXIv}, {"push ds", F_NONE}, {"pop ds", F_NONE},
+  // 20
+  {"and", F_EbGb}, {"and", F_EvGv}, {"and", F_GbEb}, {"and", F_GvEv},
+  {"and", F_ALIb}, {"and", F_AXIv}, {"es:", F_PFX}, {"daa", F_NONE},
+  {"sub", F_EbGb}, {"sub", F_EvGv}, {"sub", F_GbEb}, {"sub", F_GvEv},
+  {"sub", F_ALIb}, {"sub", F_AXIv}, {"cs:", F_PFX}, {"das", F_NONE},
+  // 30
+  {"xor", F_EbGb}, {"xor", F_EvGv}, {"xor", F_GbEb}, {"xor", F_GvEv},
+  {"xor", F_ALIb}, {"xor", F_AXIv}, {"ss:", F_PFX}, {"aaa", F_NONE},
+  {"cmp", F_EbGb}, {"cmp", F_EvGv}, {"cmp", F_GbEb}, {"cmp", F_GvEv},
+  {"cmp", F_ALIb}, {"cmp", F_AXIv}, {"ds:", F_PFX}, {"aas", F_NONE},
+  // 40
+  {"inc", F_R16}, {"inc", F_R16}, {"inc", F_R16}, {"inc", F_R16},
+  {"inc", F_R16}, {"inc", F_R16}, {"inc", F_R16}, {"inc", F_R16},
+  {"dec", F_R16}, {"dec", F_R16}, {"dec", F_R16}, {"dec", F_R16},
+  {"dec", F_R16}, {"dec", F_R16}, {"dec", F_R16}, {"dec", F_R16},
+  // 50
+  {"push", F_R16}, {"push", F_R16}, {"push", F_R16}, {"push", F_R16},
+  {"push", F_R16}, {"push", F_R16}, {"push", F_R16}, {"push", F_R16},
+  {"pop", F_R16}, {"pop", F_R16}, {"pop", F_R16}, {"pop", F_R16},
+  {"pop", F_R16}, {"pop", F_R16}, {"pop", F_R16}, {"pop", F_R16},
+  // 60
+  {"pusha", F_NONE}, {"popa", F_NONE}, {"bound", F_GvEv}, {NULL, F_NONE},
+  {NULL, F_NONE}, {NULL, F_NONE}, {NULL, F_NONE}, {NULL, F_NONE},
+  {"push", F_Iw}, {"imul", F_GvEvIv}, {"push", F_Ib}, {"imul", F_GvEvIb},
+  {"insb", F_NONE}, {"insw", F_NONE}, {"outsb", F_NONE}, {"outsw", F_NONE},
+  // 70
+  {"jo", F_Jb}, {"jno", F_Jb}, {"jb", F_Jb}, {"jnb", F_Jb},
+  {"jz", F_Jb}, {"jnz", F_Jb}, {"jbe", F_Jb}, {"ja", F_Jb},
+  {"js", F_Jb}, {"jns", F_Jb}, {"jpe", F_Jb}, {"jpo", F_Jb},
+  {"jl", F_Jb}, {"jge", F_Jb}, {"jle", F_Jb}, {"jg", F_Jb},
+  // 80
+  {NULL, F_GRP1b}, {NULL, F_GRP1v}, {NULL, F_GRP1b}, {NULL, F_GRP1s},
+  {"test", F_EbGb}, {"test", F_EvGv}, {"xchg", F_EbGb}, {"xchg", F_EvGv},
+  {"mov", F_EbGb}, {"mov", F_EvGv}, {"mov", F_GbEb}, {"mov", F_GvEv},
+  {"mov", F_EwSw}, {"lea", F_GvM}, {"mov", F_SwEw}, {"pop", F_Ev},
+  // 90
+  {"nop", F_NONE}, {"xchg", F_AXR16}, {"xchg", F_AXR16}, {"xchg", F_AXR16},
+  {"xchg", F_AXR16}, {"xchg", F_AXR16}, {"xchg", F_AXR16}, {"xchg", F_AXR16},
+  {"cbw", F_NONE}, {"cwd", F_NONE}, {"call", F_Ap}, {"wait", F_NONE},
+  {"pushf", F_NONE}, {"popf", F_NONE}, {"sahf", F_NONE}, {"lahf", F_NONE},
+  // A0
+  {"mov", F_ALOb}, {"mov", F_AXOv}, {"mov", F_ObAL}, {"mov", F_OvAX},
+  {"movsb", F_NONE}, {"movsw", F_NONE}, {"cmpsb", F_NONE}, {"cmpsw", F_NONE},
+  {"test", F_ALIb}, {"test", F_AXIv}, {"stosb", F_NONE}, {"stosw", F_NONE},
+  {"lodsb", F_NONE}, {"lodsw", F_NONE}, {"scasb", F_NONE}, {"scasw", F_NONE},
+  // B0
+  {"mov", F_R8Ib}, {"mov", F_R8Ib}, {"mov", F_R8Ib}, {"mov", F_R8Ib},
+  {"mov", F_R8Ib}, {"mov", F_R8Ib}, {"mov", F_R8Ib}, {"mov", F_R8Ib},
+  {"mov", F_R16Iv}, {"mov", F_R16Iv}, {"mov", F_R16Iv}, {"mov", F_R16Iv},
+  {"mov", F_R16Iv}, {"mov", F_R16Iv}, {"mov", F_R16Iv}, {"mov", F_R16Iv},
+  // C0
+  {NULL, F_GRP2bI}, {NULL, F_GRP2vI}, {"ret", F_Iw}, {"ret", F_NONE},
+  {"les", F_GvM}, {"lds", F_GvM}, {"mov", F_EbIb}, {"mov", F_EvIv},
+  {"enter", F_IwIb}, {"leave", F_NONE}, {"retf", F_Iw}, {"retf", F_NONE},
+  {"int3", F_NONE}, {"int", F_Ib}, {"into", F_NONE}, {"iret", F_NONE},
+  // D0
+  {NULL, F_GRP2b1}, {NULL, F_GRP2v1}, {NULL, F_GRP2bC}, {NULL, F_GRP2vC},
+  {"aam", F_Ib}, {"aad", F_Ib}, {"salc", F_NONE}, {"xlat", F_NONE},
+  {"esc", F_Ev}, {"esc", F_Ev}, {"esc", F_Ev}, {"esc", F_Ev},
+  {"esc", F_Ev}, {"esc", F_Ev}, {"esc", F_Ev}, {"esc", F_Ev},
+  // E0
+  {"loopnz", F_Jb}, {"loopz", F_Jb}, {"loop", F_Jb}, {"jcxz", F_Jb},
+  {"in", F_ALIbP}, {"in", F_AXIbP}, {"out", F_IbAL}, {"out", F_IbAX},
+  {"call", F_Jv}, {"jmp", F_Jv}, {"jmp", F_Ap}, {"jmp", F_Jb},
+  {"in", F_ALDX}, {"in", F_AXDX}, {"out", F_DXAL}, {"out", F_DXAX},
+  // F0
+  {"lock", F_PFX}, {NULL, F_NONE}, {"repnz", F_PFX}, {"repz", F_PFX},
+  {"hlt", F_NONE}, {"cmc", F_NONE}, {NULL, F_GRP3b}, {NULL, F_GRP3v},
+  {"clc", F_NONE}, {"stc", F_NONE}, {"cli", F_NONE}, {"sti", F_NONE},
+  {"cld", F_NONE}, {"std", F_NONE}, {NULL, F_GRP4}, {NULL, F_GRP5},
+};
+
+static const char *_reg8[8] = {"al", "cl", "dl", "bl", "ah", "ch", "dh", "bh"};
+static const char *_reg16[8] = {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di"};
+static const char *_sreg[8] = {"es", "cs", "ss", "ds", "?s", "?s", "?s", "?s"};
+static const char *_ea[8] = {"bx+si", "bx+di", "bp+si", "bp+di",
+                             "si",    "di",    "bp",    "bx"};
+
+static const char *_grp1[8] = {"add", "or", "adc", "sbb",
+                               "and", "sub", "xor", "cmp"};
+static const char *_grp2[8] = {"rol", "ror", "rcl", "rcr",
+                               "shl", "shr", "sal", "sar"};
+static const char *_grp3[8] = {"test", "test", "not", "neg",
+                               "mul",  "imul", "div", "idiv"};
+static const char *_grp4[8] = {"inc", "dec", "???", "???",
+                               "???", "???", "???", "???"};
+static const char *_grp5[8] = {"inc", "dec", "call", "call far",
+                               "jmp", "jmp far", "push", "???"};
+
+static inline uint16_t _u16(const uint8_t *p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+// decode a mod r/m operand, return the number of bytes consumed
+static uint32_t _modrm(const uint8_t *p, bool wide, char *out, size_t size,
+                       uint8_t *reg) {
+  const uint8_t mod = p[0] >> 6;
+  const uint8_t rm = p[0] & 7;
+  *reg = (p[0] >> 3) & 7;
+  switch (mod) {
+  case 0:
+    if (rm == 6) {
+      snprintf(out, size, "[%04x]", _u16(p + 1));
+      return 3;
+    }
+    snprintf(out, size, "[%s]", _ea[rm]);
+    return 1;
+  case 1: {
+    const int8_t d = (int8_t)p[1];
+    snprintf(out, size, "[%s%c%02x]", _ea[rm], d < 0 ? '-' : '+',
+             d < 0 ? -d : d);
+    return 2;
+  }
+  case 2:
+    snprintf(out, size, "[%s+%04x]", _ea[rm], _u16(p + 1));
+    return 3;
+  default:
+    snprintf(out, size, "%s", wide ? _reg16[rm] : _reg8[rm]);
+    return 1;
+  }
+}
+
+uint32_t cpu_disasm(const uint8_t *code, char *out, size_t size) {
+  char pfx[16] = "";
+  uint32_t len = 0;
+
+  // gather prefix bytes
+  while (_ops[code[len]].fmt == F_PFX && len < 4) {
+    strncat(pfx, _ops[code[len]].name, sizeof(pfx) - strlen(pfx) - 2);
+    strcat(pfx, " ");
+    ++len;
+  }
+
+  const uint8_t op = code[len++];
+  const struct disasm_op_t *d = &_ops[op];
+  const uint8_t *p = code + len;
+
+  char ea[24];
+  uint8_t reg = 0;
+  uint32_t n = 0;
+
+  switch (d->fmt) {
+  case F_NONE:
+    if (d->name == NULL) {
+      snprintf(out, size, "%sdb %02x", pfx, op);
+    }
+    else {
+      snprintf(out, size, "%s%s", pfx, d->name);
+    }
+    break;
+  case F_EbGb:
+    n = _modrm(p, false, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s", pfx, d->name, ea, _reg8[reg]);
+    break;
+  case F_EvGv:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s", pfx, d->name, ea, _reg16[reg]);
+    break;
+  case F_GbEb:
+    n = _modrm(p, false, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s", pfx, d->name, _reg8[reg], ea);
+    break;
+  case F_GvEv:
+  case F_GvM:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s", pfx, d->name, _reg16[reg], ea);
+    break;
+  case F_ALIb:
+    snprintf(out, size, "%s%s al, %02x", pfx, d->name, p[0]);
+    n = 1;
+    break;
+  case F_AXIv:
+    snprintf(out, size, "%s%s ax, %04x", pfx, d->name, _u16(p));
+    n = 2;
+    break;
+  case F_R16:
+    snprintf(out, size, "%s%s %s", pfx, d->name, _reg16[op & 7]);
+    break;
+  case F_AXR16:
+    snprintf(out, size, "%s%s ax, %s", pfx, d->name, _reg16[op & 7]);
+    break;
+  case F_R8Ib:
+    snprintf(out, size, "%s%s %s, %02x", pfx, d->name, _reg8[op & 7], p[0]);
+    n = 1;
+    break;
+  case F_R16Iv:
+    snprintf(out, size, "%s%s %s, %04x", pfx, d->name, _reg16[op & 7], _u16(p));
+    n = 2;
+    break;
+  case F_Jb:
+    snprintf(out, size, "%s%s %+d", pfx, d->name, (int)(int8_t)p[0] + 2);
+    n = 1;
+    break;
+  case F_Jv:
+    snprintf(out, size, "%s%s %+d", pfx, d->name, (int)(int16_t)_u16(p) + 3);
+    n = 2;
+    break;
+  case F_Ib:
+    snprintf(out, size, "%s%s %02x", pfx, d->name, p[0]);
+    n = 1;
+    break;
+  case F_Iw:
+    snprintf(out, size, "%s%s %04x", pfx, d->name, _u16(p));
+    n = 2;
+    break;
+  case F_IwIb:
+    snprintf(out, size, "%s%s %04x, %02x", pfx, d->name, _u16(p), p[2]);
+    n = 3;
+    break;
+  case F_Ap:
+    snprintf(out, size, "%s%s %04x:%04x", pfx, d->name, _u16(p + 2), _u16(p));
+    n = 4;
+    break;
+  case F_ALOb:
+    snprintf(out, size, "%s%s al, [%04x]", pfx, d->name, _u16(p));
+    n = 2;
+    break;
+  case F_AXOv:
+    snprintf(out, size, "%s%s ax, [%04x]", pfx, d->name, _u16(p));
+    n = 2;
+    break;
+  case F_ObAL:
+    snprintf(out, size, "%s%s [%04x], al", pfx, d->name, _u16(p));
+    n = 2;
+    break;
+  case F_OvAX:
+    snprintf(out, size, "%s%s [%04x], ax", pfx, d->name, _u16(p));
+    n = 2;
+    break;
+  case F_EwSw:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s", pfx, d->name, ea, _sreg[reg]);
+    break;
+  case F_SwEw:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s", pfx, d->name, _sreg[reg], ea);
+    break;
+  case F_Ev:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s", pfx, d->name, ea);
+    break;
+  case F_EbIb:
+    n = _modrm(p, false, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s byte %s, %02x", pfx, d->name, ea, p[n]);
+    n += 1;
+    break;
+  case F_EvIv:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s word %s, %04x", pfx, d->name, ea, _u16(p + n));
+    n += 2;
+    break;
+  case F_GvEvIv:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s, %04x", pfx, d->name, _reg16[reg], ea,
+             _u16(p + n));
+    n += 2;
+    break;
+  case F_GvEvIb:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %s, %d", pfx, d->name, _reg16[reg], ea,
+             (int)(int8_t)p[n]);
+    n += 1;
+    break;
+  case F_ALDX:
+    snprintf(out, size, "%s%s al, dx", pfx, d->name);
+    break;
+  case F_AXDX:
+    snprintf(out, size, "%s%s ax, dx", pfx, d->name);
+    break;
+  case F_DXAL:
+    snprintf(out, size, "%s%s dx, al", pfx, d->name);
+    break;
+  case F_DXAX:
+    snprintf(out, size, "%s%s dx, ax", pfx, d->name);
+    break;
+  case F_IbAL:
+    snprintf(out, size, "%s%s %02x, al", pfx, d->name, p[0]);
+    n = 1;
+    break;
+  case F_IbAX:
+    snprintf(out, size, "%s%s %02x, ax", pfx, d->name, p[0]);
+    n = 1;
+    break;
+  case F_ALIbP:
+    snprintf(out, size, "%s%s al, %02x", pfx, d->name, p[0]);
+    n = 1;
+    break;
+  case F_AXIbP:
+    snprintf(out, size, "%s%s ax, %02x", pfx, d->name, p[0]);
+    n = 1;
+    break;
+  case F_GRP1b:
+    n = _modrm(p, false, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s byte %s, %02x", pfx, _grp1[reg], ea, p[n]);
+    n += 1;
+    break;
+  case F_GRP1v:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s word %s, %04x", pfx, _grp1[reg], ea, _u16(p + n));
+    n += 2;
+    break;
+  case F_GRP1s:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s word %s, %d", pfx, _grp1[reg], ea,
+             (int)(int8_t)p[n]);
+    n += 1;
+    break;
+  case F_GRP2b1:
+  case F_GRP2v1:
+    n = _modrm(p, d->fmt == F_GRP2v1, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, 1", pfx, _grp2[reg], ea);
+    break;
+  case F_GRP2bC:
+  case F_GRP2vC:
+    n = _modrm(p, d->fmt == F_GRP2vC, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, cl", pfx, _grp2[reg], ea);
+    break;
+  case F_GRP2bI:
+  case F_GRP2vI:
+    n = _modrm(p, d->fmt == F_GRP2vI, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s %s, %02x", pfx, _grp2[reg], ea, p[n]);
+    n += 1;
+    break;
+  case F_GRP3b:
+    n = _modrm(p, false, ea, sizeof(ea), &reg);
+    if (reg < 2) {
+      snprintf(out, size, "%stest byte %s, %02x", pfx, ea, p[n]);
+      n += 1;
+    }
+    else {
+      snprintf(out, size, "%s%s byte %s", pfx, _grp3[reg], ea);
+    }
+    break;
+  case F_GRP3v:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    if (reg < 2) {
+      snprintf(out, size, "%stest word %s, %04x", pfx, ea, _u16(p + n));
+      n += 2;
+    }
+    else {
+      snprintf(out, size, "%s%s word %s", pfx, _grp3[reg], ea);
+    }
+    break;
+  case F_GRP4:
+    n = _modrm(p, false, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s byte %s", pfx, _grp4[reg], ea);
+    break;
+  case F_GRP5:
+    n = _modrm(p, true, ea, sizeof(ea), &reg);
+    snprintf(out, size, "%s%s word %s", pfx, _grp5[reg], ea);
+    break;
+  default:
+    snprintf(out, size, "%sdb %02x", pfx, op);
+    break;
+  }
+
+  return len + n;
+}
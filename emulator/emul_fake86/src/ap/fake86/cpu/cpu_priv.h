@@ -29,6 +29,8 @@ bool segoverride;
 extern struct cpu_io_t _cpu_io;
 
 bool cpu_redux_exec(void);
+uint8_t cpu_redux_get_sti_sr(void);
+void cpu_redux_set_sti_sr(uint8_t sr);
 
 enum {
   CF = (1 << 0),
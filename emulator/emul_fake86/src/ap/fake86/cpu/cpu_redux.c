@@ -1938,6 +1938,14 @@ static const opcode_t _op_table[256] = {
 #undef ___
 #undef XXX
 
+uint8_t cpu_redux_get_sti_sr(void) {
+  return _sti_sr;
+}
+
+void cpu_redux_set_sti_sr(uint8_t sr) {
+  _sti_sr = sr;
+}
+
 bool cpu_redux_exec(void) {
 
   // delay setting IFL for one instruction after STI
@@ -26,10 +26,13 @@
 extern bool do_fullscreen;
 extern bool cpu_running;
 extern const char *biosfile;
+extern const char *rom_basic;
 extern uint8_t bootdrive;
 extern bool do_fullscreen;
 extern uint32_t frame_skip;
 extern bool _cl_headless;
+extern uint64_t _cl_lockstep;
+extern uint64_t _cl_bench;
 
 extern bool cpu_halt;
 extern bool cpu_step;
@@ -73,6 +76,11 @@ void tick_events(void);
 // parsecl.c
 bool cl_parse(const int argc, const char **args);
 
+// lockstep.c
+void lockstep_init(void);
+int32_t lockstep_step(void);
+void lockstep_report(void);
+
 //
 void state_save(const char *path);
 void state_load(const char *path);
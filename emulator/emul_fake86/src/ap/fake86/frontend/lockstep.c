@@ -0,0 +1,481 @@
+/*
+  Fake86: A portable, open-source 8086 PC emulator.
+  Copyright (C)2010-2013 Mike Chambers
+               2019      Aidan Dodds
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+  USA.
+*/
+
+/* lockstep.c: run the redux core and the legacy core side by side, one
+ * instruction at a time, and report the first point where they disagree.
+ *
+ * each step is executed twice from the same state:
+ *
+ *   1. the redux core runs first in 'record' mode. memory writes go to RAM
+ *      but are journaled so they can be undone, port reads hit the real
+ *      devices and their results are recorded, port writes are only recorded.
+ *   2. the machine is rewound and the legacy core runs in 'replay' mode.
+ *      port reads return the values recorded in step 1 so devices only see
+ *      each access once.
+ *      its memory and port writes go to the machine for real.
+ *   3. registers, flags, memory writes and port writes are compared.
+ *
+ * steps that raise an interupt (INT n, IRQ dispatch, trap) cannot be rewound
+ * because the HLE handlers touch disk and video state directly, and steps
+ * that overflow a journal cannot be compared, so those are executed once with
+ * the legacy core in 'commit' mode and counted as unchecked. port reads the
+ * redux core already did are replayed there as well, devices never see a
+ * read twice.
+ */
+
+#include "../common/common.h"
+#include "../cpu/cpu.h"
+#include "frontend.h"
+
+
+#define LOCKSTEP_MAX_LOG  64
+
+extern struct structpic i8259;
+
+enum {
+  IO_PASS,
+  IO_RECORD,
+  IO_REPLAY,
+  IO_COMMIT,
+};
+
+struct lockstep_write_t {
+  uint32_t addr;
+  uint8_t  value;
+  uint8_t  old;
+  bool     undo;
+};
+
+struct lockstep_port_t {
+  uint16_t port;
+  uint16_t value;
+  uint8_t  wide;
+};
+
+struct lockstep_log_t {
+  struct lockstep_write_t mem[LOCKSTEP_MAX_LOG];
+  uint32_t mem_count;
+  struct lockstep_port_t port_rd[LOCKSTEP_MAX_LOG];
+  uint32_t port_rd_count;
+  struct lockstep_port_t port_wr[LOCKSTEP_MAX_LOG];
+  uint32_t port_wr_count;
+  bool     int_raised;
+  bool     overflow;
+};
+
+static int _io_mode = IO_PASS;
+static struct lockstep_log_t *_log;
+static struct lockstep_log_t _log_redux;
+static struct lockstep_log_t _log_legacy;
+static uint32_t _replay_pos;
+static bool _replay_error;
+
+static uint64_t _steps_checked;
+static uint64_t _steps_unchecked;
+
+
+// ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- io hooks
+
+// journal a memory write, NULL once the journal is full
+static const struct lockstep_write_t *_log_mem(uint32_t addr, uint8_t value) {
+  addr &= 0xFFFFF;
+  if (_log->mem_count >= LOCKSTEP_MAX_LOG) {
+    _log->overflow = true;
+    return NULL;
+  }
+  struct lockstep_write_t *w = &_log->mem[_log->mem_count++];
+  w->addr = addr;
+  w->value = value;
+  w->old = RAM[addr];
+  // vga planes are not backed by RAM so they cant be rewound, writes to them
+  // are only recorded while the first core runs
+  w->undo = (addr < 0xA0000) || (addr >= 0xB0000 && addr < 0xC0000);
+  return w;
+}
+
+static void _hook_write_8(uint32_t addr, uint8_t value) {
+  if (_io_mode == IO_PASS || _io_mode == IO_COMMIT) {
+    write86(addr, value);
+    return;
+  }
+  const struct lockstep_write_t *w = _log_mem(addr, value);
+  if (_io_mode == IO_REPLAY) {
+    write86(addr, value);
+    return;
+  }
+  // while recording only writes that can be undone reach the machine, one
+  // the full journal cant hold is dropped and the step rerun unchecked
+  if (w && w->undo) {
+    write86(addr, value);
+  }
+}
+
+static void _hook_write_16(uint32_t addr, uint16_t value) {
+  _hook_write_8(addr + 0, (uint8_t)(value >> 0));
+  _hook_write_8(addr + 1, (uint8_t)(value >> 8));
+}
+
+static uint16_t _port_read(uint16_t port, uint8_t wide) {
+  if (_io_mode == IO_PASS) {
+    return wide ? portin16(port) : portin(port);
+  }
+  if (_io_mode == IO_COMMIT) {
+    // reads the redux core did already reached the devices, replay them
+    if (_replay_pos < _log_redux.port_rd_count) {
+      const struct lockstep_port_t *r = &_log_redux.port_rd[_replay_pos];
+      if (r->port == port && r->wide == wide) {
+        ++_replay_pos;
+        return r->value;
+      }
+      // the legacy core went another way, the rest is stale
+      _replay_pos = _log_redux.port_rd_count;
+    }
+    return wide ? portin16(port) : portin(port);
+  }
+  if (_log->port_rd_count >= LOCKSTEP_MAX_LOG) {
+    _log->overflow = true;
+    return 0xFFFF;
+  }
+  struct lockstep_port_t *p = &_log->port_rd[_log->port_rd_count++];
+  p->port = port;
+  p->wide = wide;
+  if (_io_mode == IO_RECORD) {
+    p->value = wide ? portin16(port) : portin(port);
+    return p->value;
+  }
+  // replay the value the first core saw
+  if (_replay_pos >= _log_redux.port_rd_count) {
+    _replay_error = true;
+    p->value = 0xFFFF;
+    return p->value;
+  }
+  const struct lockstep_port_t *r = &_log_redux.port_rd[_replay_pos++];
+  if (r->port != port || r->wide != wide) {
+    _replay_error = true;
+  }
+  p->value = r->value;
+  return p->value;
+}
+
+static uint8_t _hook_port_read_8(uint16_t port) {
+  return (uint8_t)_port_read(port, 0);
+}
+
+static uint16_t _hook_port_read_16(uint16_t port) {
+  return _port_read(port, 1);
+}
+
+static void _port_out(uint16_t port, uint16_t value, uint8_t wide) {
+  if (wide) {
+    portout16(port, value);
+  }
+  else {
+    portout(port, (uint8_t)value);
+  }
+}
+
+static void _port_write(uint16_t port, uint16_t value, uint8_t wide) {
+  if (_io_mode == IO_PASS || _io_mode == IO_COMMIT) {
+    _port_out(port, value, wide);
+    return;
+  }
+  // the legacy core's writes are the real ones
+  if (_io_mode == IO_REPLAY) {
+    _port_out(port, value, wide);
+  }
+  if (_log->port_wr_count >= LOCKSTEP_MAX_LOG) {
+    _log->overflow = true;
+    return;
+  }
+  struct lockstep_port_t *p = &_log->port_wr[_log->port_wr_count++];
+  p->port = port;
+  p->value = value;
+  p->wide = wide;
+}
+
+static void _hook_port_write_8(uint16_t port, uint8_t value) {
+  _port_write(port, value, 0);
+}
+
+static void _hook_port_write_16(uint16_t port, uint16_t value) {
+  _port_write(port, value, 1);
+}
+
+static void _hook_int_call(uint16_t num) {
+  if (_io_mode == IO_PASS || _io_mode == IO_COMMIT) {
+    intcall86(num);
+    return;
+  }
+  // abandon this step, it will be rerun once in pass mode
+  _log->int_raised = true;
+}
+
+// ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- compare
+
+static void _log_clear(struct lockstep_log_t *log) {
+  log->mem_count = 0;
+  log->port_rd_count = 0;
+  log->port_wr_count = 0;
+  log->int_raised = false;
+  log->overflow = false;
+}
+
+static void _log_undo(const struct lockstep_log_t *log) {
+  for (int32_t i = (int32_t)log->mem_count - 1; i >= 0; --i) {
+    const struct lockstep_write_t *w = &log->mem[i];
+    if (w->undo) {
+      RAM[w->addr] = w->old;
+    }
+  }
+}
+
+// the final value written to 'addr' in this step or -1 if not written
+static int32_t _log_final(const struct lockstep_log_t *log, uint32_t addr) {
+  int32_t out = -1;
+  for (uint32_t i = 0; i < log->mem_count; ++i) {
+    if (log->mem[i].addr == addr) {
+      out = log->mem[i].value;
+    }
+  }
+  return out;
+}
+
+static bool _mem_match(const struct lockstep_log_t *a,
+                       const struct lockstep_log_t *b,
+                       uint32_t *bad_addr) {
+  for (uint32_t i = 0; i < a->mem_count; ++i) {
+    const uint32_t addr = a->mem[i].addr;
+    if (_log_final(a, addr) != _log_final(b, addr)) {
+      *bad_addr = addr;
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < b->mem_count; ++i) {
+    const uint32_t addr = b->mem[i].addr;
+    if (_log_final(a, addr) != _log_final(b, addr)) {
+      *bad_addr = addr;
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool _port_match(const struct lockstep_log_t *a,
+                        const struct lockstep_log_t *b) {
+  if (a->port_wr_count != b->port_wr_count) {
+    return false;
+  }
+  for (uint32_t i = 0; i < a->port_wr_count; ++i) {
+    if (a->port_wr[i].port  != b->port_wr[i].port ||
+        a->port_wr[i].value != b->port_wr[i].value ||
+        a->port_wr[i].wide  != b->port_wr[i].wide) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the redux core delays STI by one instruction, fold the pending bit in so
+// the shadow alone is not reported as a divergence
+static uint16_t _redux_flags(const struct cpu_snapshot_t *s) {
+  uint16_t flags;
+  const union cpu_flags_t save = cpu_flags;
+  cpu_flags = s->flags;
+  flags = cpu_get_flags();
+  cpu_flags = save;
+  if ((s->redux_sti_sr >> 1) & 1) {
+    flags |= 0x0200;
+  }
+  return flags;
+}
+
+static uint16_t _legacy_flags(const struct cpu_snapshot_t *s) {
+  uint16_t flags;
+  const union cpu_flags_t save = cpu_flags;
+  cpu_flags = s->flags;
+  flags = cpu_get_flags();
+  cpu_flags = save;
+  return flags;
+}
+
+static void _dump_regs(const char *name, const struct cpu_snapshot_t *s,
+                       uint16_t flags) {
+  const struct cpu_regs_t *r = &s->regs;
+  printf("  %-6s AX=%04x BX=%04x CX=%04x DX=%04x SP=%04x BP=%04x SI=%04x DI=%04x\n",
+         name, r->ax, r->bx, r->cx, r->dx, r->sp, r->bp, r->si, r->di);
+  printf("  %-6s CS=%04x DS=%04x ES=%04x SS=%04x IP=%04x FL=%04x\n",
+         "", r->cs, r->ds, r->es, r->ss, r->ip, flags);
+}
+
+static void _report(const struct cpu_snapshot_t *pre,
+                    const struct cpu_snapshot_t *redux,
+                    const struct cpu_snapshot_t *legacy,
+                    const char *reason) {
+  char text[64];
+  const uint32_t eip = CPU_ADDR((uint32_t)pre->regs.cs, pre->regs.ip) & 0xFFFFF;
+  const uint32_t len = cpu_disasm(RAM + eip, text, sizeof(text));
+
+  printf("lockstep divergence after %llu checked steps (%llu unchecked)\n",
+         (unsigned long long)_steps_checked,
+         (unsigned long long)_steps_unchecked);
+  printf("  reason: %s\n", reason);
+  printf("  %04x:%04x  ", pre->regs.cs, pre->regs.ip);
+  for (uint32_t i = 0; i < 6; ++i) {
+    if (i < len) {
+      printf("%02x ", RAM[(eip + i) & 0xFFFFF]);
+    }
+    else {
+      printf("   ");
+    }
+  }
+  printf(" %s\n", text);
+  _dump_regs("before", pre, _legacy_flags(pre));
+  _dump_regs("redux", redux, _redux_flags(redux));
+  _dump_regs("legacy", legacy, _legacy_flags(legacy));
+
+  for (uint32_t i = 0; i < _log_redux.mem_count; ++i) {
+    printf("  redux  write [%05x] = %02x\n",
+           _log_redux.mem[i].addr, _log_redux.mem[i].value);
+  }
+  for (uint32_t i = 0; i < _log_legacy.mem_count; ++i) {
+    printf("  legacy write [%05x] = %02x\n",
+           _log_legacy.mem[i].addr, _log_legacy.mem[i].value);
+  }
+  for (uint32_t i = 0; i < _log_redux.port_wr_count; ++i) {
+    printf("  redux  out %04x, %04x\n",
+           _log_redux.port_wr[i].port, _log_redux.port_wr[i].value);
+  }
+  for (uint32_t i = 0; i < _log_legacy.port_wr_count; ++i) {
+    printf("  legacy out %04x, %04x\n",
+           _log_legacy.port_wr[i].port, _log_legacy.port_wr[i].value);
+  }
+}
+
+// ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- ---- public
+
+void lockstep_init(void) {
+  struct cpu_io_t io;
+  io.ram           = RAM;
+  io.mem_read_8    = read86;
+  io.mem_read_16   = readw86;
+  io.mem_write_8   = _hook_write_8;
+  io.mem_write_16  = _hook_write_16;
+  io.port_read_8   = _hook_port_read_8;
+  io.port_read_16  = _hook_port_read_16;
+  io.port_write_8  = _hook_port_write_8;
+  io.port_write_16 = _hook_port_write_16;
+  io.int_call      = _hook_int_call;
+  cpu_set_io(&io);
+
+  _io_mode = IO_PASS;
+  _steps_checked = 0;
+  _steps_unchecked = 0;
+}
+
+// execute one instruction on both cores
+// return executed cycles, or -1 if the cores diverged
+int32_t lockstep_step(void) {
+  struct cpu_snapshot_t pre, redux, legacy;
+  const struct structpic pic = i8259;
+
+  cpu_snapshot_save(&pre);
+
+  // run the redux core and record its side effects
+  _log = &_log_redux;
+  _log_clear(_log);
+  _io_mode = IO_RECORD;
+  cpu_redux_enable = true;
+  cpu_exec86(1);
+  cpu_snapshot_save(&redux);
+
+  // rewind
+  _log_undo(&_log_redux);
+  cpu_snapshot_load(&pre);
+  i8259 = pic;
+
+  if (_log_redux.int_raised || _log_redux.overflow) {
+    // cant be compared, run once for real on the legacy core
+    _replay_pos = 0;
+    _io_mode = IO_COMMIT;
+    cpu_redux_enable = false;
+    const int32_t executed = cpu_exec86(1);
+    _io_mode = IO_PASS;
+    ++_steps_unchecked;
+    return executed;
+  }
+
+  // run the legacy core replaying the recorded port reads
+  _log = &_log_legacy;
+  _log_clear(_log);
+  _replay_pos = 0;
+  _replay_error = false;
+  _io_mode = IO_REPLAY;
+  cpu_redux_enable = false;
+  const int32_t executed = cpu_exec86(1);
+  cpu_snapshot_save(&legacy);
+  _io_mode = IO_PASS;
+
+  if (_log_legacy.int_raised) {
+    _report(&pre, &redux, &legacy, "interupt raised by legacy core only");
+    return -1;
+  }
+
+  // the legacy journal is incomplete, the step happened but cant be compared
+  if (_log_legacy.overflow) {
+    ++_steps_unchecked;
+    return executed;
+  }
+
+  // compare the two results
+  uint32_t bad_addr;
+  const char *reason = NULL;
+  if (memcmp(&redux.regs, &legacy.regs, sizeof(struct cpu_regs_t))) {
+    reason = "register mismatch";
+  }
+  else if (_redux_flags(&redux) != _legacy_flags(&legacy)) {
+    reason = "flags mismatch";
+  }
+  else if (_replay_error || _replay_pos != _log_redux.port_rd_count) {
+    reason = "port read sequence mismatch";
+  }
+  else if (!_port_match(&_log_redux, &_log_legacy)) {
+    reason = "port write mismatch";
+  }
+  else if (!_mem_match(&_log_redux, &_log_legacy, &bad_addr)) {
+    static char text[48];
+    snprintf(text, sizeof(text), "memory write mismatch at %05x", bad_addr);
+    reason = text;
+  }
+
+  if (reason) {
+    _report(&pre, &redux, &legacy, reason);
+    return -1;
+  }
+
+  ++_steps_checked;
+  return executed;
+}
+
+void lockstep_report(void) {
+  printf("lockstep: %llu steps checked, %llu unchecked, no divergence\n",
+         (unsigned long long)_steps_checked,
+         (unsigned long long)_steps_unchecked);
+}
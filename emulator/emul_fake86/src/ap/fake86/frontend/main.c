@@ -89,6 +89,72 @@ static void emulate_loop_headless(void) {
   cpu_dump_state(stdout);
 }
 
+static void emulate_loop_lockstep(uint64_t steps) {
+  lockstep_init();
+  for (uint64_t i = 0; cpu_running && i < steps; ++i) {
+    const int32_t executed = lockstep_step();
+    if (executed < 0) {
+      break;
+    }
+    tick_hardware(executed);
+    if (i + 1 == steps) {
+      lockstep_report();
+    }
+  }
+  cpu_redux_enable = USE_CPU_REDUX;
+}
+
+// return instructions executed, the cycles only pace the devices
+static uint64_t emulate_bench_core(uint64_t steps, uint64_t *out_ms) {
+  const uint64_t first = cpu_instructions;
+  uint64_t cpu_ms = 0;
+  while (cpu_running && cpu_instructions - first < steps) {
+    const int64_t target = min(CYCLES_PER_SLICE, i8253_cycles_before_irq());
+    const uint64_t start = get_ticks();
+    const int64_t executed = tick_cpu(max(target, 1));
+    cpu_ms += get_ticks() - start;
+    tick_hardware(executed);
+  }
+  *out_ms = max(cpu_ms, 1);
+  return cpu_instructions - first;
+}
+
+// modes asked for from the cmdif thread, run by the emulation loop
+static volatile uint64_t _req_lockstep;
+static volatile uint64_t _req_bench;
+
+static void cpu_setup(void);
+static void emulate_bench(uint64_t steps);
+
+void fake86RequestLockstep(uint32_t steps) {
+  _req_lockstep = steps;
+}
+
+void fake86RequestBench(uint32_t steps) {
+  _req_bench = steps;
+}
+
+static void emulate_request(void) {
+  const uint64_t lockstep = _req_lockstep;
+  const uint64_t bench = _req_bench;
+  _req_lockstep = 0;
+  _req_bench = 0;
+
+  if (lockstep) {
+    emulate_loop_lockstep(lockstep);
+    // back to the plain io hooks
+    cpu_setup();
+  }
+  if (bench) {
+    // the window is up already, the cold boots dont need it again
+    const bool headless = _cl_headless;
+    _cl_headless = true;
+    emulate_bench(bench);
+    _cl_headless = headless;
+  }
+  cpu_running = true;
+}
+
 static void emulate_loop(void) {
 
 #define CYCLES_PER_REFRESH (CYCLES_PER_SECOND / 30)
@@ -100,6 +166,13 @@ static void emulate_loop(void) {
   // enter main emulation loop
   while (cpu_running) {
 
+    if (_req_lockstep || _req_bench) {
+      emulate_request();
+      old_ms = get_ticks();
+      cpu_acc = 0;
+      continue;
+    }
+
     // diff cycle time
     const uint64_t new_ms = get_ticks();
     const uint64_t new_cycles = MSTOCYCLES(new_ms - old_ms);
@@ -247,6 +320,32 @@ static bool emulate_init(void) {
   return true;
 }
 
+static bool load_roms(void);
+
+static void emulate_bench(uint64_t steps) {
+  static const char *name[2] = {"legacy", "redux"};
+  uint64_t cpu_ms[2];
+  uint64_t done[2];
+
+  for (int i = 0; i < 2; ++i) {
+    // boot each core from the same cold state
+    if (!emulate_init() || !load_roms()) {
+      printf("bench: init fail\n");
+      return;
+    }
+    cpu_redux_enable = (i == 1);
+    cpu_running = true;
+    done[i] = emulate_bench_core(steps, &cpu_ms[i]);
+  }
+  for (int i = 0; i < 2; ++i) {
+    printf("bench: %-6s %llu instructions in %llu ms, %.2f MIPS\n",
+           name[i], (unsigned long long)done[i],
+           (unsigned long long)cpu_ms[i],
+           (double)done[i] / (double)cpu_ms[i] / 1000.0);
+  }
+  cpu_redux_enable = USE_CPU_REDUX;
+}
+
 static bool load_roms(void) {
   // load bios
   const uint32_t biossize = mem_loadbios(biosfile);
@@ -270,10 +369,18 @@ void fake86Main(int argc, const char *argv[])
 {
   // setup exit handler
   atexit(exit_handler);
+  // parse host command line, the device passes no arguments
+  if (argc > 1 && !cl_parse(argc, argv)) {
+    return;
+  }
   // initialize the log file
 
 
-  if (disk_insert(0, "/fake86/data/dos-boot.img") == true)
+  if (disk_is_inserted(0) == true)
+  {
+    printf("disk_insert OK\n");
+  }
+  else if (disk_insert(0, "/fake86/data/dos-boot.img") == true)
   {
     printf("disk_insert OK\n");
   }
@@ -282,6 +389,11 @@ void fake86Main(int argc, const char *argv[])
     printf("disk_insert Fail\n");
   }
 
+  if (_cl_bench) {
+    emulate_bench(_cl_bench);
+    return;
+  }
+
 
   // initalize the audio stream
 
@@ -301,6 +413,10 @@ void fake86Main(int argc, const char *argv[])
   // enter the emulation loop
   cpu_running = true;
 
+  if (_cl_lockstep) {
+    emulate_loop_lockstep(_cl_lockstep);
+    return;
+  }
 
   emulate_loop();
   //emulate_loop_headless();
@@ -25,6 +25,8 @@
 
 
 bool _cl_headless;
+uint64_t _cl_lockstep;
+uint64_t _cl_bench;
 
 
 typedef bool(*cl_callback_t)(const char *opt, const char *arg[]);
@@ -81,6 +83,11 @@ static bool _cl_do_bios(const char *opt, const char *arg[]) {
   return true;
 }
 
+static bool _cl_do_basic(const char *opt, const char *arg[]) {
+  rom_basic = *arg;
+  return true;
+}
+
 static bool _cl_do_fullscreen(const char *opt, const char *arg[]) {
   do_fullscreen = true;
   return true;
@@ -102,6 +109,20 @@ static bool _cl_do_quiet(const char *opt, const char *arg[]) {
   return true;
 }
 
+static bool _cl_do_lockstep(const char *opt, const char *arg[]) {
+  _cl_lockstep = strtoull(*arg, NULL, 0);
+  _cl_headless = true;
+  audio_enable = false;
+  return true;
+}
+
+static bool _cl_do_bench(const char *opt, const char *arg[]) {
+  _cl_bench = strtoull(*arg, NULL, 0);
+  _cl_headless = true;
+  audio_enable = false;
+  return true;
+}
+
 static const struct cl_entry_t _cl_list[] = {
   {"-help", 0, _cl_do_help, "Display this help page"
   },
@@ -130,6 +151,9 @@ static const struct cl_entry_t _cl_list[] = {
     "   -bios pcxtbios.bin\n"
     "   -bios landmarktest.bin\n"
   },
+  {"-basic", 1, _cl_do_basic, "Specify rom basic image to load",
+    "   -basic rombasic.bin\n"
+  },
   {"-fullscreen", 0, _cl_do_fullscreen, "Enable fullscreen mode"
   },
   {"-frameskip", 1, _cl_do_frameskip, "Number of frames to skip",
@@ -145,6 +169,16 @@ static const struct cl_entry_t _cl_list[] = {
   {
     "-quiet", 0, _cl_do_quiet, "Dont output on console"
   },
+  {
+    "-lockstep", 1, _cl_do_lockstep, "Run both cpu cores in lockstep and report the first divergence",
+    "   -lockstep [instructions]\n"
+    "   -lockstep 10000000\n"
+  },
+  {
+    "-bench", 1, _cl_do_bench, "Run each cpu core headless for a number of instructions and report MIPS",
+    "   -bench [instructions]\n"
+    "   -bench 50000000\n"
+  },
   {NULL, 0, NULL, NULL}
 };
 
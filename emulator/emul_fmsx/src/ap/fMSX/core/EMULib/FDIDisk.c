@@ -38,6 +38,9 @@
 #define FDI_TRACK(P,T)    (FDI_DATA(P)+(T)[0]+((int)((T)[1])<<8)+((int)((T)[2])<<16)+((int)((T)[3])<<24))
 #define FDI_SECSIZE(S)    (SecSizes[(S)[3]<=4? (S)[3]:4])
 #define FDI_SECTOR(P,T,S) (FDI_TRACK(P,T)+(S)[5]+((int)((S)[6])<<8))
+#define FDI_OFFSET(D,T)   ((D)->Base+(T)[0]+((int)((T)[1])<<8)+((int)((T)[2])<<16)+((int)((T)[3])<<24))
+
+#define FDI_IDLE   60      /* IdleFDI() calls before write-back */
 
 static const struct { int Sides,Tracks,Sectors,SecSize; } Formats[] =
 {
@@ -73,11 +76,142 @@ static int stricmpn(const char *S1,const char *S2,int Limit)
   return(Limit? toupper(*S1)-toupper(*S2):0);
 }
 
+/** TrackDir() ***********************************************/
+/** Return .FDI directory entry for track J (Track*Sides+   **/
+/** Side).                                                  **/
+/*************************************************************/
+static byte *TrackDir(FDIDisk *D,int J)
+{
+  byte *P;
+
+  for(P=FDI_DIR(D->Data);J;--J) P+=(FDI_SECTORS(P)+1)*7;
+  return(P);
+}
+
+/** WriteTrack() *********************************************/
+/** Write modified sectors of a cached track back into the  **/
+/** image file. Modifications to read-only images are       **/
+/** dropped. Returns 1 on success or 0 on failure.          **/
+/*************************************************************/
+static int WriteTrack(FDIDisk *D,FDITrack *C)
+{
+  unsigned int M;
+  int I,N,Offset,Result;
+  FRESULT R;
+  FIL F;
+  UINT len;
+
+  /* Nothing to do if track has not been modified */
+  if(!C->Dirty) return(1);
+
+  R = D->ReadOnly? FR_DENIED:f_open(&F,D->Name,FA_WRITE|FA_OPEN_EXISTING);
+  if((R==FR_DENIED)||(R==FR_WRITE_PROTECTED))
+  {
+    if(D->Verbose&&!D->ReadOnly) printf("FDIDisk: '%s' is read-only, writes dropped\n",D->Name);
+    D->ReadOnly = 1;
+    C->Dirty    = 0;
+    return(1);
+  }
+  if(R!=FR_OK) return(0);
+
+  Offset = FDI_OFFSET(D,TrackDir(D,C->Track));
+
+  /* Write every run of modified sectors with a single call */
+  for(I=0,M=C->Dirty,Result=1;M;)
+    if(!(M&1)) { ++I;M>>=1; }
+    else
+    {
+      for(N=0;M&1;++N,M>>=1);
+      if((f_lseek(&F,Offset+I*D->SecSize)!=FR_OK)
+       ||(f_write(&F,C->Data+I*D->SecSize,N*D->SecSize,&len)!=FR_OK)
+       ||(len!=N*D->SecSize)) { Result=0;break; }
+      I+=N;
+    }
+
+  f_close(&F);
+
+  if(Result) C->Dirty=0;
+  return(Result);
+}
+
+/** LoadTrack() **********************************************/
+/** Return cached track J with directory entry P, reading   **/
+/** it into the least recently used slot first if needed.   **/
+/** Returns 0 on failure.                                   **/
+/*************************************************************/
+static FDITrack *LoadTrack(FDIDisk *D,int J,const byte *P)
+{
+  FDITrack *C,*Old;
+  int I;
+  FIL F;
+  UINT len;
+
+  /* Look for the track, free slots are the least recent */
+  for(I=0,C=Old=D->Cache;I<FDI_CACHED;++I,++C)
+    if(C->Track==J) { C->Used=++D->Stamp;return(C); }
+    else if(C->Used<Old->Used) Old=C;
+
+  /* Replace the old track, writing it back if modified. A    */
+  /* failed write-back does not fail the read, it is reported */
+  /* by the next FlushFDI() instead.                          */
+  C=Old;
+  if(!WriteTrack(D,C))
+  {
+    if(D->Verbose) printf("FDIDisk: Failed writing track %d of '%s'\n",C->Track,D->Name);
+    D->WriteError = 1;
+    C->Dirty      = 0;
+  }
+  if(!C->Data&&!(C->Data=(byte *)malloc(D->TrackSize))) return(0);
+  C->Track = -1;
+
+  /* Read the track, anything past the end of file is zeros */
+  if(f_open(&F,D->Name,FA_READ)!=FR_OK) return(0);
+  if(f_lseek(&F,FDI_OFFSET(D,P))!=FR_OK) len=0;
+  else if(f_read(&F,C->Data,D->TrackSize,&len)!=FR_OK) len=0;
+  f_close(&F);
+  if(len<D->TrackSize) memset(C->Data+len,0,D->TrackSize-len);
+
+  if(D->Verbose) printf("FDIDisk: Read track %d of '%s'\n",J,D->Name);
+
+  C->Track = J;
+  C->Used  = ++D->Stamp;
+  return(C);
+}
+
+/** SectorData() *********************************************/
+/** Return data of sector T on track J with directory entry **/
+/** P, reading the track in if the image is read on demand. **/
+/*************************************************************/
+static byte *SectorData(FDIDisk *D,int J,byte *P,byte *T)
+{
+  FDITrack *C;
+
+  if(!D->Name) return(FDI_SECTOR(D->Data,P,T));
+  C = LoadTrack(D,J,P);
+  return(C? C->Data+T[5]+((int)(T[6])<<8):0);
+}
+
+/** OnDemand() ***********************************************/
+/** Make disk with the .FDI directory in Data read tracks   **/
+/** from a file, starting at Base, as they are accessed.    **/
+/** Returns 1 on success or 0 on failure.                   **/
+/*************************************************************/
+static int OnDemand(FDIDisk *D,const char *FileName,int Base)
+{
+  if(!(D->Name=(char *)malloc(strlen(FileName)+1))) return(0);
+  strcpy(D->Name,FileName);
+  D->Base      = Base;
+  D->TrackSize = D->Sectors*D->SecSize;
+  return(1);
+}
+
 /** InitFDI() ************************************************/
 /** Clear all data structure fields.                        **/
 /*************************************************************/
 void InitFDI(FDIDisk *D)
 {
+  int J;
+
   D->Format   = 0;
   D->Data     = 0;
   D->DataSize = 0;
@@ -85,6 +219,22 @@ void InitFDI(FDIDisk *D)
   D->Tracks   = 0;
   D->Sectors  = 0;
   D->SecSize  = 0;
+
+  D->Name      = 0;
+  D->Base      = 0;
+  D->TrackSize = 0;
+  D->Idle      = 0;
+  D->Stamp     = 0;
+  D->ReadOnly  = 0;
+  D->WriteError = 0;
+
+  for(J=0;J<FDI_CACHED;++J)
+  {
+    D->Cache[J].Track = -1;
+    D->Cache[J].Used  = 0;
+    D->Cache[J].Dirty = 0;
+    D->Cache[J].Data  = 0;
+  }
 }
 
 /** EjectFDI() ***********************************************/
@@ -92,16 +242,26 @@ void InitFDI(FDIDisk *D)
 /*************************************************************/
 void EjectFDI(FDIDisk *D)
 {
+  int J;
+
+  /* Write back whatever has been modified */
+  FlushFDI(D);
+
+  for(J=0;J<FDI_CACHED;++J)
+    if(D->Cache[J].Data) free(D->Cache[J].Data);
+
+  if(D->Name) free(D->Name);
   if(D->Data) free(D->Data);
   InitFDI(D);
 }
 
-/** NewFDI() *************************************************/
+/** CreateFDI() **********************************************/
 /** Allocate memory and create new .FDI disk image of given **/
-/** dimensions. Returns disk data pointer on success, 0 on  **/
-/** failure.                                                **/
+/** dimensions. When WithData=0, only allocate the header   **/
+/** and track directory. Returns disk data pointer on       **/
+/** success, 0 on failure.                                  **/
 /*************************************************************/
-byte *NewFDI(FDIDisk *D,int Sides,int Tracks,int Sectors,int SecSize)
+static byte *CreateFDI(FDIDisk *D,int Sides,int Tracks,int Sectors,int SecSize,int WithData)
 {
   byte *P,*DDir;
   int I,J,K,L,N;
@@ -111,7 +271,7 @@ byte *NewFDI(FDIDisk *D,int Sides,int Tracks,int Sectors,int SecSize)
   if(!SecSizes[L]) return(0);
 
   /* Allocate memory */
-  K = Sides*Tracks*Sectors*SecSize+sizeof(FDIDiskLabel);
+  K = (WithData? Sides*Tracks*Sectors*SecSize:0)+sizeof(FDIDiskLabel);
   I = Sides*Tracks*(Sectors+1)*7+14;
 
   if(!(P=(byte *)malloc(I+K)))
@@ -194,6 +354,71 @@ byte *NewFDI(FDIDisk *D,int Sides,int Tracks,int Sectors,int SecSize)
   return(FDI_DATA(P));
 }
 
+/** NewFDI() *************************************************/
+/** Allocate memory and create new .FDI disk image of given **/
+/** dimensions. Returns disk data pointer on success, 0 on  **/
+/** failure.                                                **/
+/*************************************************************/
+byte *NewFDI(FDIDisk *D,int Sides,int Tracks,int Sectors,int SecSize)
+{
+  return(CreateFDI(D,Sides,Tracks,Sectors,SecSize,1));
+}
+
+/** HeaderFDI() **********************************************/
+/** Read .FDI header and track directory from an open file, **/
+/** leaving sector data to be read on demand. Only images   **/
+/** with uniform, aligned sectors qualify. Returns disk     **/
+/** data pointer on success, 0 on failure.                  **/
+/*************************************************************/
+static byte *HeaderFDI(FDIDisk *D,FIL *F,const char *FileName)
+{
+  byte Buf[14],*P,*DDir,*T;
+  int I,J,L,Sectors,SecSize;
+  UINT len;
+
+  /* Read fixed part of the header, check magic number */
+  if((f_read(F,Buf,14,&len)!=FR_OK)||(len!=14)||memcmp(Buf,"FDI",3))
+    return(0);
+
+  /* Header, directory, and description precede sector data */
+  L = Buf[10]+((int)Buf[11]<<8);
+  if((L<14)||(L>f_size(F))||!(P=(byte *)malloc(L))) return(0);
+  memcpy(P,Buf,14);
+  if((f_read(F,P+14,L-14,&len)!=FR_OK)||(len!=L-14)) { free(P);return(0); }
+
+  /* All tracks must have the same sectors, each at a multiple */
+  /* of the sector size, so that dirty bits map onto sectors   */
+  Sectors = SecSize = 0;
+  for(J=FDI_SIDES(P)*FDI_TRACKS(P),DDir=FDI_DIR(P);J;--J,DDir=T)
+  {
+    if(DDir+7>P+L) break;
+    I = FDI_SECTORS(DDir);
+    if(!Sectors) Sectors=I; else if(Sectors!=I) break;
+    if(DDir+(I+1)*7>P+L) break;
+    for(T=DDir+7;I;--I,T+=7)
+    {
+      if(!SecSize) SecSize=FDI_SECSIZE(T);
+      if((FDI_SECSIZE(T)!=SecSize)
+       ||((T[5]+((int)T[6]<<8))%SecSize)
+       ||(T[5]+((int)T[6]<<8)+SecSize>Sectors*SecSize)) break;
+    }
+    if(I) break;
+  }
+  if(J||!Sectors||(Sectors>32)||!SecSize) { free(P);return(0); }
+
+  /* Eject current disk image */
+  EjectFDI(D);
+  D->Data     = P;
+  D->DataSize = L;
+  D->Sides    = FDI_SIDES(P);
+  D->Tracks   = FDI_TRACKS(P);
+  D->Sectors  = Sectors;
+  D->SecSize  = SecSize;
+
+  if(!OnDemand(D,FileName,L)) { EjectFDI(D);return(0); }
+  return(P);
+}
+
 #ifdef ZLIB
 #define fopen(N,M)      (FILE *)gzopen(N,M)
 #define fclose(F)       gzclose((gzFile)(F))
@@ -267,6 +492,9 @@ int LoadFDI(FDIDisk *D,const char *FileName,int Format)
   switch(Format)
   {
     case FMT_FDI: /* If .FDI format... */
+      /* Read just the directory if possible, tracks come later */
+      if((P=HeaderFDI(D,&F,FileName))) break;
+      f_rewind(&F);
       /* Allocate memory and read file */
       if(!(P=(byte *)malloc(J))) { f_close(&F);return(0); }
       if(f_read(&F, P,J,&len) != FR_OK) { free(P);f_close(&F);return(0); }
@@ -316,6 +544,12 @@ int LoadFDI(FDIDisk *D,const char *FileName,int Format)
       I = K&&N? I/K/N:0;                   /* Tracks  */
       /* Number of heads CAN BE WRONG */
       K = I&&N&&L? J/I/N/L:0;
+      /* Build just the directory, read tracks on demand */
+      if((N<=32)&&CreateFDI(D,K,I,N,L,0))
+      {
+        if(OnDemand(D,FileName,0)) { P=D->Data;break; }
+        EjectFDI(D);
+      }
       /* Create a new disk image */
 
       P = NewFDI(D,K,I,N,L);
@@ -548,8 +782,9 @@ int LoadFDI(FDIDisk *D,const char *FileName,int Format)
 
   if(D->Verbose)
     printf(
-      "LoadFDI(): Loaded '%s', %d sides x %d tracks x %d sectors x %d bytes\n",
-      FileName,D->Sides,D->Tracks,D->Sectors,D->SecSize
+      "LoadFDI(): Loaded '%s', %d sides x %d tracks x %d sectors x %d bytes%s\n",
+      FileName,D->Sides,D->Tracks,D->Sectors,D->SecSize,
+      D->Name? " on demand":""
     );
 
   /* Done */
@@ -578,14 +813,25 @@ int LoadFDI(FDIDisk *D,const char *FileName,int Format)
 int SaveFDI(FDIDisk *D,const char *FileName,int Format)
 {
   byte S[32];
-  int I,J,K,C,L;
+  int I,J,K,C,L,N;
   FIL F;
-  byte *P,*T;
+  UINT len;
+  byte *P,*T,*Q;
+  FDITrack *TC;
 
   /* Must have a disk to save */
   if(!D->Data) return(0);
   /* Use original format if requested */
   if(!Format) Format=D->Format;
+
+  /* Images read on demand are saved by writing modified sectors */
+  /* back. Another format would overwrite the file being read.   */
+  if(D->Name)
+  {
+    if(!FlushFDI(D)) return(0);
+    if(!stricmpn(FileName,D->Name,-1)) return(Format==D->Format? Format:0);
+  }
+
   /* Open file for writing */
   if(f_open(&F, FileName,FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return(0);
 
@@ -595,6 +841,18 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format)
     case FMT_FDI:
       if(ff_write(D->Data,1,D->DataSize,&F)!=D->DataSize)
       { f_close(&F);f_unlink(FileName);return(0); }
+      /* Images read on demand only have the directory in memory */
+      if(D->Name)
+        for(J=0;J<FDI_SIDES(D->Data)*FDI_TRACKS(D->Data);++J)
+        {
+          P  = TrackDir(D,J);
+          TC = LoadTrack(D,J,P);
+          if(!TC
+           ||(f_lseek(&F,FDI_OFFSET(D,P)-D->Base+D->DataSize)!=FR_OK)
+           ||(f_write(&F,TC->Data,D->TrackSize,&len)!=FR_OK)
+           ||(len!=D->TrackSize))
+          { f_close(&F);f_unlink(FileName);return(0); }
+        }
       break;
 
     case FMT_IMG:
@@ -624,7 +882,7 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format)
     case FMT_DSK:
       /* Scan through all tracks */
       J = FDI_SIDES(D->Data)*FDI_TRACKS(D->Data);
-      for(P=FDI_DIR(D->Data);J;--J,P=T)
+      for(P=FDI_DIR(D->Data),N=0;J;--J,++N,P=T)
       {
         /* Compute total track length for this format */
         L = Formats[Format].Sectors*Formats[Format].SecSize;
@@ -636,7 +894,8 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format)
             K = FDI_SECSIZE(T);
             K = K>L? L:K;
             L-= K;
-            if(ff_write(FDI_SECTOR(D->Data,P,T),1,K,&F)!=K)
+            Q = SectorData(D,N,P,T);
+            if(!Q||(ff_write(Q,1,K,&F)!=K))
             { f_close(&F);f_unlink(FileName);return(0); }
           }
         /* Fill remaining track length with zeros */
@@ -646,6 +905,8 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format)
       break;
 
     case FMT_SCL:
+      /* Need all sectors in memory */
+      if(D->Name) { f_close(&F);f_unlink(FileName);return(0); }
       /* Get data pointer */
       T=FDI_DATA(D->Data);
       /* Check tracks, sides, sectors, and the TR-DOS magic number */
@@ -688,6 +949,8 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format)
       break;
 
     case FMT_HOBETA:
+      /* Need all sectors in memory */
+      if(D->Name) { f_close(&F);f_unlink(FileName);return(0); }
       /* Get data pointer */
       T=FDI_DATA(D->Data);
       /* Check tracks, sides, sectors, and the TR-DOS magic number */
@@ -738,7 +1001,7 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format)
 byte *SeekFDI(FDIDisk *D,int Side,int Track,int SideID,int TrackID,int SectorID)
 {
   byte *P,*T;
-  int J;
+  int I,J;
 
   /* Have to have disk mounted */
   if(!D||!D->Data) return(0);
@@ -753,15 +1016,15 @@ byte *SeekFDI(FDIDisk *D,int Side,int Track,int SideID,int TrackID,int SectorID)
     case FMT_IMG:
     case FMT_CPCDSK:
     case FMT_SF7000:
-      /* Track directory */
-      P = FDI_DIR(D->Data);
-      /* Find current track entry */
-      for(J=Track*D->Sides+Side%D->Sides;J;--J) P+=(FDI_SECTORS(P)+1)*7;
+      /* Find current track entry, head may be stepped past it */
+      J = Track*D->Sides+Side%D->Sides;
+      if(J>=FDI_SIDES(D->Data)*FDI_TRACKS(D->Data)) return(0);
+      P = TrackDir(D,J);
       /* Find sector entry */
-      for(J=FDI_SECTORS(P),T=P+7;J;--J,T+=7)
+      for(I=FDI_SECTORS(P),T=P+7;I;--I,T+=7)
         if((T[0]==TrackID)&&(T[1]==SideID)&&(T[2]==SectorID)) break;
       /* Fall out if not found */
-      if(!J) return(0);
+      if(!I) return(0);
       /* FDI stores a header for each sector */
       D->Header[0] = T[0];
       D->Header[1] = T[1];
@@ -772,10 +1035,58 @@ byte *SeekFDI(FDIDisk *D,int Side,int Track,int SideID,int TrackID,int SectorID)
       /* FDI has variable sector numbers and sizes */
       D->Sectors   = FDI_SECTORS(P);
       D->SecSize   = FDI_SECSIZE(T);
-      return(FDI_SECTOR(D->Data,P,T));
+      return(SectorData(D,J,P,T));
   }
 
   /* Unknown format */
   return(0);
 }
 
+/** DirtyFDI() ***********************************************/
+/** Mark the sector containing P, as returned by SeekFDI(), **/
+/** as modified. Only images read on demand care about it.  **/
+/*************************************************************/
+void DirtyFDI(FDIDisk *D,const byte *P)
+{
+  FDITrack *C;
+  int J;
+
+  if(!D||!D->Name) return;
+
+  for(J=0,C=D->Cache;J<FDI_CACHED;++J,++C)
+    if((C->Track>=0)&&(P>=C->Data)&&(P<C->Data+D->TrackSize))
+    {
+      C->Dirty|= 1U<<((P-C->Data)/D->SecSize);
+      D->Idle  = FDI_IDLE;
+      return;
+    }
+}
+
+/** FlushFDI() ***********************************************/
+/** Write modified sectors back to the image file. Returns  **/
+/** 1 on success or 0 on failure, including failures when   **/
+/** tracks were replaced since the last call.               **/
+/*************************************************************/
+int FlushFDI(FDIDisk *D)
+{
+  int J,Result;
+
+  D->Idle = 0;
+  if(!D->Name) return(1);
+
+  for(J=0,Result=!D->WriteError;J<FDI_CACHED;++J)
+    if(!WriteTrack(D,&D->Cache[J])) Result=0;
+  D->WriteError = 0;
+
+  return(Result);
+}
+
+/** IdleFDI() ************************************************/
+/** Call periodically while the controller is idle. Writes  **/
+/** modified sectors back once they have settled down.      **/
+/*************************************************************/
+void IdleFDI(FDIDisk *D)
+{
+  if(D->Idle&&!--D->Idle) FlushFDI(D);
+}
+
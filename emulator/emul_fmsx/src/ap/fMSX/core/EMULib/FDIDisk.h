@@ -30,14 +30,29 @@ extern "C" {
 
 #define DataFDI(D) ((D)->Data+(D)->Data[10]+((int)((D)->Data[11])<<8))
 
+#define FDI_CACHED 8       /* Tracks cached per on-demand image */
+
 #ifndef BYTE_TYPE_DEFINED
 #define BYTE_TYPE_DEFINED
 typedef unsigned char byte;
 #endif
 
+/** FDITrack *************************************************/
+/** A track of an on-demand disk image held in memory.      **/
+/*************************************************************/
+typedef struct
+{
+  int  Track;      /* Track*Sides+Side, or -1 if slot is free */
+  unsigned int Used;  /* Last access, for LRU replacement */
+  unsigned int Dirty; /* Bit N set: sector N modified */
+  byte *Data;      /* Track data */
+} FDITrack;
+
 /** FDIDisk **************************************************/
 /** This structure contains all disk image information and  **/
-/** also the result of the last SeekFDI() call.             **/
+/** also the result of the last SeekFDI() call. Images that **/
+/** are read on demand keep only the .FDI header and track  **/
+/** directory in Data, and Name is set.                     **/
 /*************************************************************/
 typedef struct
 {
@@ -52,6 +67,15 @@ typedef struct
 
   byte Header[6];  /* Current header, result of SeekFDI() */
   byte Verbose;    /* 1: Print debugging messages */
+
+  char *Name;      /* Image file read on demand, or 0 */
+  int  Base;       /* File offset of the track data */
+  int  TrackSize;  /* Bytes per track */
+  int  Idle;       /* IdleFDI() calls left until write-back */
+  byte ReadOnly;   /* 1: Image file is read-only, writes are dropped */
+  byte WriteError; /* 1: Write-back failed since last FlushFDI() */
+  unsigned int Stamp;            /* LRU clock */
+  FDITrack Cache[FDI_CACHED];    /* Tracks read so far */
 } FDIDisk;
 
 /** InitFDI() ************************************************/
@@ -94,6 +118,25 @@ int SaveFDI(FDIDisk *D,const char *FileName,int Format);
 /*************************************************************/
 byte *SeekFDI(FDIDisk *D,int Side,int Track,int SideID,int TrackID,int SectorID);
 
+/** DirtyFDI() ***********************************************/
+/** Mark the sector containing P, as returned by SeekFDI(), **/
+/** as modified. Only images read on demand care about it.  **/
+/*************************************************************/
+void DirtyFDI(FDIDisk *D,const byte *P);
+
+/** FlushFDI() ***********************************************/
+/** Write modified sectors back to the image file. Returns  **/
+/** 1 on success or 0 on failure, including failures when   **/
+/** tracks were replaced since the last call.               **/
+/*************************************************************/
+int FlushFDI(FDIDisk *D);
+
+/** IdleFDI() ************************************************/
+/** Call periodically while the controller is idle. Writes  **/
+/** modified sectors back once they have settled down.      **/
+/*************************************************************/
+void IdleFDI(FDIDisk *D);
+
 #ifdef __cplusplus
 }
 #endif
@@ -322,6 +322,9 @@ byte Write1793(register WD1793 *D,register byte A,register byte V)
       {
         /* Write data */
         *D->Ptr++=V;
+        /* Once a sector is complete, mark it for write-back */
+        if(!((D->WRLength-1)&(D->Disk[D->Drive]->SecSize-1)))
+          DirtyFDI(D->Disk[D->Drive],D->Ptr-1);
         /* Decrement length */
         if(--D->WRLength)
         {
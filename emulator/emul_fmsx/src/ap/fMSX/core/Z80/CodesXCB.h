@@ -11,54 +11,54 @@
 /**     changes to this file.                               **/
 /*************************************************************/
 
-case RLC_xHL: I=RdZ80(J.W);M_RLC(I);WrZ80(J.W,I);break;
-case RRC_xHL: I=RdZ80(J.W);M_RRC(I);WrZ80(J.W,I);break;
-case RL_xHL:  I=RdZ80(J.W);M_RL(I);WrZ80(J.W,I);break;
-case RR_xHL:  I=RdZ80(J.W);M_RR(I);WrZ80(J.W,I);break;
-case SLA_xHL: I=RdZ80(J.W);M_SLA(I);WrZ80(J.W,I);break;
-case SRA_xHL: I=RdZ80(J.W);M_SRA(I);WrZ80(J.W,I);break;
-case SLL_xHL: I=RdZ80(J.W);M_SLL(I);WrZ80(J.W,I);break;
-case SRL_xHL: I=RdZ80(J.W);M_SRL(I);WrZ80(J.W,I);break;
+OP(RLC_xHL):  I=RdZ80(J.W);M_RLC(I);WrZ80(J.W,I);break;
+OP(RRC_xHL):  I=RdZ80(J.W);M_RRC(I);WrZ80(J.W,I);break;
+OP(RL_xHL):   I=RdZ80(J.W);M_RL(I);WrZ80(J.W,I);break;
+OP(RR_xHL):   I=RdZ80(J.W);M_RR(I);WrZ80(J.W,I);break;
+OP(SLA_xHL):  I=RdZ80(J.W);M_SLA(I);WrZ80(J.W,I);break;
+OP(SRA_xHL):  I=RdZ80(J.W);M_SRA(I);WrZ80(J.W,I);break;
+OP(SLL_xHL):  I=RdZ80(J.W);M_SLL(I);WrZ80(J.W,I);break;
+OP(SRL_xHL):  I=RdZ80(J.W);M_SRL(I);WrZ80(J.W,I);break;
 
-case BIT0_B: case BIT0_C: case BIT0_D: case BIT0_E:
-case BIT0_H: case BIT0_L: case BIT0_A:
-case BIT0_xHL: I=RdZ80(J.W);M_BIT(0,I);break;
-case BIT1_B: case BIT1_C: case BIT1_D: case BIT1_E:
-case BIT1_H: case BIT1_L: case BIT1_A:
-case BIT1_xHL: I=RdZ80(J.W);M_BIT(1,I);break;
-case BIT2_B: case BIT2_C: case BIT2_D: case BIT2_E:
-case BIT2_H: case BIT2_L: case BIT2_A:
-case BIT2_xHL: I=RdZ80(J.W);M_BIT(2,I);break;
-case BIT3_B: case BIT3_C: case BIT3_D: case BIT3_E:
-case BIT3_H: case BIT3_L: case BIT3_A:
-case BIT3_xHL: I=RdZ80(J.W);M_BIT(3,I);break;
-case BIT4_B: case BIT4_C: case BIT4_D: case BIT4_E:
-case BIT4_H: case BIT4_L: case BIT4_A:
-case BIT4_xHL: I=RdZ80(J.W);M_BIT(4,I);break;
-case BIT5_B: case BIT5_C: case BIT5_D: case BIT5_E:
-case BIT5_H: case BIT5_L: case BIT5_A:
-case BIT5_xHL: I=RdZ80(J.W);M_BIT(5,I);break;
-case BIT6_B: case BIT6_C: case BIT6_D: case BIT6_E:
-case BIT6_H: case BIT6_L: case BIT6_A:
-case BIT6_xHL: I=RdZ80(J.W);M_BIT(6,I);break;
-case BIT7_B: case BIT7_C: case BIT7_D: case BIT7_E:
-case BIT7_H: case BIT7_L: case BIT7_A:
-case BIT7_xHL: I=RdZ80(J.W);M_BIT(7,I);break;
+OP(BIT0_B):  OP(BIT0_C):  OP(BIT0_D):  OP(BIT0_E):
+OP(BIT0_H):  OP(BIT0_L):  OP(BIT0_A):
+OP(BIT0_xHL):  I=RdZ80(J.W);M_BIT(0,I);break;
+OP(BIT1_B):  OP(BIT1_C):  OP(BIT1_D):  OP(BIT1_E):
+OP(BIT1_H):  OP(BIT1_L):  OP(BIT1_A):
+OP(BIT1_xHL):  I=RdZ80(J.W);M_BIT(1,I);break;
+OP(BIT2_B):  OP(BIT2_C):  OP(BIT2_D):  OP(BIT2_E):
+OP(BIT2_H):  OP(BIT2_L):  OP(BIT2_A):
+OP(BIT2_xHL):  I=RdZ80(J.W);M_BIT(2,I);break;
+OP(BIT3_B):  OP(BIT3_C):  OP(BIT3_D):  OP(BIT3_E):
+OP(BIT3_H):  OP(BIT3_L):  OP(BIT3_A):
+OP(BIT3_xHL):  I=RdZ80(J.W);M_BIT(3,I);break;
+OP(BIT4_B):  OP(BIT4_C):  OP(BIT4_D):  OP(BIT4_E):
+OP(BIT4_H):  OP(BIT4_L):  OP(BIT4_A):
+OP(BIT4_xHL):  I=RdZ80(J.W);M_BIT(4,I);break;
+OP(BIT5_B):  OP(BIT5_C):  OP(BIT5_D):  OP(BIT5_E):
+OP(BIT5_H):  OP(BIT5_L):  OP(BIT5_A):
+OP(BIT5_xHL):  I=RdZ80(J.W);M_BIT(5,I);break;
+OP(BIT6_B):  OP(BIT6_C):  OP(BIT6_D):  OP(BIT6_E):
+OP(BIT6_H):  OP(BIT6_L):  OP(BIT6_A):
+OP(BIT6_xHL):  I=RdZ80(J.W);M_BIT(6,I);break;
+OP(BIT7_B):  OP(BIT7_C):  OP(BIT7_D):  OP(BIT7_E):
+OP(BIT7_H):  OP(BIT7_L):  OP(BIT7_A):
+OP(BIT7_xHL):  I=RdZ80(J.W);M_BIT(7,I);break;
 
-case RES0_xHL: I=RdZ80(J.W);M_RES(0,I);WrZ80(J.W,I);break;
-case RES1_xHL: I=RdZ80(J.W);M_RES(1,I);WrZ80(J.W,I);break;   
-case RES2_xHL: I=RdZ80(J.W);M_RES(2,I);WrZ80(J.W,I);break;   
-case RES3_xHL: I=RdZ80(J.W);M_RES(3,I);WrZ80(J.W,I);break;   
-case RES4_xHL: I=RdZ80(J.W);M_RES(4,I);WrZ80(J.W,I);break;   
-case RES5_xHL: I=RdZ80(J.W);M_RES(5,I);WrZ80(J.W,I);break;   
-case RES6_xHL: I=RdZ80(J.W);M_RES(6,I);WrZ80(J.W,I);break;   
-case RES7_xHL: I=RdZ80(J.W);M_RES(7,I);WrZ80(J.W,I);break;   
+OP(RES0_xHL):  I=RdZ80(J.W);M_RES(0,I);WrZ80(J.W,I);break;
+OP(RES1_xHL):  I=RdZ80(J.W);M_RES(1,I);WrZ80(J.W,I);break;   
+OP(RES2_xHL):  I=RdZ80(J.W);M_RES(2,I);WrZ80(J.W,I);break;   
+OP(RES3_xHL):  I=RdZ80(J.W);M_RES(3,I);WrZ80(J.W,I);break;   
+OP(RES4_xHL):  I=RdZ80(J.W);M_RES(4,I);WrZ80(J.W,I);break;   
+OP(RES5_xHL):  I=RdZ80(J.W);M_RES(5,I);WrZ80(J.W,I);break;   
+OP(RES6_xHL):  I=RdZ80(J.W);M_RES(6,I);WrZ80(J.W,I);break;   
+OP(RES7_xHL):  I=RdZ80(J.W);M_RES(7,I);WrZ80(J.W,I);break;   
 
-case SET0_xHL: I=RdZ80(J.W);M_SET(0,I);WrZ80(J.W,I);break;   
-case SET1_xHL: I=RdZ80(J.W);M_SET(1,I);WrZ80(J.W,I);break; 
-case SET2_xHL: I=RdZ80(J.W);M_SET(2,I);WrZ80(J.W,I);break; 
-case SET3_xHL: I=RdZ80(J.W);M_SET(3,I);WrZ80(J.W,I);break; 
-case SET4_xHL: I=RdZ80(J.W);M_SET(4,I);WrZ80(J.W,I);break; 
-case SET5_xHL: I=RdZ80(J.W);M_SET(5,I);WrZ80(J.W,I);break; 
-case SET6_xHL: I=RdZ80(J.W);M_SET(6,I);WrZ80(J.W,I);break; 
-case SET7_xHL: I=RdZ80(J.W);M_SET(7,I);WrZ80(J.W,I);break; 
+OP(SET0_xHL):  I=RdZ80(J.W);M_SET(0,I);WrZ80(J.W,I);break;   
+OP(SET1_xHL):  I=RdZ80(J.W);M_SET(1,I);WrZ80(J.W,I);break; 
+OP(SET2_xHL):  I=RdZ80(J.W);M_SET(2,I);WrZ80(J.W,I);break; 
+OP(SET3_xHL):  I=RdZ80(J.W);M_SET(3,I);WrZ80(J.W,I);break; 
+OP(SET4_xHL):  I=RdZ80(J.W);M_SET(4,I);WrZ80(J.W,I);break; 
+OP(SET5_xHL):  I=RdZ80(J.W);M_SET(5,I);WrZ80(J.W,I);break; 
+OP(SET6_xHL):  I=RdZ80(J.W);M_SET(6,I);WrZ80(J.W,I);break; 
+OP(SET7_xHL):  I=RdZ80(J.W);M_SET(7,I);WrZ80(J.W,I);break; 
@@ -0,0 +1,223 @@
+/** Z80: portable Z80 emulator *******************************/
+/**                                                         **/
+/**                          Labels.h                       **/
+/**                                                         **/
+/** This file contains label tables used by the computed-   **/
+/** goto version of RunZ80(). It is included from RunZ80()  **/
+/** in Z80.c, where OP(Name) in Codes*.h is turned into a   **/
+/** Table_Name label. Table order follows enum Codes,       **/
+/** CodesCB, and CodesED.                                   **/
+/**                                                         **/
+/*************************************************************/
+
+/** LABELS() *************************************************/
+/** Main, DD, and FD tables share the enum Codes names.     **/
+/*************************************************************/
+#define LABELS(T) \
+  &&T##_NOP,&&T##_LD_BC_WORD,&&T##_LD_xBC_A,&&T##_INC_BC,\
+  &&T##_INC_B,&&T##_DEC_B,&&T##_LD_B_BYTE,&&T##_RLCA,\
+  &&T##_EX_AF_AF,&&T##_ADD_HL_BC,&&T##_LD_A_xBC,&&T##_DEC_BC,\
+  &&T##_INC_C,&&T##_DEC_C,&&T##_LD_C_BYTE,&&T##_RRCA,\
+  &&T##_DJNZ,&&T##_LD_DE_WORD,&&T##_LD_xDE_A,&&T##_INC_DE,\
+  &&T##_INC_D,&&T##_DEC_D,&&T##_LD_D_BYTE,&&T##_RLA,\
+  &&T##_JR,&&T##_ADD_HL_DE,&&T##_LD_A_xDE,&&T##_DEC_DE,\
+  &&T##_INC_E,&&T##_DEC_E,&&T##_LD_E_BYTE,&&T##_RRA,\
+  &&T##_JR_NZ,&&T##_LD_HL_WORD,&&T##_LD_xWORD_HL,&&T##_INC_HL,\
+  &&T##_INC_H,&&T##_DEC_H,&&T##_LD_H_BYTE,&&T##_DAA,\
+  &&T##_JR_Z,&&T##_ADD_HL_HL,&&T##_LD_HL_xWORD,&&T##_DEC_HL,\
+  &&T##_INC_L,&&T##_DEC_L,&&T##_LD_L_BYTE,&&T##_CPL,\
+  &&T##_JR_NC,&&T##_LD_SP_WORD,&&T##_LD_xWORD_A,&&T##_INC_SP,\
+  &&T##_INC_xHL,&&T##_DEC_xHL,&&T##_LD_xHL_BYTE,&&T##_SCF,\
+  &&T##_JR_C,&&T##_ADD_HL_SP,&&T##_LD_A_xWORD,&&T##_DEC_SP,\
+  &&T##_INC_A,&&T##_DEC_A,&&T##_LD_A_BYTE,&&T##_CCF,\
+  &&T##_LD_B_B,&&T##_LD_B_C,&&T##_LD_B_D,&&T##_LD_B_E,\
+  &&T##_LD_B_H,&&T##_LD_B_L,&&T##_LD_B_xHL,&&T##_LD_B_A,\
+  &&T##_LD_C_B,&&T##_LD_C_C,&&T##_LD_C_D,&&T##_LD_C_E,\
+  &&T##_LD_C_H,&&T##_LD_C_L,&&T##_LD_C_xHL,&&T##_LD_C_A,\
+  &&T##_LD_D_B,&&T##_LD_D_C,&&T##_LD_D_D,&&T##_LD_D_E,\
+  &&T##_LD_D_H,&&T##_LD_D_L,&&T##_LD_D_xHL,&&T##_LD_D_A,\
+  &&T##_LD_E_B,&&T##_LD_E_C,&&T##_LD_E_D,&&T##_LD_E_E,\
+  &&T##_LD_E_H,&&T##_LD_E_L,&&T##_LD_E_xHL,&&T##_LD_E_A,\
+  &&T##_LD_H_B,&&T##_LD_H_C,&&T##_LD_H_D,&&T##_LD_H_E,\
+  &&T##_LD_H_H,&&T##_LD_H_L,&&T##_LD_H_xHL,&&T##_LD_H_A,\
+  &&T##_LD_L_B,&&T##_LD_L_C,&&T##_LD_L_D,&&T##_LD_L_E,\
+  &&T##_LD_L_H,&&T##_LD_L_L,&&T##_LD_L_xHL,&&T##_LD_L_A,\
+  &&T##_LD_xHL_B,&&T##_LD_xHL_C,&&T##_LD_xHL_D,&&T##_LD_xHL_E,\
+  &&T##_LD_xHL_H,&&T##_LD_xHL_L,&&T##_HALT,&&T##_LD_xHL_A,\
+  &&T##_LD_A_B,&&T##_LD_A_C,&&T##_LD_A_D,&&T##_LD_A_E,\
+  &&T##_LD_A_H,&&T##_LD_A_L,&&T##_LD_A_xHL,&&T##_LD_A_A,\
+  &&T##_ADD_B,&&T##_ADD_C,&&T##_ADD_D,&&T##_ADD_E,\
+  &&T##_ADD_H,&&T##_ADD_L,&&T##_ADD_xHL,&&T##_ADD_A,\
+  &&T##_ADC_B,&&T##_ADC_C,&&T##_ADC_D,&&T##_ADC_E,\
+  &&T##_ADC_H,&&T##_ADC_L,&&T##_ADC_xHL,&&T##_ADC_A,\
+  &&T##_SUB_B,&&T##_SUB_C,&&T##_SUB_D,&&T##_SUB_E,\
+  &&T##_SUB_H,&&T##_SUB_L,&&T##_SUB_xHL,&&T##_SUB_A,\
+  &&T##_SBC_B,&&T##_SBC_C,&&T##_SBC_D,&&T##_SBC_E,\
+  &&T##_SBC_H,&&T##_SBC_L,&&T##_SBC_xHL,&&T##_SBC_A,\
+  &&T##_AND_B,&&T##_AND_C,&&T##_AND_D,&&T##_AND_E,\
+  &&T##_AND_H,&&T##_AND_L,&&T##_AND_xHL,&&T##_AND_A,\
+  &&T##_XOR_B,&&T##_XOR_C,&&T##_XOR_D,&&T##_XOR_E,\
+  &&T##_XOR_H,&&T##_XOR_L,&&T##_XOR_xHL,&&T##_XOR_A,\
+  &&T##_OR_B,&&T##_OR_C,&&T##_OR_D,&&T##_OR_E,\
+  &&T##_OR_H,&&T##_OR_L,&&T##_OR_xHL,&&T##_OR_A,\
+  &&T##_CP_B,&&T##_CP_C,&&T##_CP_D,&&T##_CP_E,\
+  &&T##_CP_H,&&T##_CP_L,&&T##_CP_xHL,&&T##_CP_A,\
+  &&T##_RET_NZ,&&T##_POP_BC,&&T##_JP_NZ,&&T##_JP,\
+  &&T##_CALL_NZ,&&T##_PUSH_BC,&&T##_ADD_BYTE,&&T##_RST00,\
+  &&T##_RET_Z,&&T##_RET,&&T##_JP_Z,&&T##_PFX_CB,\
+  &&T##_CALL_Z,&&T##_CALL,&&T##_ADC_BYTE,&&T##_RST08,\
+  &&T##_RET_NC,&&T##_POP_DE,&&T##_JP_NC,&&T##_OUTA,\
+  &&T##_CALL_NC,&&T##_PUSH_DE,&&T##_SUB_BYTE,&&T##_RST10,\
+  &&T##_RET_C,&&T##_EXX,&&T##_JP_C,&&T##_INA,\
+  &&T##_CALL_C,&&T##_PFX_DD,&&T##_SBC_BYTE,&&T##_RST18,\
+  &&T##_RET_PO,&&T##_POP_HL,&&T##_JP_PO,&&T##_EX_HL_xSP,\
+  &&T##_CALL_PO,&&T##_PUSH_HL,&&T##_AND_BYTE,&&T##_RST20,\
+  &&T##_RET_PE,&&T##_LD_PC_HL,&&T##_JP_PE,&&T##_EX_DE_HL,\
+  &&T##_CALL_PE,&&T##_PFX_ED,&&T##_XOR_BYTE,&&T##_RST28,\
+  &&T##_RET_P,&&T##_POP_AF,&&T##_JP_P,&&T##_DI,\
+  &&T##_CALL_P,&&T##_PUSH_AF,&&T##_OR_BYTE,&&T##_RST30,\
+  &&T##_RET_M,&&T##_LD_SP_HL,&&T##_JP_M,&&T##_EI,\
+  &&T##_CALL_M,&&T##_PFX_FD,&&T##_CP_BYTE,&&T##_RST38
+
+static const void *const MainOps[256] = { LABELS(Main) };
+static const void *const DDOps[256]   = { LABELS(DD) };
+static const void *const FDOps[256]   = { LABELS(FD) };
+
+#undef LABELS
+
+static const void *const CBOps[256] =
+{
+  &&CB_RLC_B,&&CB_RLC_C,&&CB_RLC_D,&&CB_RLC_E,
+  &&CB_RLC_H,&&CB_RLC_L,&&CB_RLC_xHL,&&CB_RLC_A,
+  &&CB_RRC_B,&&CB_RRC_C,&&CB_RRC_D,&&CB_RRC_E,
+  &&CB_RRC_H,&&CB_RRC_L,&&CB_RRC_xHL,&&CB_RRC_A,
+  &&CB_RL_B,&&CB_RL_C,&&CB_RL_D,&&CB_RL_E,
+  &&CB_RL_H,&&CB_RL_L,&&CB_RL_xHL,&&CB_RL_A,
+  &&CB_RR_B,&&CB_RR_C,&&CB_RR_D,&&CB_RR_E,
+  &&CB_RR_H,&&CB_RR_L,&&CB_RR_xHL,&&CB_RR_A,
+  &&CB_SLA_B,&&CB_SLA_C,&&CB_SLA_D,&&CB_SLA_E,
+  &&CB_SLA_H,&&CB_SLA_L,&&CB_SLA_xHL,&&CB_SLA_A,
+  &&CB_SRA_B,&&CB_SRA_C,&&CB_SRA_D,&&CB_SRA_E,
+  &&CB_SRA_H,&&CB_SRA_L,&&CB_SRA_xHL,&&CB_SRA_A,
+  &&CB_SLL_B,&&CB_SLL_C,&&CB_SLL_D,&&CB_SLL_E,
+  &&CB_SLL_H,&&CB_SLL_L,&&CB_SLL_xHL,&&CB_SLL_A,
+  &&CB_SRL_B,&&CB_SRL_C,&&CB_SRL_D,&&CB_SRL_E,
+  &&CB_SRL_H,&&CB_SRL_L,&&CB_SRL_xHL,&&CB_SRL_A,
+  &&CB_BIT0_B,&&CB_BIT0_C,&&CB_BIT0_D,&&CB_BIT0_E,
+  &&CB_BIT0_H,&&CB_BIT0_L,&&CB_BIT0_xHL,&&CB_BIT0_A,
+  &&CB_BIT1_B,&&CB_BIT1_C,&&CB_BIT1_D,&&CB_BIT1_E,
+  &&CB_BIT1_H,&&CB_BIT1_L,&&CB_BIT1_xHL,&&CB_BIT1_A,
+  &&CB_BIT2_B,&&CB_BIT2_C,&&CB_BIT2_D,&&CB_BIT2_E,
+  &&CB_BIT2_H,&&CB_BIT2_L,&&CB_BIT2_xHL,&&CB_BIT2_A,
+  &&CB_BIT3_B,&&CB_BIT3_C,&&CB_BIT3_D,&&CB_BIT3_E,
+  &&CB_BIT3_H,&&CB_BIT3_L,&&CB_BIT3_xHL,&&CB_BIT3_A,
+  &&CB_BIT4_B,&&CB_BIT4_C,&&CB_BIT4_D,&&CB_BIT4_E,
+  &&CB_BIT4_H,&&CB_BIT4_L,&&CB_BIT4_xHL,&&CB_BIT4_A,
+  &&CB_BIT5_B,&&CB_BIT5_C,&&CB_BIT5_D,&&CB_BIT5_E,
+  &&CB_BIT5_H,&&CB_BIT5_L,&&CB_BIT5_xHL,&&CB_BIT5_A,
+  &&CB_BIT6_B,&&CB_BIT6_C,&&CB_BIT6_D,&&CB_BIT6_E,
+  &&CB_BIT6_H,&&CB_BIT6_L,&&CB_BIT6_xHL,&&CB_BIT6_A,
+  &&CB_BIT7_B,&&CB_BIT7_C,&&CB_BIT7_D,&&CB_BIT7_E,
+  &&CB_BIT7_H,&&CB_BIT7_L,&&CB_BIT7_xHL,&&CB_BIT7_A,
+  &&CB_RES0_B,&&CB_RES0_C,&&CB_RES0_D,&&CB_RES0_E,
+  &&CB_RES0_H,&&CB_RES0_L,&&CB_RES0_xHL,&&CB_RES0_A,
+  &&CB_RES1_B,&&CB_RES1_C,&&CB_RES1_D,&&CB_RES1_E,
+  &&CB_RES1_H,&&CB_RES1_L,&&CB_RES1_xHL,&&CB_RES1_A,
+  &&CB_RES2_B,&&CB_RES2_C,&&CB_RES2_D,&&CB_RES2_E,
+  &&CB_RES2_H,&&CB_RES2_L,&&CB_RES2_xHL,&&CB_RES2_A,
+  &&CB_RES3_B,&&CB_RES3_C,&&CB_RES3_D,&&CB_RES3_E,
+  &&CB_RES3_H,&&CB_RES3_L,&&CB_RES3_xHL,&&CB_RES3_A,
+  &&CB_RES4_B,&&CB_RES4_C,&&CB_RES4_D,&&CB_RES4_E,
+  &&CB_RES4_H,&&CB_RES4_L,&&CB_RES4_xHL,&&CB_RES4_A,
+  &&CB_RES5_B,&&CB_RES5_C,&&CB_RES5_D,&&CB_RES5_E,
+  &&CB_RES5_H,&&CB_RES5_L,&&CB_RES5_xHL,&&CB_RES5_A,
+  &&CB_RES6_B,&&CB_RES6_C,&&CB_RES6_D,&&CB_RES6_E,
+  &&CB_RES6_H,&&CB_RES6_L,&&CB_RES6_xHL,&&CB_RES6_A,
+  &&CB_RES7_B,&&CB_RES7_C,&&CB_RES7_D,&&CB_RES7_E,
+  &&CB_RES7_H,&&CB_RES7_L,&&CB_RES7_xHL,&&CB_RES7_A,
+  &&CB_SET0_B,&&CB_SET0_C,&&CB_SET0_D,&&CB_SET0_E,
+  &&CB_SET0_H,&&CB_SET0_L,&&CB_SET0_xHL,&&CB_SET0_A,
+  &&CB_SET1_B,&&CB_SET1_C,&&CB_SET1_D,&&CB_SET1_E,
+  &&CB_SET1_H,&&CB_SET1_L,&&CB_SET1_xHL,&&CB_SET1_A,
+  &&CB_SET2_B,&&CB_SET2_C,&&CB_SET2_D,&&CB_SET2_E,
+  &&CB_SET2_H,&&CB_SET2_L,&&CB_SET2_xHL,&&CB_SET2_A,
+  &&CB_SET3_B,&&CB_SET3_C,&&CB_SET3_D,&&CB_SET3_E,
+  &&CB_SET3_H,&&CB_SET3_L,&&CB_SET3_xHL,&&CB_SET3_A,
+  &&CB_SET4_B,&&CB_SET4_C,&&CB_SET4_D,&&CB_SET4_E,
+  &&CB_SET4_H,&&CB_SET4_L,&&CB_SET4_xHL,&&CB_SET4_A,
+  &&CB_SET5_B,&&CB_SET5_C,&&CB_SET5_D,&&CB_SET5_E,
+  &&CB_SET5_H,&&CB_SET5_L,&&CB_SET5_xHL,&&CB_SET5_A,
+  &&CB_SET6_B,&&CB_SET6_C,&&CB_SET6_D,&&CB_SET6_E,
+  &&CB_SET6_H,&&CB_SET6_L,&&CB_SET6_xHL,&&CB_SET6_A,
+  &&CB_SET7_B,&&CB_SET7_C,&&CB_SET7_D,&&CB_SET7_E,
+  &&CB_SET7_H,&&CB_SET7_L,&&CB_SET7_xHL,&&CB_SET7_A
+};
+
+/* ED opcodes without a handler go to ED_Bad */
+static const void *const EDOps[256] =
+{
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_IN_B_xC,&&ED_OUT_xC_B,&&ED_SBC_HL_BC,&&ED_LD_xWORDe_BC,
+  &&ED_NEG,&&ED_RETN,&&ED_IM_0,&&ED_LD_I_A,
+  &&ED_IN_C_xC,&&ED_OUT_xC_C,&&ED_ADC_HL_BC,&&ED_LD_BC_xWORDe,
+  &&ED_Bad,&&ED_RETI,&&ED_Bad,&&ED_LD_R_A,
+  &&ED_IN_D_xC,&&ED_OUT_xC_D,&&ED_SBC_HL_DE,&&ED_LD_xWORDe_DE,
+  &&ED_Bad,&&ED_Bad,&&ED_IM_1,&&ED_LD_A_I,
+  &&ED_IN_E_xC,&&ED_OUT_xC_E,&&ED_ADC_HL_DE,&&ED_LD_DE_xWORDe,
+  &&ED_Bad,&&ED_Bad,&&ED_IM_2,&&ED_LD_A_R,
+  &&ED_IN_H_xC,&&ED_OUT_xC_H,&&ED_SBC_HL_HL,&&ED_LD_xWORDe_HL,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_RRD,
+  &&ED_IN_L_xC,&&ED_OUT_xC_L,&&ED_ADC_HL_HL,&&ED_LD_HL_xWORDe,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_RLD,
+  &&ED_IN_F_xC,&&ED_OUT_xC_F,&&ED_SBC_HL_SP,&&ED_LD_xWORDe_SP,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_IN_A_xC,&&ED_OUT_xC_A,&&ED_ADC_HL_SP,&&ED_LD_SP_xWORDe,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_LDI,&&ED_CPI,&&ED_INI,&&ED_OUTI,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_LDD,&&ED_CPD,&&ED_IND,&&ED_OUTD,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_LDIR,&&ED_CPIR,&&ED_INIR,&&ED_OTIR,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_LDDR,&&ED_CPDR,&&ED_INDR,&&ED_OTDR,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_PFX_ED,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_Bad,&&ED_Bad,
+  &&ED_Bad,&&ED_Bad,&&ED_DB_FE,&&ED_Bad
+};
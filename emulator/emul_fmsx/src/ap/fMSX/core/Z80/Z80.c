@@ -54,8 +54,16 @@ INLINE byte RdZ80(word A) { return(Page[A>>13][A&0x1FFF]); }
 
 #ifdef FMSX
 #define FAST_RDOP
-extern byte *RAM[];
+extern byte *RAM[],EnWrite[];
 INLINE byte OpZ80(word A) { return(RAM[A>>13][A&0x1FFF]); }
+/* Only [xx11 1111 1xxx 1xxx] may hit the FDC, see RdZ80() in MSX.c */
+INLINE byte RDZ80(word A)
+{ return((A&0x3F88)!=0x3F88? RAM[A>>13][A&0x1FFF]:RdZ80(A)); }
+/* EnWrite[] pages are RAM, the rest is ROM, mappers, or FFFFh */
+INLINE void WRZ80(word A,byte V)
+{ if(EnWrite[A>>14]&&(A!=0xFFFF)) RAM[A>>13][A&0x1FFF]=V; else WrZ80(A,V); }
+#define RdZ80 RDZ80
+#define WrZ80 WRZ80
 #endif
 
 #ifdef ATI85
@@ -67,6 +75,14 @@ INLINE byte RdZ80(word A) { return(Page[A>>14][A&0x3FFF]); }
 INLINE void WrZ80(word A,byte V) { if(Page[A>>14]<ROM) Page[A>>14][A&0x3FFF]=V; else DoMEM(A,V); }
 #endif
 
+/** GOTOZ80 **************************************************/
+/** Computed goto is a GCC extension, and it is only used   **/
+/** by RunZ80().                                            **/
+/*************************************************************/
+#if defined(EXECZ80)||!defined(__GNUC__)
+#undef GOTOZ80
+#endif
+
 /** FAST_RDOP ************************************************/
 /** With this #define not present, RdZ80() should perform   **/
 /** the functions of OpZ80().                               **/
@@ -338,6 +354,14 @@ enum CodesED
   DB_F8,DB_F9,DB_FA,DB_FB,DB_FC,DB_FD,DB_FE,DB_FF
 };
 
+/** OP() *****************************************************/
+/** Opcode handlers in Codes*.h start with OP(Name). It is  **/
+/** a case label here, and a plain label in the computed-   **/
+/** goto RunZ80().                                          **/
+/*************************************************************/
+#define OP(Name) case Name
+
+#ifndef GOTOZ80
 static void CodesCB(register Z80 *R)
 {
   register byte I;
@@ -361,6 +385,7 @@ static void CodesCB(register Z80 *R)
         );
   }
 }
+#endif /* !GOTOZ80 */
 
 static void CodesDDCB(register Z80 *R)
 {
@@ -412,6 +437,7 @@ static void CodesFDCB(register Z80 *R)
 #undef XX
 }
 
+#ifndef GOTOZ80
 static void CodesED(register Z80 *R)
 {
   register byte I;
@@ -501,6 +527,7 @@ static void CodesFD(register Z80 *R)
   }
 #undef XX
 }
+#endif /* !GOTOZ80 */
 
 /** ResetZ80() ***********************************************/
 /** This function can be used to reset the register struct  **/
@@ -656,7 +683,7 @@ void IntZ80(Z80 *R,word Vector)
 /** returns INT_QUIT. It will return the PC at which        **/
 /** emulation stopped, and current register values in R.    **/
 /*************************************************************/
-#ifndef EXECZ80
+#if !defined(EXECZ80)&&!defined(GOTOZ80)
 word RunZ80(Z80 *R)
 {
   register byte I;
@@ -722,4 +749,173 @@ word RunZ80(Z80 *R)
   /* Execution stopped */
   return(R->PC.W);
 }
-#endif /* !EXECZ80 */
+#endif /* !EXECZ80 && !GOTOZ80 */
+
+/** RunZ80() *************************************************/
+/** Computed-goto version of RunZ80(). Every opcode table   **/
+/** is included once more with OP(Name) turned into a label **/
+/** and entered through the tables in Labels.h. A "break"   **/
+/** in a handler leaves the do{}while(0) around its table   **/
+/** and goes on to the cycle counter check, exactly where   **/
+/** the switch() version would go.                          **/
+/*************************************************************/
+#ifdef GOTOZ80
+word RunZ80(Z80 *R)
+{
+#include "Labels.h"
+  register byte I;
+  register pair J;
+
+  for(;;)
+  {
+#ifdef DEBUG
+    /* Turn tracing on when reached trap address */
+    if(R->PC.W==R->Trap) R->Trace=1;
+    /* Call single-step debugger, exit if requested */
+    if(R->Trace)
+      if(!DebugZ80(R)) return(R->PC.W);
+#endif
+
+    /* Read opcode and count cycles */
+    I=OpZ80(R->PC.W++);
+    R->ICount-=Cycles[I];
+
+    /* R register incremented on each M1 cycle */
+    INCR(1);
+
+    goto *MainOps[I];
+
+#undef OP
+#define OP(Name) Main_##Name
+    do
+    {
+#include "Codes.h"
+Main_PFX_CB:
+      I=OpZ80(R->PC.W++);
+      R->ICount-=CyclesCB[I];
+      INCR(1);
+      goto *CBOps[I];
+Main_PFX_ED:
+      I=OpZ80(R->PC.W++);
+      R->ICount-=CyclesED[I];
+      INCR(1);
+      goto *EDOps[I];
+Main_PFX_DD:
+      I=OpZ80(R->PC.W++);
+      R->ICount-=CyclesXX[I];
+      INCR(1);
+      goto *DDOps[I];
+Main_PFX_FD:
+      I=OpZ80(R->PC.W++);
+      R->ICount-=CyclesXX[I];
+      INCR(1);
+      goto *FDOps[I];
+    } while(0);
+    goto Done;
+
+#undef OP
+#define OP(Name) CB_##Name
+    do
+    {
+#include "CodesCB.h"
+    } while(0);
+    goto Done;
+
+#undef OP
+#define OP(Name) ED_##Name
+    do
+    {
+#include "CodesED.h"
+ED_PFX_ED:
+      R->PC.W--;break;
+ED_Bad:
+      if(R->TrapBadOps)
+        printf
+        (
+          "[Z80 %lX] Unrecognized instruction: ED %02X at PC=%04X\n",
+          (long)R->User,OpZ80(R->PC.W-1),R->PC.W-2
+        );
+    } while(0);
+    goto Done;
+
+#define XX IX
+#undef OP
+#define OP(Name) DD_##Name
+    do
+    {
+#include "CodesXX.h"
+DD_PFX_FD:
+DD_PFX_DD:
+      R->PC.W--;break;
+DD_PFX_CB:
+      CodesDDCB(R);break;
+DD_PFX_ED:
+      if(R->TrapBadOps)
+        printf
+        (
+          "[Z80 %lX] Unrecognized instruction: DD %02X at PC=%04X\n",
+          (long)R->User,OpZ80(R->PC.W-1),R->PC.W-2
+        );
+    } while(0);
+    goto Done;
+#undef XX
+
+#define XX IY
+#undef OP
+#define OP(Name) FD_##Name
+    do
+    {
+#include "CodesXX.h"
+FD_PFX_FD:
+FD_PFX_DD:
+      R->PC.W--;break;
+FD_PFX_CB:
+      CodesFDCB(R);break;
+FD_PFX_ED:
+        printf
+        (
+          "Unrecognized instruction: FD %02X at PC=%04X\n",
+          OpZ80(R->PC.W-1),R->PC.W-2
+        );
+    } while(0);
+#undef XX
+
+#undef OP
+#define OP(Name) case Name
+
+Done:
+    /* If cycle counter expired... */
+    if(R->ICount<=0)
+    {
+      /* If we have come after EI, get address from IRequest */
+      /* Otherwise, get it from the loop handler             */
+      if(R->IFF&IFF_EI)
+      {
+        R->IFF=(R->IFF&~IFF_EI)|IFF_1; /* Done with AfterEI state */
+        R->ICount+=R->IBackup-1;       /* Restore the ICount      */
+
+        /* Call periodic handler or set pending IRQ */
+        if(R->ICount>0) J.W=R->IRequest;
+        else
+        {
+          J.W=LoopZ80(R);        /* Call periodic handler    */
+          R->ICount+=R->IPeriod; /* Reset the cycle counter  */
+          if(J.W==INT_NONE) J.W=R->IRequest;  /* Pending IRQ */
+        }
+      }
+      else
+      {
+        J.W=LoopZ80(R);          /* Call periodic handler    */
+        R->ICount+=R->IPeriod;   /* Reset the cycle counter  */
+        if(J.W==INT_NONE) J.W=R->IRequest;    /* Pending IRQ */
+      }
+
+      if(J.W==INT_QUIT) return(R->PC.W); /* Exit if INT_QUIT */
+      if(J.W!=INT_NONE) IntZ80(R,J.W);   /* Int-pt if needed */
+    }
+  }
+
+  /* Execution stopped */
+  return(R->PC.W);
+}
+#endif /* GOTOZ80 */
@@ -21,6 +21,7 @@ extern "C" {
 /* #define DEBUG */            /* Compile debugging version  */
 /* #define LSB_FIRST */        /* Compile for low-endian CPU */
 /* #define MSB_FIRST */        /* Compile for hi-endian CPU  */
+/* #define GOTOZ80 */          /* Computed-goto RunZ80()     */
 
                                /* LoopZ80() may return:      */
 #define INT_RST00   0x00C7     /* RST 00h                    */
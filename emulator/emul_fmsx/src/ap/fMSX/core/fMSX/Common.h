@@ -15,6 +15,12 @@
 
 static int FirstLine = 18;     /* First scanline in the XBuf */
 
+/* Border painted around the 256pix screen, out of WIDTH.    */
+/* Anything narrower leaves the sides of XBuf to the caller. */
+#ifndef BORDER_WIDTH
+#define BORDER_WIDTH WIDTH
+#endif
+
 static void  Sprites(byte Y,pixel *Line);
 static void  ColorSprites(byte Y,byte *ZBuf);
 static pixel *RefreshBorder(byte Y,pixel C);
@@ -65,6 +71,9 @@ pixel *RefreshBorder(register byte Y,register pixel C)
 {
   register pixel *P;
   register int H;
+#if BORDER_WIDTH<WIDTH
+  register int J;
+#endif
 
   /* First line number in the buffer */
   if(!Y) FirstLine=(ScanLines212? 8:18)+VAdjust;
@@ -79,18 +88,30 @@ pixel *RefreshBorder(register byte Y,register pixel C)
   P=(pixel *)XBuf;
 
   /* Paint top of the screen */
+#if BORDER_WIDTH<WIDTH
+  if(!Y)
+    for(H=0;H<FirstLine;H++)
+      for(J=(WIDTH-BORDER_WIDTH)/2;J<(WIDTH+BORDER_WIDTH)/2;J++) P[WIDTH*H+J]=C;
+#else
   if(!Y) for(H=WIDTH*FirstLine-1;H>=0;H--) P[H]=C;
+#endif
 
   /* Start of the line */
   P+=WIDTH*(FirstLine+Y);
 
   /* Paint left/right borders */
-  for(H=(WIDTH-256)/2+HAdjust;H>0;H--) P[H-1]=C;
-  for(H=(WIDTH-256)/2-HAdjust;H>0;H--) P[WIDTH-H]=C;
+  for(H=(BORDER_WIDTH-256)/2+HAdjust;H>0;H--) P[(WIDTH-BORDER_WIDTH)/2+H-1]=C;
+  for(H=(BORDER_WIDTH-256)/2-HAdjust;H>0;H--) P[(WIDTH+BORDER_WIDTH)/2-H]=C;
 
   /* Paint bottom of the screen */
   H=ScanLines212? 212:192;
+#if BORDER_WIDTH<WIDTH
+  if(Y==H-1)
+    for(H=HEIGHT-H-FirstLine;H>0;H--)
+      for(J=(WIDTH-BORDER_WIDTH)/2;J<(WIDTH+BORDER_WIDTH)/2;J++) P[WIDTH*H+J]=C;
+#else
   if(Y==H-1) for(H=WIDTH*(HEIGHT-H-FirstLine+1)-1;H>=WIDTH;H--) P[H]=C;
+#endif
 
   /* Return pointer to the scanline in XBuf */
   return(P+(WIDTH-256)/2+HAdjust);
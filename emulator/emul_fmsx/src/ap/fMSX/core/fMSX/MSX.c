@@ -1002,7 +1002,8 @@ int ResetMSX(int NewMode,int NewRAMPages,int NewVRAMPages)
 /** RdZ80() **************************************************/
 /** Z80 emulation calls this function to read a byte from   **/
 /** address A in the Z80 address space. Also see OpZ80() in **/
-/** Z80.c which is a simplified code-only RdZ80() version.  **/
+/** Z80.c which is a simplified code-only RdZ80() version,  **/
+/** and RDZ80() there, which inlines the RAM case.          **/
 /*************************************************************/
 byte RdZ80(word A)
 {
@@ -1036,7 +1037,8 @@ byte RdZ80(word A)
 
 /** WrZ80() **************************************************/
 /** Z80 emulation calls this function to write byte V to    **/
-/** address A of Z80 address space.                         **/
+/** address A of Z80 address space. WRZ80() in Z80.c only   **/
+/** calls it when EnWrite[] is off or for FFFFh.            **/
 /*************************************************************/
 void WrZ80(word A,byte V)
 {
@@ -2201,6 +2203,10 @@ word LoopZ80(Z80 *R)
     /* Check keyboard */
     Keyboard();
 
+    /* Write modified disk sectors back while the FDC is idle */
+    if(!(FDC.R[0]&F_BUSY))
+      for(J=0;J<MAXDRIVES;++J) IdleFDI(&FDD[J]);
+
     /* Exit emulation if requested */
     if(ExitNow) return(INT_QUIT);
 
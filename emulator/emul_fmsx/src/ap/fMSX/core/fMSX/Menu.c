@@ -51,6 +51,9 @@ void MenuMSX(void)
   char S[512],*T,*PP;
   int I,J,K,N,V,M;
 
+  /* Write modified disk sectors back before going on */
+  for(J=0;J<MAXDRIVES;++J) FlushFDI(&FDD[J]);
+
   /* Display and activate top menu */
   for(J=1;J;)
   {
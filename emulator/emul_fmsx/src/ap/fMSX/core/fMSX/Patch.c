@@ -71,7 +71,7 @@ byte DiskWrite(byte ID,const byte *Buf,int N)
     Side   = (N/FDD[ID].Sectors)%FDD[ID].Sides;
     P      = SeekFDI(&FDD[ID],Side,Track,Side,Track,Sector+1);
     /* If seek operation succeeded, write sector */
-    if(P) memcpy(P,Buf,FDD[ID].SecSize);
+    if(P) { memcpy(P,Buf,FDD[ID].SecSize);DirtyFDI(&FDD[ID],P); }
     /* Done */
     return(!!P);
   }
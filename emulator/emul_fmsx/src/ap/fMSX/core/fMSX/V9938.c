@@ -145,6 +145,14 @@ static void VDPpset(register byte SM,
 
 static int GetVdpTimingValue(register int *);
 
+static int  VDPRunLength(int AX, int TX, int MX, int ANX);
+static void VDPFillBytes(byte SM, int X, int Y, int TX, int N, byte CL);
+static void VDPCopyBytes(byte SM, int SX, int SY, int DX, int DY,
+                         int TX, int N);
+static void VDPFillDots(byte SM, int X, int Y, int TX, int N, byte CL);
+static void VDPCopyDots(byte SM, int SX, int SY, int DX, int DY,
+                        int TX, int N);
+
 static void SrchEngine(void);
 static void LineEngine(void);
 static void LmmvEngine(void);
@@ -167,6 +175,9 @@ static int  PPL[4]  = { 256,512,512,256 };
 static int  VdpOpsCnt=1;
 static void (*VdpEngine)(void)=0;
 
+/** 1: Use row-granular fast paths for block commands ******/
+int VDPFastPath = 1;
+
                       /*  SprOn SprOn SprOf SprOf */
                       /*  ScrOf ScrOn ScrOf ScrOn */
 static int srch_timing[8]={ 818, 1025,  818,  830,   /* ntsc */
@@ -331,6 +342,114 @@ INLINE void VDPpset(byte SM, int DX, int DY, byte CL, byte OP)
   }
 }
 
+/** VDPRunLength() *******************************************/
+/** Number of steps left in the current row, starting at AX **/
+/** (0..MX-1) and moving by TX, before the row ends on ANX  **/
+/** reaching zero or on AX leaving 0..MX-1. ANX<=0 means    **/
+/** that ANX does not limit the row.                        **/
+/*************************************************************/
+INLINE int VDPRunLength(int AX, int TX, int MX, int ANX)
+{
+  register int N;
+
+  N = TX>0? (MX-AX+TX-1)/TX:AX/(-TX)+1;
+  return((ANX>0)&&(ANX<N)? ANX:N);
+}
+
+/** VDPFillBytes() *******************************************/
+/** Fill N VRAM bytes of row Y with CL, starting at pixel X **/
+/** and moving left (TX<0) or right (TX>0).                 **/
+/*************************************************************/
+INLINE void VDPFillBytes(byte SM, int X, int Y, int TX, int N, byte CL)
+{
+  register byte *P = VDP_VRMP(SM, X, Y);
+
+  memset(TX>0? P:P-N+1, CL, N);
+}
+
+/** VDPCopyBytes() *******************************************/
+/** Copy N VRAM bytes from row SY to row DY, in the order   **/
+/** the byte-by-byte engine would. Overlapping moves that   **/
+/** smear in that order are done byte by byte.              **/
+/*************************************************************/
+INLINE void VDPCopyBytes(byte SM, int SX, int SY, int DX, int DY,
+                         int TX, int N)
+{
+  register byte *S = VDP_VRMP(SM, SX, SY);
+  register byte *D = VDP_VRMP(SM, DX, DY);
+
+  if (TX>0) {
+    if ((D>S) && (D<S+N))
+      for(;N;--N) *D++=*S++;
+    else
+      memmove(D, S, N);
+  }
+  else {
+    if ((D<S) && (D>S-N))
+      for(;N;--N) *D--=*S--;
+    else
+      memmove(D-N+1, S-N+1, N);
+  }
+}
+
+/** VDPFillDots() ********************************************/
+/** Set N pixels of row Y to CL with the IMP operation,     **/
+/** starting at pixel X. Whole bytes are filled at once.    **/
+/*************************************************************/
+INLINE void VDPFillDots(byte SM, int X, int Y, int TX, int N, byte CL)
+{
+  static const byte Fill[4] = { 0x11,0x55,0x11,0x01 };
+  register int L,H,P;
+
+  L = TX>0? X:X-N+1;
+  H = L+N-1;
+  P = PPB[SM];
+
+  for(;(L&(P-1))&&(L<=H);++L) VDPpset(SM, L, Y, CL, 0);
+  for(;((H+1)&(P-1))&&(H>=L);--H) VDPpset(SM, H, Y, CL, 0);
+  if (H>=L)
+    memset(VDP_VRMP(SM, L, Y), CL*Fill[SM], (H-L+1)/P);
+}
+
+/** VDPCopyDots() ********************************************/
+/** Copy N pixels with the IMP operation. Whole bytes are   **/
+/** moved at once when source and destination share their  **/
+/** position within a byte and do not overlap, otherwise    **/
+/** pixels are copied one by one in engine order.           **/
+/*************************************************************/
+INLINE void VDPCopyDots(byte SM, int SX, int SY, int DX, int DY,
+                        int TX, int N)
+{
+  register int LS,LD,H,P;
+  register byte *S,*D;
+
+  /* SCREEN8 has a pixel per byte */
+  if (SM==3) {
+    VDPCopyBytes(SM, SX, SY, DX, DY, TX, N);
+    return;
+  }
+
+  P  = PPB[SM];
+  LS = TX>0? SX:SX-N+1;
+  LD = TX>0? DX:DX-N+1;
+  S  = VDP_VRMP(SM, LS, SY);
+  D  = VDP_VRMP(SM, LD, DY);
+
+  if (((LS^LD)&(P-1)) || ((D<S+(N+P-1)/P+1) && (S<D+(N+P-1)/P+1))) {
+    for(;N;--N,SX+=TX,DX+=TX)
+      VDPpset(SM, DX, DY, VDPpoint(SM, SX, SY), 0);
+    return;
+  }
+
+  H = LD+N-1;
+  for(;(LD&(P-1))&&(LD<=H);++LD,++LS)
+    VDPpset(SM, LD, DY, VDPpoint(SM, LS, SY), 0);
+  for(;((H+1)&(P-1))&&(H>=LD);--H)
+    VDPpset(SM, H, DY, VDPpoint(SM, LS+H-LD, SY), 0);
+  if (H>=LD)
+    memcpy(VDP_VRMP(SM, LD, DY), VDP_VRMP(SM, LS, SY), (H-LD+1)/P);
+}
+
 /** GetVdpTimingValue() **************************************/
 /** Get timing value for a certain VDP command              **/
 /*************************************************************/
@@ -492,11 +611,33 @@ void LmmvEngine(void)
   register byte LO=MMC.LO;
   register int cnt;
   register int delta;
+  register int N,K;
 
   delta = GetVdpTimingValue(lmmv_timing);
   cnt = VdpOpsCnt;
 
-  switch (ScrMode) {
+  /* Fast path: IMP fills a row run at a time */
+  if (VDPFastPath && !LO && (ScrMode>=5) && (ScrMode<=8)
+      && !((DX|ADX)&PPL[ScrMode-5])) {
+    register byte SM=ScrMode-5;
+
+    for(;;) {
+      N = VDPRunLength(ADX, TX, PPL[SM], ANX);
+      K = (cnt-1)/delta;
+      if (K<N) {
+        if (K) VDPFillDots(SM, ADX, DY, TX, K, CL);
+        ADX+=K*TX; ANX-=K; cnt-=(K+1)*delta;
+        break;
+      }
+      VDPFillDots(SM, ADX, DY, TX, N, CL);
+      cnt-=N*delta;
+      if (!(--NY&1023) || (DY+=TY)==-1)
+        break;
+      ADX=DX;
+      ANX=NX;
+    }
+  }
+  else switch (ScrMode) {
     case 5: pre_loop VDPpset5(ADX, DY, CL, LO); post__x_y(256)
             break;
     case 6: pre_loop VDPpset6(ADX, DY, CL, LO); post__x_y(512)
@@ -545,11 +686,36 @@ void LmmmEngine(void)
   register byte LO=MMC.LO;
   register int cnt;
   register int delta;
+  register int N,K;
  
   delta = GetVdpTimingValue(lmmm_timing);
   cnt = VdpOpsCnt;
 
-  switch (ScrMode) {
+  /* Fast path: IMP copies a row run at a time */
+  if (VDPFastPath && !LO && (ScrMode>=5) && (ScrMode<=8)
+      && !((SX|DX|ASX|ADX)&PPL[ScrMode-5])) {
+    register byte SM=ScrMode-5;
+
+    for(;;) {
+      N = VDPRunLength(ASX, TX, PPL[SM], ANX);
+      K = VDPRunLength(ADX, TX, PPL[SM], 0);
+      N = K<N? K:N;
+      K = (cnt-1)/delta;
+      if (K<N) {
+        if (K) VDPCopyDots(SM, ASX, SY, ADX, DY, TX, K);
+        ASX+=K*TX; ADX+=K*TX; ANX-=K; cnt-=(K+1)*delta;
+        break;
+      }
+      VDPCopyDots(SM, ASX, SY, ADX, DY, TX, N);
+      cnt-=N*delta;
+      if (!(--NY&1023) || (SY+=TY)==-1 || (DY+=TY)==-1)
+        break;
+      ASX=SX;
+      ADX=DX;
+      ANX=NX;
+    }
+  }
+  else switch (ScrMode) {
     case 5: pre_loop VDPpset5(ADX, DY, VDPpoint5(ASX, SY), LO); post_xxyy(256)
             break;
     case 6: pre_loop VDPpset6(ADX, DY, VDPpoint6(ASX, SY), LO); post_xxyy(512)
@@ -666,11 +832,33 @@ void HmmvEngine(void)
   register byte CL=MMC.CL;
   register int cnt;
   register int delta;
+  register int N,K;
  
   delta = GetVdpTimingValue(hmmv_timing);
   cnt = VdpOpsCnt;
 
-  switch (ScrMode) {
+  /* Fast path: fill a row run of bytes at a time */
+  if (VDPFastPath && (ScrMode>=5) && (ScrMode<=8)
+      && !((DX|ADX)&PPL[ScrMode-5])) {
+    register byte SM=ScrMode-5;
+
+    for(;;) {
+      N = VDPRunLength(ADX, TX, PPL[SM], ANX);
+      K = (cnt-1)/delta;
+      if (K<N) {
+        if (K) VDPFillBytes(SM, ADX, DY, TX, K, CL);
+        ADX+=K*TX; ANX-=K; cnt-=(K+1)*delta;
+        break;
+      }
+      VDPFillBytes(SM, ADX, DY, TX, N, CL);
+      cnt-=N*delta;
+      if (!(--NY&1023) || (DY+=TY)==-1)
+        break;
+      ADX=DX;
+      ANX=NX;
+    }
+  }
+  else switch (ScrMode) {
     case 5: pre_loop *VDP_VRMP5(ADX, DY) = CL; post__x_y(256)
             break;
     case 6: pre_loop *VDP_VRMP6(ADX, DY) = CL; post__x_y(512)
@@ -718,11 +906,36 @@ void HmmmEngine(void)
   register int ANX=MMC.ANX;
   register int cnt;
   register int delta;
+  register int N,K;
  
   delta = GetVdpTimingValue(hmmm_timing);
   cnt = VdpOpsCnt;
 
-  switch (ScrMode) {
+  /* Fast path: move a row run of bytes at a time */
+  if (VDPFastPath && (ScrMode>=5) && (ScrMode<=8)
+      && !((SX|DX|ASX|ADX)&PPL[ScrMode-5])) {
+    register byte SM=ScrMode-5;
+
+    for(;;) {
+      N = VDPRunLength(ASX, TX, PPL[SM], ANX);
+      K = VDPRunLength(ADX, TX, PPL[SM], 0);
+      N = K<N? K:N;
+      K = (cnt-1)/delta;
+      if (K<N) {
+        if (K) VDPCopyBytes(SM, ASX, SY, ADX, DY, TX, K);
+        ASX+=K*TX; ADX+=K*TX; ANX-=K; cnt-=(K+1)*delta;
+        break;
+      }
+      VDPCopyBytes(SM, ASX, SY, ADX, DY, TX, N);
+      cnt-=N*delta;
+      if (!(--NY&1023) || (SY+=TY)==-1 || (DY+=TY)==-1)
+        break;
+      ASX=SX;
+      ADX=DX;
+      ANX=NX;
+    }
+  }
+  else switch (ScrMode) {
     case 5: pre_loop *VDP_VRMP5(ADX, DY) = *VDP_VRMP5(ASX, SY); post_xxyy(256)
             break;
     case 6: pre_loop *VDP_VRMP6(ADX, DY) = *VDP_VRMP6(ASX, SY); post_xxyy(512)
@@ -775,11 +988,32 @@ void YmmmEngine(void)
   register int ADX=MMC.ADX;
   register int cnt;
   register int delta;
+  register int N,K;
  
   delta = GetVdpTimingValue(ymmm_timing);
   cnt = VdpOpsCnt;
 
-  switch (ScrMode) {
+  /* Fast path: move a row run of bytes at a time */
+  if (VDPFastPath && (ScrMode>=5) && (ScrMode<=8)
+      && !((DX|ADX)&PPL[ScrMode-5])) {
+    register byte SM=ScrMode-5;
+
+    for(;;) {
+      N = VDPRunLength(ADX, TX, PPL[SM], 0);
+      K = (cnt-1)/delta;
+      if (K<N) {
+        if (K) VDPCopyBytes(SM, ADX, SY, ADX, DY, TX, K);
+        ADX+=K*TX; cnt-=(K+1)*delta;
+        break;
+      }
+      VDPCopyBytes(SM, ADX, SY, ADX, DY, TX, N);
+      cnt-=N*delta;
+      if (!(--NY&1023) || (SY+=TY)==-1 || (DY+=TY)==-1)
+        break;
+      ADX=DX;
+    }
+  }
+  else switch (ScrMode) {
     case 5: pre_loop *VDP_VRMP5(ADX, DY) = *VDP_VRMP5(ADX, SY); post__xyy(256)
             break;
     case 6: pre_loop *VDP_VRMP6(ADX, DY) = *VDP_VRMP6(ADX, SY); post__xyy(512)
@@ -1044,3 +1278,30 @@ void LoopVDP(void)
   }
 }
 
+/** VDPSaveCmd()/VDPLoadCmd() ********************************/
+/** Keep the state of the command engine aside and put it   **/
+/** back. Buf holds VDPCmdSize() bytes.                     **/
+/*************************************************************/
+int VDPCmdSize(void)
+{
+  return(sizeof(MMC)+sizeof(VdpOpsCnt)+sizeof(VdpEngine));
+}
+
+void VDPSaveCmd(void *Buf)
+{
+  byte *P=(byte *)Buf;
+
+  memcpy(P,&MMC,sizeof(MMC));P+=sizeof(MMC);
+  memcpy(P,&VdpOpsCnt,sizeof(VdpOpsCnt));P+=sizeof(VdpOpsCnt);
+  memcpy(P,&VdpEngine,sizeof(VdpEngine));
+}
+
+void VDPLoadCmd(const void *Buf)
+{
+  const byte *P=(const byte *)Buf;
+
+  memcpy(&MMC,P,sizeof(MMC));P+=sizeof(MMC);
+  memcpy(&VdpOpsCnt,P,sizeof(VdpOpsCnt));P+=sizeof(VdpOpsCnt);
+  memcpy(&VdpEngine,P,sizeof(VdpEngine));
+}
+
@@ -35,4 +35,12 @@ byte VDPDraw(register byte Op);
 /*************************************************************/
 void LoopVDP(void);
 
+/** VDPSaveCmd()/VDPLoadCmd() ********************************/
+/** Keep the state of the command engine aside and put it   **/
+/** back. Buf holds VDPCmdSize() bytes.                     **/
+/*************************************************************/
+int  VDPCmdSize(void);
+void VDPSaveCmd(void *Buf);
+void VDPLoadCmd(const void *Buf);
+
 #endif /* V9938_H */
@@ -33,6 +33,9 @@ pixel *RefreshBorder512(register byte Y,register pixel C)
 {
   register pixel *P;
   register int H;
+#if BORDER_WIDTH<WIDTH
+  register int J;
+#endif
 
   /* First line number in the buffer */
   if(!Y) FirstLine=(ScanLines212? 8:18)+VAdjust;
@@ -47,18 +50,30 @@ pixel *RefreshBorder512(register byte Y,register pixel C)
   P=(pixel *)WBuf;
 
   /* Paint top of the screen */
+#if BORDER_WIDTH<WIDTH
+  if(!Y)
+    for(H=0;H<FirstLine;H++)
+      for(J=WIDTH-BORDER_WIDTH;J<WIDTH+BORDER_WIDTH;J++) P[2*WIDTH*H+J]=C;
+#else
   if(!Y) for(H=2*WIDTH*FirstLine-1;H>=0;H--) P[H]=C;
+#endif
 
   /* Start of the line */
   P+=2*WIDTH*(FirstLine+Y);
 
   /* Paint left/right borders */
-  for(H=(WIDTH-256)+2*HAdjust;H>0;H--) P[H-1]=C;
-  for(H=(WIDTH-256)-2*HAdjust;H>0;H--) P[2*WIDTH-H]=C;
+  for(H=(BORDER_WIDTH-256)+2*HAdjust;H>0;H--) P[WIDTH-BORDER_WIDTH+H-1]=C;
+  for(H=(BORDER_WIDTH-256)-2*HAdjust;H>0;H--) P[WIDTH+BORDER_WIDTH-H]=C;
 
   /* Paint bottom of the screen */
   H=ScanLines212? 212:192;
+#if BORDER_WIDTH<WIDTH
+  if(Y==H-1)
+    for(H=HEIGHT-H-FirstLine;H>0;H--)
+      for(J=WIDTH-BORDER_WIDTH;J<WIDTH+BORDER_WIDTH;J++) P[2*WIDTH*H+J]=C;
+#else
   if(Y==H-1) for(H=2*WIDTH*(HEIGHT-H-FirstLine+1)-2;H>=2*WIDTH;H--) P[H]=C;
+#endif
 
   /* Return pointer to the scanline in XBuf */
   return(P+WIDTH-256+2*HAdjust);
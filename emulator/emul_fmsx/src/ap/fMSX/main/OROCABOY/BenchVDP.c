@@ -0,0 +1,226 @@
+/** fMSX: portable MSX emulator ******************************/
+/**                                                         **/
+/**                        BenchVDP.c                       **/
+/**                                                         **/
+/** This file contains a microbenchmark for the V9938 block **/
+/** commands. Every command is run with the per-pixel and   **/
+/** with the fast-path engines from the same VRAM contents, **/
+/** and both times and results are reported over cmdif.    **/
+/** The emulation is parked at a frame boundary meanwhile,  **/
+/** and its VDP state is put back afterwards.               **/
+/**                                                         **/
+/*************************************************************/
+#include "MSX.h"
+#include "V9938.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "hw.h"
+
+#define PARK_TIMEOUT 1000   /* ms for the emulation to park  */
+
+extern int VDPFastPath;
+
+static volatile byte BenchPause  = 0;  /* Asked by the cmdif thread   */
+static volatile byte BenchParked = 0;  /* Emulation waits in a frame  */
+
+static const struct
+{
+  const char *Name;
+  byte Op;                 /* Command and logical operation  */
+  byte Mode;               /* SCREEN to run the command in   */
+} Bench[] =
+{
+  { "HMMV s8", 0xC0, 8 },
+  { "HMMM s8", 0xD0, 8 },
+  { "YMMM s8", 0xE0, 8 },
+  { "LMMV s5", 0x80, 5 },
+  { "LMMM s5", 0x90, 5 },
+  { "LMMM s8", 0x90, 8 },
+  { "HMMM s5", 0xD0, 5 },
+};
+
+/** RunCommand() *********************************************/
+/** Start a 256x212 command and step the VDP until it ends. **/
+/** Returns time taken in microseconds.                     **/
+/*************************************************************/
+static uint32_t RunCommand(byte Op,byte Mode)
+{
+  uint32_t Start;
+
+  ScrMode = Mode;
+
+  /* SX=0,SY=256 -> DX=0,DY=0, NX=256,NY=212, left to right */
+  VDP[32]=0x00;VDP[33]=0x00;VDP[34]=0x00;VDP[35]=0x01;
+  VDP[36]=0x00;VDP[37]=0x00;VDP[38]=0x00;VDP[39]=0x00;
+  VDP[40]=0x00;VDP[41]=0x01;VDP[42]=212; VDP[43]=0x00;
+  VDP[44]=0x5A;VDP[45]=0x00;
+
+  /* Drop whatever was running and start on a fresh slice */
+  VDPDraw(0x00);
+  LoopVDP();LoopVDP();
+
+  Start = micros();
+  VDPDraw(Op);
+  while(VDPStatus[2]&0x01) LoopVDP();
+
+  return(micros()-Start);
+}
+
+/** FillVRAM() ***********************************************/
+/** Fill VRAM with the same non-trivial pattern every time. **/
+/*************************************************************/
+static void FillVRAM(int Size)
+{
+  int J;
+
+  for(J=0;J<Size;++J) VRAM[J]=J*7+(J>>8);
+}
+
+/** ParkBenchVDP() *******************************************/
+/** Called by ShowVideo() once a frame. Waits there while   **/
+/** a benchmark runs.                                       **/
+/*************************************************************/
+void ParkBenchVDP(void)
+{
+  if(!BenchPause) return;
+
+  BenchParked=1;
+  while(BenchPause) delay(1);
+  BenchParked=0;
+}
+
+/** PauseEmulation() *****************************************/
+/** Ask the emulation to park and wait until it does.       **/
+/** Returns 0 if it did not within PARK_TIMEOUT.            **/
+/*************************************************************/
+static int PauseEmulation(void)
+{
+  uint32_t Start;
+
+  BenchPause=1;
+  for(Start=millis();!BenchParked;delay(1))
+    if(millis()-Start>=PARK_TIMEOUT)
+    {
+      BenchPause=0;
+      return(0);
+    }
+
+  return(1);
+}
+
+/** BenchVDP() ***********************************************/
+/** Run all benchmarks, keeping the emulated VDP state.     **/
+/*************************************************************/
+static void BenchVDP(void)
+{
+  byte SavedVDP[64],SavedStatus[16],SavedMode;
+  byte *SavedVRAM,*SavedCmd,*Result;
+  int Size,FastPath,J;
+  uint32_t Slow,Fast;
+
+  Size      = VRAMPages*0x4000;
+  SavedVRAM = malloc(Size);
+  SavedCmd  = malloc(VDPCmdSize());
+  Result    = malloc(Size);
+  if(!SavedVRAM||!SavedCmd||!Result)
+  {
+    cmdifPrintf("no memory for %d bytes\n",2*Size+VDPCmdSize());
+    free(SavedVRAM);
+    free(SavedCmd);
+    free(Result);
+    return;
+  }
+
+  if(!PauseEmulation())
+  {
+    cmdifPrintf("emulation not running\n");
+    free(SavedVRAM);
+    free(SavedCmd);
+    free(Result);
+    return;
+  }
+
+  /* A command may be in flight, it goes on afterwards */
+  VDPSaveCmd(SavedCmd);
+  memcpy(SavedVRAM,VRAM,Size);
+  memcpy(SavedVDP,VDP,sizeof(SavedVDP));
+  memcpy(SavedStatus,VDPStatus,sizeof(SavedStatus));
+  SavedMode = ScrMode;
+  FastPath  = VDPFastPath;
+
+  cmdifPrintf("%-8s %10s %10s %7s %s\n","command","slow us","fast us","speedup","result");
+
+  for(J=0;J<sizeof(Bench)/sizeof(Bench[0]);++J)
+  {
+    FillVRAM(Size);
+    VDPFastPath = 0;
+    Slow        = RunCommand(Bench[J].Op,Bench[J].Mode);
+    memcpy(Result,VRAM,Size);
+
+    FillVRAM(Size);
+    VDPFastPath = 1;
+    Fast        = RunCommand(Bench[J].Op,Bench[J].Mode);
+    Fast        = Fast? Fast:1;
+
+    cmdifPrintf("%-8s %10lu %10lu %5lu.%lux %s\n",
+                Bench[J].Name,(unsigned long)Slow,(unsigned long)Fast,
+                (unsigned long)(Slow/Fast),(unsigned long)((10*Slow/Fast)%10),
+                memcmp(VRAM,Result,Size)? "DIFFERENT":"same");
+  }
+
+  memcpy(VRAM,SavedVRAM,Size);
+  memcpy(VDP,SavedVDP,sizeof(SavedVDP));
+  memcpy(VDPStatus,SavedStatus,sizeof(SavedStatus));
+  ScrMode     = SavedMode;
+  VDPFastPath = FastPath;
+  VDPLoadCmd(SavedCmd);
+
+  BenchPause  = 0;
+
+  free(Result);
+  free(SavedCmd);
+  free(SavedVRAM);
+}
+
+static void vdpCmdif(void)
+{
+  bool ret = true;
+
+  if (cmdifGetParamCnt() == 1 && cmdifHasString("bench", 0) == true)
+  {
+    BenchVDP();
+  }
+  else if (cmdifGetParamCnt() == 1 && cmdifHasString("info", 0) == true)
+  {
+    cmdifPrintf("fast path    : %d\n", VDPFastPath);
+  }
+  else if (cmdifGetParamCnt() == 2 && cmdifHasString("fast", 0) == true)
+  {
+    VDPFastPath = cmdifHasString("on", 1) == true;
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "vdp info \n");
+    cmdifPrintf( "vdp bench \n");
+    cmdifPrintf( "vdp fast on/off \n");
+  }
+}
+
+/** InitBenchVDP() *******************************************/
+/** Register the "vdp" command.                             **/
+/*************************************************************/
+void InitBenchVDP(void)
+{
+  if (cmdifIsInit() == false)
+  {
+    cmdifInit();
+  }
+  cmdifAdd("vdp", vdpCmdif);
+}
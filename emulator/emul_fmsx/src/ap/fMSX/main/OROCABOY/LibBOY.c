@@ -32,6 +32,8 @@
 extern int MasterSwitch; /* Switches to turn channels on/off */
 extern int MasterVolume; /* Master volume                    */
 
+extern void ParkBenchVDP(void);
+
 static volatile int TimerReady = 0;   /* 1: Sync timer ready */
 static volatile unsigned int JoyState = 0; /* Joystick state */
 static volatile unsigned int LastKey  = 0; /* Last key prsd  */
@@ -47,6 +49,7 @@ static int FrameCount;      /* Frame counter for EFF_SHOWFPS */
 static int FrameRate;       /* Last frame rate value         */
 static uint32_t TimeStamp;  /* Last timestamp           */
 static uint32_t sync_time;
+static uint32_t sync_pre_time;
 
 /** TimerHandler() *******************************************/
 /** The main timer handler used by SetSyncTimer().          **/
@@ -101,6 +104,58 @@ void TrashUnix(void)
   FreeImage(&OutImg);
 }
 
+/** SyncVideo() **********************************************/
+/** Wait for the sync timer if requested and report frame   **/
+/** time. CopyTime is the time spent presenting the image.  **/
+/*************************************************************/
+static void SyncVideo(uint32_t CopyTime)
+{
+  /* Wait for sync timer if requested */
+  if(Effects&EFF_SYNC)
+  {
+
+    while((millis()-sync_pre_time < sync_time))
+    {
+      delay(1);
+    }
+
+    printf("%dms, %dfps, %d %% w %d, h %d, %d\n", millis()-sync_pre_time,
+                                                  1000/(millis()-sync_pre_time),
+                                                  100*(1000/(millis()-sync_pre_time))/60,
+                                                  VideoImg->W,
+                                                  VideoImg->H,
+                                                  CopyTime);
+  }
+  sync_pre_time = millis();
+}
+
+/** ShowVideoLCD() *******************************************/
+/** VideoImg already is the LCD back buffer: the MSX screen **/
+/** was rendered straight into it, scaled and with borders. **/
+/** Only flip buffers, then wait until the next back buffer **/
+/** may be written before the first line of the next frame. **/
+/*************************************************************/
+static int ShowVideoLCD(void)
+{
+  /* Show framerate if requested */
+  if((Effects&EFF_SHOWFPS)&&(FrameRate>0))
+  {
+    char S[8];
+    sprintf(S,"%dfps",FrameRate);
+    PrintXY(VideoImg,S,VideoX+8,VideoY+8,FPS_COLOR,-1);
+  }
+
+  lcdRequestDraw();
+  SyncVideo(0);
+
+  while(lcdDrawAvailable() != true)
+  {
+    delay(1);
+  }
+
+  return(1);
+}
+
 /** ShowVideo() **********************************************/
 /** Show "active" image at the actual screen or window.     **/
 /*************************************************************/
@@ -113,9 +168,15 @@ int ShowVideo(void)
 
   //printf("ShowVideo \n");
 
+  /* Wait here while "vdp bench" runs */
+  ParkBenchVDP();
+
   /* Must have active video image, X11 display */
   if(!VideoImg||!VideoImg->Data) return(0);
 
+  /* Nothing to copy if rendered into the LCD back buffer */
+  if(VideoImg->Data==(pixel *)p_buf) return(ShowVideoLCD());
+
 
   /* If no window yet... */
 
@@ -280,7 +341,7 @@ int ShowVideo(void)
     x_offset = (320-Output->W)/2;
     y_offset = (240-Output->H)/2;
 
-    memset(p_buf, 0x00, 320 * 240 * 2);
+    if(x_offset||y_offset) memset(p_buf, 0x00, 320 * 240 * 2);
     for (int y=0; y<VideoImg->H; y++)
     {
       memcpy(&p_buf[(y+y_offset)*320 + x_offset], &VideoImg->Data[VideoImg->W * y], VideoImg->W*2);
@@ -307,31 +368,7 @@ int ShowVideo(void)
   lcdRequestDraw();
 
 
-  static uint32_t sync_pre_time;
-
-  /* Wait for sync timer if requested */
-  if(Effects&EFF_SYNC)
-  {
-
-    while((millis()-sync_pre_time < sync_time))
-    {
-      delay(1);
-    }
-
-    /*
-    if ((lcdDrawAvailable() != true) || (millis()-sync_pre_time < sync_time))
-    {
-      return 0;
-    }
-    */
-    printf("%dms, %dfps, %d %% w %d, h %d, %d\n", millis()-sync_pre_time,
-                                                  1000/(millis()-sync_pre_time),
-                                                  100*(1000/(millis()-sync_pre_time))/60,
-                                                  VideoImg->W,
-                                                  VideoImg->H,
-                                                  copy_time);
-  }
-  sync_pre_time = millis();
+  SyncVideo(copy_time);
 
   /* Done */
   return(1);
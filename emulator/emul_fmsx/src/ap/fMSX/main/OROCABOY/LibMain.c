@@ -28,8 +28,14 @@
 //#define WIDTH       320                   /* Buffer width    */
 //#define HEIGHT      240                   /* Buffer height   */
 
-#define WIDTH       272                   /* Buffer width    */
-#define HEIGHT      228                   /* Buffer height   */
+/* Buffers match the 320x240 LCD so that 256pix lines can be */
+/* rendered straight into the LCD frame buffer. fMSX paints  */
+/* the 8pix side borders of the old 272pix buffer, the 24pix */
+/* beyond them stay black and get cleared on mode changes.   */
+#define WIDTH        320                  /* Buffer width    */
+#define HEIGHT       240                  /* Buffer height   */
+#define BORDER_WIDTH 272                  /* Painted width   */
+#define BORDER_X     ((WIDTH-BORDER_WIDTH)/2)
 
 
 #define BOY_COLOR(r, g, b)\
@@ -62,6 +68,10 @@ const char *Title     = "fMSX 5.4";       /* Program version */
 
 Image NormScreen;          /* Main screen image              */
 Image WideScreen;          /* Wide screen image              */
+Image LCDScreen;           /* LCD back buffer as an image    */
+static int UseLCD;         /* 1: Render into LCDScreen       */
+static int LCDRow;         /* Next wide row to scale to LCD  */
+static int LCDClear;       /* LCD buffers left to clear      */
 static pixel *WBuf;        /* From Wide.h                    */
 static pixel *XBuf;        /* From Common.h                  */
 static unsigned int XPal[80];
@@ -76,12 +86,107 @@ void PutImage(void);
 unsigned int X11GetColor(unsigned char R,unsigned char G,unsigned char B);
 
 extern void fmsxChangeHome(void);
+extern void InitBenchVDP(void);
+
+static void SetLCD(int Switch);
 
 /** CommonMux.h **********************************************/
 /** Display drivers for all possible screen depths.         **/
 /*************************************************************/
 #include "CommonMux.h"
 
+/** Wide screen drivers replaced by the LCD wrappers below **/
+static void (*RefreshWide[MAXSCREEN+2])(byte Y);
+
+/** ScaleWideRows() ******************************************/
+/** Halve WBuf rows up to and including scanline Y into the **/
+/** LCD back buffer, averaging each pair of RGB565 pixels.  **/
+/** Only the BORDER_WIDTH columns are scaled, the rest are  **/
+/** never painted. The bottom border is flushed with the    **/
+/** last scanline.                                          **/
+/*************************************************************/
+static void ScaleWideRows(register byte Y)
+{
+  register const unsigned int *S;
+  register unsigned int *D,A,B;
+  register int J,End;
+
+  if(!Y) LCDRow=0;
+  End = FirstLine_16+Y+1;
+  if(Y==(ScanLines212? 211:191)) End=HEIGHT;
+  if(End>HEIGHT) End=HEIGHT;
+
+  for(;LCDRow<End;++LCDRow)
+  {
+    S = (const unsigned int *)(WBuf+2*WIDTH*LCDRow+2*BORDER_X);
+    D = (unsigned int *)(LCDScreen.Data+WIDTH*LCDRow+BORDER_X);
+
+    /* Two source pairs in, two LCD pixels out per iteration */
+    for(J=BORDER_WIDTH/2;J;--J,S+=2)
+    {
+      A = S[0];
+      A = (A&(A>>16))+((((A^(A>>16))&0xF7DE)>>1));
+      B = S[1];
+      B = (B&(B>>16))+((((B^(B>>16))&0xF7DE)>>1));
+      *D++ = (A&0xFFFF)|(B<<16);
+    }
+  }
+}
+
+static void RefreshLCD6(byte Y)    { RefreshWide[6](Y);ScaleWideRows(Y); }
+static void RefreshLCD7(byte Y)    { RefreshWide[7](Y);ScaleWideRows(Y); }
+static void RefreshLCDTx80(byte Y) { RefreshWide[MAXSCREEN+1](Y);ScaleWideRows(Y); }
+
+/** StartLCDFrame() ******************************************/
+/** Point the line renderers at the current LCD back buffer **/
+/** and clear it if the screen mode has just changed.       **/
+/*************************************************************/
+static void StartLCDFrame(void)
+{
+  LCDScreen.Data = (pixel *)lcdGetFrameBuffer();
+  XBuf = LCDScreen.Data;
+
+  /* Both LCD buffers get cleared once after a mode change */
+  if(LCDClear) { memset(LCDScreen.Data,0,WIDTH*HEIGHT*sizeof(pixel));--LCDClear; }
+}
+
+/** SetLCD() *************************************************/
+/** Switch rendering into the LCD frame buffer on or off.   **/
+/** Post-processing effects need the full image in memory,  **/
+/** so they keep the buffered NormScreen/WideScreen path.   **/
+/*************************************************************/
+static void SetLCD(int Switch)
+{
+  Switch = Switch&&(NormScreen.D==16)
+         &&!(UseEffects&(EFF_RASTER_ALL|EFF_MASK_ALL|EFF_SOFTEN_ALL|EFF_4X3));
+
+  if(Switch)
+  {
+    RefreshLine[6]           = RefreshLCD6;
+    RefreshLine[7]           = RefreshLCD7;
+    RefreshLine[MAXSCREEN+1] = RefreshLCDTx80;
+    StartLCDFrame();
+  }
+  else
+  {
+    RefreshLine[6]           = RefreshWide[6];
+    RefreshLine[7]           = RefreshWide[7];
+    RefreshLine[MAXSCREEN+1] = RefreshWide[MAXSCREEN+1];
+    XBuf = NormScreen.Data;
+
+    /* Nothing paints beside the border, clear it here */
+    memset(NormScreen.Data,0,WIDTH*HEIGHT*sizeof(pixel));
+#ifndef NARROW
+    memset(WideScreen.Data,0,2*WIDTH*HEIGHT*sizeof(pixel));
+#endif
+  }
+
+  /* Have PutImage() pick the matching video image */
+  UseLCD     = Switch;
+  LCDClear   = 2;
+  OldScrMode = -1;
+}
+
 /** InitMachine() ********************************************/
 /** Allocate resources needed by machine-dependent code.    **/
 /*************************************************************/
@@ -119,10 +224,19 @@ int InitMachine(void)
 
   /* Set correct screen drivers */
   if(!SetScreenDepth(NormScreen.D)) { TrashUnix();return(0); }
+  memcpy(RefreshWide,RefreshLine,sizeof(RefreshWide));
 
   /* Initialize video to main image */
   SetVideo(&NormScreen,0,0,WIDTH,HEIGHT);
 
+  /* LCD back buffer image, its Data is set on every frame */
+  LCDScreen.W       = WIDTH;
+  LCDScreen.H       = HEIGHT;
+  LCDScreen.L       = WIDTH;
+  LCDScreen.D       = 16;
+  LCDScreen.Cropped = 1;
+  SetLCD(1);
+
   /* Set all colors to black */
   for(J=0;J<80;J++) SetColor(J,0,0,0);
 
@@ -132,6 +246,9 @@ int InitMachine(void)
     BPal[J]=X11GetColor(((J>>2)&0x07)*255/7,((J>>5)&0x07)*255/7,(J&0x03)*255/3);
   }
 
+  /* V9938 command benchmark over cmdif */
+  InitBenchVDP();
+
   /* Initialize temporary keyboard array */
   memset((void *)XKeyState,0xFF,sizeof(XKeyState));
 
@@ -178,6 +295,24 @@ void PutImage(void)
 {
   //printf("PutImage \n");
 
+  /* Frame was rendered straight into the LCD back buffer */
+  if(UseLCD)
+  {
+    if(ScrMode!=OldScrMode)
+    {
+      OldScrMode=ScrMode;
+      LCDClear=2;
+      SetVideo(&LCDScreen,BORDER_X,0,BORDER_WIDTH,HEIGHT);
+    }
+
+    if(RPLPlay(RPL_QUERY)) RPLShow(VideoImg,VideoX+10,VideoY+10);
+
+    /* ShowVideo() returns once the next back buffer is free */
+    ShowVideo();
+    StartLCDFrame();
+    return;
+  }
+
 #ifndef NARROW
   /* If screen mode changed... */
   if(ScrMode!=OldScrMode)
@@ -225,7 +360,20 @@ unsigned int Joystick(void)
   {
     speakerDisable();
     fmsxChangeHome();
+
+    /* The menu draws over the last frame in NormScreen */
+    if(UseLCD)
+    {
+      SetLCD(0);
+      memcpy(NormScreen.Data,lcdGetCurrentFrameBuffer(),WIDTH*HEIGHT*sizeof(pixel));
+      SetVideo(&NormScreen,0,0,WIDTH,HEIGHT);
+    }
     MenuMSX();
+
+    /* Back to the LCD if the effects allow, and either way */
+    /* clear what the menu left beside the border           */
+    SetLCD(1);
+
     speakerEnable();
   }
 
@@ -13,38 +13,114 @@
 #include "EMULib.h"
 #include "Sound.h"
 
+#include <string.h>
+
 #include "hw.h"
 
 
+#define AUDIO_FPS      60          /* Emulated frames per second    */
+#define AUDIO_MAX      1024        /* Max samples per half buffer   */
+
+extern int MasterVolume;           /* Master volume from Sound.c    */
+
+static osSemaphoreId audioSem;
+static int     Streaming = 0;      /* 1: DAC pulls audio from us    */
+static int     Paused    = 0;      /* 1: Play silence               */
+static int     Created   = 0;      /* 1: threadAudio is running     */
+static unsigned int HalfLength;    /* Samples per half buffer       */
+
+/* Halves played by the DAC and waiting to be rendered again */
+static uint16_t *volatile Pending[2];
+
+/* Statistics reported by the "snd" command */
+static volatile uint32_t Underruns;
+static uint32_t Rendered;
+static uint32_t RenderLast;
+static uint32_t RenderMax;
+static uint32_t RenderSum;
+
+static int Wave[AUDIO_MAX];
+
+static void sndCmdif(void);
+
+/** AudioCallback() ******************************************/
+/** Called from the DAC DMA half/complete interrupt with    **/
+/** the half that has just been played. Queues it for the   **/
+/** audio thread. A half still queued from the last round   **/
+/** has been played twice: count it as an underrun.         **/
+/*************************************************************/
+static void AudioCallback(uint16_t *Buf,uint32_t Length)
+{
+  UNUSED(Length);
+
+  if((Pending[0]==Buf)||(Pending[1]==Buf)) ++Underruns;
+  else if(!Pending[0]) Pending[0]=Buf;
+  else Pending[1]=Buf;
+
+  osSemaphoreRelease(audioSem);
+}
+
+/** PopHalf() ************************************************/
+/** Take the oldest queued half, or 0 if none.              **/
+/*************************************************************/
+static uint16_t *PopHalf(void)
+{
+  uint16_t *Buf;
+
+  taskENTER_CRITICAL();
+  Buf        = Pending[0];
+  Pending[0] = Pending[1];
+  Pending[1] = 0;
+  taskEXIT_CRITICAL();
+
+  return(Buf);
+}
 
+/** RenderHalf() *********************************************/
+/** Render one emulated frame of PSG/SCC/FM-PAC sound into  **/
+/** a half of the DAC buffer as 12bit unsigned samples.     **/
+/*************************************************************/
+static void RenderHalf(uint16_t *Buf)
+{
+  uint32_t Start,Scale,J;
+  int D;
 
-static sample *playData;
-unsigned int   playLength;
-uint16_t       toPlayLength = 0;
-QueueHandle_t  audioQueue;
-///static int     volLevel;
-static char    stop = 0;
+  Start = micros();
+  Scale = speakerGetVolume()*4095/100;
 
+  if(Paused)
+    for(J=0;J<HalfLength;++J) Buf[J]=Scale>>1;
+  else
+  {
+    memset(Wave,0,HalfLength*sizeof(Wave[0]));
+    RenderAudio(Wave,HalfLength);
+
+    for(J=0;J<HalfLength;++J)
+    {
+      D      = (Wave[J]*MasterVolume)>>8;
+      D      = D>32767? 32767:D<-32768? -32768:D;
+      Buf[J] = ((uint32_t)(D+32768)*Scale)>>16;
+    }
+  }
+
+  RenderLast = micros()-Start;
+  RenderMax  = RenderLast>RenderMax? RenderLast:RenderMax;
+  RenderSum += RenderLast;
+  ++Rendered;
+}
 
 static void threadAudio(void const *argument)
 {
   UNUSED(argument);
 
-  uint16_t* param;
+  uint16_t *Buf;
 
 
   while(1)
   {
-    printf("th \n");
-
-    xQueuePeek(audioQueue, &param, portMAX_DELAY);
+    osSemaphoreWait(audioSem, osWaitForever);
 
-    if (!stop)
-    {
-      RenderAndPlayAudio(toPlayLength);
-      speakerWrite((uint8_t *)playData, playLength);
-   }
-   xQueueReceive(audioQueue, &param, portMAX_DELAY);
+    while((Buf=PopHalf())) RenderHalf(Buf);
   }
 }
 
@@ -57,25 +133,53 @@ unsigned int InitAudio(unsigned int Rate,unsigned int Latency)
 {
   printf("InitAudio Rate %d %d\n", Rate, Latency);
 
-  stop = 0;
+  if(!Rate) return(0);
 
-  speakerEnable();
-  speakerStart(Rate);
+  Paused     = 0;
+  Underruns  = 0;
+  Rendered   = 0;
+  RenderLast = 0;
+  RenderMax  = 0;
+  RenderSum  = 0;
+  Pending[0] = 0;
+  Pending[1] = 0;
 
-  audioQueue = xQueueCreate(1, sizeof(uint16_t*));
+  /* One half of the ping-pong buffer per emulated frame */
+  HalfLength = Rate/AUDIO_FPS;
+  HalfLength = HalfLength>AUDIO_MAX? AUDIO_MAX:HalfLength;
 
+  speakerEnable();
 
-  osThreadDef(threadAudio, threadAudio, _HW_DEF_RTOS_THREAD_PRI_MAIN, 0, _HW_DEF_RTOS_THREAD_MEM_MAIN);
-  if (osThreadCreate(osThread(threadAudio), NULL) != NULL)
-  {
-    logPrintf("threadAudio \t\t: OK\r\n");
-  }
-  else
+  if(!Created)
   {
-    logPrintf("threadAudio \t\t: Fail\r\n");
-    while(1);
+    osSemaphoreDef(audioSem);
+    audioSem = osSemaphoreCreate(osSemaphore(audioSem), 1);
+
+    osThreadDef(threadAudio, threadAudio, _HW_DEF_RTOS_THREAD_PRI_AUDIO, 0, _HW_DEF_RTOS_THREAD_MEM_AUDIO);
+    if (osThreadCreate(osThread(threadAudio), NULL) != NULL)
+    {
+      logPrintf("threadAudio \t\t: OK\r\n");
+    }
+    else
+    {
+      logPrintf("threadAudio \t\t: Fail\r\n");
+      while(1);
+    }
+
+    if (cmdifIsInit() == false)
+    {
+      cmdifInit();
+    }
+    cmdifAdd("snd", sndCmdif);
+
+    Created = 1;
   }
 
+  /* DAC interrupts pull frames from now on */
+  Streaming = speakerStartStream(Rate, HalfLength, AudioCallback);
+
+  /* Fall back to the byte ring fed by WriteAudio() */
+  if(!Streaming) speakerStart(Rate);
 
   return(Rate);
 }
@@ -85,7 +189,8 @@ unsigned int InitAudio(unsigned int Rate,unsigned int Latency)
 /*************************************************************/
 void TrashAudio(void)
 {
-  printf("TrashAudio\n");
+  if(Streaming) speakerStopStream();
+  Streaming = 0;
 }
 
 /** PauseAudio() *********************************************/
@@ -94,11 +199,10 @@ void TrashAudio(void)
 /*************************************************************/
 int PauseAudio(int Switch)
 {
-  printf("PauseAudio\n");
+  if(Switch==2) Switch=!Paused;
+  Paused=Switch;
 
-  stop=1;
-
-  return(stop);
+  return(Paused);
 }
 
 /** GetFreeAudio() *******************************************/
@@ -106,7 +210,8 @@ int PauseAudio(int Switch)
 /*************************************************************/
 unsigned int GetFreeAudio(void)
 {
-  return speakerAvailable();
+  /* When streaming, RenderAndPlayAudio() has nothing to do */
+  return(Streaming? 0:speakerAvailable());
 }
 
 /** WriteAudio() *********************************************/
@@ -115,35 +220,59 @@ unsigned int GetFreeAudio(void)
 /*************************************************************/
 unsigned int WriteAudio(sample *Data,unsigned int Length)
 {
-  //printf("WriteAudio %d\n", Length);
+  uint8_t Buf[64];
+  uint32_t Free,Done,N,J;
 
-  uint32_t i;
-  uint32_t written = 0;
+  Free   = speakerAvailable();
+  Length = Length<Free? Length:Free;
 
-  for (i=0; i<Length; i++)
+  /* speakerWrite() takes one unsigned byte per sample */
+  for(Done=0;Done<Length;Done+=N)
   {
-    if (speakerAvailable() > 0)
-    {
-      speakerPutch((uint8_t)Data[i]);
-      written++;
-    }
-    else
-    {
-
-    }
+    N = Length-Done<sizeof(Buf)? Length-Done:sizeof(Buf);
+    for(J=0;J<N;++J)
+#ifdef BPS16
+      Buf[J] = (uint8_t)(((int)Data[Done+J]+32768)>>8);
+#else
+      Buf[J] = (uint8_t)((int)Data[Done+J]+128);
+#endif
+    speakerWrite(Buf,N);
   }
-  return written;
+
+  return(Length);
 }
-#if 0
-/** PlayAllSound() *******************************************/
-/** Render and play given number of microseconds of sound.  **/
-/************************************ TO BE WRITTEN BY USER **/
-void PlayAllSound(int uSec) {
 
-  //void* tempPtr = (void*)0x1234;
-  //toPlayLength = 2*uSec*AUDIO_SAMPLE_RATE/1000000;
-  //xQueueSend(audioQueue, &tempPtr, portMAX_DELAY);
+static void sndCmdif(void)
+{
+  bool ret = true;
 
-  printf("PlayAllSound\n");
+  if (cmdifGetParamCnt() == 1 && cmdifHasString("info", 0) == true)
+  {
+    cmdifPrintf("streaming    : %d\n", Streaming);
+    cmdifPrintf("paused       : %d\n", Paused);
+    cmdifPrintf("frame        : %d samples\n", HalfLength);
+    cmdifPrintf("rendered     : %d\n", Rendered);
+    cmdifPrintf("underruns    : %d\n", Underruns);
+    cmdifPrintf("render us    : last %d, avg %d, max %d\n",
+                RenderLast,
+                Rendered? RenderSum/Rendered:0,
+                RenderMax);
+  }
+  else if (cmdifGetParamCnt() == 1 && cmdifHasString("reset", 0) == true)
+  {
+    Underruns = 0;
+    Rendered  = 0;
+    RenderMax = 0;
+    RenderSum = 0;
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "snd info \n");
+    cmdifPrintf( "snd reset \n");
+  }
 }
-#endif
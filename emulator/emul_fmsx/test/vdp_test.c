@@ -0,0 +1,213 @@
+/** fMSX: portable MSX emulator ******************************/
+/**                                                         **/
+/**                        vdp_test.c                       **/
+/**                                                         **/
+/** Host test for the V9938 block command fast paths. Runs  **/
+/** random commands with the per-pixel and the fast-path    **/
+/** engines from the same VRAM and registers, and checks    **/
+/** VRAM, registers and the number of LoopVDP() slices are  **/
+/** the same. Also checks that VDPSaveCmd()/VDPLoadCmd()    **/
+/** let a command go on after another one ran in between.   **/
+/**                                                         **/
+/** Build and run from this directory:                      **/
+/**   gcc -O2 -o vdp_test vdp_test.c && ./vdp_test          **/
+/**                                                         **/
+/*************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Just what V9938.c needs from MSX.h */
+#define MSX_H
+typedef unsigned char byte;
+#define INLINE static inline
+extern byte *VRAM;
+extern byte VDP[64];
+extern byte VDPStatus[16];
+extern byte ScrMode;
+extern int Verbose;
+
+#include "../src/ap/fMSX/core/fMSX/V9938.c"
+
+#define VRAM_SIZE  0x20000
+#define ITERATIONS 20000
+#define MAX_LOOPS  200000
+
+byte *VRAM;
+byte VDP[64];
+byte VDPStatus[16];
+byte ScrMode;
+int  Verbose = 0;
+
+static byte InitVRAM[VRAM_SIZE];
+
+/** RandomVRAM() *********************************************/
+/** Fill InitVRAM with xorshift noise, rand() is too slow.  **/
+/*************************************************************/
+static void RandomVRAM(void)
+{
+  static unsigned int X = 2463534242U;
+  int J;
+
+  for(J=0;J<VRAM_SIZE;J+=4)
+  {
+    X^=X<<13;X^=X>>17;X^=X<<5;
+    memcpy(InitVRAM+J,&X,4);
+  }
+}
+
+/** Run() ****************************************************/
+/** Run one command to the end from InitVRAM and Regs.      **/
+/** Returns the number of LoopVDP() slices it took.         **/
+/*************************************************************/
+static int Run(int Fast,byte Op,const byte *Regs,byte Mode,byte *OutVRAM,byte *OutRegs)
+{
+  int Loops;
+
+  memcpy(VRAM,InitVRAM,VRAM_SIZE);
+  memcpy(VDP,Regs,64);
+  memset(VDPStatus,0,16);
+  ScrMode     = Mode;
+  VDPFastPath = Fast;
+
+  VDPDraw(0x00);
+  LoopVDP();LoopVDP();LoopVDP();
+
+  VDPDraw(Op);
+  for(Loops=0;(VDPStatus[2]&0x01)&&(Loops<MAX_LOOPS);++Loops) LoopVDP();
+
+  memcpy(OutVRAM,VRAM,VRAM_SIZE);
+  memcpy(OutRegs,VDP,64);
+  return(Loops);
+}
+
+/** RandomRegs() *********************************************/
+/** Random command registers, with small and overlapping    **/
+/** areas now and then.                                     **/
+/*************************************************************/
+static void RandomRegs(byte *Regs)
+{
+  int J;
+
+  memset(Regs,0,64);
+  for(J=32;J<47;++J) Regs[J]=rand();
+  Regs[1]=rand();Regs[8]=rand();Regs[9]=rand();
+
+  if(rand()%2) { Regs[41]=0;Regs[43]=0; }
+  if(rand()%3==0) { Regs[34]=Regs[38];Regs[35]=Regs[39]; }
+}
+
+/** TestFastPath() *******************************************/
+/** Both engines give the same VRAM, registers and timing.  **/
+/*************************************************************/
+static int TestFastPath(void)
+{
+  static const byte Ops[] = { 0x80,0x90,0xC0,0xD0,0xE0,0x98,0x83 };
+  static byte V1[VRAM_SIZE],V2[VRAM_SIZE];
+  byte R1[64],R2[64],Regs[64],Op,Mode;
+  int I,L1,L2,Fails;
+
+  for(I=0,Fails=0;I<ITERATIONS;++I)
+  {
+    RandomVRAM();
+    RandomRegs(Regs);
+
+    Mode = 5+rand()%4;
+    Op   = Ops[rand()%(sizeof(Ops)/sizeof(Ops[0]))];
+    if(((Op&0xF0)==0x80||(Op&0xF0)==0x90)&&(rand()%2)) Op&=0xF0;
+
+    L1 = Run(0,Op,Regs,Mode,V1,R1);
+    L2 = Run(1,Op,Regs,Mode,V2,R2);
+
+    if((L1!=L2)||memcmp(V1,V2,VRAM_SIZE)||memcmp(R1,R2,64))
+    {
+      if(Fails++<10)
+        printf("fast path: #%d op %02X screen %d slices %d/%d vram %s regs %s\n",
+               I,Op,Mode,L1,L2,
+               memcmp(V1,V2,VRAM_SIZE)? "differ":"same",
+               memcmp(R1,R2,64)? "differ":"same");
+    }
+  }
+
+  printf("fast path : %d commands, %d mismatches\n",ITERATIONS,Fails);
+  return(Fails==0);
+}
+
+/** TestSaveCmd() ********************************************/
+/** A command parked with VDPSaveCmd() while another one    **/
+/** runs ends the same as one that ran on its own.          **/
+/*************************************************************/
+static int TestSaveCmd(void)
+{
+  static byte V1[VRAM_SIZE],V2[VRAM_SIZE];
+  byte R1[64],R2[64],Regs[64],Other[64],SavedVDP[64],SavedStatus[16];
+  byte *Saved,*SavedVRAM;
+  int I,J,Fails;
+
+  Saved     = malloc(VDPCmdSize());
+  SavedVRAM = malloc(VRAM_SIZE);
+
+  for(I=0,Fails=0;I<200;++I)
+  {
+    RandomVRAM();
+    RandomRegs(Regs);
+    Regs[41]=1;Regs[42]=212;   /* NX=256,NY=212, takes many slices */
+
+    Run(1,0xD0,Regs,8,V1,R1);
+
+    /* Same command, interrupted after a few slices */
+    memcpy(VRAM,InitVRAM,VRAM_SIZE);
+    memcpy(VDP,Regs,64);
+    memset(VDPStatus,0,16);
+    ScrMode=8;
+    VDPDraw(0x00);
+    LoopVDP();LoopVDP();LoopVDP();
+    VDPDraw(0xD0);
+    for(J=0;J<3;++J) LoopVDP();
+
+    VDPSaveCmd(Saved);
+    memcpy(SavedVRAM,VRAM,VRAM_SIZE);
+    memcpy(SavedVDP,VDP,64);
+    memcpy(SavedStatus,VDPStatus,16);
+
+    RandomRegs(Other);
+    memcpy(VDP,Other,64);
+    VDPDraw(0x00);
+    VDPDraw(0xC0);
+    for(J=0;(VDPStatus[2]&0x01)&&(J<MAX_LOOPS);++J) LoopVDP();
+
+    memcpy(VRAM,SavedVRAM,VRAM_SIZE);
+    memcpy(VDP,SavedVDP,64);
+    memcpy(VDPStatus,SavedStatus,16);
+    VDPLoadCmd(Saved);
+
+    for(J=0;(VDPStatus[2]&0x01)&&(J<MAX_LOOPS);++J) LoopVDP();
+    memcpy(V2,VRAM,VRAM_SIZE);
+    memcpy(R2,VDP,64);
+
+    if(memcmp(V1,V2,VRAM_SIZE)||memcmp(R1,R2,64))
+      if(Fails++<10) printf("save cmd: #%d differs\n",I);
+  }
+
+  free(SavedVRAM);
+  free(Saved);
+
+  printf("save cmd  : %d commands, %d mismatches\n",I,Fails);
+  return(Fails==0);
+}
+
+int main(void)
+{
+  int OK;
+
+  VRAM=malloc(VRAM_SIZE);
+  srand(1);
+
+  OK  = TestFastPath();
+  OK &= TestSaveCmd();
+
+  free(VRAM);
+
+  printf("%s\n",OK? "PASS":"FAIL");
+  return(OK? 0:1);
+}
@@ -0,0 +1,273 @@
+/** fMSX: portable MSX emulator ******************************/
+/**                                                         **/
+/**                        z80_test.c                       **/
+/**                                                         **/
+/** Host test for the Z80 cores. The reference is Z80.c as  **/
+/** it was built before: switch dispatch, every access      **/
+/** through RdZ80()/WrZ80(). It is checked against the fMSX **/
+/** build (FMSX, RAM[] accesses inlined) with the switch    **/
+/** and with the computed-goto (GOTOZ80) RunZ80(). Random   **/
+/** code, memory, mappers, and interrupts must leave the    **/
+/** same registers, memory, cycle counts, and I/O trace.    **/
+/** The FMSX build fetches opcodes through RAM[], so reads  **/
+/** of the FDC window only act as a device when the two     **/
+/** FMSX cores are compared. A tight loop then gives MIPS   **/
+/** for each core.                                          **/
+/**                                                         **/
+/** Build and run from this directory:                      **/
+/**   Z=../src/ap/fMSX/core/Z80                             **/
+/**   for C in ref sw goto; do                              **/
+/**     F=; [ $C != ref ] && F=-DFMSX;                      **/
+/**     [ $C = goto ] && F="$F -DGOTOZ80";                  **/
+/**     gcc -O2 -DLSB_FIRST $F -I$Z -DRunZ80=RunZ80_$C      **/
+/**       -DResetZ80=ResetZ80_$C -DIntZ80=IntZ80_$C         **/
+/**       -c $Z/Z80.c -o z80_$C.o;                          **/
+/**   done                                                  **/
+/**   gcc -O2 -DLSB_FIRST -I$Z -o z80_test z80_test.c       **/
+/**     z80_ref.o z80_sw.o z80_goto.o && ./z80_test         **/
+/**                                                         **/
+/*************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "Z80.h"
+
+#define RUNS       2000
+#define RUN_LOOPS  200
+#define BENCH_LOOPS 2000000
+
+typedef struct
+{
+  const char *Name;
+  word (*Run)(Z80 *R);
+  void (*Reset)(Z80 *R);
+} Core;
+
+word RunZ80_ref(Z80 *R);  void ResetZ80_ref(Z80 *R);
+word RunZ80_sw(Z80 *R);   void ResetZ80_sw(Z80 *R);
+word RunZ80_goto(Z80 *R); void ResetZ80_goto(Z80 *R);
+
+static const Core Cores[] =
+{
+  { "switch RdZ80()",RunZ80_ref, ResetZ80_ref  },
+  { "switch FMSX   ",RunZ80_sw,  ResetZ80_sw   },
+  { "goto FMSX     ",RunZ80_goto,ResetZ80_goto }
+};
+
+/* What the FMSX block in Z80.c expects from MSX.c */
+byte *RAM[8];
+byte EnWrite[4];
+
+static byte Mem[16][0x4000];
+static uint64_t Hash;
+static uint32_t Seed;
+static int Loops,MaxLoops,Bench,Device;
+static uint32_t M1,LastR;
+
+/** Rnd() ****************************************************/
+/** Seeded LCG, the same sequence for every core.           **/
+/*************************************************************/
+static uint32_t Rnd(void) { Seed=Seed*1103515245+12345;return(Seed>>8); }
+
+/** Trace() **************************************************/
+/** Fold a value into the FNV-1a style trace hash.          **/
+/*************************************************************/
+static void Trace(uint32_t V) { Hash=(Hash^V)*0x100000001B3ULL; }
+
+/** Map() ****************************************************/
+/** Two bits per 16kB page: which block, and blocks 2,3 of  **/
+/** a page are RAM while 0,1 are ROM.                       **/
+/*************************************************************/
+static void Map(byte V)
+{
+  int J,B;
+
+  for(J=0;J<4;++J)
+  {
+    B=J*4+((V>>(2*J))&3);
+    RAM[2*J]   = Mem[B];
+    RAM[2*J+1] = Mem[B]+0x2000;
+    EnWrite[J] = ((V>>(2*J))&3)>=2;
+  }
+}
+
+/** RdZ80()/WrZ80() ******************************************/
+/** Like MSX.c: the FDC window is a device (reads only with **/
+/** Device set), ROM writes switch the page like a mapper,  **/
+/** and FFFFh switches all of them.                         **/
+/*************************************************************/
+byte RdZ80(word A)
+{
+  if(Device&&((A&0x3F88)==0x3F88)&&!EnWrite[A>>14]) { Trace(0x100000|A);return(Rnd()); }
+  return(RAM[A>>13][A&0x1FFF]);
+}
+
+void WrZ80(word A,byte V)
+{
+  if(A==0xFFFF) { Trace(0x200000|V);Map(V^0x55);return; }
+  if(((A&0x3F88)==0x3F88)&&!EnWrite[A>>14]) { Trace(0x300000|A|(V<<8));return; }
+  if(EnWrite[A>>14]) { RAM[A>>13][A&0x1FFF]=V;return; }
+  Trace(0x400000|A|(V<<24));
+  RAM[A>>13]=Mem[V&15]+((A>>13)&1)*0x2000;
+}
+
+byte InZ80(word P) { Trace(0x500000|P);return(Bench? 0:Rnd()); }
+
+void OutZ80(word P,byte V)
+{
+  Trace(0x600000|P|(V<<24));
+  if((P&0xFF)==0xA8) Map(V);
+}
+
+void PatchZ80(Z80 *R) { Trace(0x700000|R->PC.W);R->AF.B.h^=0x5A; }
+
+/** LoopZ80() ************************************************/
+/** Trace all registers each slice and raise random IRQs    **/
+/** and NMIs. In the benchmark only count M1 cycles.        **/
+/*************************************************************/
+word LoopZ80(Z80 *R)
+{
+  uint32_t X;
+
+  M1+=(R->R-LastR)&0x7F;LastR=R->R;
+  if(Bench) return(++Loops>=MaxLoops? INT_QUIT:INT_NONE);
+
+  Trace(R->AF.W);Trace(R->BC.W);Trace(R->DE.W);Trace(R->HL.W);
+  Trace(R->IX.W);Trace(R->IY.W);Trace(R->PC.W);Trace(R->SP.W);
+  Trace(R->AF1.W);Trace(R->BC1.W);Trace(R->DE1.W);Trace(R->HL1.W);
+  Trace(R->IFF);Trace(R->I);Trace(R->R);Trace(R->ICount);Trace(R->IRequest);
+  if(++Loops>=MaxLoops) return(INT_QUIT);
+
+  X=Rnd()%100;
+  if(X<2)  return(INT_NMI);
+  if(X<30) return(INT_IRQ);
+  if(X<35) { R->IRequest=INT_IRQ;return(INT_NONE); }
+  if(X<38) R->IRequest=INT_NONE;
+  return(INT_NONE);
+}
+
+/** Setup() **************************************************/
+/** Random memory and registers from a seed.                **/
+/*************************************************************/
+static void Setup(uint32_t S,Z80 *R,const Core *C)
+{
+  int J;
+
+  Seed=S;Hash=1469598103934665603ULL;Loops=0;
+  for(J=0;J<16*0x4000;++J) ((byte *)Mem)[J]=Rnd();
+  Map(0xF0);
+  memset(R,0,sizeof(*R));
+  R->IPeriod    = 50+Rnd()%400;
+  R->IAutoReset = 1;
+  C->Reset(R);
+  R->SP.W=0xF000;
+  R->AF.W=Rnd();R->BC.W=Rnd();R->DE.W=Rnd();R->HL.W=Rnd();
+  R->IX.W=Rnd();R->IY.W=Rnd();R->PC.W=Rnd();
+  R->IFF=Rnd()&(IFF_1|IFF_2|IFF_IM1|IFF_IM2);
+  R->I=Rnd();
+}
+
+/** Finish() *************************************************/
+/** Trace hash with memory and mapping folded in.           **/
+/*************************************************************/
+static uint64_t Finish(Z80 *R)
+{
+  int J;
+
+  Trace(R->PC.W);Trace(R->AF.W);Trace(R->ICount);
+  for(J=0;J<16*0x4000;++J) Trace(((byte *)Mem)[J]);
+  for(J=0;J<8;++J) Trace((uint32_t)(RAM[J]-(byte *)Mem));
+  return(Hash);
+}
+
+/** TestCores() **********************************************/
+/** Core C ends each random run like core Ref.              **/
+/*************************************************************/
+static int TestCores(const Core *Ref,const Core *C)
+{
+  Z80 A,B;
+  uint64_t HA,HB;
+  int J,Fails;
+
+  for(J=0,Fails=0;J<RUNS;++J)
+  {
+    MaxLoops=RUN_LOOPS;
+    Setup(J+1,&A,Ref);Ref->Run(&A);HA=Finish(&A);
+    Setup(J+1,&B,C);C->Run(&B);HB=Finish(&B);
+    if((HA!=HB)||memcmp(&A,&B,offsetof(Z80,User)))
+      if(Fails++<10) printf("%s: seed %d differs\n",C->Name,J+1);
+  }
+
+  printf("%s vs %s: %d runs, %d mismatches%s\n",
+         Ref->Name,C->Name,RUNS,Fails,Device? ", FDC window":"");
+  return(Fails==0);
+}
+
+/** BenchCore() **********************************************/
+/** Copy, add, call, index and DJNZ in a loop, no IRQs.     **/
+/*************************************************************/
+static void BenchCore(const Core *C)
+{
+  static const byte Prog[] =
+  {
+    0x21,0x00,0x80,       /* 0000 LD HL,8000h */
+    0x11,0x00,0x90,       /* 0003 LD DE,9000h */
+    0x06,0x00,            /* 0006 LD B,0      */
+    0x7E,                 /* 0008 LD A,(HL)   */
+    0x81,                 /* 0009 ADD A,C     */
+    0x12,                 /* 000A LD (DE),A   */
+    0x23,                 /* 000B INC HL      */
+    0x13,                 /* 000C INC DE      */
+    0xEE,0x55,            /* 000D XOR 55h     */
+    0x4F,                 /* 000F LD C,A      */
+    0xCD,0x20,0x00,       /* 0010 CALL 0020h  */
+    0x10,0xF3,            /* 0013 DJNZ 0008h  */
+    0xC3,0x00,0x00        /* 0015 JP 0000h    */
+  };
+  static const byte Sub[] =
+  {
+    0xCB,0x41,            /* BIT 0,C          */
+    0xDD,0x21,0x34,0x12,  /* LD IX,1234h      */
+    0xDD,0x7E,0x02,       /* LD A,(IX+2)      */
+    0xEB,0xEB,            /* EX DE,HL x2      */
+    0xC9                  /* RET              */
+  };
+  struct timespec T0,T1;
+  double S;
+  Z80 R;
+
+  Setup(1,&R,C);
+  memcpy(RAM[0],Prog,sizeof(Prog));
+  memcpy(RAM[0]+0x20,Sub,sizeof(Sub));
+  R.PC.W=0;R.IFF=0;R.IPeriod=228;R.ICount=228;
+
+  Bench=1;Loops=0;MaxLoops=BENCH_LOOPS;M1=0;LastR=R.R;
+  clock_gettime(CLOCK_MONOTONIC,&T0);
+  C->Run(&R);
+  clock_gettime(CLOCK_MONOTONIC,&T1);
+  Bench=0;
+
+  S=(T1.tv_sec-T0.tv_sec)+(T1.tv_nsec-T0.tv_nsec)/1e9;
+  printf("%s: %.3fs, %.1f emulated MHz, %.1f M1 MIPS\n",
+         C->Name,S,228.0*BENCH_LOOPS/S/1e6,M1/S/1e6);
+}
+
+int main(int argc,char *argv[])
+{
+  int J,OK;
+
+  Device=0;
+  OK =TestCores(&Cores[0],&Cores[1]);
+  OK&=TestCores(&Cores[0],&Cores[2]);
+  Device=1;
+  OK&=TestCores(&Cores[1],&Cores[2]);
+  Device=0;
+
+  for(J=0;J<sizeof(Cores)/sizeof(Cores[0]);++J) BenchCore(&Cores[J]);
+
+  printf("%s\n",OK? "z80_test : OK":"z80_test : FAIL");
+  return(OK? 0:1);
+}
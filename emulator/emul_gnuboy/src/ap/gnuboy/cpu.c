@@ -392,6 +392,7 @@ extern int debug_trace;
 	Might emulate up to cycles+(11) time units (longest op takes 12
 	cycles in single-speed mode)
 */
+__attribute__((section(".itcm_text")))
 int cpu_emulate(int cycles)
 {
 	int i;
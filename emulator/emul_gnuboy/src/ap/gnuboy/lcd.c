@@ -137,6 +137,7 @@ void updatepatpix()
 
 
 
+__attribute__((section(".itcm_text")))
 void tilebuf()
 {
 	int i, cnt;
@@ -235,6 +236,7 @@ void tilebuf()
 }
 
 
+__attribute__((section(".itcm_text")))
 void bg_scan()
 {
 	int cnt;
@@ -263,6 +265,7 @@ void bg_scan()
 		*(dest++) = *(src++);
 }
 
+__attribute__((section(".itcm_text")))
 void wnd_scan()
 {
 	int cnt;
@@ -354,6 +357,7 @@ void wnd_scan_pri()
 }
 
 #ifndef ASM_BG_SCAN_COLOR
+__attribute__((section(".itcm_text")))
 void bg_scan_color()
 {
 	int cnt;
@@ -382,6 +386,7 @@ void bg_scan_color()
 }
 #endif
 
+__attribute__((section(".itcm_text")))
 void wnd_scan_color()
 {
 	int cnt;
@@ -495,6 +500,7 @@ void spr_enum()
 	memcpy(VS, ts, sizeof VS);
 }
 
+__attribute__((section(".itcm_text")))
 void spr_scan()
 {
 	int i, x;
@@ -576,6 +582,7 @@ void lcd_begin()
 	WY = R_WY;
 }
 
+__attribute__((section(".itcm_text")))
 void lcd_refreshline()
 {
 #if 1
@@ -12,9 +12,11 @@
 #include "uart.h"
 #include "rtos.h"
 #include "usb.h"
+#include "qspi.h"
 
 
 static void SystemClock_Config(void);
+static void MPU_Config(void);
 
 
 void bspTest()
@@ -26,6 +28,11 @@ void bspInit(void)
 {
   HAL_Init();
 
+  if (qspiIsXip() == true)
+  {
+    MPU_Config();
+  }
+
   SCB_EnableICache();
   SCB_EnableDCache();
 
@@ -79,6 +86,42 @@ void Error_Handler(void)
   }
 }
 
+// QSPI : the 64MB of the flash are cacheable write-through and read only,
+// code may run from it (STM32H753II_QSPI.ld). The rest of the 256MB window
+// is no access, so speculative reads never go past the end of the flash.
+// Regions 0 to 5 are set up by the launcher (D3 SRAM and SDRAM) and kept.
+//
+static void MPU_Config(void)
+{
+  MPU_Region_InitTypeDef MPU_InitStruct;
+
+
+  HAL_MPU_Disable();
+
+  MPU_InitStruct.Enable           = MPU_REGION_ENABLE;
+  MPU_InitStruct.Number           = MPU_REGION_NUMBER6;
+  MPU_InitStruct.BaseAddress      = 0x90000000;
+  MPU_InitStruct.Size             = MPU_REGION_SIZE_256MB;
+  MPU_InitStruct.AccessPermission = MPU_REGION_NO_ACCESS;
+  MPU_InitStruct.TypeExtField     = MPU_TEX_LEVEL0;
+  MPU_InitStruct.IsBufferable     = MPU_ACCESS_NOT_BUFFERABLE;
+  MPU_InitStruct.IsCacheable      = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsShareable      = MPU_ACCESS_NOT_SHAREABLE;
+  MPU_InitStruct.DisableExec      = MPU_INSTRUCTION_ACCESS_DISABLE;
+  MPU_InitStruct.SubRegionDisable = 0x00;
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+  MPU_InitStruct.Number           = MPU_REGION_NUMBER7;
+  MPU_InitStruct.BaseAddress      = 0x90000000;
+  MPU_InitStruct.Size             = MPU_REGION_SIZE_64MB;
+  MPU_InitStruct.AccessPermission = MPU_REGION_PRIV_RO_URO;
+  MPU_InitStruct.IsCacheable      = MPU_ACCESS_CACHEABLE;
+  MPU_InitStruct.DisableExec      = MPU_INSTRUCTION_ACCESS_ENABLE;
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+  HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+}
+
 /**
   * @brief  System Clock Configuration
   *         The system Clock is configured as follow :
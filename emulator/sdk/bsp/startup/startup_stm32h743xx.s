@@ -60,6 +60,9 @@ defined in linker script */
 .word  _sbss
 /* end address for the .bss section. defined in linker script */
 .word  _ebss
+/* sections copied before .data, only STM32H753II_QSPI.ld defines the table */
+.weak  __copy_table_start__
+.weak  __copy_table_end__
 /* stack used for SystemInit_ExtMemCtl; always internal RAM used */
 
 /**
@@ -77,6 +80,26 @@ defined in linker script */
 Reset_Handler:  
   ldr   sp, =_estack       /* set stack pointer */
 
+/* Copy the sections of the copy table, {load, run, bytes} each */
+  ldr  r4, =__copy_table_start__
+  ldr  r5, =__copy_table_end__
+
+LoopCopyTable:
+  cmp  r4, r5
+  bcs  CopyTableDone
+  ldmia  r4!, {r1, r2, r3}
+
+CopySection:
+  subs  r3, r3, #4
+  bmi  LoopCopyTable
+  ldr  r0, [r1, r3]
+  str  r0, [r2, r3]
+  b  CopySection
+
+CopyTableDone:
+  dsb
+  isb
+
 
 /* Copy the data segment initializers from flash to SRAM */  
   movs  r1, #0
@@ -23,6 +23,11 @@
 #define DAC_MAX_CH       HW_DAC_MAX_CH
 
 
+// Called from the DMA half/complete interrupt with the half of the
+// buffer that has just been played and may be refilled.
+typedef void (*dac_stream_func_t)(uint16_t *p_buf, uint32_t length);
+
+
 
 void dacInit();
 void dacSetup(uint32_t hz);
@@ -36,6 +41,9 @@ void     dacWrite(uint8_t *p_data, uint32_t length);
 void dacPut16(uint16_t data);
 void dacWrite16(uint16_t *p_data, uint32_t length);
 
+bool dacStartStream(uint32_t hz, uint32_t length, dac_stream_func_t func);
+void dacStopStream(void);
+
 uint32_t dacGetDebug(void);
 uint32_t dacGetBufLength(void);
 
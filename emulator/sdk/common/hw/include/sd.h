@@ -40,6 +40,10 @@ bool sdDeInit(void);
 void sdTest(void);
 
 bool sdReadBlocks(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, uint32_t timeout_ms);
+bool sdReadBlocksStart(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks);
+bool sdReadBlocksWait(uint32_t timeout_ms);
+bool sdReadBlocksAsync(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, void (*func)(bool is_ok, void *arg), void *arg);
+bool sdWriteBlocksAsync(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, void (*func)(bool is_ok, void *arg), void *arg);
 bool sdWriteBlocks(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, uint32_t timeout_ms);
 bool sdEraseBlocks(uint32_t start_addr, uint32_t end_addr);
 bool sdIsBusy(void);
@@ -32,6 +32,9 @@ uint32_t speakerGetBufLength(void);
 void speakerPutch(uint8_t data);
 void speakerWrite(uint8_t *p_data, uint32_t length);
 
+bool speakerStartStream(uint32_t hz, uint32_t length, void (*func)(uint16_t *p_buf, uint32_t length));
+void speakerStopStream(void);
+
 #endif
 
 
@@ -34,6 +34,9 @@ static ring_buf16_t tx_buf;
 static uint32_t     dac_hz = 0;
 static bool         is_stop = true;
 
+static dac_stream_func_t stream_func   = NULL;
+static uint32_t          stream_length = 0;
+
 
 
 volatile __attribute__((section(".sram_d4")))   uint16_t dac_buffer[DAC_BUFFER_MAX];
@@ -230,6 +233,73 @@ void dacWrite16(uint16_t *p_data, uint32_t length)
   }
 }
 
+bool dacStartStream(uint32_t hz, uint32_t length, dac_stream_func_t func)
+{
+  uint32_t i;
+
+
+  if (length == 0 || length > DAC_BUFFER_MAX/2 || func == NULL)
+  {
+    return false;
+  }
+
+  HAL_TIM_Base_Stop(&htim);
+  HAL_DAC_Stop_DMA(&DacHandle, dac_tbl[0].channel);
+
+  for (i=0; i<length*2; i++)
+  {
+    dac_tbl[0].buffer[i] = 0;
+  }
+
+  stream_func   = func;
+  stream_length = length;
+
+  // Let the owner fill both halves before the first sample goes out.
+  stream_func((uint16_t *)&dac_tbl[0].buffer[0], length);
+  stream_func((uint16_t *)&dac_tbl[0].buffer[length], length);
+
+  HAL_NVIC_SetPriority(DMA2_Stream6_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+
+  HAL_DAC_Start_DMA(&DacHandle, dac_tbl[0].channel, (uint32_t *)dac_tbl[0].buffer, length*2, DAC_ALIGN_12B_R);
+
+  dacSetup(hz);
+  dacStart();
+
+  return true;
+}
+
+void dacStopStream(void)
+{
+  uint32_t i;
+
+
+  if (stream_func == NULL)
+  {
+    return;
+  }
+
+  is_stop = true;
+
+  HAL_TIM_Base_Stop(&htim);
+  HAL_DAC_Stop_DMA(&DacHandle, dac_tbl[0].channel);
+  HAL_NVIC_DisableIRQ(DMA2_Stream6_IRQn);
+
+  stream_func   = NULL;
+  stream_length = 0;
+
+  for (i=0; i<DAC_BUFFER_MAX; i++)
+  {
+    dac_tbl[0].buffer[i] = 0;
+  }
+
+  // Back to the free running ring used by dacPutch()/dacPut16().
+  HAL_DAC_Start_DMA(&DacHandle, dac_tbl[0].channel, (uint32_t *)dac_tbl[0].buffer, DAC_BUFFER_MAX, DAC_ALIGN_12B_R);
+
+  tx_buf.ptr_in  = 0;
+  tx_buf.ptr_out = 0;
+}
+
 uint32_t dacGetDebug(void)
 {
   return ((DMA_Stream_TypeDef   *)hdma_dac1.Instance)->NDTR;
@@ -312,10 +382,20 @@ volatile uint32_t dac_isr_count = 0;
 void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef* hdac)
 {
   dac_isr_count++;
+
+  // First half has been played, it is free to refill.
+  if (stream_func != NULL)
+  {
+    stream_func((uint16_t *)&dac_tbl[0].buffer[0], stream_length);
+  }
 }
 
 void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef* hdac)
 {
+  if (stream_func != NULL)
+  {
+    stream_func((uint16_t *)&dac_tbl[0].buffer[stream_length], stream_length);
+  }
 }
 
 
@@ -90,6 +90,8 @@ typedef struct {
 static QSPI_HandleTypeDef QSPIHandle;
 static bool is_init = false;
 
+extern uint32_t _flash_tag_addr;
+
 uint8_t BSP_QSPI_Init       (void);
 uint8_t BSP_QSPI_DeInit     (void);
 uint8_t BSP_QSPI_Read       (uint8_t* pData, uint32_t ReadAddr, uint32_t Size);
@@ -111,6 +113,13 @@ bool qspiInit(void)
   QSPI_Info info;
 
 
+  // The launcher left it memory mapped and this code runs from it.
+  if (qspiIsXip() == true)
+  {
+    logPrintf("MT25QL512A(QSPI) \t: XIP\r\n");
+    return false;
+  }
+
   if (BSP_QSPI_Init() == QSPI_OK)
   {
     ret = true;
@@ -148,7 +157,25 @@ bool qspiInit(void)
 
 bool qspiIsInit(void)
 {
-  return is_init;
+  return is_init || qspiIsXip();
+}
+
+// Running from the memory mapped QSPI (STM32H753II_QSPI.ld). Anything that
+// leaves memory mapped mode would pull the code away, so reads go through
+// the mapping and writes, erases and commands are refused.
+//
+bool qspiIsXip(void)
+{
+  uint32_t addr = (uint32_t)&_flash_tag_addr;
+
+  if (addr >= QSPI_BASE_ADDRESS && addr < QSPI_BASE_ADDRESS + N25Q512A_FLASH_SIZE)
+  {
+    return true;
+  }
+  else
+  {
+    return false;
+  }
 }
 
 bool qspiRead(uint32_t addr, uint8_t *p_data, uint32_t length)
@@ -160,6 +187,12 @@ bool qspiRead(uint32_t addr, uint8_t *p_data, uint32_t length)
     return false;
   }
 
+  if (qspiIsXip() == true)
+  {
+    memcpy(p_data, (void *)(QSPI_BASE_ADDRESS + addr), length);
+    return true;
+  }
+
   ret = BSP_QSPI_Read(p_data, addr, length);
 
   if (ret == QSPI_OK)
@@ -176,7 +209,7 @@ bool qspiWrite(uint32_t addr, uint8_t *p_data, uint32_t length)
 {
   uint8_t ret;
 
-  if (addr >= qspiGetLength())
+  if (addr >= qspiGetLength() || qspiIsXip() == true)
   {
     return false;
   }
@@ -197,6 +230,11 @@ bool qspiEraseBlock(uint32_t block_addr)
 {
   uint8_t ret;
 
+  if (qspiIsXip() == true)
+  {
+    return false;
+  }
+
   ret = BSP_QSPI_Erase_Block(block_addr);
 
   if (ret == QSPI_OK)
@@ -254,6 +292,11 @@ bool qspiEraseChip(void)
 {
   uint8_t ret;
 
+  if (qspiIsXip() == true)
+  {
+    return false;
+  }
+
   ret = BSP_QSPI_Erase_Chip();
 
   if (ret == QSPI_OK)
@@ -270,6 +313,11 @@ bool qspiGetStatus(void)
 {
   uint8_t ret;
 
+  if (qspiIsXip() == true)
+  {
+    return false;
+  }
+
   ret = BSP_QSPI_GetStatus();
 
   if (ret == QSPI_OK)
@@ -286,6 +334,11 @@ bool qspiGetInfo(qspi_info_t* p_info)
 {
   uint8_t ret;
 
+  if (qspiIsXip() == true)
+  {
+    return false;
+  }
+
   ret = BSP_QSPI_GetInfo((QSPI_Info *)p_info);
 
   if (ret == QSPI_OK)
@@ -302,6 +355,11 @@ bool qspiEnableMemoryMappedMode(void)
 {
   uint8_t ret;
 
+  if (qspiIsXip() == true)
+  {
+    return true;
+  }
+
   ret = BSP_QSPI_EnableMemoryMappedMode();
 
   if (ret == QSPI_OK)
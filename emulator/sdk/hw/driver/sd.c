@@ -14,14 +14,58 @@
 
 #ifdef _USE_HW_SD
 #include "gpio.h"
+#include "micros.h"
 #include "cmdif.h"
 
 
+#define SD_BLOCK_SIZE           512
+#define SD_DMA_ALIGN            32          // D-cache line
+#define SD_BOUNCE_BLOCKS        16
+#define SD_LOCK_TIMEOUT         5000
+#define SD_BENCH_MB             4
+#define SD_BENCH_IOPS_CNT       1000
+
+
+typedef struct
+{
+  uint32_t rd_bytes;
+  uint32_t rd_cnt;
+  uint32_t rd_us;
+  uint32_t wr_bytes;
+  uint32_t wr_cnt;
+  uint32_t wr_us;
+} sd_stat_t;
+
+
 //-- Internal Variables
 //
 static bool is_init = false;
 static SD_HandleTypeDef uSdHandle;
 
+// One transfer at a time, started by sdDmaBegin() and finished in the
+// SDMMC1 interrupt.
+static volatile bool is_done = true;
+static volatile bool is_err  = false;
+static bool     xfer_is_read;
+static uint8_t *xfer_p_data;
+static uint32_t xfer_length;
+static uint32_t xfer_begin_us;
+static void   (*xfer_func)(bool is_ok, void *arg) = NULL;
+static void    *xfer_arg;
+static bool     xfer_is_locked = false;
+static volatile bool is_prog = false;     // an async write left the card programming
+
+static sd_stat_t sd_stat;
+
+// IDMA can not reach the DTCM and the cache works on 32 byte lines, other
+// buffers go through here.
+static uint8_t sd_bounce_buf[SD_BOUNCE_BLOCKS * SD_BLOCK_SIZE] __attribute__((aligned(SD_DMA_ALIGN)));
+
+#ifdef _USE_HW_RTOS
+static osSemaphoreId sem_lock;
+static osSemaphoreId sem_done;
+#endif
+
 
 
 
@@ -37,6 +81,15 @@ void sdCmdif(void);
 #endif
 
 //static void sdInitHw(void);
+static bool sdIsThread(void);
+static bool sdLock(void);
+static void sdUnlock(void);
+static bool sdIsDmaBuffer(uint8_t *p_data);
+static bool sdDmaAsync(bool is_read, uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, void (*func)(bool is_ok, void *arg), void *arg);
+static bool sdDmaBegin(bool is_read, uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks);
+static bool sdDmaWait(uint32_t timeout_ms);
+static void sdDmaDone(bool is_ok);
+static bool sdWaitReady(uint32_t timeout_ms);
 
 
 //-- External Functions
@@ -61,6 +114,17 @@ bool sdInit(void)
 
 
 
+#ifdef _USE_HW_RTOS
+  if (sem_lock == NULL)
+  {
+    osSemaphoreDef(sem_lock);
+    osSemaphoreDef(sem_done);
+    sem_lock = osSemaphoreCreate(osSemaphore(sem_lock), 1);
+    sem_done = osSemaphoreCreate(osSemaphore(sem_done), 1);
+  }
+#endif
+
+
   if (sdIsDetected() != true)
   {
     logPrintf("sdCard     \t\t: not connected\r\n");
@@ -123,28 +187,142 @@ bool sdDeInit(void)
 
 bool sdReadBlocks(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, uint32_t timeout_ms)
 {
-  bool ret = false;
+  bool ret = true;
+  uint32_t blocks;
 
 
-  if(HAL_SD_ReadBlocks(&uSdHandle, (uint8_t *)p_data, block_addr, num_of_blocks, timeout_ms) == HAL_OK)
+  if (sdLock() != true)
   {
-    while(sdIsBusy() == true);
-    ret = true;
+    return false;
+  }
+
+  if (sdIsDmaBuffer(p_data) == true)
+  {
+    ret = sdDmaBegin(true, block_addr, p_data, num_of_blocks);
+    if (ret == true)
+    {
+      ret = sdDmaWait(timeout_ms);
+    }
+  }
+  else
+  {
+    while (num_of_blocks > 0 && ret == true)
+    {
+      blocks = constrain(num_of_blocks, 1, SD_BOUNCE_BLOCKS);
+
+      ret = sdDmaBegin(true, block_addr, sd_bounce_buf, blocks);
+      if (ret == true)
+      {
+        ret = sdDmaWait(timeout_ms);
+      }
+      if (ret == true)
+      {
+        memcpy(p_data, sd_bounce_buf, blocks * SD_BLOCK_SIZE);
+      }
+
+      block_addr    += blocks;
+      p_data        += blocks * SD_BLOCK_SIZE;
+      num_of_blocks -= blocks;
+    }
   }
 
+  sdUnlock();
+
+  return ret;
+}
+
+// Start a read and return, sdReadBlocksWait() finishes it. p_data has to be
+// 32 byte aligned and outside the DTCM.
+//
+bool sdReadBlocksStart(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks)
+{
+  if (sdIsDmaBuffer(p_data) != true || sdLock() != true)
+  {
+    return false;
+  }
+
+  if (sdDmaBegin(true, block_addr, p_data, num_of_blocks) != true)
+  {
+    sdUnlock();
+    return false;
+  }
+
+  return true;
+}
+
+bool sdReadBlocksWait(uint32_t timeout_ms)
+{
+  bool ret;
+
+
+  ret = sdDmaWait(timeout_ms);
+  sdUnlock();
+
   return ret;
 }
 
+// Start a read, func is called from the SDMMC1 interrupt when it is done.
+// p_data has to be 32 byte aligned and outside the DTCM.
+//
+bool sdReadBlocksAsync(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, void (*func)(bool is_ok, void *arg), void *arg)
+{
+  return sdDmaAsync(true, block_addr, p_data, num_of_blocks, func, arg);
+}
+
+// Same for a write. func is called once the data is sent, the card may
+// still be programming then, sdIsBusy() tells when it is done.
+//
+bool sdWriteBlocksAsync(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, void (*func)(bool is_ok, void *arg), void *arg)
+{
+  return sdDmaAsync(false, block_addr, p_data, num_of_blocks, func, arg);
+}
+
 bool sdWriteBlocks(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, uint32_t timeout_ms)
 {
-  bool ret = false;
+  bool ret = true;
+  uint32_t blocks;
 
 
-  if(HAL_SD_WriteBlocks(&uSdHandle, (uint8_t *)p_data, block_addr, num_of_blocks, timeout_ms) == HAL_OK)
+  if (sdLock() != true)
   {
-    ret = true;
+    return false;
   }
 
+  if (sdIsDmaBuffer(p_data) == true)
+  {
+    ret = sdDmaBegin(false, block_addr, p_data, num_of_blocks);
+    if (ret == true)
+    {
+      ret = sdDmaWait(timeout_ms);
+    }
+  }
+  else
+  {
+    while (num_of_blocks > 0 && ret == true)
+    {
+      blocks = constrain(num_of_blocks, 1, SD_BOUNCE_BLOCKS);
+
+      memcpy(sd_bounce_buf, p_data, blocks * SD_BLOCK_SIZE);
+      ret = sdDmaBegin(false, block_addr, sd_bounce_buf, blocks);
+      if (ret == true)
+      {
+        ret = sdDmaWait(timeout_ms);
+      }
+
+      block_addr    += blocks;
+      p_data        += blocks * SD_BLOCK_SIZE;
+      num_of_blocks -= blocks;
+    }
+  }
+
+  // Reads never wait for the card, so let it finish programming here.
+  if (ret == true)
+  {
+    ret = sdWaitReady(timeout_ms);
+  }
+
+  sdUnlock();
+
   return ret;
 }
 
@@ -153,11 +331,24 @@ bool sdEraseBlocks(uint32_t start_addr, uint32_t end_addr)
   bool ret = false;
 
 
+  if (sdLock() != true)
+  {
+    return false;
+  }
+
+  if (is_prog == true)
+  {
+    sdWaitReady(SD_LOCK_TIMEOUT);
+    is_prog = false;
+  }
+
   if(HAL_SD_Erase(&uSdHandle, start_addr, end_addr) == HAL_OK)
   {
-    ret = true;
+    ret = sdWaitReady(SD_LOCK_TIMEOUT);
   }
 
+  sdUnlock();
+
   return ret;
 }
 
@@ -166,9 +357,16 @@ bool sdIsBusy(void)
   bool is_busy;
 
 
+  // No CMD13 while the data lines are in use.
+  if (is_done != true)
+  {
+    return true;
+  }
+
   if (HAL_SD_GetCardState(&uSdHandle) == HAL_SD_CARD_TRANSFER )
   {
     is_busy = false;
+    is_prog = false;
   }
   else
   {
@@ -218,26 +416,284 @@ bool sdGetInfo(sd_info_t *p_info)
   return ret;
 }
 
+bool sdIsThread(void)
+{
+#ifdef _USE_HW_RTOS
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED && __get_IPSR() == 0)
+  {
+    return true;
+  }
+#endif
+  return false;
+}
+
+// Threads queue up here. Before the scheduler runs, and from interrupts
+// (usb msc), there is nobody to wait for, so only a transfer already in
+// flight makes it fail.
+//
+bool sdLock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (sdIsThread() == true)
+  {
+    if (osSemaphoreWait(sem_lock, SD_LOCK_TIMEOUT) != osOK)
+    {
+      return false;
+    }
+    return true;
+  }
+#endif
+
+  if (is_done != true || uSdHandle.State != HAL_SD_STATE_READY)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+void sdUnlock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (sdIsThread() == true)
+  {
+    osSemaphoreRelease(sem_lock);
+  }
+#endif
+}
+
+bool sdIsDmaBuffer(uint8_t *p_data)
+{
+  uint32_t addr = (uint32_t)p_data;
+
+
+  if ((addr % SD_DMA_ALIGN) != 0)
+  {
+    return false;
+  }
+  if (addr >= D1_DTCMRAM_BASE && addr < D1_DTCMRAM_BASE + 128*1024)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+bool sdDmaAsync(bool is_read, uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks, void (*func)(bool is_ok, void *arg), void *arg)
+{
+  if (sdIsDmaBuffer(p_data) != true || sdLock() != true)
+  {
+    return false;
+  }
+
+  xfer_func      = func;
+  xfer_arg       = arg;
+  xfer_is_locked = sdIsThread();
+
+  if (sdDmaBegin(is_read, block_addr, p_data, num_of_blocks) != true)
+  {
+    xfer_func = NULL;
+    sdUnlock();
+    return false;
+  }
+
+  if (is_read != true)
+  {
+    is_prog = true;
+  }
+
+  return true;
+}
+
+bool sdDmaBegin(bool is_read, uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks)
+{
+  HAL_StatusTypeDef status;
+
+
+  if (is_prog == true)
+  {
+    if (sdWaitReady(SD_LOCK_TIMEOUT) != true)
+    {
+      return false;
+    }
+    is_prog = false;
+  }
+
+#ifdef _USE_HW_RTOS
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    osSemaphoreWait(sem_done, 0);
+  }
+#endif
+
+  xfer_is_read  = is_read;
+  xfer_p_data   = p_data;
+  xfer_length   = num_of_blocks * SD_BLOCK_SIZE;
+  xfer_begin_us = micros();
+
+  is_err  = false;
+  is_done = false;
+
+  if (SCB->CCR & SCB_CCR_DC_Msk)
+  {
+    if (is_read == true)
+    {
+      SCB_InvalidateDCache_by_Addr((uint32_t *)p_data, xfer_length);
+    }
+    else
+    {
+      SCB_CleanDCache_by_Addr((uint32_t *)p_data, xfer_length);
+    }
+  }
+
+  // More than one block goes out as CMD18/CMD25.
+  if (is_read == true)
+  {
+    status = HAL_SD_ReadBlocks_DMA(&uSdHandle, p_data, block_addr, num_of_blocks);
+  }
+  else
+  {
+    status = HAL_SD_WriteBlocks_DMA(&uSdHandle, p_data, block_addr, num_of_blocks);
+  }
+
+  if (status != HAL_OK)
+  {
+    xfer_func = NULL;
+    is_done   = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool sdDmaWait(uint32_t timeout_ms)
+{
+  uint32_t pre_time;
+
+
+#ifdef _USE_HW_RTOS
+  if (sdIsThread() == true)
+  {
+    if (osSemaphoreWait(sem_done, timeout_ms) != osOK && is_done != true)
+    {
+      HAL_SD_Abort(&uSdHandle);
+      is_done = true;
+      return false;
+    }
+    return !is_err;
+  }
+#endif
+
+  pre_time = millis();
+  while(is_done == false)
+  {
+    if (millis()-pre_time >= timeout_ms)
+    {
+      HAL_SD_Abort(&uSdHandle);
+      is_done = true;
+      return false;
+    }
+  }
+
+  return !is_err;
+}
+
+void sdDmaDone(bool is_ok)
+{
+  void (*func)(bool is_ok, void *arg);
+  uint32_t time_us;
+
+
+  time_us = micros() - xfer_begin_us;
+
+  if (xfer_is_read == true)
+  {
+    if (SCB->CCR & SCB_CCR_DC_Msk)
+    {
+      SCB_InvalidateDCache_by_Addr((uint32_t *)xfer_p_data, xfer_length);
+    }
+    sd_stat.rd_bytes += xfer_length;
+    sd_stat.rd_cnt++;
+    sd_stat.rd_us += time_us;
+  }
+  else
+  {
+    sd_stat.wr_bytes += xfer_length;
+    sd_stat.wr_cnt++;
+    sd_stat.wr_us += time_us;
+  }
+
+  is_err  = !is_ok;
+  is_done = true;
+
+  func = xfer_func;
+  xfer_func = NULL;
+
+  if (func != NULL)
+  {
+#ifdef _USE_HW_RTOS
+    if (xfer_is_locked == true)
+    {
+      osSemaphoreRelease(sem_lock);
+    }
+#endif
+    func(is_ok, xfer_arg);
+  }
+#ifdef _USE_HW_RTOS
+  else if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    osSemaphoreRelease(sem_done);
+  }
+#endif
+}
+
+bool sdWaitReady(uint32_t timeout_ms)
+{
+  uint32_t pre_time;
+
+
+  pre_time = millis();
+  while(HAL_SD_GetCardState(&uSdHandle) != HAL_SD_CARD_TRANSFER)
+  {
+    if (millis()-pre_time >= timeout_ms)
+    {
+      return false;
+    }
+    if (sdIsThread() == true && millis()-pre_time >= 1)
+    {
+      delay(1);
+    }
+  }
+
+  return true;
+}
+
 void HAL_SD_AbortCallback(SD_HandleTypeDef *hsd)
 {
-  printf("sd abort isr\n");
 }
 
 void HAL_SD_TxCpltCallback(SD_HandleTypeDef *hsd)
 {
-  printf("sd tx isr\n");
+  sdDmaDone(true);
 }
 
 void HAL_SD_RxCpltCallback(SD_HandleTypeDef *hsd)
 {
-  printf("sd rx isr\n");
+  sdDmaDone(true);
+}
+
+void HAL_SD_ErrorCallback(SD_HandleTypeDef *hsd)
+{
+  if (is_done != true)
+  {
+    sdDmaDone(false);
+  }
 }
 
 void SDMMC1_IRQHandler(void)
 {
-   HAL_SD_IRQHandler(&uSdHandle);
-   printf("sd isr\n");
- }
+  HAL_SD_IRQHandler(&uSdHandle);
+}
 
 void HAL_SD_MspInit(SD_HandleTypeDef *hsd)
 {
@@ -339,6 +795,58 @@ void sdCmdif(void)
       }
     }
   }
+  else if (cmdifGetParamCnt() >= 1 && cmdifHasString("stat", 0) == true)
+  {
+    if (cmdifGetParamCnt() == 2 && cmdifHasString("clear", 1) == true)
+    {
+      memset(&sd_stat, 0, sizeof(sd_stat));
+    }
+
+    cmdifPrintf("read  : %d KB, %d ops, %d KB/s, %d IOPS\n",
+                sd_stat.rd_bytes/1024, sd_stat.rd_cnt,
+                sd_stat.rd_us > 0 ? (uint32_t)((uint64_t)sd_stat.rd_bytes * 1000 / sd_stat.rd_us) : 0,
+                sd_stat.rd_us > 0 ? (uint32_t)((uint64_t)sd_stat.rd_cnt * 1000000 / sd_stat.rd_us) : 0);
+    cmdifPrintf("write : %d KB, %d ops, %d KB/s, %d IOPS\n",
+                sd_stat.wr_bytes/1024, sd_stat.wr_cnt,
+                sd_stat.wr_us > 0 ? (uint32_t)((uint64_t)sd_stat.wr_bytes * 1000 / sd_stat.wr_us) : 0,
+                sd_stat.wr_us > 0 ? (uint32_t)((uint64_t)sd_stat.wr_cnt * 1000000 / sd_stat.wr_us) : 0);
+  }
+  else if (cmdifGetParamCnt() == 1 && cmdifHasString("bench", 0) == true && is_init == true)
+  {
+    uint32_t pre_time;
+    uint32_t exe_time;
+    uint32_t blocks;
+    uint32_t i;
+
+
+    // Sequential, SD_BOUNCE_BLOCKS per command
+    blocks   = SD_BENCH_MB * 1024 * 1024 / SD_BLOCK_SIZE;
+    pre_time = micros();
+    for (i=0; i<blocks; i+=SD_BOUNCE_BLOCKS)
+    {
+      if (sdReadBlocks(i, sd_bounce_buf, SD_BOUNCE_BLOCKS, 1000) != true)
+      {
+        break;
+      }
+    }
+    exe_time = micros() - pre_time;
+    cmdifPrintf("seq read    : %d KB, %d us, %d KB/s\n", i*SD_BLOCK_SIZE/1024, exe_time,
+                exe_time > 0 ? (uint32_t)((uint64_t)i * SD_BLOCK_SIZE * 1000 / exe_time) : 0);
+
+    // Random, one block per command
+    blocks   = uSdHandle.SdCard.LogBlockNbr;
+    pre_time = micros();
+    for (i=0; i<SD_BENCH_IOPS_CNT; i++)
+    {
+      if (sdReadBlocks(random() % blocks, sd_bounce_buf, 1, 1000) != true)
+      {
+        break;
+      }
+    }
+    exe_time = micros() - pre_time;
+    cmdifPrintf("random read : %d ops, %d us, %d IOPS\n", i, exe_time,
+                exe_time > 0 ? (uint32_t)((uint64_t)i * 1000000 / exe_time) : 0);
+  }
   else
   {
     ret = false;
@@ -347,6 +855,8 @@ void sdCmdif(void)
   if (ret == false)
   {
     cmdifPrintf( "sd info \n");
+    cmdifPrintf( "sd stat [clear]\n");
+    cmdifPrintf( "sd bench \n");
   }
 }
 #endif /* _USE_HW_CMDIF_SD */
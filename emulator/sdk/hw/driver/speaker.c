@@ -109,3 +109,13 @@ void speakerWrite(uint8_t *p_data, uint32_t length)
     speakerPutch(p_data[i]);
   }
 }
+
+bool speakerStartStream(uint32_t hz, uint32_t length, void (*func)(uint16_t *p_buf, uint32_t length))
+{
+  return dacStartStream(hz, length, func);
+}
+
+void speakerStopStream(void)
+{
+  dacStopStream();
+}
@@ -58,6 +58,10 @@ void hwInit(void)
     qspiInit();
     qspiEnableMemoryMappedMode();
   }
+  else if (qspiIsXip() == true)
+  {
+    logPrintf("Booting..XIP \t\t: 0x%X\r\n", (int)&_flash_tag_addr);
+  }
 
   flashInit();
   buttonInit();
@@ -20,10 +20,12 @@
 #define _HW_DEF_RTOS_THREAD_PRI_MAIN          osPriorityNormal
 #define _HW_DEF_RTOS_THREAD_PRI_CMD           osPriorityNormal
 #define _HW_DEF_RTOS_THREAD_PRI_EMUL          osPriorityNormal
+#define _HW_DEF_RTOS_THREAD_PRI_AUDIO         osPriorityHigh
 
 #define _HW_DEF_RTOS_THREAD_MEM_MAIN          _HW_DEF_RTOS_MEM_SIZE(6*1024)
 #define _HW_DEF_RTOS_THREAD_MEM_CMD           _HW_DEF_RTOS_MEM_SIZE(4*1024)
 #define _HW_DEF_RTOS_THREAD_MEM_EMUL          _HW_DEF_RTOS_MEM_SIZE(8*1024)
+#define _HW_DEF_RTOS_THREAD_MEM_AUDIO         _HW_DEF_RTOS_MEM_SIZE(2*1024)
 
 
 
@@ -135,14 +137,19 @@
 #define SDRAM_ADDR_HEAP               0xD1000000    // 16MB
 
 #define SDRAM_ADDR_IMAGE              0xD0000000    // 2MB
-#define SDRAM_ADDR_FW                 0xD0200000    // 2MB
+#define SDRAM_ADDR_FW                 0xD0200000    // 2MB, .sdram_fw when run from QSPI
 #define SDRAM_ADDR_BUF                0xD0400000    // 2MB
 
+#define SRAM_D1_ADDR_START            0x24000000    // 512KB
+#define SRAM_D1_SIZE                  (512*1024)
+
 
 #define QSPI_ADDR_START               0x90000000
 #define QSPI_FW_TAG                   1024
 #define QSPI_FW_SIZE                  (2*1024*1024)
 #define QSPI_FW_ADDR(x)               ((x)*QSPI_FW_SIZE)
+#define QSPI_DATA_ADDR                (32*1024*1024)
+#define QSPI_DATA_SIZE                (32*1024*1024 - 64*1024)  // last 64KB : launcher slot catalog
 
 
 #define _DEF_HW_BTN_LEFT              1
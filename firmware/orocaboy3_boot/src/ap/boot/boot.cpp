@@ -8,6 +8,7 @@
 
 #include "boot.h"
 #include "util.h"
+#include "crc.h"
 
 
 extern const __attribute__((section(".version"))) uint8_t boot_ver[32];
@@ -23,6 +24,48 @@ extern const __attribute__((section(".version"))) uint8_t boot_name[32];
 #define BOOT_CMD_FLASH_VERIFY           0x06
 #define BOOT_CMD_FLASH_READ             0x07
 #define BOOT_CMD_JUMP_TO_FW             0x08
+#define BOOT_CMD_READ_CAPS              0x09
+#define BOOT_CMD_FLASH_BEGIN            0x0A
+#define BOOT_CMD_FLASH_BLOCK            0x0B
+#define BOOT_CMD_FLASH_HASH             0x0C
+
+
+// Windowed download (BOOT_CMD_READ_CAPS/FLASH_BEGIN/FLASH_BLOCK).
+//
+// FLASH_BEGIN gives the whole range but only the first erase step is erased.
+// Each FLASH_BLOCK carries its own address, sequence number and CRC32 and is
+// acked with the sequence number, so the loader can keep several blocks in
+// flight and resend only the ones that failed. The rest of the range is
+// erased one step ahead of the writes, after the ack has gone out, while the
+// next blocks are still coming in.
+//
+#define BOOT_PROTOCOL_VERSION           2           // 2 : BOOT_CMD_FLASH_HASH
+#define BOOT_BLOCK_LENGTH_MAX           (4*1024)
+#define BOOT_BLOCK_HEADER               16
+#define BOOT_WINDOW_MAX                 8
+#define BOOT_ERASE_STEP                 (128*1024)  // largest sector, internal flash
+
+// BOOT_CMD_FLASH_HASH returns one CRC32 per sector, so the loader can send
+// only what changed. It also gives the erase unit, as a changed sector in
+// the internal flash means rewriting the whole 128 KB around it.
+//
+#define BOOT_HASH_SECTOR                (4*1024)
+#define BOOT_HASH_HEADER                8
+#define BOOT_HASH_MAX                   ((CMD_MAX_DATA_LENGTH - 7 - BOOT_HASH_HEADER) / 4)
+#define BOOT_ERASE_UNIT_FLASH           (128*1024)
+#define BOOT_ERASE_UNIT_QSPI            (4*1024)
+
+#define BOOT_CH_VCP                     _DEF_UART2  // the only channel with flow control
+
+
+typedef struct
+{
+  bool     is_begin;
+  uint32_t addr_begin;
+  uint32_t addr_end;
+  uint32_t erase_addr;      // erased up to here
+  uint32_t write_addr;      // end of the highest block written
+} boot_down_t;
 
 
 
@@ -34,7 +77,13 @@ static void bootCmdFlashErase(cmd_t *p_cmd);
 static void bootCmdFlashWrite(cmd_t *p_cmd);
 static void bootCmdFlashRead(cmd_t *p_cmd);
 static void bootCmdJumpToFw(cmd_t *p_cmd);
+static void bootCmdReadCaps(cmd_t *p_cmd);
+static void bootCmdFlashBegin(cmd_t *p_cmd);
+static void bootCmdFlashBlock(cmd_t *p_cmd);
+static void bootCmdFlashHash(cmd_t *p_cmd);
 static bool bootIsFlashRange(uint32_t addr_begin, uint32_t length);
+static bool bootEraseStep(void);
+static bool bootIsWritten(uint32_t addr, uint8_t *p_data, uint32_t length);
 
 
 bool bootCheckFw(void);
@@ -42,6 +91,7 @@ void bootJumpToFw(void);
 
 
 static flash_tag_t  *p_fw_tag = (flash_tag_t *)FLASH_ADDR_TAG;
+static boot_down_t   boot_down;
 
 
 void bootInit(void)
@@ -73,7 +123,6 @@ bool bootVerifyFw(void)
 
 bool bootVerifyCrc(void)
 {
-  uint32_t i;
   uint8_t *p_data;
   uint16_t fw_crc;
 
@@ -85,12 +134,7 @@ bool bootVerifyCrc(void)
 
   p_data = (uint8_t *)p_fw_tag->tag_flash_start;
 
-  fw_crc = 0;
-
-  for (i=0; i<p_fw_tag->tag_flash_length; i++)
-  {
-    utilUpdateCrc(&fw_crc, p_data[i]);
-  }
+  fw_crc = crc16Update(0, p_data, p_fw_tag->tag_flash_length);
 
   if (fw_crc == p_fw_tag->tag_flash_crc)
   {
@@ -235,6 +279,271 @@ void bootCmdJumpToFw(cmd_t *p_cmd)
   }
 }
 
+void bootCmdReadCaps(cmd_t *p_cmd)
+{
+  uint8_t data[12];
+  uint32_t window;
+  uint32_t block_length = BOOT_BLOCK_LENGTH_MAX;
+  uint32_t erase_step   = BOOT_ERASE_STEP;
+
+
+  // Without flow control the uart drops bytes while the flash is busy,
+  // so only one block may be in flight there.
+  if (p_cmd->ch == BOOT_CH_VCP)
+  {
+    window = BOOT_WINDOW_MAX;
+  }
+  else
+  {
+    window = 1;
+  }
+
+  data[0]  = BOOT_PROTOCOL_VERSION;
+  data[1]  = window;
+  data[2]  = 0;
+  data[3]  = 0;
+
+  data[4]  = block_length >> 0;
+  data[5]  = block_length >> 8;
+  data[6]  = block_length >> 16;
+  data[7]  = block_length >> 24;
+
+  data[8]  = erase_step >> 0;
+  data[9]  = erase_step >> 8;
+  data[10] = erase_step >> 16;
+  data[11] = erase_step >> 24;
+
+  cmdSendResp(p_cmd, OK, data, 12);
+}
+
+void bootCmdFlashBegin(cmd_t *p_cmd)
+{
+  uint8_t err_code = OK;
+  uint32_t addr_begin;
+  uint32_t length;
+
+
+  addr_begin  = p_cmd->rx_packet.data[0]<<0;
+  addr_begin |= p_cmd->rx_packet.data[1]<<8;
+  addr_begin |= p_cmd->rx_packet.data[2]<<16;
+  addr_begin |= p_cmd->rx_packet.data[3]<<24;
+
+  length      = p_cmd->rx_packet.data[4]<<0;
+  length     |= p_cmd->rx_packet.data[5]<<8;
+  length     |= p_cmd->rx_packet.data[6]<<16;
+  length     |= p_cmd->rx_packet.data[7]<<24;
+
+
+  boot_down.is_begin = false;
+
+  if (length > 0 && bootIsFlashRange(addr_begin, length) == true)
+  {
+    boot_down.addr_begin = addr_begin;
+    boot_down.addr_end   = addr_begin + length;
+    boot_down.erase_addr = addr_begin;
+    boot_down.write_addr = addr_begin;
+
+    if (bootEraseStep() == true)
+    {
+      boot_down.is_begin = true;
+    }
+    else
+    {
+      err_code = ERR_FLASH_ERASE;
+    }
+  }
+  else
+  {
+    err_code = ERR_FLASH_INVALID_ADDR;
+  }
+
+  cmdSendResp(p_cmd, err_code, NULL, 0);
+}
+
+void bootCmdFlashBlock(cmd_t *p_cmd)
+{
+  uint8_t err_code = OK;
+  uint8_t *p_data = p_cmd->rx_packet.data;
+  uint32_t addr_begin;
+  uint32_t length;
+  uint32_t crc;
+  uint8_t  seq[4];
+
+
+  if (p_cmd->rx_packet.length < BOOT_BLOCK_HEADER)
+  {
+    cmdSendResp(p_cmd, ERR_INVALID_LENGTH, NULL, 0);
+    return;
+  }
+
+  addr_begin  = p_data[0]<<0;
+  addr_begin |= p_data[1]<<8;
+  addr_begin |= p_data[2]<<16;
+  addr_begin |= p_data[3]<<24;
+
+  length      = p_data[4]<<0;
+  length     |= p_data[5]<<8;
+  length     |= p_data[6]<<16;
+  length     |= p_data[7]<<24;
+
+  crc         = p_data[8]<<0;
+  crc        |= p_data[9]<<8;
+  crc        |= p_data[10]<<16;
+  crc        |= p_data[11]<<24;
+
+  seq[0] = p_data[12];
+  seq[1] = p_data[13];
+  seq[2] = p_data[14];
+  seq[3] = p_data[15];
+
+  p_data = &p_data[BOOT_BLOCK_HEADER];
+
+
+  if (boot_down.is_begin != true)
+  {
+    err_code = ERR_INVALID_CMD;
+  }
+  else if (length == 0 || length > BOOT_BLOCK_LENGTH_MAX ||
+           p_cmd->rx_packet.length != BOOT_BLOCK_HEADER + length)
+  {
+    err_code = ERR_INVALID_LENGTH;
+  }
+  else if (addr_begin < boot_down.addr_begin || addr_begin + length > boot_down.addr_end)
+  {
+    err_code = ERR_FLASH_INVALID_ADDR;
+  }
+  else if (crc32Update(0, p_data, length) != crc)
+  {
+    err_code = ERR_FLASH_INVALID_CHECK_SUM;
+  }
+
+  while (err_code == OK && boot_down.erase_addr < addr_begin + length)
+  {
+    if (bootEraseStep() != true)
+    {
+      err_code = ERR_FLASH_ERASE;
+    }
+  }
+
+  // A block below the write pointer may be a resend of one whose ack got
+  // lost. Flash words can not be programmed twice, so skip it if it is there.
+  if (err_code == OK)
+  {
+    if (addr_begin >= boot_down.write_addr || bootIsWritten(addr_begin, p_data, length) != true)
+    {
+      if (flashWrite(addr_begin, p_data, length) == false)
+      {
+        err_code = ERR_FLASH_WRITE;
+      }
+    }
+  }
+
+  if (err_code == OK && addr_begin + length > boot_down.write_addr)
+  {
+    boot_down.write_addr = addr_begin + length;
+  }
+
+  cmdSendResp(p_cmd, err_code, seq, 4);
+
+
+  // Erase ahead while the loader sends the next blocks. The usb endpoint
+  // NAKs meanwhile; on the uart the next block is not sent before the ack,
+  // and the erase above covers it.
+  if (err_code == OK && p_cmd->ch == BOOT_CH_VCP)
+  {
+    if (boot_down.erase_addr < boot_down.addr_end &&
+        boot_down.erase_addr < boot_down.write_addr + BOOT_ERASE_STEP)
+    {
+      bootEraseStep();
+    }
+  }
+}
+
+void bootCmdFlashHash(cmd_t *p_cmd)
+{
+  uint8_t *p_data = p_cmd->tx_packet.data;
+  uint32_t addr_begin;
+  uint32_t length;
+  uint32_t hash_cnt;
+  uint32_t erase_unit;
+  uint32_t index;
+  uint32_t sector_length;
+  uint32_t read_length;
+  uint32_t crc;
+  uint8_t  buf[256];
+
+
+  addr_begin  = p_cmd->rx_packet.data[0]<<0;
+  addr_begin |= p_cmd->rx_packet.data[1]<<8;
+  addr_begin |= p_cmd->rx_packet.data[2]<<16;
+  addr_begin |= p_cmd->rx_packet.data[3]<<24;
+
+  length      = p_cmd->rx_packet.data[4]<<0;
+  length     |= p_cmd->rx_packet.data[5]<<8;
+  length     |= p_cmd->rx_packet.data[6]<<16;
+  length     |= p_cmd->rx_packet.data[7]<<24;
+
+
+  if (length == 0 || bootIsFlashRange(addr_begin, length) != true)
+  {
+    cmdSendResp(p_cmd, ERR_FLASH_INVALID_ADDR, NULL, 0);
+    return;
+  }
+
+  hash_cnt = (length + BOOT_HASH_SECTOR - 1) / BOOT_HASH_SECTOR;
+  if (hash_cnt > BOOT_HASH_MAX)
+  {
+    cmdSendResp(p_cmd, ERR_INVALID_LENGTH, NULL, 0);
+    return;
+  }
+
+  if (addr_begin >= qspiGetAddr() && addr_begin < qspiGetAddr() + qspiGetLength())
+  {
+    erase_unit = BOOT_ERASE_UNIT_QSPI;
+  }
+  else
+  {
+    erase_unit = BOOT_ERASE_UNIT_FLASH;
+  }
+
+
+  // The hashes are built in the tx buffer, cmdSendResp() copies the data
+  // onto itself.
+  p_data[0] = (BOOT_HASH_SECTOR >> 0) & 0xFF;
+  p_data[1] = (BOOT_HASH_SECTOR >> 8) & 0xFF;
+  p_data[2] = 0;
+  p_data[3] = 0;
+  p_data[4] = (erase_unit >> 0) & 0xFF;
+  p_data[5] = (erase_unit >> 8) & 0xFF;
+  p_data[6] = (erase_unit >> 16) & 0xFF;
+  p_data[7] = (erase_unit >> 24) & 0xFF;
+
+  for (uint32_t i=0; i<hash_cnt; i++)
+  {
+    sector_length = constrain(length - i*BOOT_HASH_SECTOR, 0, BOOT_HASH_SECTOR);
+    crc = 0;
+
+    for (index=0; index<sector_length; index+=read_length)
+    {
+      read_length = constrain(sector_length - index, 0, sizeof(buf));
+
+      if (flashRead(addr_begin + i*BOOT_HASH_SECTOR + index, buf, read_length) == false)
+      {
+        cmdSendResp(p_cmd, ERR_FLASH_READ, NULL, 0);
+        return;
+      }
+      crc = crc32Update(crc, buf, read_length);
+    }
+
+    p_data[BOOT_HASH_HEADER + i*4 + 0] = crc >> 0;
+    p_data[BOOT_HASH_HEADER + i*4 + 1] = crc >> 8;
+    p_data[BOOT_HASH_HEADER + i*4 + 2] = crc >> 16;
+    p_data[BOOT_HASH_HEADER + i*4 + 3] = crc >> 24;
+  }
+
+  cmdSendResp(p_cmd, OK, p_data, BOOT_HASH_HEADER + hash_cnt*4);
+}
+
 void bootProcessCmd(cmd_t *p_cmd)
 {
   switch(p_cmd->rx_packet.cmd)
@@ -271,6 +580,22 @@ void bootProcessCmd(cmd_t *p_cmd)
       bootCmdJumpToFw(p_cmd);
       break;
 
+    case BOOT_CMD_READ_CAPS:
+      bootCmdReadCaps(p_cmd);
+      break;
+
+    case BOOT_CMD_FLASH_BEGIN:
+      bootCmdFlashBegin(p_cmd);
+      break;
+
+    case BOOT_CMD_FLASH_BLOCK:
+      bootCmdFlashBlock(p_cmd);
+      break;
+
+    case BOOT_CMD_FLASH_HASH:
+      bootCmdFlashHash(p_cmd);
+      break;
+
 
     default:
       cmdSendResp(p_cmd, ERR_INVALID_CMD, NULL, 0);
@@ -307,3 +632,50 @@ bool bootIsFlashRange(uint32_t addr_begin, uint32_t length)
 
   return ret;
 }
+
+// Erase from erase_addr up to the next BOOT_ERASE_STEP boundary. Sectors are
+// never larger than a step, so no sector is erased twice.
+//
+bool bootEraseStep(void)
+{
+  uint32_t addr_next;
+
+
+  addr_next = (boot_down.erase_addr + BOOT_ERASE_STEP) & ~(BOOT_ERASE_STEP - 1);
+  if (addr_next > boot_down.addr_end)
+  {
+    addr_next = boot_down.addr_end;
+  }
+
+  if (flashErase(boot_down.erase_addr, addr_next - boot_down.erase_addr) == false)
+  {
+    return false;
+  }
+  boot_down.erase_addr = addr_next;
+
+  return true;
+}
+
+bool bootIsWritten(uint32_t addr, uint8_t *p_data, uint32_t length)
+{
+  uint8_t buf[256];
+  uint32_t index;
+  uint32_t read_length;
+
+
+  for (index=0; index<length; index+=read_length)
+  {
+    read_length = constrain(length - index, 0, sizeof(buf));
+
+    if (flashRead(addr + index, buf, read_length) == false)
+    {
+      return false;
+    }
+    if (memcmp(buf, &p_data[index], read_length) != 0)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
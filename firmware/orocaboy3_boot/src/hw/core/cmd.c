@@ -103,7 +103,11 @@ bool cmdReceivePacket(cmd_t *p_cmd)
       p_cmd->rx_packet.length |= (rx_data << 8);
       p_cmd->rx_packet.check_sum ^= rx_data;
 
-      if (p_cmd->rx_packet.length > 0)
+      if (p_cmd->rx_packet.length > CMD_MAX_DATA_LENGTH - 7)
+      {
+        p_cmd->state = CMD_STATE_WAIT_STX;
+      }
+      else if (p_cmd->rx_packet.length > 0)
       {
         p_cmd->index = 0;
         p_cmd->state = CMD_STATE_WAIT_DATA;
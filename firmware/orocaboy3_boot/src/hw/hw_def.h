@@ -70,7 +70,7 @@
 #define      HW_CMDIF_CMD_BUF_LENGTH        128
 
 #define _USE_HW_CMD
-#define      HW_CMD_MAX_DATA_LENGTH         2048
+#define      HW_CMD_MAX_DATA_LENGTH         (4*1024 + 64)   // a BOOT_CMD_FLASH_BLOCK packet
 
 
 #define FLASH_ADDR_TAG                0x08040000
@@ -19,6 +19,7 @@ public:
     virtual void handleKeyEvent(uint8_t key);
 
     void processKey(void);
+    void loadSlotInfo(void);
     void updateSlotInfo(void);
 protected:
 
@@ -26,6 +27,7 @@ private:
 
     uint32_t prev_key;
     uint32_t key_repeat;
+    uint32_t slot_cat_ver;
 
 
 };
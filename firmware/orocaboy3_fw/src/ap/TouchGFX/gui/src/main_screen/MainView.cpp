@@ -39,23 +39,11 @@ void MainView::setupScreen()
   textArea_slot_title.setWidth(320);
   textArea_slot_title_1.setWidth(320);
 
-  flash_tag_t tag;
-
-
-  for (int i=0; i<16; i++)
-  {
-    if (slotGetTag(i, &tag) == true)
-    {
-      slot_info[i].is_empty = false;
-      Unicode::fromUTF8((const uint8_t*)tag.name_str, slot_info[i].name_str, 32);
-      Unicode::fromUTF8((const uint8_t*)tag.version_str, slot_info[i].ver_str, 32);
-    }
-    else
-    {
-      slot_info[i].is_empty = true;
-    }
-  }
-
+#ifndef SIMULATOR
+  slotCatalogRefresh();
+  slot_cat_ver = slotCatalogGetVersion();
+#endif
+  loadSlotInfo();
   updateSlotInfo();
 
   prev_key = 0;
@@ -165,6 +153,14 @@ void MainView::handleTickEvent(void)
     textArea_volume.invalidate();
   }
 
+  // The slot thread found a change on the card or in flash.
+  if (slot_cat_ver != slotCatalogGetVersion())
+  {
+    slot_cat_ver = slotCatalogGetVersion();
+    loadSlotInfo();
+    updateSlotInfo();
+  }
+
   int slot_index = swipeContainer_emulator.currentPage;
 
   if (slot_info[slot_index].is_empty != true)
@@ -184,6 +180,26 @@ void MainView::handleTickEvent(void)
 #endif
 }
 
+void MainView::loadSlotInfo(void)
+{
+  flash_tag_t tag;
+
+
+  for (int i=0; i<16; i++)
+  {
+    if (slotGetTag(i, &tag) == true)
+    {
+      slot_info[i].is_empty = false;
+      Unicode::fromUTF8((const uint8_t*)tag.name_str, slot_info[i].name_str, 32);
+      Unicode::fromUTF8((const uint8_t*)tag.version_str, slot_info[i].ver_str, 32);
+    }
+    else
+    {
+      slot_info[i].is_empty = true;
+    }
+  }
+}
+
 void MainView::updateSlotInfo(void)
 {
   for (int slot_index=0; slot_index<swipeContainer_emulator.getNumberOfPages(); slot_index++)
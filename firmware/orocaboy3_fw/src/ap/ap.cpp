@@ -38,9 +38,13 @@ void apMain(void)
       //logPrintf("joyt %d %d\n", joypadGetX(), joypadGetY());
     }
 
-    esp32Update();
     batteryUpdate();
     joypadUpdate();
     osdUpdate();
+
+    // The slot and qspi threads run below this one, give them the rest
+    // of the tick.
+    //
+    delay(1);
   }
 }
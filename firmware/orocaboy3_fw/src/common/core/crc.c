@@ -0,0 +1,232 @@
+/*
+ * crc.c
+ *
+ *  CRC16 and CRC32, see crc.h.
+ */
+#include "def.h"
+#include "crc.h"
+
+
+
+
+#define CRC16_POLY          0x8005
+#define CRC32_POLY          0xEDB88320    // 0x04C11DB7 reflected
+
+#define CRC_TEST_LENGTH     1031
+
+
+// The tables are built in RAM on first use. [k][x] is the CRC of byte x
+// followed by k zero bytes, so 8 bytes are folded in with one lookup each.
+//
+static volatile bool is_init = false;
+static uint16_t crc16_tbl[8][256];
+static uint32_t crc32_tbl[8][256];
+
+
+typedef struct
+{
+  uint32_t length;
+  uint16_t crc16;
+  uint32_t crc32;
+} crc_vector_t;
+
+// CRC_TEST_LENGTH bytes of crcTestData(), cut at these lengths.
+//
+static const crc_vector_t crc_vector_tbl[] =
+{
+  {    0, 0x0000, 0x00000000},
+  {    1, 0x0294, 0xA0058808},
+  {    7, 0xA7AE, 0xA6AB295D},
+  {    8, 0xAFC8, 0xED114279},
+  {   63, 0x4A6E, 0x08360A34},
+  { 1024, 0x1751, 0x6A191F4E},
+  { 1031, 0x5831, 0x2C6E8ED4},
+};
+
+
+static void crcInitTable(void)
+{
+  uint32_t i;
+  uint32_t k;
+  uint32_t crc;
+
+
+  for (i=0; i<256; i++)
+  {
+    crc = i << 8;
+    for (k=0; k<8; k++)
+    {
+      crc = (crc & 0x8000) ? (crc << 1) ^ CRC16_POLY : (crc << 1);
+    }
+    crc16_tbl[0][i] = crc;
+
+    crc = i;
+    for (k=0; k<8; k++)
+    {
+      crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLY : (crc >> 1);
+    }
+    crc32_tbl[0][i] = crc;
+  }
+
+  for (k=1; k<8; k++)
+  {
+    for (i=0; i<256; i++)
+    {
+      crc16_tbl[k][i] = (crc16_tbl[k-1][i] << 8) ^ crc16_tbl[0][crc16_tbl[k-1][i] >> 8];
+      crc32_tbl[k][i] = (crc32_tbl[k-1][i] >> 8) ^ crc32_tbl[0][crc32_tbl[k-1][i] & 0xFF];
+    }
+  }
+
+  is_init = true;
+}
+
+uint16_t crc16Update(uint16_t crc, const uint8_t *p_data, uint32_t length)
+{
+  if (is_init != true)
+  {
+    crcInitTable();
+  }
+
+  while (length >= 8)
+  {
+    crc = crc16_tbl[7][p_data[0] ^ (crc >> 8)] ^
+          crc16_tbl[6][p_data[1] ^ (crc & 0xFF)] ^
+          crc16_tbl[5][p_data[2]] ^
+          crc16_tbl[4][p_data[3]] ^
+          crc16_tbl[3][p_data[4]] ^
+          crc16_tbl[2][p_data[5]] ^
+          crc16_tbl[1][p_data[6]] ^
+          crc16_tbl[0][p_data[7]];
+
+    p_data += 8;
+    length -= 8;
+  }
+
+  while (length--)
+  {
+    crc = (crc << 8) ^ crc16_tbl[0][(crc >> 8) ^ *p_data++];
+  }
+
+  return crc;
+}
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *p_data, uint32_t length)
+{
+  if (is_init != true)
+  {
+    crcInitTable();
+  }
+
+  crc = ~crc;
+
+  while (length >= 8)
+  {
+    crc ^= (uint32_t)p_data[0] | (uint32_t)p_data[1]<<8 | (uint32_t)p_data[2]<<16 | (uint32_t)p_data[3]<<24;
+
+    crc = crc32_tbl[7][(crc >>  0) & 0xFF] ^
+          crc32_tbl[6][(crc >>  8) & 0xFF] ^
+          crc32_tbl[5][(crc >> 16) & 0xFF] ^
+          crc32_tbl[4][(crc >> 24) & 0xFF] ^
+          crc32_tbl[3][p_data[4]] ^
+          crc32_tbl[2][p_data[5]] ^
+          crc32_tbl[1][p_data[6]] ^
+          crc32_tbl[0][p_data[7]];
+
+    p_data += 8;
+    length -= 8;
+  }
+
+  while (length--)
+  {
+    crc = (crc >> 8) ^ crc32_tbl[0][(crc ^ *p_data++) & 0xFF];
+  }
+
+  return ~crc;
+}
+
+static void crcTestData(uint8_t *p_data, uint32_t length)
+{
+  uint32_t i;
+  uint32_t seed = 1;
+
+
+  for (i=0; i<length; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    p_data[i] = seed >> 16;
+  }
+}
+
+// Check against the standard check values, the fixed vectors above and a
+// bit by bit reference, for every alignment and for chunked updates.
+//
+bool crcTest(void)
+{
+  uint8_t  p_buf[CRC_TEST_LENGTH];
+  uint32_t i;
+  uint32_t j;
+  uint32_t k;
+  uint16_t crc16;
+  uint32_t crc32;
+  uint16_t ref16;
+  uint32_t ref32;
+  bool ret = true;
+
+
+  if (crc16Update(0, (const uint8_t *)"123456789", 9) != 0xFEE8 ||
+      crc32Update(0, (const uint8_t *)"123456789", 9) != 0xCBF43926)
+  {
+    return false;
+  }
+
+  crcTestData(p_buf, CRC_TEST_LENGTH);
+
+  for (i=0; i<sizeof(crc_vector_tbl)/sizeof(crc_vector_t); i++)
+  {
+    if (crc16Update(0, p_buf, crc_vector_tbl[i].length) != crc_vector_tbl[i].crc16 ||
+        crc32Update(0, p_buf, crc_vector_tbl[i].length) != crc_vector_tbl[i].crc32)
+    {
+      ret = false;
+    }
+  }
+
+  for (i=0; i<8 && ret == true; i++)
+  {
+    ref16 = 0;
+    ref32 = 0xFFFFFFFF;
+
+    for (j=0; j<64; j++)
+    {
+      crc16 = crc16Update(0, &p_buf[i], j);
+      crc32 = crc32Update(0, &p_buf[i], j);
+
+      if (crc16 != ref16 || crc32 != ~ref32)
+      {
+        ret = false;
+        break;
+      }
+
+      ref16 ^= p_buf[i + j] << 8;
+      ref32 ^= p_buf[i + j];
+      for (k=0; k<8; k++)
+      {
+        ref16 = (ref16 & 0x8000) ? (ref16 << 1) ^ CRC16_POLY : (ref16 << 1);
+        ref32 = (ref32 & 1) ? (ref32 >> 1) ^ CRC32_POLY : (ref32 >> 1);
+      }
+    }
+  }
+
+  for (i=1; i<CRC_TEST_LENGTH && ret == true; i+=97)
+  {
+    crc16 = crc16Update(crc16Update(0, p_buf, i), &p_buf[i], CRC_TEST_LENGTH - i);
+    crc32 = crc32Update(crc32Update(0, p_buf, i), &p_buf[i], CRC_TEST_LENGTH - i);
+
+    if (crc16 != crc16Update(0, p_buf, CRC_TEST_LENGTH) ||
+        crc32 != crc32Update(0, p_buf, CRC_TEST_LENGTH))
+    {
+      ret = false;
+    }
+  }
+
+  return ret;
+}
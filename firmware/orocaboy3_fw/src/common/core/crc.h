@@ -0,0 +1,40 @@
+/*
+ * crc.h
+ *
+ *  CRC16 and CRC32 used for firmware images, table driven slice-by-8.
+ *
+ *  CRC16 : poly 0x8005, init 0, MSB first, no final xor (tag_flash_crc).
+ *  CRC32 : IEEE 802.3, same as zlib crc32().
+ *
+ *  Both are streamed : start with crc = 0 and pass the previous result
+ *  back in to continue over several buffers. The same file is built for
+ *  the firmware, the boot and the PC loader, so the results are bit
+ *  identical everywhere; crcTest() checks them against fixed vectors.
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+#include "def.h"
+
+
+uint16_t crc16Update(uint16_t crc, const uint8_t *p_data, uint32_t length);
+uint32_t crc32Update(uint32_t crc, const uint8_t *p_data, uint32_t length);
+
+bool     crcTest(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+#endif /* CRC_H_ */
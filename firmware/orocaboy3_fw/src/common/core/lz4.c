@@ -0,0 +1,325 @@
+/*
+ * lz4.c
+ *
+ *  LZ4 block compressor and decompressor, see lz4.h.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "def.h"
+#include "lz4.h"
+
+
+
+
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5       // a block always ends with this many literals
+#define LZ4_MF_LIMIT        12      // no match starts this close to the end
+#define LZ4_MAX_OFFSET      65535
+#define LZ4_HASH_LOG        12
+
+
+static inline uint32_t lz4Read32(const uint8_t *p_data)
+{
+  return (uint32_t)p_data[0] | (uint32_t)p_data[1]<<8 | (uint32_t)p_data[2]<<16 | (uint32_t)p_data[3]<<24;
+}
+
+static inline uint32_t lz4Hash(uint32_t data)
+{
+  return (data * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static bool lz4PutLength(uint8_t *p_dst, uint32_t dst_len, uint32_t *p_op, uint32_t length)
+{
+  while (length >= 255)
+  {
+    if (*p_op >= dst_len) return false;
+    p_dst[(*p_op)++] = 255;
+    length -= 255;
+  }
+  if (*p_op >= dst_len) return false;
+  p_dst[(*p_op)++] = length;
+
+  return true;
+}
+
+static bool lz4PutSequence(uint8_t *p_dst, uint32_t dst_len, uint32_t *p_op,
+                           const uint8_t *p_lit, uint32_t lit_len,
+                           uint32_t offset, uint32_t match_len)
+{
+  uint8_t *p_token;
+  uint32_t op = *p_op;
+
+
+  if (op >= dst_len) return false;
+  p_token  = &p_dst[op++];
+  *p_token = (lit_len >= 15 ? 15 : lit_len) << 4;
+
+  if (lit_len >= 15 && lz4PutLength(p_dst, dst_len, &op, lit_len - 15) != true) return false;
+
+  if (op + lit_len > dst_len) return false;
+  memcpy(&p_dst[op], p_lit, lit_len);
+  op += lit_len;
+
+  // The last sequence has literals only.
+  if (match_len > 0)
+  {
+    if (op + 2 > dst_len) return false;
+    p_dst[op++] = offset >> 0;
+    p_dst[op++] = offset >> 8;
+
+    match_len -= LZ4_MIN_MATCH;
+    *p_token |= match_len >= 15 ? 15 : match_len;
+
+    if (match_len >= 15 && lz4PutLength(p_dst, dst_len, &op, match_len - 15) != true) return false;
+  }
+
+  *p_op = op;
+
+  return true;
+}
+
+// Greedy single probe compressor. Returns the compressed length, or -1 if
+// p_dst is too small (LZ4_BOUND(src_len) is always enough).
+//
+int32_t lz4CompressBlock(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len)
+{
+  uint32_t *table;
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  uint32_t anchor = 0;
+  uint32_t ref;
+  uint32_t len;
+  uint32_t h;
+
+
+  table = (uint32_t *)calloc(1<<LZ4_HASH_LOG, sizeof(uint32_t));
+  if (table == NULL)
+  {
+    return -1;
+  }
+
+  if (src_len > LZ4_MF_LIMIT)
+  {
+    ip = 1;
+
+    while (ip < src_len - LZ4_MF_LIMIT)
+    {
+      h   = lz4Hash(lz4Read32(&p_src[ip]));
+      ref = table[h];
+      table[h] = ip;
+
+      if (ip - ref > LZ4_MAX_OFFSET || lz4Read32(&p_src[ref]) != lz4Read32(&p_src[ip]))
+      {
+        ip++;
+        continue;
+      }
+
+      len = LZ4_MIN_MATCH;
+      while (ip + len < src_len - LZ4_LAST_LITERALS && p_src[ref + len] == p_src[ip + len])
+      {
+        len++;
+      }
+
+      if (lz4PutSequence(p_dst, dst_len, &op, &p_src[anchor], ip - anchor, ip - ref, len) != true)
+      {
+        free(table);
+        return -1;
+      }
+
+      ip    += len;
+      anchor = ip;
+    }
+  }
+
+  if (lz4PutSequence(p_dst, dst_len, &op, &p_src[anchor], src_len - anchor, 0, 0) != true)
+  {
+    op = -1;
+  }
+
+  free(table);
+
+  return op;
+}
+
+// Returns the decompressed length, or -1 if the data is broken or does not
+// fit in dst_len bytes.
+//
+int32_t lz4DecompressBlock(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len)
+{
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  uint32_t token;
+  uint32_t len;
+  uint32_t offset;
+  uint8_t  data;
+  uint8_t *p_match;
+
+
+  while (ip < src_len)
+  {
+    token = p_src[ip++];
+
+    len = token >> 4;
+    if (len == 15)
+    {
+      do
+      {
+        if (ip >= src_len) return -1;
+        data = p_src[ip++];
+        len += data;
+      } while (data == 255);
+    }
+
+    if (len > src_len - ip || len > dst_len - op) return -1;
+    memcpy(&p_dst[op], &p_src[ip], len);
+    ip += len;
+    op += len;
+
+    if (ip >= src_len)
+    {
+      break;
+    }
+
+    if (src_len - ip < 2) return -1;
+    offset = p_src[ip] | p_src[ip+1]<<8;
+    ip += 2;
+    if (offset == 0 || offset > op) return -1;
+
+    len = token & 0x0F;
+    if (len == 15)
+    {
+      do
+      {
+        if (ip >= src_len) return -1;
+        data = p_src[ip++];
+        len += data;
+      } while (data == 255);
+    }
+    len += LZ4_MIN_MATCH;
+
+    if (len > dst_len - op) return -1;
+
+    p_match = &p_dst[op - offset];
+    if (offset >= len)
+    {
+      memcpy(&p_dst[op], p_match, len);
+      op += len;
+    }
+    else
+    {
+      while (len--)
+      {
+        p_dst[op++] = *p_match++;
+      }
+    }
+  }
+
+  return op;
+}
+
+// Split p_src into blocks. A block that does not get smaller is stored raw.
+// Returns the stream length, or -1 if p_dst is too small
+// (LZ4_STREAM_BOUND(src_len) is always enough).
+//
+int32_t lz4CompressStream(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len)
+{
+  uint8_t *p_buf;
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  uint32_t length;
+  uint32_t header;
+  int32_t  comp_len;
+
+
+  p_buf = (uint8_t *)malloc(LZ4_BOUND(LZ4_BLOCK_SIZE));
+  if (p_buf == NULL)
+  {
+    return -1;
+  }
+
+  while (ip < src_len)
+  {
+    length = src_len - ip;
+    if (length > LZ4_BLOCK_SIZE)
+    {
+      length = LZ4_BLOCK_SIZE;
+    }
+
+    comp_len = lz4CompressBlock(&p_src[ip], length, p_buf, LZ4_BOUND(LZ4_BLOCK_SIZE));
+
+    if (comp_len < 0 || (uint32_t)comp_len >= length)
+    {
+      header = length | LZ4_BLOCK_RAW;
+      comp_len = length;
+    }
+    else
+    {
+      header = comp_len;
+    }
+
+    if (op + LZ4_BLOCK_HEADER + comp_len > dst_len)
+    {
+      free(p_buf);
+      return -1;
+    }
+
+    p_dst[op++] = header >> 0;
+    p_dst[op++] = header >> 8;
+    p_dst[op++] = header >> 16;
+    p_dst[op++] = header >> 24;
+    memcpy(&p_dst[op], (header & LZ4_BLOCK_RAW) ? &p_src[ip] : p_buf, comp_len);
+
+    op += comp_len;
+    ip += length;
+  }
+
+  free(p_buf);
+
+  return op;
+}
+
+int32_t lz4DecompressStream(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len)
+{
+  uint32_t ip = 0;
+  uint32_t op = 0;
+  uint32_t header;
+  uint32_t length;
+  uint32_t out_len;
+
+
+  while (ip < src_len)
+  {
+    if (src_len - ip < LZ4_BLOCK_HEADER) return -1;
+
+    header = lz4Read32(&p_src[ip]);
+    length = header & ~LZ4_BLOCK_RAW;
+    ip += LZ4_BLOCK_HEADER;
+
+    if (length > src_len - ip) return -1;
+
+    out_len = dst_len - op;
+    if (out_len > LZ4_BLOCK_SIZE)
+    {
+      out_len = LZ4_BLOCK_SIZE;
+    }
+
+    if (header & LZ4_BLOCK_RAW)
+    {
+      if (length > out_len) return -1;
+      memcpy(&p_dst[op], &p_src[ip], length);
+      op += length;
+    }
+    else
+    {
+      int32_t ret;
+
+      ret = lz4DecompressBlock(&p_src[ip], length, &p_dst[op], out_len);
+      if (ret < 0) return -1;
+      op += ret;
+    }
+    ip += length;
+  }
+
+  return op;
+}
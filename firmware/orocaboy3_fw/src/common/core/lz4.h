@@ -0,0 +1,60 @@
+/*
+ * lz4.h
+ *
+ *  LZ4 block format, used for compressed firmware slot images.
+ *
+ *  The stream is our own wrapper around raw LZ4 blocks, not the LZ4 frame
+ *  format : no magic number, frame descriptor, content size or checksums,
+ *  so lz4 command line tools can't read it. The image CRC in the tag
+ *  covers the decoded data instead.
+ *
+ *  The source is cut into blocks of LZ4_BLOCK_SIZE bytes, the last one
+ *  holds what is left. Each block is stored as
+ *
+ *    offset 0 : uint32_t header, little endian
+ *               bit 31    LZ4_BLOCK_RAW, the data is the block as is
+ *               bit 30..0 bytes of data that follow
+ *    offset 4 : data, LZ4 sequences or the raw block
+ *
+ *  and the next block starts right after the data, without padding. A
+ *  block that does not get smaller is stored raw. The decoded size of a
+ *  block is LZ4_BLOCK_SIZE or, for the last one, what is left of the
+ *  image, so it isn't stored. Blocks don't refer to each other and each
+ *  one can be decoded as soon as it has been read.
+ */
+
+#ifndef LZ4_H_
+#define LZ4_H_
+
+
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+#include "def.h"
+
+
+#define LZ4_BLOCK_SIZE          (64*1024)
+#define LZ4_BLOCK_HEADER        4
+#define LZ4_BLOCK_RAW           0x80000000
+
+#define LZ4_BOUND(length)       ((length) + (length)/255 + 16)
+#define LZ4_STREAM_BOUND(length) ((length) + ((length)/LZ4_BLOCK_SIZE + 1) * LZ4_BLOCK_HEADER)
+
+
+int32_t lz4CompressBlock(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len);
+int32_t lz4DecompressBlock(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len);
+
+int32_t lz4CompressStream(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len);
+int32_t lz4DecompressStream(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+
+#endif /* LZ4_H_ */
@@ -0,0 +1,38 @@
+/*
+ * checksum.h
+ *
+ *  CRC16/CRC32 with the H7 CRC unit, same results as crc.h.
+ */
+
+#ifndef SRC_COMMON_HW_INCLUDE_CHECKSUM_H_
+#define SRC_COMMON_HW_INCLUDE_CHECKSUM_H_
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include "hw_def.h"
+
+#ifdef _USE_HW_CHECKSUM
+
+#include "crc.h"
+
+
+// Same results as crc16Update()/crc32Update(), computed by the CRC unit
+// when it is free.
+//
+bool     checksumInit(void);
+uint16_t checksumCrc16(uint16_t crc, const uint8_t *p_data, uint32_t length);
+uint32_t checksumCrc32(uint32_t crc, const uint8_t *p_data, uint32_t length);
+
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* SRC_COMMON_HW_INCLUDE_CHECKSUM_H_ */
@@ -29,6 +29,36 @@ typedef struct {
 } qspi_info_t;
 
 
+#define QSPI_JOB_ERASE      0
+#define QSPI_JOB_WRITE      1
+
+#define QSPI_JOB_WAIT       0
+#define QSPI_JOB_RUN        1
+#define QSPI_JOB_OK         2
+#define QSPI_JOB_ERR        3
+
+// Erase and program requests for the qspi thread. The caller owns the
+// job and keeps it until is_done, func is called from the qspi thread
+// after each block and once more when the job ends.
+//
+typedef struct qspi_job_t qspi_job_t;
+
+struct qspi_job_t
+{
+  uint8_t  type;
+  uint32_t addr;
+  uint8_t  *p_data;
+  uint32_t length;
+
+  void (*func)(qspi_job_t *p_job);
+  void *arg;
+
+  volatile uint32_t done;       // bytes erased or programmed
+  volatile uint8_t  state;
+  volatile bool     is_done;
+};
+
+
 bool qspiInit(void);
 bool qspiIsInit(void);
 
@@ -40,6 +70,13 @@ bool qspiEraseChip(void);
 bool qspiGetStatus(void);
 bool qspiGetInfo(qspi_info_t* p_info);
 bool qspiEnableMemoryMappedMode(void);
+bool qspiMapBegin(void);
+void qspiMapEnd(void);
+
+bool qspiJobErase(qspi_job_t *p_job, uint32_t addr, uint32_t length, void (*func)(qspi_job_t *p_job), void *arg);
+bool qspiJobWrite(qspi_job_t *p_job, uint32_t addr, uint8_t *p_data, uint32_t length, void (*func)(qspi_job_t *p_job), void *arg);
+bool qspiJobIsDone(qspi_job_t *p_job);
+bool qspiJobWait(qspi_job_t *p_job, uint32_t timeout_ms);
 
 uint32_t qspiGetAddr(void);
 uint32_t qspiGetLength(void);
@@ -31,6 +31,8 @@ bool slotRunFromFolder(uint8_t slot_index);
 bool slotGetTag(uint8_t slot_index, flash_tag_t *p_tag);
 bool slotGetTagFromFolder(uint8_t slot_index, flash_tag_t *p_tag);
 bool slotGetTagFromFlash(uint8_t slot_index, flash_tag_t *p_tag);
+bool slotCatalogRefresh(void);
+uint32_t slotCatalogGetVersion(void);
 void slotJumpToFw(uint32_t addr);
 
 
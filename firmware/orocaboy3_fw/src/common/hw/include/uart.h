@@ -32,6 +32,10 @@ void     uartPutch(uint8_t channel, uint8_t ch);
 uint8_t  uartGetch(uint8_t channel);
 int32_t  uartWrite(uint8_t channel, uint8_t *p_data, uint32_t length);
 uint8_t  uartRead(uint8_t channel);
+uint32_t uartReadSpan(uint8_t channel, uint8_t **pp_data);
+void     uartReadSkip(uint8_t channel, uint32_t length);
+bool     uartWriteDma(uint8_t channel, uint8_t *p_data, uint32_t length);
+bool     uartIsTxBusy(uint8_t channel);
 int32_t  uartPrintf(uint8_t channel, const char *fmt, ...);
 bool     uartSendBreak(uint8_t channel);
 void     uartSetTxDoneISR(uint8_t channel, void (*func)(void));
@@ -0,0 +1,490 @@
+/*
+ * checksum.c
+ *
+ *  CRC16/CRC32 on the H7 CRC unit, see checksum.h.
+ */
+
+
+
+
+#include "checksum.h"
+
+
+#ifdef _USE_HW_CHECKSUM
+#include "micros.h"
+#include "cmdif.h"
+
+
+#define CHECKSUM_CRC16          0
+#define CHECKSUM_CRC32          1
+
+#define CHECKSUM_MODE_AUTO      0
+#define CHECKSUM_MODE_SW        1
+#define CHECKSUM_MODE_CPU       2
+#define CHECKSUM_MODE_DMA       3
+
+#define CHECKSUM_DMA_MIN        (16*1024)
+#define CHECKSUM_DMA_WORDS      0xFFFF
+#define CHECKSUM_DMA_TIMEOUT    100
+
+#define CHECKSUM_DMA_WAIT       0
+#define CHECKSUM_DMA_OK         1
+#define CHECKSUM_DMA_ERR        2
+
+#define ITCM_SIZE               (64*1024)
+#define DTCM_SIZE               (128*1024)
+
+
+static bool checksumRun(uint8_t type, uint32_t *p_crc, const uint8_t *p_data, uint32_t length, uint8_t mode);
+static bool checksumRunHw(uint8_t type, uint32_t *p_crc, const uint8_t *p_data, uint32_t length, bool use_dma);
+static bool checksumRunDma(const uint8_t *p_data, uint32_t length, uint32_t *p_done);
+static bool checksumIsThread(void);
+static bool checksumLock(void);
+static void checksumUnlock(void);
+
+#if HW_USE_CMDIF_CHECKSUM == 1
+static void checksumCmdif(void);
+#endif
+
+
+static CRC_HandleTypeDef hcrc;
+static DMA_HandleTypeDef hdma_crc;
+static bool is_init = false;
+static volatile bool is_hw_busy = false;
+
+#ifdef _USE_HW_RTOS
+static osMutexId     checksum_lock;
+static osSemaphoreId sem_dma;
+static volatile uint8_t dma_state = CHECKSUM_DMA_OK;
+
+static void checksumDmaCplt(DMA_HandleTypeDef *hdma);
+static void checksumDmaError(DMA_HandleTypeDef *hdma);
+#endif
+
+
+
+
+bool checksumInit(void)
+{
+  __HAL_RCC_CRC_CLK_ENABLE();
+
+  hcrc.Instance                     = CRC;
+  hcrc.Init.DefaultPolynomialUse    = DEFAULT_POLYNOMIAL_DISABLE;
+  hcrc.Init.DefaultInitValueUse     = DEFAULT_INIT_VALUE_DISABLE;
+  hcrc.Init.GeneratingPolynomial    = 0x8005;
+  hcrc.Init.CRCLength               = CRC_POLYLENGTH_16B;
+  hcrc.Init.InitValue               = 0;
+  hcrc.Init.InputDataInversionMode  = CRC_INPUTDATA_INVERSION_NONE;
+  hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_DISABLE;
+  hcrc.InputDataFormat              = CRC_INPUTDATA_FORMAT_BYTES;
+
+  if (HAL_CRC_Init(&hcrc) == HAL_OK)
+  {
+    is_init = true;
+  }
+
+#ifdef _USE_HW_RTOS
+  if (checksum_lock == NULL)
+  {
+    osMutexDef(checksum_lock);
+    osSemaphoreDef(sem_dma);
+    checksum_lock = osMutexCreate(osMutex(checksum_lock));
+    sem_dma       = osSemaphoreCreate(osSemaphore(sem_dma), 1);
+  }
+
+  // memory to memory : the source is on the peripheral port. Words are read
+  // and written to DR a byte at a time by the FIFO, in memory order.
+  //
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  hdma_crc.Instance                 = DMA2_Stream0;
+  hdma_crc.Init.Request             = DMA_REQUEST_MEM2MEM;
+  hdma_crc.Init.Direction           = DMA_MEMORY_TO_MEMORY;
+  hdma_crc.Init.PeriphInc           = DMA_PINC_ENABLE;
+  hdma_crc.Init.MemInc              = DMA_MINC_DISABLE;
+  hdma_crc.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+  hdma_crc.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+  hdma_crc.Init.Mode                = DMA_NORMAL;
+  hdma_crc.Init.Priority            = DMA_PRIORITY_LOW;
+  hdma_crc.Init.FIFOMode            = DMA_FIFOMODE_ENABLE;
+  hdma_crc.Init.FIFOThreshold       = DMA_FIFO_THRESHOLD_FULL;
+  hdma_crc.Init.MemBurst            = DMA_MBURST_SINGLE;
+  hdma_crc.Init.PeriphBurst         = DMA_PBURST_SINGLE;
+
+  if (HAL_DMA_Init(&hdma_crc) == HAL_OK)
+  {
+    hdma_crc.XferCpltCallback  = checksumDmaCplt;
+    hdma_crc.XferErrorCallback = checksumDmaError;
+
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+  }
+#endif
+
+#if HW_USE_CMDIF_CHECKSUM == 1
+  cmdifAdd("checksum", checksumCmdif);
+#endif
+
+  return is_init;
+}
+
+uint16_t checksumCrc16(uint16_t crc, const uint8_t *p_data, uint32_t length)
+{
+  uint32_t value = crc;
+
+  checksumRun(CHECKSUM_CRC16, &value, p_data, length, CHECKSUM_MODE_AUTO);
+
+  return value;
+}
+
+uint32_t checksumCrc32(uint32_t crc, const uint8_t *p_data, uint32_t length)
+{
+  uint32_t value = crc;
+
+  checksumRun(CHECKSUM_CRC32, &value, p_data, length, CHECKSUM_MODE_AUTO);
+
+  return value;
+}
+
+// The CRC unit is used when nobody else has it, with the DMA for large
+// regions it can reach from a thread. Anything else, or a failed DMA,
+// is done in software.
+//
+bool checksumRun(uint8_t type, uint32_t *p_crc, const uint8_t *p_data, uint32_t length, uint8_t mode)
+{
+  bool ret = false;
+  bool use_dma = false;
+  uint32_t addr = (uint32_t)p_data;
+
+
+  if (mode == CHECKSUM_MODE_AUTO || mode == CHECKSUM_MODE_DMA)
+  {
+    use_dma = true;
+
+    if (mode == CHECKSUM_MODE_AUTO && length < CHECKSUM_DMA_MIN)
+    {
+      use_dma = false;
+    }
+    if (checksumIsThread() != true)
+    {
+      use_dma = false;
+    }
+    // DMA2 can not reach the TCMs.
+    if (addr < D1_ITCMRAM_BASE + ITCM_SIZE)
+    {
+      use_dma = false;
+    }
+    if (addr + length > D1_DTCMRAM_BASE && addr < D1_DTCMRAM_BASE + DTCM_SIZE)
+    {
+      use_dma = false;
+    }
+  }
+
+  if (mode != CHECKSUM_MODE_SW && is_init == true && checksumLock() == true)
+  {
+    ret = checksumRunHw(type, p_crc, p_data, length, use_dma);
+    checksumUnlock();
+  }
+
+  if (ret != true)
+  {
+    if (type == CHECKSUM_CRC16)
+    {
+      *p_crc = crc16Update(*p_crc, p_data, length);
+    }
+    else
+    {
+      *p_crc = crc32Update(*p_crc, p_data, length);
+    }
+  }
+
+  return ret;
+}
+
+// The running value is loaded into INIT, so a stream can be continued from
+// any earlier result. For the reflected CRC32 the unit works on the bit
+// reversed register.
+//
+bool checksumRunHw(uint8_t type, uint32_t *p_crc, const uint8_t *p_data, uint32_t length, bool use_dma)
+{
+  uint32_t done = 0;
+
+
+  if (type == CHECKSUM_CRC16)
+  {
+    hcrc.Init.GeneratingPolynomial    = 0x8005;
+    hcrc.Init.CRCLength               = CRC_POLYLENGTH_16B;
+    hcrc.Init.InitValue               = *p_crc & 0xFFFF;
+    hcrc.Init.InputDataInversionMode  = CRC_INPUTDATA_INVERSION_NONE;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_DISABLE;
+  }
+  else
+  {
+    hcrc.Init.GeneratingPolynomial    = 0x04C11DB7;
+    hcrc.Init.CRCLength               = CRC_POLYLENGTH_32B;
+    hcrc.Init.InitValue               = __RBIT(~*p_crc);
+    hcrc.Init.InputDataInversionMode  = CRC_INPUTDATA_INVERSION_BYTE;
+    hcrc.Init.OutputDataInversionMode = CRC_OUTPUTDATA_INVERSION_ENABLE;
+  }
+
+  if (HAL_CRC_Init(&hcrc) != HAL_OK)
+  {
+    return false;
+  }
+  __HAL_CRC_DR_RESET(&hcrc);
+
+  if (use_dma == true)
+  {
+    if (checksumRunDma(p_data, length, &done) != true)
+    {
+      return false;
+    }
+  }
+
+  HAL_CRC_Accumulate(&hcrc, (uint32_t *)&p_data[done], length - done);
+
+  if (type == CHECKSUM_CRC16)
+  {
+    *p_crc = hcrc.Instance->DR & 0xFFFF;
+  }
+  else
+  {
+    *p_crc = ~hcrc.Instance->DR;
+  }
+
+  return true;
+}
+
+// Feed the word aligned middle of the region to DR with the DMA and leave
+// the tail to the CPU. Only called from a thread.
+//
+bool checksumRunDma(const uint8_t *p_data, uint32_t length, uint32_t *p_done)
+{
+#ifdef _USE_HW_RTOS
+  uint32_t done;
+  uint32_t words;
+
+
+  done = (4 - ((uint32_t)p_data & 0x03)) & 0x03;
+  done = constrain(done, 0, length);
+
+  HAL_CRC_Accumulate(&hcrc, (uint32_t *)p_data, done);
+
+  while (length - done >= 4)
+  {
+    words = constrain((length - done) / 4, 0, CHECKSUM_DMA_WORDS);
+
+    osSemaphoreWait(sem_dma, 0);
+    dma_state = CHECKSUM_DMA_WAIT;
+
+    if (HAL_DMA_Start_IT(&hdma_crc, (uint32_t)&p_data[done], (uint32_t)&hcrc.Instance->DR, words) != HAL_OK)
+    {
+      return false;
+    }
+
+    if (osSemaphoreWait(sem_dma, CHECKSUM_DMA_TIMEOUT) != osOK || dma_state != CHECKSUM_DMA_OK)
+    {
+      HAL_DMA_Abort(&hdma_crc);
+      return false;
+    }
+
+    done += words * 4;
+  }
+
+  *p_done = done;
+
+  return true;
+#else
+  *p_done = 0;
+
+  return true;
+#endif
+}
+
+bool checksumIsThread(void)
+{
+#ifdef _USE_HW_RTOS
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED && __get_IPSR() == 0)
+  {
+    return true;
+  }
+#endif
+  return false;
+}
+
+// Threads wait for each other. An interrupt, or a thread before the
+// scheduler runs, only takes the unit when it is free.
+//
+bool checksumLock(void)
+{
+  bool ret = false;
+  uint32_t primask;
+
+
+#ifdef _USE_HW_RTOS
+  if (checksumIsThread() == true)
+  {
+    if (osMutexWait(checksum_lock, osWaitForever) != osOK)
+    {
+      return false;
+    }
+  }
+#endif
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (is_hw_busy != true)
+  {
+    is_hw_busy = true;
+    ret = true;
+  }
+  __set_PRIMASK(primask);
+
+#ifdef _USE_HW_RTOS
+  if (ret != true && checksumIsThread() == true)
+  {
+    osMutexRelease(checksum_lock);
+  }
+#endif
+
+  return ret;
+}
+
+void checksumUnlock(void)
+{
+  is_hw_busy = false;
+
+#ifdef _USE_HW_RTOS
+  if (checksumIsThread() == true)
+  {
+    osMutexRelease(checksum_lock);
+  }
+#endif
+}
+
+
+#ifdef _USE_HW_RTOS
+void checksumDmaCplt(DMA_HandleTypeDef *hdma)
+{
+  dma_state = CHECKSUM_DMA_OK;
+  osSemaphoreRelease(sem_dma);
+}
+
+void checksumDmaError(DMA_HandleTypeDef *hdma)
+{
+  dma_state = CHECKSUM_DMA_ERR;
+  osSemaphoreRelease(sem_dma);
+}
+
+void DMA2_Stream0_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_crc);
+}
+#endif
+
+
+
+
+#if HW_USE_CMDIF_CHECKSUM == 1
+
+static const char *checksum_mode_str[] = {"auto", "sw  ", "cpu ", "dma "};
+
+// Compare every backend with the software one over the program flash,
+// at each alignment and across the DMA block size.
+//
+static bool checksumCmdifTest(void)
+{
+  const uint8_t *p_data = (const uint8_t *)FLASH_BANK1_BASE;
+  const uint32_t length_tbl[] = {0, 1, 3, 4, 7, 8, 63, 64, 4097, CHECKSUM_DMA_MIN + 5, CHECKSUM_DMA_WORDS*4 + 4099};
+  uint32_t i;
+  uint32_t j;
+  uint32_t mode;
+  uint32_t ref16;
+  uint32_t ref32;
+  uint32_t crc16;
+  uint32_t crc32;
+  bool ret = true;
+
+
+  for (i=0; i<8; i++)
+  {
+    for (j=0; j<sizeof(length_tbl)/sizeof(uint32_t); j++)
+    {
+      ref16 = crc16Update(0x1234, &p_data[i], length_tbl[j]);
+      ref32 = crc32Update(0x12345678, &p_data[i], length_tbl[j]);
+
+      for (mode=CHECKSUM_MODE_CPU; mode<=CHECKSUM_MODE_DMA; mode++)
+      {
+        crc16 = 0x1234;
+        crc32 = 0x12345678;
+        checksumRun(CHECKSUM_CRC16, &crc16, &p_data[i], length_tbl[j], mode);
+        checksumRun(CHECKSUM_CRC32, &crc32, &p_data[i], length_tbl[j], mode);
+
+        if (crc16 != ref16 || crc32 != ref32)
+        {
+          cmdifPrintf("%s : offset %d, length %d, crc16 %X/%X, crc32 %X/%X\n",
+                      checksum_mode_str[mode], i, length_tbl[j], crc16, ref16, crc32, ref32);
+          ret = false;
+        }
+      }
+    }
+  }
+
+  return ret;
+}
+
+void checksumCmdif(void)
+{
+  bool ret = true;
+
+
+  if (cmdifGetParamCnt() == 1 && cmdifHasString("test", 0) == true)
+  {
+    cmdifPrintf("vectors  : %s\n", crcTest() == true ? "OK" : "Fail");
+    cmdifPrintf("backends : %s\n", checksumCmdifTest() == true ? "OK" : "Fail");
+  }
+  else if (cmdifGetParamCnt() >= 1 && cmdifHasString("speed", 0) == true)
+  {
+    const uint8_t *p_data = (const uint8_t *)FLASH_BANK1_BASE;
+    uint32_t length = 2048;
+    uint32_t mode;
+    uint32_t crc;
+    uint32_t pre_time_us;
+    uint32_t exe_time_us;
+    bool is_hw;
+
+
+    if (cmdifGetParamCnt() == 3)
+    {
+      p_data = (const uint8_t *)cmdifGetParam(1);
+      length = cmdifGetParam(2);
+    }
+
+    cmdifPrintf("0x%X, %d KB\n", (uint32_t)p_data, length);
+
+    for (mode=CHECKSUM_MODE_SW; mode<=CHECKSUM_MODE_DMA; mode++)
+    {
+      crc = 0;
+      pre_time_us = micros();
+      is_hw = checksumRun(CHECKSUM_CRC16, &crc, p_data, length*1024, mode);
+      exe_time_us = micros()-pre_time_us;
+
+      cmdifPrintf("%s crc16 : %04X, %d.%03d ms%s\n", checksum_mode_str[mode], crc,
+                  exe_time_us/1000, exe_time_us%1000,
+                  (mode != CHECKSUM_MODE_SW && is_hw != true) ? " (sw)" : "");
+    }
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "checksum test\n");
+    cmdifPrintf( "checksum speed [addr length_kb]\n");
+  }
+}
+#endif
+
+#endif
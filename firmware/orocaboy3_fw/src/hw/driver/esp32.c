@@ -15,6 +15,8 @@
 #include "esp32.h"
 #include "gpio.h"
 #include "uart.h"
+#include "vcp.h"
+#include "cmdif.h"
 
 
 #ifdef _USE_HW_ESP32
@@ -24,27 +26,85 @@
 #define ESP_RESET_BOOT    1
 #define ESP_RESET_RUN     2
 
+#define ESP_BRIDGE_NONE   0xFF
 
 
 
-static bool is_download_mode = false;
+static volatile bool is_download_mode = false;
 
-static uint8_t req_boot_reset = 0;
-static bool req_set_baud   = false;
+static volatile uint8_t req_boot_reset = 0;
+static volatile bool req_set_baud   = false;
 
 static uint8_t  uart_down_ch  = _DEF_UART3;
 static uint8_t  uart_run_ch   = _DEF_UART4;
-static uint8_t  usb_ch        = _DEF_UART2;
-static uint32_t uart_baud_req = 115200;
+static uint8_t  bridge_ch     = ESP_BRIDGE_NONE;
+static volatile uint32_t uart_baud_req = 115200;
+
+#ifdef _USE_HW_RTOS
+static osSemaphoreId sem_req;
+
+static void esp32Thread(void const *argument);
+#endif
+
+#if HW_USE_CMDIF_ESP32 == 1
+static void esp32Cmdif(void);
+#endif
+
 
 bool esp32Init(void)
 {
   //esp32DownloadMode(true);
   esp32Reset(false);
 
+#ifdef _USE_HW_RTOS
+  osSemaphoreDef(sem_req);
+  sem_req = osSemaphoreCreate(osSemaphore(sem_req), 1);
+
+  osThreadDef(esp32Thread, esp32Thread, _HW_DEF_RTOS_THREAD_PRI_ESP32, 0, _HW_DEF_RTOS_THREAD_MEM_ESP32);
+  if (osThreadCreate(osThread(esp32Thread), NULL) == NULL)
+  {
+    logPrintf("esp32Thread \t\t: Fail\r\n");
+  }
+#endif
+
+#if HW_USE_CMDIF_ESP32 == 1
+  if (cmdifIsInit() == false)
+  {
+    cmdifInit();
+  }
+  cmdifAdd("esp32", esp32Cmdif);
+#endif
+
   return true;
 }
 
+#ifdef _USE_HW_RTOS
+// The data between the VCP and the ESP32 is moved by the vcp bridge in the
+// USB and uart interrupts, this thread only follows the reset and baud
+// requests of the host.
+//
+static void esp32Thread(void const *argument)
+{
+  UNUSED(argument);
+
+  while(1)
+  {
+    esp32Update();
+    osSemaphoreWait(sem_req, 100);
+  }
+}
+#endif
+
+static void esp32Request(void)
+{
+#ifdef _USE_HW_RTOS
+  if (sem_req != NULL)
+  {
+    osSemaphoreRelease(sem_req);
+  }
+#endif
+}
+
 void esp32Reset(bool boot)
 {
   if (boot == true)
@@ -69,8 +129,9 @@ void esp32Reset(bool boot)
 
 void esp32SetBaud(uint32_t baud)
 {
-  req_set_baud = true;
   uart_baud_req = baud;
+  req_set_baud = true;
+  esp32Request();
 }
 
 
@@ -88,6 +149,7 @@ void esp32RequestBoot(uint8_t param)
     is_download_mode = false;
     req_boot_reset = ESP_RESET_RUN;
   }
+  esp32Request();
 }
 
 void esp32DownloadMode(bool enable)
@@ -102,9 +164,32 @@ bool esp32IsDownloadMode(void)
 
 void esp32Update(void)
 {
-  uint8_t data;
+  uint8_t ch;
 
 
+  ch = (is_download_mode == true) ? uart_down_ch : uart_run_ch;
+
+  if (req_set_baud == true)
+  {
+    req_set_baud = false;
+
+    if (uartGetBaud(ch) != uart_baud_req)
+    {
+      vcpBridgeEnd();
+      bridge_ch = ESP_BRIDGE_NONE;
+      uartOpen(ch, uart_baud_req);
+    }
+  }
+
+  // switch the bridge before the reset, so the boot messages are not lost.
+  if (bridge_ch != ch)
+  {
+    if (vcpBridgeBegin(ch) == true)
+    {
+      bridge_ch = ch;
+    }
+  }
+
   if (req_boot_reset == ESP_RESET_BOOT)
   {
     req_boot_reset = ESP_RESET_NONE;
@@ -115,56 +200,43 @@ void esp32Update(void)
     req_boot_reset = ESP_RESET_NONE;
     esp32Reset(false);
   }
+}
 
-  if (req_set_baud == true)
-  {
-    req_set_baud = false;
 
-    if (is_download_mode == true)
-    {
-      if (uartGetBaud(uart_down_ch) != uart_baud_req)
-      {
-        uartOpen(uart_down_ch, uart_baud_req);
-      }
-    }
-    else
-    {
-      if (uartGetBaud(uart_run_ch) != uart_baud_req)
-      {
-        uartOpen(uart_run_ch, uart_baud_req);
-      }
-    }
-  }
+
+#if HW_USE_CMDIF_ESP32 == 1
+void esp32Cmdif(void)
+{
+  bool ret = true;
 
 
-  if (is_download_mode == true)
+  if (cmdifGetParamCnt() >= 1 && cmdifHasString("stat", 0) == true)
   {
-    while(uartAvailable(uart_down_ch) > 0)
-    {
-      data = uartRead(uart_down_ch);
-      uartPutch(usb_ch, data);
-    }
+    vcp_bridge_stat_t stat;
 
-    while(uartAvailable(usb_ch) > 0)
+
+    if (cmdifGetParamCnt() == 2 && cmdifHasString("clear", 1) == true)
     {
-      data = uartRead(usb_ch);
-      uartPutch(uart_down_ch, data);
+      vcpBridgeClearStat();
     }
+
+    vcpBridgeGetStat(&stat);
+
+    cmdifPrintf("mode     : %s\n", is_download_mode == true ? "download" : "run");
+    cmdifPrintf("uart     : %d, %d bps, err %d\n", bridge_ch, uartGetBaud(bridge_ch), uartGetErrCnt(bridge_ch));
+    cmdifPrintf("up       : %d bytes, rx high %d\n", stat.up_bytes, stat.rx_high);
+    cmdifPrintf("down     : %d bytes, out high %d, hold %d\n", stat.down_bytes, stat.out_high, stat.hold_cnt);
   }
   else
   {
-    while(uartAvailable(uart_run_ch) > 0)
-    {
-      data = uartRead(uart_run_ch);
-      uartPutch(usb_ch, data);
-    }
+    ret = false;
+  }
 
-    while(uartAvailable(usb_ch) > 0)
-    {
-      data = uartRead(usb_ch);
-      uartPutch(uart_run_ch, data);
-    }
+  if (ret == false)
+  {
+    cmdifPrintf( "esp32 stat [clear]\n");
   }
 }
+#endif
 
 #endif
@@ -152,10 +152,6 @@ DRESULT SD_read(BYTE lun, BYTE *buff, DWORD sector, UINT count)
 
   if(sdReadBlocks((uint32_t) (sector), (uint8_t *)buff, count, SD_TIMEOUT) == true)
   {
-    /* wait until the read operation is finished */
-    while(sdIsBusy() == true)
-    {
-    }
     res = RES_OK;
   }
 
@@ -177,10 +173,6 @@ DRESULT SD_write(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
 
   if(sdWriteBlocks((uint32_t)(sector), (uint8_t*)buff, count, SD_TIMEOUT) == true)
   {
-	/* wait until the Write operation is finished */
-    while(sdIsBusy() == true)
-    {
-    }
     res = RES_OK;
   }
 
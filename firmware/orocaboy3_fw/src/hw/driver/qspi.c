@@ -75,6 +75,18 @@
 
 
 
+#define QSPI_JOB_QUEUE_MAX         8
+#define QSPI_JOB_RUN_MIN           2      /* ms an operation runs after a resume before it is suspended again */
+#define QSPI_PROG_MAX_TIME         10
+#define QSPI_SUSPEND_MAX_TIME      10
+#define QSPI_VERIFY_SIZE           1024
+
+#define QSPI_POLL_RUN              0
+#define QSPI_POLL_OK               1
+#define QSPI_POLL_ERR              2
+
+
+
 /* QSPI Info */
 typedef struct {
   uint32_t FlashSize;          /*!< Size of the flash */
@@ -89,6 +101,19 @@ typedef struct {
 
 static QSPI_HandleTypeDef QSPIHandle;
 static bool is_init = false;
+static bool is_map_on = false;            // memory mapped mode whenever the bus is idle
+static volatile bool is_job_run = false;
+
+#ifdef _USE_HW_RTOS
+static osMutexId     qspi_lock;
+static osSemaphoreId sem_event;
+static osMessageQId  job_q;
+
+static volatile uint32_t req_cnt = 0;     // threads waiting for the bus
+static volatile uint8_t  poll_state = QSPI_POLL_OK;
+
+static uint8_t verify_buf[QSPI_VERIFY_SIZE];
+#endif
 
 uint8_t BSP_QSPI_Init       (void);
 uint8_t BSP_QSPI_DeInit     (void);
@@ -101,7 +126,26 @@ uint8_t BSP_QSPI_GetInfo    (QSPI_Info* pInfo);
 uint8_t BSP_QSPI_EnableMemoryMappedMode(void);
 uint8_t BSP_QSPI_GetID(QSPI_Info* pInfo);
 
+static bool qspiLock(void);
+static void qspiUnlock(void);
+static bool qspiMapOff(void);
+static bool qspiMapRestore(void);
+
+#ifdef _USE_HW_RTOS
+static bool qspiIsThread(void);
+static bool qspiJobPut(qspi_job_t *p_job);
+static bool qspiJobRun(qspi_job_t *p_job);
+static bool qspiJobExec(qspi_job_t *p_job);
+static void qspiJobYield(void);
+static bool qspiJobPoll(uint32_t timeout_ms);
+static bool qspiPollBegin(void);
+static void qspiPollStop(void);
+static uint8_t qspiJobSuspend(void);
+static bool qspiSendCmd(uint8_t cmd, uint32_t addr, uint8_t *p_data, uint32_t length, bool is_write);
+static void qspiThread(void const *argument);
 
+static uint8_t QSPI_WriteEnable(QSPI_HandleTypeDef *hqspi);
+#endif
 
 
 
@@ -111,6 +155,29 @@ bool qspiInit(void)
   QSPI_Info info;
 
 
+#ifdef _USE_HW_RTOS
+  if (qspi_lock == NULL)
+  {
+    osMutexDef(qspi_lock);
+    osSemaphoreDef(sem_event);
+    osMessageQDef(job_q, QSPI_JOB_QUEUE_MAX, uint32_t);
+    qspi_lock = osRecursiveMutexCreate(osMutex(qspi_lock));
+    sem_event = osSemaphoreCreate(osSemaphore(sem_event), 1);
+    job_q     = osMessageCreate(osMessageQ(job_q), NULL);
+
+    osThreadDef(qspiThread, qspiThread, _HW_DEF_RTOS_THREAD_PRI_QSPI, 0, _HW_DEF_RTOS_THREAD_MEM_QSPI);
+    if (osThreadCreate(osThread(qspiThread), NULL) == NULL)
+    {
+      logPrintf("qspiThread \t\t: Fail\r\n");
+    }
+  }
+#endif
+
+  if (qspiLock() != true)
+  {
+    return false;
+  }
+
   if (BSP_QSPI_Init() == QSPI_OK)
   {
     ret = true;
@@ -139,6 +206,8 @@ bool qspiInit(void)
     ret = false;
   }
 
+  qspiMapRestore();
+  qspiUnlock();
 
 
   is_init = ret;
@@ -160,8 +229,17 @@ bool qspiRead(uint32_t addr, uint8_t *p_data, uint32_t length)
     return false;
   }
 
+  if (qspiLock() != true)
+  {
+    return false;
+  }
+  qspiMapOff();
+
   ret = BSP_QSPI_Read(p_data, addr, length);
 
+  qspiMapRestore();
+  qspiUnlock();
+
   if (ret == QSPI_OK)
   {
     return true;
@@ -181,8 +259,30 @@ bool qspiWrite(uint32_t addr, uint8_t *p_data, uint32_t length)
     return false;
   }
 
+#ifdef _USE_HW_RTOS
+  if (qspiIsThread() == true)
+  {
+    qspi_job_t job;
+
+    if (qspiJobWrite(&job, addr, p_data, length, NULL, NULL) != true)
+    {
+      return false;
+    }
+    return qspiJobRun(&job);
+  }
+#endif
+
+  if (qspiLock() != true)
+  {
+    return false;
+  }
+  qspiMapOff();
+
   ret = BSP_QSPI_Write(p_data, addr, length);
 
+  qspiMapRestore();
+  qspiUnlock();
+
   if (ret == QSPI_OK)
   {
     return true;
@@ -197,8 +297,17 @@ bool qspiEraseBlock(uint32_t block_addr)
 {
   uint8_t ret;
 
+  if (qspiLock() != true)
+  {
+    return false;
+  }
+  qspiMapOff();
+
   ret = BSP_QSPI_Erase_Block(block_addr);
 
+  qspiMapRestore();
+  qspiUnlock();
+
   if (ret == QSPI_OK)
   {
     return true;
@@ -233,6 +342,18 @@ bool qspiErase(uint32_t addr, uint32_t length)
     return false;
   }
 
+#ifdef _USE_HW_RTOS
+  if (qspiIsThread() == true)
+  {
+    qspi_job_t job;
+
+    if (qspiJobErase(&job, addr, length, NULL, NULL) != true)
+    {
+      return false;
+    }
+    return qspiJobRun(&job);
+  }
+#endif
 
   block_begin = addr / block_size;
   block_end   = (addr + length - 1) / block_size;
@@ -254,8 +375,17 @@ bool qspiEraseChip(void)
 {
   uint8_t ret;
 
+  if (qspiLock() != true)
+  {
+    return false;
+  }
+  qspiMapOff();
+
   ret = BSP_QSPI_Erase_Chip();
 
+  qspiMapRestore();
+  qspiUnlock();
+
   if (ret == QSPI_OK)
   {
     return true;
@@ -270,8 +400,17 @@ bool qspiGetStatus(void)
 {
   uint8_t ret;
 
+  if (qspiLock() != true)
+  {
+    return false;
+  }
+  qspiMapOff();
+
   ret = BSP_QSPI_GetStatus();
 
+  qspiMapRestore();
+  qspiUnlock();
+
   if (ret == QSPI_OK)
   {
     return true;
@@ -300,18 +439,118 @@ bool qspiGetInfo(qspi_info_t* p_info)
 
 bool qspiEnableMemoryMappedMode(void)
 {
-  uint8_t ret;
+  bool ret;
+
+  if (qspiLock() != true)
+  {
+    return false;
+  }
 
-  ret = BSP_QSPI_EnableMemoryMappedMode();
+  is_map_on = true;
+  ret = qspiMapRestore();
 
-  if (ret == QSPI_OK)
+  qspiUnlock();
+
+  return ret;
+}
+
+// Readers of the QSPI_ADDR_START window go between these two. A job in
+// progress is suspended for them, its sector reads back undefined data
+// until the job ends.
+//
+bool qspiMapBegin(void)
+{
+  if (qspiLock() != true)
   {
-    return true;
+    return false;
   }
-  else
+
+  if (QSPIHandle.State != HAL_QSPI_STATE_BUSY_MEM_MAPPED)
+  {
+    if (BSP_QSPI_EnableMemoryMappedMode() != QSPI_OK)
+    {
+      qspiUnlock();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void qspiMapEnd(void)
+{
+  qspiUnlock();
+}
+
+bool qspiJobErase(qspi_job_t *p_job, uint32_t addr, uint32_t length, void (*func)(qspi_job_t *p_job), void *arg)
+{
+  if (length == 0 || addr >= qspiGetLength() || (addr + length) > qspiGetLength())
   {
     return false;
   }
+
+  p_job->type    = QSPI_JOB_ERASE;
+  p_job->addr    = addr;
+  p_job->p_data  = NULL;
+  p_job->length  = length;
+  p_job->func    = func;
+  p_job->arg     = arg;
+
+#ifdef _USE_HW_RTOS
+  return qspiJobPut(p_job);
+#else
+  p_job->done    = length;
+  p_job->state   = qspiErase(addr, length) == true ? QSPI_JOB_OK : QSPI_JOB_ERR;
+  p_job->is_done = true;
+  return true;
+#endif
+}
+
+bool qspiJobWrite(qspi_job_t *p_job, uint32_t addr, uint8_t *p_data, uint32_t length, void (*func)(qspi_job_t *p_job), void *arg)
+{
+  if (length == 0 || addr >= qspiGetLength() || (addr + length) > qspiGetLength())
+  {
+    return false;
+  }
+
+  p_job->type    = QSPI_JOB_WRITE;
+  p_job->addr    = addr;
+  p_job->p_data  = p_data;
+  p_job->length  = length;
+  p_job->func    = func;
+  p_job->arg     = arg;
+
+#ifdef _USE_HW_RTOS
+  return qspiJobPut(p_job);
+#else
+  p_job->done    = length;
+  p_job->state   = qspiWrite(addr, p_data, length) == true ? QSPI_JOB_OK : QSPI_JOB_ERR;
+  p_job->is_done = true;
+  return true;
+#endif
+}
+
+bool qspiJobIsDone(qspi_job_t *p_job)
+{
+  return p_job->is_done;
+}
+
+// On timeout the job stays queued, p_job must be kept until it is done.
+//
+bool qspiJobWait(qspi_job_t *p_job, uint32_t timeout_ms)
+{
+  uint32_t pre_time = millis();
+
+  while (p_job->is_done != true)
+  {
+    if (millis()-pre_time >= timeout_ms)
+    {
+      return false;
+    }
+    delay(1);
+  }
+
+  return p_job->state == QSPI_JOB_OK;
 }
 
 uint32_t qspiGetAddr(void)
@@ -325,6 +564,454 @@ uint32_t qspiGetLength(void)
 }
 
 
+// Threads queue up here, the job thread gives the bus away between blocks
+// and while an erase or program is suspended. Before the scheduler runs
+// there is nobody to wait for.
+//
+bool qspiLock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (qspiIsThread() == true)
+  {
+    taskENTER_CRITICAL();
+    req_cnt++;
+    taskEXIT_CRITICAL();
+
+    osSemaphoreRelease(sem_event);
+    osRecursiveMutexWait(qspi_lock, osWaitForever);
+    return true;
+  }
+#endif
+
+  if (is_job_run == true)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+void qspiUnlock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (qspiIsThread() == true)
+  {
+    osRecursiveMutexRelease(qspi_lock);
+
+    taskENTER_CRITICAL();
+    req_cnt--;
+    taskEXIT_CRITICAL();
+  }
+#endif
+}
+
+bool qspiMapOff(void)
+{
+  if (QSPIHandle.State == HAL_QSPI_STATE_BUSY_MEM_MAPPED)
+  {
+    if (HAL_QSPI_Abort(&QSPIHandle) != HAL_OK)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool qspiMapRestore(void)
+{
+  if (is_map_on == true && QSPIHandle.State != HAL_QSPI_STATE_BUSY_MEM_MAPPED)
+  {
+    if (BSP_QSPI_EnableMemoryMappedMode() != QSPI_OK)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+#ifdef _USE_HW_RTOS
+bool qspiIsThread(void)
+{
+  if (job_q != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED && __get_IPSR() == 0)
+  {
+    return true;
+  }
+  return false;
+}
+
+bool qspiJobPut(qspi_job_t *p_job)
+{
+  p_job->done    = 0;
+  p_job->state   = QSPI_JOB_WAIT;
+  p_job->is_done = false;
+
+  if (job_q == NULL || osMessagePut(job_q, (uint32_t)p_job, 0) != osOK)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+bool qspiJobRun(qspi_job_t *p_job)
+{
+  while (p_job->is_done != true)
+  {
+    osDelay(1);
+  }
+
+  return p_job->state == QSPI_JOB_OK;
+}
+
+void qspiThread(void const *argument)
+{
+  osEvent evt;
+  qspi_job_t *p_job;
+  bool ret;
+
+  UNUSED(argument);
+
+
+  while(1)
+  {
+    evt = osMessageGet(job_q, osWaitForever);
+    if (evt.status != osEventMessage)
+    {
+      continue;
+    }
+    p_job = (qspi_job_t *)evt.value.p;
+
+    osRecursiveMutexWait(qspi_lock, osWaitForever);
+    is_job_run   = true;
+    p_job->state = QSPI_JOB_RUN;
+
+    ret = qspiJobExec(p_job);
+
+    qspiMapRestore();
+    is_job_run = false;
+    osRecursiveMutexRelease(qspi_lock);
+
+    p_job->state = (ret == true) ? QSPI_JOB_OK : QSPI_JOB_ERR;
+    if (p_job->func != NULL)
+    {
+      p_job->func(p_job);
+    }
+    // p_job may be gone from here on
+    p_job->is_done = true;
+  }
+}
+
+// One erase block or page at a time, the thread sleeps while the flash is
+// busy and the status match interrupt wakes it.
+//
+bool qspiJobExec(qspi_job_t *p_job)
+{
+  uint32_t addr;
+  uint32_t size;
+  uint32_t offset;
+  uint32_t timeout;
+  uint8_t  cmd;
+
+
+  if (qspiMapOff() != true)
+  {
+    return false;
+  }
+
+  while (p_job->done < p_job->length)
+  {
+    qspiJobYield();
+
+    addr = p_job->addr + p_job->done;
+
+    if (p_job->type == QSPI_JOB_ERASE)
+    {
+      if ((addr % N25Q512A_SECTOR_SIZE) == 0 && (p_job->length - p_job->done) >= N25Q512A_SECTOR_SIZE)
+      {
+        cmd     = SECTOR_ERASE_CMD;
+        size    = N25Q512A_SECTOR_SIZE;
+        timeout = N25Q512A_SECTOR_ERASE_MAX_TIME;
+      }
+      else
+      {
+        cmd     = SUBSECTOR_ERASE_CMD;
+        size    = N25Q512A_SUBSECTOR_SIZE - (addr % N25Q512A_SUBSECTOR_SIZE);
+        timeout = N25Q512A_SUBSECTOR_ERASE_MAX_TIME;
+      }
+      addr -= addr % N25Q512A_SUBSECTOR_SIZE;
+
+      if (qspiSendCmd(cmd, addr, NULL, 0, true) != true)
+      {
+        return false;
+      }
+    }
+    else
+    {
+      size    = N25Q512A_PAGE_SIZE - (addr % N25Q512A_PAGE_SIZE);
+      timeout = QSPI_PROG_MAX_TIME;
+
+      if (size > p_job->length - p_job->done)
+      {
+        size = p_job->length - p_job->done;
+      }
+
+      if (qspiSendCmd(QUAD_IN_FAST_PROG_4_BYTE_ADDR_CMD, addr, &p_job->p_data[p_job->done], size, true) != true)
+      {
+        return false;
+      }
+    }
+
+    if (qspiJobPoll(timeout) != true || BSP_QSPI_GetStatus() != QSPI_OK)
+    {
+      qspiSendCmd(CLEAR_FLAG_STATUS_REG_CMD, 0, NULL, 0, false);
+      return false;
+    }
+
+    p_job->done = constrain(p_job->done + size, 0, p_job->length);
+
+    if (p_job->func != NULL)
+    {
+      p_job->func(p_job);
+    }
+  }
+
+  if (p_job->type == QSPI_JOB_WRITE)
+  {
+    for (offset=0; offset<p_job->length; offset+=size)
+    {
+      qspiJobYield();
+
+      size = constrain(p_job->length - offset, 0, QSPI_VERIFY_SIZE);
+
+      if (BSP_QSPI_Read(verify_buf, p_job->addr + offset, size) != QSPI_OK)
+      {
+        return false;
+      }
+      if (memcmp(verify_buf, &p_job->p_data[offset], size) != 0)
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Hand the bus to the threads waiting in qspiLock(), in the idle state
+// they expect, and take it back once they are all done.
+//
+void qspiJobYield(void)
+{
+  if (req_cnt == 0)
+  {
+    return;
+  }
+
+  qspiMapRestore();
+  while (req_cnt > 0)
+  {
+    osRecursiveMutexRelease(qspi_lock);
+    osDelay(1);
+    osRecursiveMutexWait(qspi_lock, osWaitForever);
+  }
+  qspiMapOff();
+}
+
+bool qspiJobPoll(uint32_t timeout_ms)
+{
+  uint32_t pre_time;
+  uint32_t run_time;
+  uint32_t sus_time;
+
+
+  osSemaphoreWait(sem_event, 0);
+
+  if (qspiPollBegin() != true)
+  {
+    return false;
+  }
+
+  pre_time = millis();
+  run_time = millis();
+
+  while(1)
+  {
+    osSemaphoreWait(sem_event, 10);
+
+    if (poll_state == QSPI_POLL_OK)
+    {
+      return true;
+    }
+    if (poll_state == QSPI_POLL_ERR || millis()-pre_time >= timeout_ms)
+    {
+      qspiPollStop();
+      return false;
+    }
+
+    if (req_cnt > 0 && millis()-run_time >= QSPI_JOB_RUN_MIN)
+    {
+      qspiPollStop();
+      if (poll_state == QSPI_POLL_OK)
+      {
+        return true;
+      }
+
+      sus_time = millis();
+
+      switch(qspiJobSuspend())
+      {
+        case QSPI_SUSPENDED:
+          break;
+
+        case QSPI_OK:
+          // finished before the suspend
+          return true;
+
+        default:
+          return false;
+      }
+
+      qspiJobYield();
+
+      if (qspiSendCmd(PROG_ERASE_RESUME_CMD, 0, NULL, 0, false) != true)
+      {
+        return false;
+      }
+
+      // the time spent suspended does not count
+      pre_time += millis() - sus_time;
+      run_time  = millis();
+
+      osSemaphoreWait(sem_event, 0);
+      if (qspiPollBegin() != true)
+      {
+        return false;
+      }
+    }
+  }
+}
+
+bool qspiPollBegin(void)
+{
+  QSPI_CommandTypeDef     s_command;
+  QSPI_AutoPollingTypeDef s_config;
+
+  s_command.InstructionMode   = QSPI_INSTRUCTION_4_LINES;
+  s_command.Instruction       = READ_STATUS_REG_CMD;
+  s_command.AddressMode       = QSPI_ADDRESS_NONE;
+  s_command.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  s_command.DataMode          = QSPI_DATA_4_LINES;
+  s_command.DummyCycles       = 2;
+  s_command.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  s_command.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  s_command.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  s_config.Match           = 0;
+  s_config.Mask            = N25Q512A_SR_WIP;
+  s_config.MatchMode       = QSPI_MATCH_MODE_AND;
+  s_config.StatusBytesSize = 1;
+  s_config.Interval        = 0x10;
+  s_config.AutomaticStop   = QSPI_AUTOMATIC_STOP_ENABLE;
+
+  poll_state = QSPI_POLL_RUN;
+
+  if (HAL_QSPI_AutoPolling_IT(&QSPIHandle, &s_command, &s_config) != HAL_OK)
+  {
+    poll_state = QSPI_POLL_ERR;
+    return false;
+  }
+
+  return true;
+}
+
+// Returns QSPI_SUSPENDED, or QSPI_OK if the operation ended first.
+//
+uint8_t qspiJobSuspend(void)
+{
+  QSPI_CommandTypeDef     s_command;
+  QSPI_AutoPollingTypeDef s_config;
+
+  if (qspiSendCmd(PROG_ERASE_SUSPEND_CMD, 0, NULL, 0, false) != true)
+  {
+    return QSPI_ERROR;
+  }
+
+  /* Wait for the program/erase controller to stop */
+  s_command.InstructionMode   = QSPI_INSTRUCTION_4_LINES;
+  s_command.Instruction       = READ_FLAG_STATUS_REG_CMD;
+  s_command.AddressMode       = QSPI_ADDRESS_NONE;
+  s_command.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  s_command.DataMode          = QSPI_DATA_4_LINES;
+  s_command.DummyCycles       = 0;
+  s_command.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  s_command.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  s_command.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  s_config.Match           = N25Q512A_FSR_READY;
+  s_config.Mask            = N25Q512A_FSR_READY;
+  s_config.MatchMode       = QSPI_MATCH_MODE_AND;
+  s_config.StatusBytesSize = 1;
+  s_config.Interval        = 0x10;
+  s_config.AutomaticStop   = QSPI_AUTOMATIC_STOP_ENABLE;
+
+  if (HAL_QSPI_AutoPolling(&QSPIHandle, &s_command, &s_config, QSPI_SUSPEND_MAX_TIME) != HAL_OK)
+  {
+    return QSPI_ERROR;
+  }
+
+  return BSP_QSPI_GetStatus();
+}
+
+void qspiPollStop(void)
+{
+  __HAL_QSPI_DISABLE_IT(&QSPIHandle, QSPI_IT_SM | QSPI_IT_TE);
+
+  if (QSPIHandle.State == HAL_QSPI_STATE_BUSY_AUTO_POLLING)
+  {
+    HAL_QSPI_Abort(&QSPIHandle);
+  }
+}
+
+// is_write : write enable first, and the command takes an address
+//
+bool qspiSendCmd(uint8_t cmd, uint32_t addr, uint8_t *p_data, uint32_t length, bool is_write)
+{
+  QSPI_CommandTypeDef s_command;
+
+  s_command.InstructionMode   = QSPI_INSTRUCTION_4_LINES;
+  s_command.Instruction       = cmd;
+  s_command.AddressMode       = is_write ? QSPI_ADDRESS_4_LINES : QSPI_ADDRESS_NONE;
+  s_command.AddressSize       = QSPI_ADDRESS_32_BITS;
+  s_command.Address           = addr;
+  s_command.AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+  s_command.DataMode          = length > 0 ? QSPI_DATA_4_LINES : QSPI_DATA_NONE;
+  s_command.DummyCycles       = 0;
+  s_command.NbData            = length;
+  s_command.DdrMode           = QSPI_DDR_MODE_DISABLE;
+  s_command.DdrHoldHalfCycle  = QSPI_DDR_HHC_ANALOG_DELAY;
+  s_command.SIOOMode          = QSPI_SIOO_INST_EVERY_CMD;
+
+  if (is_write == true && QSPI_WriteEnable(&QSPIHandle) != QSPI_OK)
+  {
+    return false;
+  }
+
+  if (HAL_QSPI_Command(&QSPIHandle, &s_command, HAL_QPSI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  {
+    return false;
+  }
+
+  if (length > 0 && HAL_QSPI_Transmit(&QSPIHandle, p_data, HAL_QPSI_TIMEOUT_DEFAULT_VALUE) != HAL_OK)
+  {
+    return false;
+  }
+
+  return true;
+}
+#endif
+
 
 
 static uint8_t QSPI_ResetMemory          (QSPI_HandleTypeDef *hqspi);
@@ -1148,3 +1835,22 @@ static uint8_t QSPI_EnterQPI(QSPI_HandleTypeDef *hqspi)
 }
 
 
+
+#ifdef _USE_HW_RTOS
+void HAL_QSPI_StatusMatchCallback(QSPI_HandleTypeDef *hqspi)
+{
+  poll_state = QSPI_POLL_OK;
+  osSemaphoreRelease(sem_event);
+}
+
+void HAL_QSPI_ErrorCallback(QSPI_HandleTypeDef *hqspi)
+{
+  poll_state = QSPI_POLL_ERR;
+  osSemaphoreRelease(sem_event);
+}
+#endif
+
+void QUADSPI_IRQHandler(void)
+{
+  HAL_QSPI_IRQHandler(&QSPIHandle);
+}
@@ -14,7 +14,11 @@
 #include "gpio.h"
 #include "qspi.h"
 #include "flash.h"
+#include "sd.h"
+#include "lz4.h"
+#include "checksum.h"
 #include "fatfs/fatfs.h"
+#include "usb/usb.h"
 
 
 
@@ -23,51 +27,222 @@
 
 #define FLASH_TAG_SIZE    1024
 
+#define SLOT_CHUNK_SIZE   (64*1024)     // SD blocks per DMA read / QSPI bytes per copy
+#define SLOT_CLMT_MAX     64            // fast seek table, up to 31 fragments
+#define SLOT_SD_TIMEOUT   1000
+
+#define SLOT_LZ4_BUF      SDRAM_ADDR_BUF  // LZ4 slot data read from SD, unused by the launcher
+#define SLOT_LZ4_BUF_SIZE (2*1024*1024)
+
+#define SLOT_CAT_MAGIC    0x54414353      // "SCAT"
+#define SLOT_CAT_VERSION  1
+#define SLOT_CAT_FILE     "/slot/catalog.bin"
+#define SLOT_CAT_PERIOD   5000            // ms between checks nobody asked for
+
+#define SLOT_CAT_NONE     0
+#define SLOT_CAT_FOLDER   1
+#define SLOT_CAT_FLASH    2
+
+#define SLOT_CAT_HAS_DIR  (1<<0)
+#define SLOT_CAT_HAS_FILE (1<<1)
+
 
 
 typedef struct
 {
   char     file_name[256];
   uint32_t file_size;
+  uint32_t file_stamp;
 
   flash_tag_t tag;
 } slot_file_t;
 
+// One slot as slotGetTag() reports it, with what it was taken from. The
+// stamps are FILINFO fdate<<16 | ftime. FAT doesn't touch the time of a
+// folder when its files change, so the file slotGetFile() picked is kept
+// and checked as well.
+//
+typedef struct
+{
+  uint32_t src;               // SLOT_CAT_NONE, _FOLDER or _FLASH
+  uint32_t flags;             // SLOT_CAT_HAS_DIR, SLOT_CAT_HAS_FILE
+  uint32_t dir_stamp;         // /slot/N
+  uint32_t file_stamp;
+  uint32_t file_size;
+  uint32_t flash_sum;         // crc32 of the tag in the QSPI slot, 0 when empty
+  char     file_name[64];     // "" when none or too long, checked by a scan then
+
+  flash_tag_t tag;
+} slot_cat_entry_t;
+
+// Same layout in RAM, in SLOT_CAT_FILE and in the QSPI at QSPI_CAT_ADDR.
+//
+typedef struct
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t length;            // sizeof(slot_cat_t)
+  uint32_t crc;               // crc32 of entry[]
+
+  slot_cat_entry_t entry[SLOT_MAX_CH];
+} slot_cat_t;
+
+typedef struct
+{
+  uint8_t  *p_dst;        // image at addr_tag
+  uint32_t length;        // image bytes, tag included
+  uint32_t dst_done;      // image bytes in place
+
+  uint8_t  *p_src;        // slot data : the image itself, its QSPI copy or LZ4 blocks
+  uint32_t src_length;
+  uint32_t src_done;      // slot bytes copied or decoded
+  bool     is_lz4;
+  bool     is_err;
+
+  uint32_t crc_begin;     // image offsets covered by tag_flash_crc
+  uint32_t crc_end;
+  uint32_t crc_done;
+  uint16_t crc;
+
+  uint32_t wait_us;       // time spent waiting for the SD card
+  uint32_t copy_us;       // time spent in memcpy from QSPI
+  uint32_t lz4_us;
+  uint32_t crc_us;
+} slot_load_t;
+
 
 
 static flash_tag_t slot_fw_tag;
 static char slot_path[256];
 static char slot_file_name[256];
 
+static slot_cat_t slot_cat;           // what slotGetTag() answers from
+static slot_cat_t slot_cat_work;      // built by slotCatUpdate()
+static volatile uint32_t slot_cat_ver = 0;
+static bool     is_cat_valid  = false;
+static bool     is_cat_loaded = false;
+static bool     is_cat_msc    = false;
+static uint32_t cat_check_ms  = 0;
+static uint32_t cat_check_cnt = 0;
+static uint32_t cat_scan_cnt  = 0;
+static uint32_t cat_first_ms  = 0;
+
+#ifdef _USE_HW_RTOS
+static osMutexId     cat_lock;
+static osMutexId     fs_lock;
+static osSemaphoreId sem_cat;
+
+static void slotThread(void const *argument);
+#endif
+
 
 
+static bool slotRunFromMap(uint8_t slot_index);
+static bool slotIsXip(flash_tag_t *p_tag);
 static bool slotVerifyFwCrc(uint32_t addr);
+static void slotLoadBegin(slot_load_t *p_load, flash_tag_t *p_tag, uint32_t addr_run, uint8_t *p_src, uint32_t src_length);
+static bool slotLoadFile(slot_load_t *p_load, FIL *p_file);
+static void slotLoadUpdate(slot_load_t *p_load, uint32_t src_end);
+static void slotLoadLz4(slot_load_t *p_load, uint32_t src_end);
+static void slotLoadCrc(slot_load_t *p_load);
+static bool slotLoadVerify(slot_load_t *p_load);
+static bool slotGetFile(uint8_t slot_index, slot_file_t *p_file);
+static void slotCatLock(void);
+static void slotCatUnlock(void);
+static void slotFsLock(void);
+static void slotFsUnlock(void);
+static void slotCatLoadFlash(void);
+static bool slotCatIsValid(slot_cat_t *p_cat);
+static void slotCatSeal(slot_cat_t *p_cat);
+static bool slotCatIsSame(uint8_t slot_index, slot_cat_entry_t *p_entry, bool is_sd);
+static void slotCatScan(uint8_t slot_index, slot_cat_entry_t *p_entry, bool is_sd);
+static void slotCatScanFlash(uint8_t slot_index, slot_cat_entry_t *p_entry);
+static bool slotCatReadFile(slot_cat_t *p_cat);
+static void slotCatSave(slot_cat_t *p_cat, bool is_sd);
+static void slotCatUpdate(void);
 static void slotCmdif(void);
 
 
 
+
 bool slotInit(void)
 {
+#ifdef _USE_HW_RTOS
+  osMutexDef(cat_lock);
+  osMutexDef(fs_lock);
+  osSemaphoreDef(sem_cat);
+  cat_lock = osMutexCreate(osMutex(cat_lock));
+  fs_lock  = osMutexCreate(osMutex(fs_lock));
+  sem_cat  = osSemaphoreCreate(osSemaphore(sem_cat), 1);
+#endif
+
+  // The copy in QSPI is there before the SD card is, the slot thread
+  // checks it against the card once it runs.
+  //
+  slotCatLoadFlash();
+
+#ifdef _USE_HW_RTOS
+  osThreadDef(slotThread, slotThread, _HW_DEF_RTOS_THREAD_PRI_SLOT, 0, _HW_DEF_RTOS_THREAD_MEM_SLOT);
+  if (osThreadCreate(osThread(slotThread), NULL) == NULL)
+  {
+    logPrintf("slotThread \t\t: Fail\r\n");
+  }
+#endif
 
   cmdifAdd("slot", slotCmdif);
 
   return true;
 }
 
+// From the catalog in RAM, same answer as slotGetTagFromFolder() and then
+// slotGetTagFromFlash() as of the last check.
+//
 bool slotGetTag(uint8_t slot_index, flash_tag_t *p_tag)
 {
   bool ret = false;
 
-  ret = slotGetTagFromFolder(slot_index, p_tag);
+  if (slot_index >= SLOT_MAX_CH)
+  {
+    return false;
+  }
 
-  if (ret != true)
+  slotCatLock();
+  if (cat_first_ms == 0)
+  {
+    cat_first_ms = millis();
+  }
+  if (slot_cat.entry[slot_index].src != SLOT_CAT_NONE)
   {
-    ret = slotGetTagFromFlash(slot_index, p_tag);
+    *p_tag = slot_cat.entry[slot_index].tag;
+    ret = true;
   }
+  slotCatUnlock();
 
   return ret;
 }
 
+// Ask the slot thread for a check now instead of at the next period.
+//
+bool slotCatalogRefresh(void)
+{
+#ifdef _USE_HW_RTOS
+  if (sem_cat != NULL)
+  {
+    osSemaphoreRelease(sem_cat);
+  }
+#else
+  slotCatUpdate();
+#endif
+  return true;
+}
+
+// Changes whenever a tag in the catalog does.
+//
+uint32_t slotCatalogGetVersion(void)
+{
+  return slot_cat_ver;
+}
+
 bool slotGetTagFromFlash(uint8_t slot_index, flash_tag_t *p_tag)
 {
   uint32_t addr_fw;
@@ -79,17 +254,42 @@ bool slotGetTagFromFlash(uint8_t slot_index, flash_tag_t *p_tag)
   p_fw_tag = (flash_tag_t *)addr_fw;
 
 
+  if (qspiMapBegin() != true)
+  {
+    return false;
+  }
+
   if (p_fw_tag->magic_number != FLASH_MAGIC_NUMBER)
   {
+    qspiMapEnd();
     return false;
   }
 
   *p_tag = *p_fw_tag;
 
+  qspiMapEnd();
+
   return true;
 }
 
 bool slotRunFromFlash(uint8_t slot_index)
+{
+  bool ret;
+
+  // Held for good when the slot starts, a pending qspi job never resumes.
+  if (qspiMapBegin() != true)
+  {
+    return false;
+  }
+
+  ret = slotRunFromMap(slot_index);
+
+  qspiMapEnd();
+
+  return ret;
+}
+
+bool slotRunFromMap(uint8_t slot_index)
 {
   uint32_t addr_fw;
   uint32_t addr_run;
@@ -109,28 +309,87 @@ bool slotRunFromFlash(uint8_t slot_index)
     return false;
   }
 
-  slot_size = p_fw_tag->tag_flash_length + p_fw_tag->tag_length;
-  if (p_fw_tag->addr_tag == addr_fw)
+  if (p_fw_tag->tag_flash_type == FLASH_TAG_TYPE_LZ4)
   {
-    addr_run = addr_fw;
+    slot_size = p_fw_tag->tag_length + p_fw_tag->tag_comp_length;
   }
   else
   {
-    pre_time = millis();
-    addr_run = p_fw_tag->addr_tag;
-    memcpy((void *)addr_run, (void *)addr_fw, slot_size);
+    slot_size = p_fw_tag->tag_flash_length + p_fw_tag->tag_length;
+  }
 
-    logPrintf("copy_fw   \t\t: %dms, %dKB\n", (int)(millis()-pre_time), (int)slot_size/1024);
+  if (slot_size > QSPI_FW_SIZE)
+  {
+    logPrintf("fw size   \t\t: Fail\n");
+    return false;
   }
 
-  if (slotVerifyFwCrc(addr_run) == true)
+  // Linked to run in place from another slot, it can't be moved.
+  if (slotIsXip(p_fw_tag) == true && p_fw_tag->addr_tag != addr_fw)
   {
-    logPrintf("fw crc    \t\t: OK\n");
+    logPrintf("fw xip    \t\t: Fail, linked for 0x%X\n", (int)p_fw_tag->addr_tag);
+    return false;
+  }
+
+  if (p_fw_tag->addr_tag == addr_fw)
+  {
+    if (p_fw_tag->tag_flash_type == FLASH_TAG_TYPE_LZ4)
+    {
+      logPrintf("fw type   \t\t: Fail\n");
+      return false;
+    }
+
+    addr_run = addr_fw;
+
+    if (slotVerifyFwCrc(addr_run) == true)
+    {
+      logPrintf("fw crc    \t\t: OK\n");
+    }
+    else
+    {
+      logPrintf("fw crc    \t\t: Fail\n");
+      return false;
+    }
   }
   else
   {
-    logPrintf("fw crc    \t\t: Fail\n");
-    return false;
+    slot_load_t load;
+    uint32_t offset;
+    uint32_t length;
+
+    pre_time = millis();
+    addr_run = p_fw_tag->addr_tag;
+
+    // Copy or decode in chunks and checksum each one while it is still
+    // fresh, instead of a second pass over the whole image.
+    //
+    slotLoadBegin(&load, p_fw_tag, addr_run, (uint8_t *)addr_fw, slot_size);
+    for (offset=0; offset<slot_size; offset+=length)
+    {
+      length = constrain(slot_size - offset, 0, SLOT_CHUNK_SIZE);
+
+      slotLoadUpdate(&load, offset + length);
+    }
+
+    logPrintf("copy_fw   \t\t: %dms, %dKB/%dKB (copy %dms, lz4 %dms, crc %dms)\n",
+              (int)(millis()-pre_time), (int)slot_size/1024, (int)load.length/1024,
+              (int)load.copy_us/1000, (int)load.lz4_us/1000, (int)load.crc_us/1000);
+
+    if (load.dst_done != load.length)
+    {
+      logPrintf("fw load   \t\t: Fail\n");
+      return false;
+    }
+
+    if (slotLoadVerify(&load) == true)
+    {
+      logPrintf("fw crc    \t\t: OK\n");
+    }
+    else
+    {
+      logPrintf("fw crc    \t\t: Fail\n");
+      return false;
+    }
   }
 
 
@@ -148,7 +407,6 @@ bool slotDelFromFlash(uint8_t slot_index)
 {
   bool ret;
   uint32_t addr_fw;
-  flash_tag_t  *p_fw_tag;
 
 
   logPrintf("\nslotRunFromFlash.. \n");
@@ -156,18 +414,13 @@ bool slotDelFromFlash(uint8_t slot_index)
   addr_fw  = QSPI_FW_ADDR(slot_index);
 
 
-  p_fw_tag = (flash_tag_t *)addr_fw;
-
-
-  if (p_fw_tag->magic_number != FLASH_MAGIC_NUMBER)
+  if (slotIsAvailable(slot_index) != true)
   {
     logPrintf("slot %d empty\r\n", slot_index);
     return false;
   }
 
-  qspiInit();
-  delay(10);
-
+  // Queued to the qspi thread, the launcher keeps reading the other slots
   if (flashErase(addr_fw, 1024) == true)
   {
     logPrintf("slot erase  \t\t: OK\n");
@@ -179,30 +432,44 @@ bool slotDelFromFlash(uint8_t slot_index)
     ret = false;
   }
 
-  qspiEnableMemoryMappedMode();
+  slotCatalogRefresh();
 
   return ret;
 }
 
 bool slotIsAvailable(uint8_t slot_index)
 {
+  bool ret = true;
   flash_tag_t  *p_fw_tag;
 
 
   p_fw_tag = (flash_tag_t *)QSPI_FW_ADDR(slot_index);
 
 
-  if (p_fw_tag->magic_number != FLASH_MAGIC_NUMBER)
+  if (qspiMapBegin() != true)
   {
     return false;
   }
 
-  return true;
+  if (p_fw_tag->magic_number != FLASH_MAGIC_NUMBER)
+  {
+    ret = false;
+  }
+
+  qspiMapEnd();
+
+  return ret;
 }
 
 bool slotRun(uint8_t slot_index)
 {
-  if (slotRunFromFolder(slot_index) != true)
+  bool ret;
+
+  slotFsLock();
+  ret = slotRunFromFolder(slot_index);
+  slotFsUnlock();
+
+  if (ret != true)
   {
     slotRunFromFlash(slot_index);
   }
@@ -257,6 +524,7 @@ bool slotGetFile(uint8_t slot_index, slot_file_t *p_file)
 
             p_file->tag = slot_fw_tag;
             p_file->file_size = f_size(&file);
+            p_file->file_stamp = ((uint32_t)fno.fdate << 16) | fno.ftime;
 
             ret = true;
           }
@@ -296,7 +564,6 @@ bool slotRunFromFolder(uint8_t slot_index)
 
   FRESULT res;
   FIL file;
-  UINT len;
 
   bool ret = false;
 
@@ -308,19 +575,54 @@ bool slotRunFromFolder(uint8_t slot_index)
   {
     p_fw_tag = &slot_file.tag;
 
+    // Only runs in place from its QSPI slot, left to slotRunFromFlash().
+    if (slotIsXip(p_fw_tag) == true)
+    {
+      logPrintf("fw xip    \t\t: 0x%X, run from flash\n", (int)p_fw_tag->addr_tag);
+      return false;
+    }
+
     addr_fw  = p_fw_tag->addr_tag;
     addr_run = p_fw_tag->addr_tag;
 
     res = f_open(&file, slot_file.file_name, FA_OPEN_EXISTING | FA_READ);
     if (res == FR_OK)
     {
+      slot_load_t load;
+      uint8_t *p_src;
+      bool is_loaded;
+
       slot_size = slot_file.file_size;
 
+      // An LZ4 image is read to a buffer and decoded from there to addr_tag.
+      //
+      p_src = (uint8_t *)addr_run;
+      if (p_fw_tag->magic_number == FLASH_MAGIC_NUMBER && p_fw_tag->tag_flash_type == FLASH_TAG_TYPE_LZ4)
+      {
+        p_src = (uint8_t *)SLOT_LZ4_BUF;
+
+        if (slot_size > SLOT_LZ4_BUF_SIZE)
+        {
+          logPrintf("fw size   \t\t: Fail\n");
+          f_close(&file);
+          return false;
+        }
+      }
+
       pre_time = millis();
-      f_read(&file, (void *)addr_run, slot_file.file_size, &len);
-      logPrintf("copy_fw   \t\t: %dms, %dKB\n", (int)(millis()-pre_time), (int)slot_size/1024);
+      slotLoadBegin(&load, p_fw_tag, addr_run, p_src, slot_size);
+      is_loaded = slotLoadFile(&load, &file);
+      logPrintf("copy_fw   \t\t: %dms, %dKB/%dKB (sd wait %dms, lz4 %dms, crc %dms)\n",
+                (int)(millis()-pre_time), (int)slot_size/1024, (int)load.length/1024,
+                (int)load.wait_us/1000, (int)load.lz4_us/1000, (int)load.crc_us/1000);
       f_close(&file);
 
+      if (is_loaded != true)
+      {
+        logPrintf("fw read   \t\t: Fail\n");
+        return false;
+      }
+
       p_fw_tag = (flash_tag_t *)addr_run;
 
       if (p_fw_tag->magic_number == 0xAAAA5555 && strcmp((char *)p_fw_tag->board_str, "OROCABOY3") == 0)
@@ -330,7 +632,7 @@ bool slotRunFromFolder(uint8_t slot_index)
 
       if (p_fw_tag->magic_number == 0x5555AAAA && strcmp((char *)p_fw_tag->board_str, "OROCABOY3") == 0)
       {
-        if (slotVerifyFwCrc(addr_run) == true)
+        if (slotLoadVerify(&load) == true)
         {
           logPrintf("fw crc    \t\t: OK\n");
           ret = true;
@@ -359,10 +661,25 @@ bool slotRunFromFolder(uint8_t slot_index)
 
 
 
+// An image linked with STM32H753II_QSPI.ld has its tag in a QSPI slot.
+//
+bool slotIsXip(flash_tag_t *p_tag)
+{
+  if (p_tag->tag_flash_type == FLASH_TAG_TYPE_XIP)
+  {
+    return true;
+  }
+
+  if (p_tag->addr_tag >= QSPI_FW_ADDR(0) && p_tag->addr_tag < QSPI_FW_ADDR(SLOT_MAX_CH))
+  {
+    return true;
+  }
+
+  return false;
+}
+
 bool slotVerifyFwCrc(uint32_t addr)
 {
-  uint32_t i;
-  uint8_t *p_data;
   uint16_t fw_crc;
   flash_tag_t  *p_fw_tag = (flash_tag_t *)addr;
 
@@ -373,25 +690,683 @@ bool slotVerifyFwCrc(uint32_t addr)
     return false;
   }
 
-  p_data = (uint8_t *)p_fw_tag->tag_flash_start;
+  fw_crc = checksumCrc16(0, (uint8_t *)p_fw_tag->tag_flash_start, p_fw_tag->tag_flash_length);
+
+  if (fw_crc == p_fw_tag->tag_flash_crc)
+  {
+    return true;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+void slotLoadBegin(slot_load_t *p_load, flash_tag_t *p_tag, uint32_t addr_run, uint8_t *p_src, uint32_t src_length)
+{
+  uint32_t length = src_length;
 
-  fw_crc = 0;
 
-  for (i=0; i<p_fw_tag->tag_flash_length; i++)
+  p_load->is_lz4 = false;
+  if (p_tag->magic_number == FLASH_MAGIC_NUMBER && p_tag->tag_flash_type == FLASH_TAG_TYPE_LZ4)
   {
-    utilUpdateCrc(&fw_crc, p_data[i]);
+    p_load->is_lz4 = true;
+    length = FLASH_TAG_SIZE + p_tag->tag_flash_length;
   }
 
-  if (fw_crc == p_fw_tag->tag_flash_crc)
+  p_load->p_dst      = (uint8_t *)addr_run;
+  p_load->length     = length;
+  p_load->dst_done   = 0;
+  p_load->p_src      = p_src;
+  p_load->src_length = src_length;
+  p_load->src_done   = 0;
+  p_load->is_err     = false;
+  p_load->crc_begin  = 0;
+  p_load->crc_end    = 0;
+  p_load->crc_done   = 0;
+  p_load->crc        = 0;
+  p_load->wait_us    = 0;
+  p_load->copy_us    = 0;
+  p_load->lz4_us     = 0;
+  p_load->crc_us     = 0;
+
+  // Only an image whose checked range lies inside the file is checksummed
+  // while loading. Anything else is left to slotVerifyFwCrc() afterwards.
+  //
+  if (p_tag->magic_number == FLASH_MAGIC_NUMBER &&
+      p_tag->tag_flash_start >= addr_run &&
+      p_tag->tag_flash_start - addr_run + p_tag->tag_flash_length <= length)
   {
-    return true;
+    p_load->crc_begin = p_tag->tag_flash_start - addr_run;
+    p_load->crc_end   = p_load->crc_begin + p_tag->tag_flash_length;
+    p_load->crc_done  = p_load->crc_begin;
+  }
+}
+
+// Read the whole file to p_load->p_src. The cluster runs of the file are
+// read with SD DMA straight to SDRAM, and the chunk before the one in flight
+// is decoded and checksummed meanwhile. A file with too many fragments for the fast seek
+// table is read with f_read in chunks instead.
+//
+bool slotLoadFile(slot_load_t *p_load, FIL *p_file)
+{
+  FATFS *fs = p_file->obj.fs;
+  DWORD clmt[SLOT_CLMT_MAX];
+  DWORD *p_clmt;
+  UINT len;
+  uint32_t offset = 0;
+  uint32_t length;
+  uint32_t sector = 0;
+  uint32_t sector_cnt = 0;
+  uint32_t blocks;
+  uint32_t pre_time_us;
+  bool ret;
+
+
+  clmt[0] = SLOT_CLMT_MAX;
+  p_file->cltbl = clmt;
+
+  if (f_lseek(p_file, CREATE_LINKMAP) == FR_OK)
+  {
+    p_clmt = &clmt[1];
+    length = p_load->src_length & ~(_MAX_SS - 1);
+
+    while (offset < length)
+    {
+      if (sector_cnt == 0)
+      {
+        if (p_clmt[0] == 0)
+        {
+          return false;
+        }
+        sector     = fs->database + (p_clmt[1] - 2) * fs->csize;
+        sector_cnt = p_clmt[0] * fs->csize;
+        p_clmt += 2;
+      }
+
+      blocks = constrain(sector_cnt, 0, SLOT_CHUNK_SIZE/_MAX_SS);
+      blocks = constrain(blocks, 0, (length - offset)/_MAX_SS);
+
+      if (sdReadBlocksStart(sector, &p_load->p_src[offset], blocks) != true)
+      {
+        return false;
+      }
+
+      slotLoadUpdate(p_load, offset);
+
+      pre_time_us = micros();
+      ret = sdReadBlocksWait(SLOT_SD_TIMEOUT);
+      p_load->wait_us += micros()-pre_time_us;
+      if (ret != true)
+      {
+        return false;
+      }
+
+      offset     += blocks * _MAX_SS;
+      sector     += blocks;
+      sector_cnt -= blocks;
+    }
+
+    // The partial last sector goes through FatFs, so nothing is written past the image.
+    //
+    if (offset < p_load->src_length)
+    {
+      if (f_lseek(p_file, offset) != FR_OK ||
+          f_read(p_file, &p_load->p_src[offset], p_load->src_length - offset, &len) != FR_OK)
+      {
+        return false;
+      }
+      offset += len;
+    }
+  }
+  else
+  {
+    p_file->cltbl = NULL;
+
+    while (offset < p_load->src_length)
+    {
+      length = constrain(p_load->src_length - offset, 0, SLOT_CHUNK_SIZE);
+
+      pre_time_us = micros();
+      if (f_read(p_file, &p_load->p_src[offset], length, &len) != FR_OK || len != length)
+      {
+        return false;
+      }
+      p_load->wait_us += micros()-pre_time_us;
+
+      offset += len;
+      slotLoadUpdate(p_load, offset);
+    }
+  }
+
+  slotLoadUpdate(p_load, offset);
+
+  return offset == p_load->src_length && p_load->dst_done == p_load->length;
+}
+
+// Bring the image up to date with the first src_end bytes of slot data.
+//
+void slotLoadUpdate(slot_load_t *p_load, uint32_t src_end)
+{
+  uint32_t pre_time_us;
+
+
+  if (p_load->is_lz4 == true)
+  {
+    slotLoadLz4(p_load, src_end);
   }
   else
+  {
+    src_end = constrain(src_end, 0, p_load->length);
+
+    if (src_end > p_load->dst_done && p_load->p_src != p_load->p_dst)
+    {
+      pre_time_us = micros();
+      memcpy(&p_load->p_dst[p_load->dst_done], &p_load->p_src[p_load->dst_done], src_end - p_load->dst_done);
+      p_load->copy_us += micros()-pre_time_us;
+    }
+    p_load->src_done = src_end;
+    p_load->dst_done = src_end;
+  }
+
+  slotLoadCrc(p_load);
+}
+
+// The tag is stored as is, then every complete block that has arrived is
+// decoded. Each block but the last one gives LZ4_BLOCK_SIZE bytes.
+//
+void slotLoadLz4(slot_load_t *p_load, uint32_t src_end)
+{
+  uint32_t pre_time_us;
+  uint32_t header;
+  uint32_t length;
+  uint32_t out_len;
+  int32_t  ret;
+
+
+  pre_time_us = micros();
+
+  if (p_load->src_done == 0 && src_end >= FLASH_TAG_SIZE)
+  {
+    memcpy(p_load->p_dst, p_load->p_src, FLASH_TAG_SIZE);
+    p_load->src_done = FLASH_TAG_SIZE;
+    p_load->dst_done = FLASH_TAG_SIZE;
+  }
+
+  while (p_load->src_done > 0 &&
+         p_load->is_err == false &&
+         p_load->dst_done < p_load->length &&
+         src_end - p_load->src_done >= LZ4_BLOCK_HEADER)
+  {
+    header = utilConvert8ToU32(&p_load->p_src[p_load->src_done]);
+    length = header & ~LZ4_BLOCK_RAW;
+
+    if (length > src_end - p_load->src_done - LZ4_BLOCK_HEADER)
+    {
+      break;
+    }
+
+    out_len = constrain(p_load->length - p_load->dst_done, 0, LZ4_BLOCK_SIZE);
+
+    if (header & LZ4_BLOCK_RAW)
+    {
+      ret = -1;
+      if (length == out_len)
+      {
+        memcpy(&p_load->p_dst[p_load->dst_done], &p_load->p_src[p_load->src_done + LZ4_BLOCK_HEADER], length);
+        ret = length;
+      }
+    }
+    else
+    {
+      ret = lz4DecompressBlock(&p_load->p_src[p_load->src_done + LZ4_BLOCK_HEADER], length,
+                               &p_load->p_dst[p_load->dst_done], out_len);
+    }
+
+    if (ret != (int32_t)out_len)
+    {
+      p_load->is_err = true;
+      break;
+    }
+
+    p_load->src_done += LZ4_BLOCK_HEADER + length;
+    p_load->dst_done += out_len;
+  }
+
+  p_load->lz4_us += micros()-pre_time_us;
+}
+
+// Checksum what is in place and not checksummed yet.
+//
+void slotLoadCrc(slot_load_t *p_load)
+{
+  uint32_t pre_time_us;
+  uint32_t end;
+
+
+  end = constrain(p_load->dst_done, 0, p_load->crc_end);
+
+  if (end > p_load->crc_done)
+  {
+    pre_time_us = micros();
+    p_load->crc = checksumCrc16(p_load->crc,
+                                &p_load->p_dst[p_load->crc_done],
+                                end - p_load->crc_done);
+    p_load->crc_us += micros()-pre_time_us;
+
+    p_load->crc_done = end;
+  }
+}
+
+bool slotLoadVerify(slot_load_t *p_load)
+{
+  if (p_load->crc_end == 0)
+  {
+    return slotVerifyFwCrc((uint32_t)p_load->p_dst);
+  }
+
+  return p_load->crc == ((flash_tag_t *)p_load->p_dst)->tag_flash_crc;
+}
+
+void slotCatLock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (cat_lock != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    osMutexWait(cat_lock, osWaitForever);
+  }
+#endif
+}
+
+void slotCatUnlock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (cat_lock != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    osMutexRelease(cat_lock);
+  }
+#endif
+}
+
+// FatFs is built without _FS_REENTRANT, the slot thread and a launch from
+// the GUI take turns on the card.
+//
+void slotFsLock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (fs_lock != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    osMutexWait(fs_lock, osWaitForever);
+  }
+#endif
+}
+
+void slotFsUnlock(void)
+{
+#ifdef _USE_HW_RTOS
+  if (fs_lock != NULL && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+  {
+    osMutexRelease(fs_lock);
+  }
+#endif
+}
+
+void slotCatLoadFlash(void)
+{
+  uint8_t i;
+
+  memset(&slot_cat, 0, sizeof(slot_cat_t));
+
+  if (qspiMapBegin() == true)
+  {
+    memcpy(&slot_cat, (void *)QSPI_CAT_ADDR, sizeof(slot_cat_t));
+    qspiMapEnd();
+  }
+
+  if (slotCatIsValid(&slot_cat) == true)
+  {
+    is_cat_valid = true;
+    logPrintf("slot catalog \t\t: QSPI\n");
+  }
+  else
+  {
+    // Nothing saved yet, the flash slots alone until the first check.
+    memset(&slot_cat, 0, sizeof(slot_cat_t));
+    for (i=0; i<SLOT_MAX_CH; i++)
+    {
+      slotCatScan(i, &slot_cat.entry[i], false);
+    }
+    logPrintf("slot catalog \t\t: Flash\n");
+  }
+
+  slot_cat_ver++;
+}
+
+bool slotCatIsValid(slot_cat_t *p_cat)
+{
+  if (p_cat->magic   != SLOT_CAT_MAGIC   ||
+      p_cat->version != SLOT_CAT_VERSION ||
+      p_cat->length  != sizeof(slot_cat_t))
+  {
+    return false;
+  }
+
+  if (checksumCrc32(0, (uint8_t *)p_cat->entry, sizeof(p_cat->entry)) != p_cat->crc)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+void slotCatSeal(slot_cat_t *p_cat)
+{
+  p_cat->magic   = SLOT_CAT_MAGIC;
+  p_cat->version = SLOT_CAT_VERSION;
+  p_cat->length  = sizeof(slot_cat_t);
+  p_cat->crc     = checksumCrc32(0, (uint8_t *)p_cat->entry, sizeof(p_cat->entry));
+}
+
+// Whether the entry still holds without reading any file : the tag in the
+// QSPI slot, the time of /slot/N and the time and size of its file.
+//
+bool slotCatIsSame(uint8_t slot_index, slot_cat_entry_t *p_entry, bool is_sd)
+{
+  FILINFO fno;
+  flash_tag_t *p_fw_tag;
+  uint32_t flash_sum = 0;
+
+
+  p_fw_tag = (flash_tag_t *)QSPI_FW_ADDR(slot_index);
+
+  if (qspiMapBegin() != true)
+  {
+    return false;
+  }
+  if (p_fw_tag->magic_number == FLASH_MAGIC_NUMBER)
+  {
+    flash_sum = checksumCrc32(0, (uint8_t *)p_fw_tag, sizeof(flash_tag_t));
+  }
+  qspiMapEnd();
+
+  if (flash_sum != p_entry->flash_sum)
+  {
+    return false;
+  }
+
+  if (is_sd != true)
+  {
+    return p_entry->flags == 0;
+  }
+
+  sprintf(slot_path, "/slot/%d", slot_index);
+
+  if (f_stat(slot_path, &fno) != FR_OK || (fno.fattrib & AM_DIR) == 0)
+  {
+    return (p_entry->flags & SLOT_CAT_HAS_DIR) == 0;
+  }
+
+  if ((p_entry->flags & SLOT_CAT_HAS_DIR) == 0 ||
+      p_entry->dir_stamp != (((uint32_t)fno.fdate << 16) | fno.ftime))
+  {
+    return false;
+  }
+
+  // A folder without an image is scanned again, that costs one readdir.
+  if ((p_entry->flags & SLOT_CAT_HAS_FILE) == 0 || p_entry->file_name[0] == 0)
+  {
+    return false;
+  }
+
+  if (f_stat(p_entry->file_name, &fno) != FR_OK)
   {
     return false;
   }
+
+  if (p_entry->file_stamp != (((uint32_t)fno.fdate << 16) | fno.ftime) ||
+      p_entry->file_size  != fno.fsize)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+void slotCatScan(uint8_t slot_index, slot_cat_entry_t *p_entry, bool is_sd)
+{
+  FILINFO fno;
+  slot_file_t slot_file;
+
+
+  memset(p_entry, 0, sizeof(slot_cat_entry_t));
+
+  if (is_sd == true)
+  {
+    sprintf(slot_path, "/slot/%d", slot_index);
+
+    if (f_stat(slot_path, &fno) == FR_OK && (fno.fattrib & AM_DIR) != 0)
+    {
+      p_entry->flags    |= SLOT_CAT_HAS_DIR;
+      p_entry->dir_stamp = ((uint32_t)fno.fdate << 16) | fno.ftime;
+
+      if (slotGetFile(slot_index, &slot_file) == true)
+      {
+        p_entry->flags     |= SLOT_CAT_HAS_FILE;
+        p_entry->file_stamp = slot_file.file_stamp;
+        p_entry->file_size  = slot_file.file_size;
+        if (strlen(slot_file.file_name) < sizeof(p_entry->file_name))
+        {
+          strcpy(p_entry->file_name, slot_file.file_name);
+        }
+        p_entry->tag = slot_file.tag;
+        p_entry->src = SLOT_CAT_FOLDER;
+      }
+    }
+  }
+
+  slotCatScanFlash(slot_index, p_entry);
+}
+
+// Only the QSPI side of an entry, a folder entry keeps its tag.
+//
+void slotCatScanFlash(uint8_t slot_index, slot_cat_entry_t *p_entry)
+{
+  flash_tag_t *p_fw_tag;
+
+
+  p_entry->flash_sum = 0;
+
+  if (p_entry->src == SLOT_CAT_FLASH)
+  {
+    p_entry->src = SLOT_CAT_NONE;
+    memset(&p_entry->tag, 0, sizeof(flash_tag_t));
+  }
+
+  p_fw_tag = (flash_tag_t *)QSPI_FW_ADDR(slot_index);
+
+  if (qspiMapBegin() == true)
+  {
+    if (p_fw_tag->magic_number == FLASH_MAGIC_NUMBER)
+    {
+      p_entry->flash_sum = checksumCrc32(0, (uint8_t *)p_fw_tag, sizeof(flash_tag_t));
+
+      if (p_entry->src == SLOT_CAT_NONE)
+      {
+        p_entry->tag = *p_fw_tag;
+        p_entry->src = SLOT_CAT_FLASH;
+      }
+    }
+    qspiMapEnd();
+  }
+}
+
+bool slotCatReadFile(slot_cat_t *p_cat)
+{
+  FIL file;
+  UINT len = 0;
+  bool ret = false;
+
+
+  if (f_open(&file, SLOT_CAT_FILE, FA_OPEN_EXISTING | FA_READ) == FR_OK)
+  {
+    f_read(&file, (void *)p_cat, sizeof(slot_cat_t), &len);
+    f_close(&file);
+
+    if (len == sizeof(slot_cat_t) && slotCatIsValid(p_cat) == true)
+    {
+      ret = true;
+    }
+  }
+
+  return ret;
+}
+
+void slotCatSave(slot_cat_t *p_cat, bool is_sd)
+{
+  FIL file;
+  UINT len;
+  bool is_same = false;
+
+
+  if (is_sd == true && f_open(&file, SLOT_CAT_FILE, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK)
+  {
+    f_write(&file, (void *)p_cat, sizeof(slot_cat_t), &len);
+    f_close(&file);
+  }
+
+  // Erased and programmed by the qspi thread, and only when it differs.
+  if (qspiMapBegin() == true)
+  {
+    is_same = memcmp((void *)QSPI_CAT_ADDR, p_cat, sizeof(slot_cat_t)) == 0 ? true : false;
+    qspiMapEnd();
+  }
+
+  if (is_same != true)
+  {
+    if (flashErase(QSPI_CAT_ADDR, sizeof(slot_cat_t)) != true ||
+        flashWrite(QSPI_CAT_ADDR, (uint8_t *)p_cat, sizeof(slot_cat_t)) != true)
+    {
+      logPrintf("slot catalog \t\t: QSPI Fail\n");
+    }
+  }
+}
+
+// Check every slot and scan the ones that changed. The catalog is saved
+// only while a card is in, so taking it out and back wears nothing.
+//
+// In USB_MSC_MODE the host owns the FAT volume : nothing is read from or
+// written to the card, only the QSPI side is checked and mirrored, and
+// every slot is scanned again once MSC is gone.
+//
+void slotCatUpdate(void)
+{
+  uint8_t  i;
+  slot_cat_entry_t entry;
+  uint32_t pre_time;
+  bool is_sd;
+  bool is_msc;
+  bool is_rescan = false;
+  bool is_changed = false;
+
+
+  pre_time = millis();
+  is_msc   = usbGetMode() == USB_MSC_MODE ? true : false;
+  is_sd    = sdIsDetected() == true && is_msc != true ? true : false;
+
+  if (is_msc == true)
+  {
+    is_cat_msc = true;
+  }
+  else if (is_cat_msc == true)
+  {
+    is_cat_msc = false;
+    is_rescan  = true;
+  }
+
+  slotFsLock();
+
+  if (is_cat_loaded != true && is_sd == true)
+  {
+    is_cat_loaded = true;
+
+    // Nothing in QSPI, the index on the card is the next best start.
+    if (is_cat_valid != true && slotCatReadFile(&slot_cat_work) == true)
+    {
+      slotCatLock();
+      slot_cat = slot_cat_work;
+      slot_cat_ver++;
+      slotCatUnlock();
+
+      logPrintf("slot catalog \t\t: SD\n");
+    }
+  }
+
+  slotCatLock();
+  slot_cat_work = slot_cat;
+  slotCatUnlock();
+
+  for (i=0; i<SLOT_MAX_CH; i++)
+  {
+    if (is_msc == true)
+    {
+      entry = slot_cat_work.entry[i];
+      slotCatScanFlash(i, &entry);
+    }
+    else if (is_rescan == true || slotCatIsSame(i, &slot_cat_work.entry[i], is_sd) != true)
+    {
+      slotCatScan(i, &entry, is_sd);
+      cat_scan_cnt++;
+    }
+    else
+    {
+      continue;
+    }
+
+    if (memcmp(&entry, &slot_cat_work.entry[i], sizeof(slot_cat_entry_t)) != 0)
+    {
+      slot_cat_work.entry[i] = entry;
+      is_changed = true;
+    }
+  }
+
+  if (is_changed == true || (is_sd == true && is_cat_valid != true))
+  {
+    slotCatSeal(&slot_cat_work);
+
+    slotCatLock();
+    slot_cat = slot_cat_work;
+    slot_cat_ver++;
+    slotCatUnlock();
+
+    if (is_sd == true || is_msc == true)
+    {
+      slotCatSave(&slot_cat_work, is_sd);
+    }
+    if (is_sd == true)
+    {
+      is_cat_valid = true;
+    }
+  }
+
+  slotFsUnlock();
+
+  cat_check_ms = millis() - pre_time;
+  cat_check_cnt++;
 }
 
+#ifdef _USE_HW_RTOS
+static void slotThread(void const *argument)
+{
+  UNUSED(argument);
+
+  while(1)
+  {
+    osSemaphoreWait(sem_cat, SLOT_CAT_PERIOD);
+    slotCatUpdate();
+  }
+}
+#endif
+
 void slotJumpToFw(uint32_t addr)
 {
   void (**jump_func)(void) = (void (**)(void))(addr + 4);
@@ -426,12 +1401,18 @@ void slotCmdif(void)
   uint8_t ch;
   uint32_t i;
   flash_tag_t  *p_fw_tag;
+  slot_cat_entry_t entry;
 
 
   if (cmdifGetParamCnt() == 1)
   {
     if(cmdifHasString("list", 0) == true)
     {
+      if (qspiMapBegin() != true)
+      {
+        cmdifPrintf("qspi map fail\r\n");
+        return;
+      }
       for (i=0; i<HW_SLOT_MAX_CH; i++)
       {
         p_fw_tag = (flash_tag_t *)QSPI_FW_ADDR(i);
@@ -445,8 +1426,31 @@ void slotCmdif(void)
           cmdifPrintf("%02d 0x%X : \r\n", i, 0x90000000+0x200000*i);
         }
       }
+      qspiMapEnd();
       cmdifPrintf("\r");
     }
+    else if(cmdifHasString("cat", 0) == true)
+    {
+      const char *src_str[] = {"    ", "sd  ", "qspi"};
+
+      for (i=0; i<HW_SLOT_MAX_CH; i++)
+      {
+        slotCatLock();
+        entry = slot_cat.entry[i];
+        slotCatUnlock();
+
+        if (entry.src != SLOT_CAT_NONE)
+        {
+          cmdifPrintf("%02d %s : %s \t%s\r\n", i, src_str[entry.src], entry.tag.name_str, entry.tag.version_str);
+        }
+        else
+        {
+          cmdifPrintf("%02d %s : \r\n", i, src_str[entry.src]);
+        }
+      }
+      cmdifPrintf("ver %d, check %dms, checks %d, scans %d, first query %dms\r\n",
+                  (int)slot_cat_ver, (int)cat_check_ms, (int)cat_check_cnt, (int)cat_scan_cnt, (int)cat_first_ms);
+    }
     else
     {
       ret = false;
@@ -480,6 +1484,7 @@ void slotCmdif(void)
   if (ret == false)
   {
     cmdifPrintf( "slot list\n");
+    cmdifPrintf( "slot cat\n");
     cmdifPrintf( "slot run 0~%d\n", HW_SLOT_MAX_CH-1);
     cmdifPrintf( "slot del 0~%d\n", HW_SLOT_MAX_CH-1);
   }
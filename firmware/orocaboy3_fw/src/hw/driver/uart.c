@@ -25,12 +25,12 @@
   _DEF_UART3
       USART6
         - RX PC7: DMA1_Stream1
-        - TX PC6:
+        - TX PC6: DMA1_Stream3
 
   _DEF_UART4
       UART5
         - RX PB12: DMA1_Stream2
-        - TX PB13:
+        - TX PB13: DMA1_Stream4
 
 */
 
@@ -48,6 +48,7 @@
 
 
 #define UART_RX_BUF_LENGTH      (1024+7)
+#define UART_RX_ESP_BUF_LENGTH  (8*1024)    // 90ms at 921600 baud
 
 
 
@@ -79,6 +80,8 @@ typedef struct
 
 static __attribute__((section(".sram_d3")))  uart_t uart_tbl[UART_MAX_CH];
 
+static __attribute__((section(".sram_d3")))  uint8_t uart_rx_esp_buf[2][UART_RX_ESP_BUF_LENGTH];
+
 
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart5;
@@ -86,6 +89,8 @@ UART_HandleTypeDef huart6;
 DMA_HandleTypeDef hdma_usart1_rx;
 DMA_HandleTypeDef hdma_uart5_rx;
 DMA_HandleTypeDef hdma_usart6_rx;
+DMA_HandleTypeDef hdma_uart5_tx;
+DMA_HandleTypeDef hdma_usart6_tx;
 
 
 void uartStartRx(uint8_t channel);
@@ -105,6 +110,7 @@ bool uartInit(void)
     uart_tbl[i].tx_mode  = UART_MODE_POLLING;
     uart_tbl[i].tx_done  = false;
     uart_tbl[i].txDoneISR = NULL;
+    uart_tbl[i].hdma_tx  = NULL;
     uart_tbl[i].err_cnt  = 0;
     uart_tbl[i].hw_driver = UART_HW_NONE;
   }
@@ -184,6 +190,7 @@ bool uartOpen(uint8_t channel, uint32_t baud)
       p_uart->tx_mode   = UART_MODE_POLLING;
 
       p_uart->hdma_rx = &hdma_usart6_rx;
+      p_uart->hdma_tx = &hdma_usart6_tx;
       p_uart->handle =  &huart6;
       p_uart->handle->Instance = USART6;
 
@@ -200,7 +207,7 @@ bool uartOpen(uint8_t channel, uint32_t baud)
       p_uart->handle->AdvancedInit.AutoBaudRateEnable = UART_ADVFEATURE_AUTOBAUDRATE_DISABLE;
 
 
-      qbufferCreate(&p_uart->qbuffer_rx, p_uart->rx_buf, UART_RX_BUF_LENGTH);
+      qbufferCreate(&p_uart->qbuffer_rx, uart_rx_esp_buf[0], UART_RX_ESP_BUF_LENGTH);
 
       HAL_UART_DeInit(p_uart->handle);
       HAL_UART_Init(p_uart->handle);
@@ -220,6 +227,7 @@ bool uartOpen(uint8_t channel, uint32_t baud)
       p_uart->tx_mode   = UART_MODE_POLLING;
 
       p_uart->hdma_rx = &hdma_uart5_rx;
+      p_uart->hdma_tx = &hdma_uart5_tx;
       p_uart->handle =  &huart5;
       p_uart->handle->Instance = UART5;
 
@@ -236,7 +244,7 @@ bool uartOpen(uint8_t channel, uint32_t baud)
       p_uart->handle->AdvancedInit.AutoBaudRateEnable = UART_ADVFEATURE_AUTOBAUDRATE_DISABLE;
 
 
-      qbufferCreate(&p_uart->qbuffer_rx, p_uart->rx_buf, UART_RX_BUF_LENGTH);
+      qbufferCreate(&p_uart->qbuffer_rx, uart_rx_esp_buf[1], UART_RX_ESP_BUF_LENGTH);
 
       HAL_UART_DeInit(p_uart->handle);
       HAL_UART_Init(p_uart->handle);
@@ -348,6 +356,81 @@ void uartFlush(uint8_t channel)
   }
 }
 
+// Contiguous received bytes from the DMA ring, they stay in place until
+// uartReadSkip().
+//
+uint32_t uartReadSpan(uint8_t channel, uint8_t **pp_data)
+{
+  uint32_t ptr_in;
+  uart_t *p_uart = &uart_tbl[channel];
+  qbuffer_t *p_q = &p_uart->qbuffer_rx;
+
+
+  if (channel >= UART_MAX_CH || p_uart->rx_mode != UART_MODE_DMA)
+  {
+    return 0;
+  }
+
+  ptr_in = p_q->length - ((DMA_Stream_TypeDef *)p_uart->hdma_rx->Instance)->NDTR;
+  if (ptr_in >= p_q->length)
+  {
+    ptr_in = 0;
+  }
+  p_q->ptr_in = ptr_in;
+
+  *pp_data = &p_q->p_buf[p_q->ptr_out];
+
+  if (ptr_in >= p_q->ptr_out)
+  {
+    return ptr_in - p_q->ptr_out;
+  }
+  else
+  {
+    return p_q->length - p_q->ptr_out;
+  }
+}
+
+void uartReadSkip(uint8_t channel, uint32_t length)
+{
+  qbuffer_t *p_q = &uart_tbl[channel].qbuffer_rx;
+
+  p_q->ptr_out = (p_q->ptr_out + length) % p_q->length;
+}
+
+// Starts a DMA transfer and returns, p_data has to stay valid until the
+// txDoneISR of the channel is called.
+//
+bool uartWriteDma(uint8_t channel, uint8_t *p_data, uint32_t length)
+{
+  uart_t *p_uart = &uart_tbl[channel];
+
+
+  if (channel >= UART_MAX_CH || p_uart->is_open != true || p_uart->hdma_tx == NULL)
+  {
+    return false;
+  }
+
+  p_uart->tx_done = false;
+
+  if (HAL_UART_Transmit_DMA(p_uart->handle, p_data, length) != HAL_OK)
+  {
+    p_uart->tx_done = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool uartIsTxBusy(uint8_t channel)
+{
+  if (channel >= UART_MAX_CH || uart_tbl[channel].hw_driver != UART_HW_STM32_UART)
+  {
+    return false;
+  }
+
+  return uart_tbl[channel].handle->gState != HAL_UART_STATE_READY;
+}
+
 void uartPutch(uint8_t channel, uint8_t ch)
 {
   uartWrite(channel, &ch, 1 );
@@ -479,6 +562,20 @@ void uartResetErrCnt(uint8_t channel)
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle)
 {
+  uint8_t i;
+
+  for (i=0; i<UART_MAX_CH; i++)
+  {
+    if (uart_tbl[i].hw_driver == UART_HW_STM32_UART && uart_tbl[i].handle == UartHandle)
+    {
+      uart_tbl[i].tx_done = true;
+
+      if (uart_tbl[i].txDoneISR != NULL)
+      {
+        uart_tbl[i].txDoneISR();
+      }
+    }
+  }
 }
 
 
@@ -494,6 +591,10 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *UartHandle)
   {
     uartErrHandler(_DEF_UART3);
   }
+  if (UartHandle->Instance == uart_tbl[_DEF_UART4].handle->Instance)
+  {
+    uartErrHandler(_DEF_UART4);
+  }
 }
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
@@ -514,6 +615,24 @@ void DMA1_Stream0_IRQHandler(void)
   HAL_DMA_IRQHandler(&hdma_usart1_rx);
 }
 
+void USART6_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&huart6);
+}
+void DMA1_Stream3_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_usart6_tx);
+}
+
+void UART5_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&huart5);
+}
+void DMA1_Stream4_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_uart5_tx);
+}
+
 
 
 void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
@@ -607,6 +726,30 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     }
 
     __HAL_LINKDMA(uartHandle,hdmarx,hdma_usart6_rx);
+
+    /* USART6_TX Init */
+    hdma_usart6_tx.Instance = DMA1_Stream3;
+    hdma_usart6_tx.Init.Request = DMA_REQUEST_USART6_TX;
+    hdma_usart6_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart6_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart6_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart6_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart6_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart6_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart6_tx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_usart6_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_usart6_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmatx,hdma_usart6_tx);
+
+    /* Same priority as the USB, the vcp bridge runs in both */
+    HAL_NVIC_SetPriority(DMA1_Stream3_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream3_IRQn);
+    HAL_NVIC_SetPriority(USART6_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(USART6_IRQn);
   }
   else   if(uartHandle->Instance==UART5)
   {
@@ -643,6 +786,29 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     }
 
     __HAL_LINKDMA(uartHandle,hdmarx,hdma_uart5_rx);
+
+    /* UART5_TX Init */
+    hdma_uart5_tx.Instance = DMA1_Stream4;
+    hdma_uart5_tx.Init.Request = DMA_REQUEST_UART5_TX;
+    hdma_uart5_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_uart5_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_uart5_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_uart5_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_uart5_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_uart5_tx.Init.Mode = DMA_NORMAL;
+    hdma_uart5_tx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_uart5_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_uart5_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(uartHandle,hdmatx,hdma_uart5_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Stream4_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream4_IRQn);
+    HAL_NVIC_SetPriority(UART5_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(UART5_IRQn);
   }
 }
 
@@ -685,6 +851,10 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 
     /* USART6 DMA DeInit */
     HAL_DMA_DeInit(uartHandle->hdmarx);
+    HAL_DMA_DeInit(uartHandle->hdmatx);
+
+    HAL_NVIC_DisableIRQ(USART6_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Stream3_IRQn);
   }
   else   if(uartHandle->Instance==UART5)
   {
@@ -699,5 +869,9 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 
     /* UART5 DMA DeInit */
     HAL_DMA_DeInit(uartHandle->hdmarx);
+    HAL_DMA_DeInit(uartHandle->hdmatx);
+
+    HAL_NVIC_DisableIRQ(UART5_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Stream4_IRQn);
   }
 }
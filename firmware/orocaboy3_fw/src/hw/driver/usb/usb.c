@@ -7,6 +7,7 @@
 
 
 #include "usb.h"
+#include "cmdif.h"
 
 
 
@@ -24,6 +25,12 @@ extern USBD_DescriptorsTypeDef MSC_Desc;
 extern USBD_StorageTypeDef USBD_DISK_fops;
 
 
+#if HW_USE_CMDIF_USB == 1
+static void usbCmdifInit(void);
+static void usbCmdif(void);
+#endif
+
+
 bool usbInit(void)
 {
   GPIO_InitTypeDef  GPIO_InitStruct;
@@ -43,6 +50,9 @@ bool usbInit(void)
   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_11, GPIO_PIN_RESET);
   HAL_GPIO_WritePin(GPIOA, GPIO_PIN_12, GPIO_PIN_RESET);
 
+#if HW_USE_CMDIF_USB == 1
+  usbCmdifInit();
+#endif
 
   return true;
 }
@@ -105,7 +115,21 @@ void usbDeInit(void)
   if (is_init == true)
   {
     USBD_DeInit(&USBD_Device);
+    is_init = false;
   }
+  is_usb_mode = USB_NON_MODE;
+}
+
+// Runs the USB interrupt once more, so MSC can go on when the storage
+// finishes between endpoint events.
+//
+void usbPendIrq(void)
+{
+#ifdef USE_USB_FS
+  HAL_NVIC_SetPendingIRQ(OTG_FS_IRQn);
+#else
+  HAL_NVIC_SetPendingIRQ(OTG_HS_IRQn);
+#endif
 }
 
 #ifdef USE_USB_FS
@@ -115,4 +139,69 @@ void OTG_HS_IRQHandler(void)
 #endif
 {
   HAL_PCD_IRQHandler(&hpcd);
+
+#if HW_USE_MSC == 1
+  if (is_usb_mode == USB_MSC_MODE)
+  {
+    MSC_BOT_Process(&USBD_Device);
+  }
+#endif
+}
+
+
+
+#if HW_USE_CMDIF_USB == 1
+void usbCmdifInit(void)
+{
+  if (cmdifIsInit() == false)
+  {
+    cmdifInit();
+  }
+  cmdifAdd("usb", usbCmdif);
+}
+
+static void usbCmdifPrintStat(const char *name, uint32_t bytes, uint32_t cnt, uint32_t time_us)
+{
+  uint32_t kb_per_s = 0;
+
+
+  if (time_us > 0)
+  {
+    kb_per_s = (uint32_t)((uint64_t)bytes * 1000 / time_us);
+  }
+
+  cmdifPrintf("%s : %d KB, %d cmds, %d.%02d MB/s\n", name, bytes/1024, cnt, kb_per_s/1000, (kb_per_s%1000)/10);
+}
+
+void usbCmdif(void)
+{
+  bool ret = true;
+
+
+  if (cmdifGetParamCnt() >= 1 && cmdifHasString("msc", 0) == true)
+  {
+    USBD_SCSI_StatTypeDef stat;
+
+
+    if (cmdifGetParamCnt() == 2 && cmdifHasString("clear", 1) == true)
+    {
+      SCSI_ClearStat();
+    }
+
+    SCSI_GetStat(&stat);
+
+    cmdifPrintf("usb mode : %s\n", is_usb_mode == USB_MSC_MODE ? "MSC" : "CDC");
+    usbCmdifPrintStat("read ", stat.rd_bytes, stat.rd_cnt, stat.rd_us);
+    usbCmdifPrintStat("write", stat.wr_bytes, stat.wr_cnt, stat.wr_us);
+  }
+  else
+  {
+    ret = false;
+  }
+
+  if (ret == false)
+  {
+    cmdifPrintf( "usb msc [clear]\n");
+  }
 }
+#endif
@@ -46,6 +46,7 @@ bool usbBegin(enum UsbMode usb_mode);
 void usbDeInit(void);
 
 enum UsbMode usbGetMode(void);
+void usbPendIrq(void);
 
 
 #endif
@@ -51,6 +51,7 @@
 #include "wdg.h"
 #include "reset.h"
 #include "esp32.h"
+#include "uart.h"
 
 const char *JUMP_BOOT_STR = "BOOT 5555AAAA";
 
@@ -60,6 +61,10 @@ const char *JUMP_BOOT_STR = "BOOT 5555AAAA";
 #define APP_RX_DATA_SIZE  2048
 #define APP_TX_DATA_SIZE  2048
 
+#define BRIDGE_OUT_SIZE   (8*1024)
+#define BRIDGE_OUT_PACKET CDC_DATA_HS_MAX_PACKET_SIZE
+#define BRIDGE_NONE       0xFF
+
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
@@ -97,6 +102,26 @@ static bool is_reopen = false;
 
 volatile bool usb_rx_full = false;
 
+
+// vcp bridge, CDC data goes straight to and from a uart.
+//
+// IN  : spans of the uart rx dma ring are sent as they are.
+// OUT : packets are received in bridge_out_buf and sent with the uart tx dma.
+//       bridge_out_buf is used as a bip buffer, when the space at the end is
+//       smaller than a packet the writer goes back to 0 and bridge_out_end
+//       marks where the data behind bridge_out_rd stops.
+//
+static volatile uint8_t  bridge_ch = BRIDGE_NONE;
+static uint8_t           bridge_out_buf[BRIDGE_OUT_SIZE];
+static volatile uint32_t bridge_out_wr   = 0;
+static volatile uint32_t bridge_out_rd   = 0;
+static volatile uint32_t bridge_out_end  = 0;
+static volatile bool     bridge_out_wrap = false;
+static volatile uint32_t bridge_out_dma  = 0;
+static volatile uint32_t bridge_in_len   = 0;
+static volatile uint32_t bridge_in_err   = 0;
+static vcp_bridge_stat_t bridge_stat;
+
 /* USB handler declaration */
 extern USBD_HandleTypeDef  USBD_Device;
 
@@ -109,6 +134,12 @@ static uint8_t CDC_Itf_TxRead( void );
 
 void CDC_Itf_TxISR(void *arg);
 
+static void CDC_Itf_BridgeISR(void);
+static void CDC_Itf_BridgeReceive(uint8_t *Buf, uint32_t Len);
+static void CDC_Itf_BridgeArm(void);
+static void CDC_Itf_BridgeKick(void);
+static void CDC_Itf_BridgeTxISR(void);
+
 extern void hwJumpToBoot(void);
 
 
@@ -252,13 +283,20 @@ void CDC_Itf_SofISR(void)
   uint32_t rx_buf_length;
 
 
+  if (bridge_ch != BRIDGE_NONE)
+  {
+    CDC_Itf_BridgeISR();
+    return;
+  }
+
   rx_buf_length = APP_RX_DATA_SIZE - CDC_Itf_RxAvailable() - 1;
 
   // 수신버퍼가 USB 전송 패킷 이상 남았을때만 수신하도록 함.
-  if (usb_rx_full == true)
+  if (usb_rx_full == true && USBD_Device.pClassData != NULL)
   {
     if (rx_buf_length > CDC_DATA_FS_MAX_PACKET_SIZE)
     {
+      USBD_CDC_SetRxBuffer(&USBD_Device, UserRxBuffer);
       USBD_CDC_ReceivePacket(&USBD_Device);
       usb_rx_full = false;
     }
@@ -321,7 +359,7 @@ static int8_t CDC_Itf_Receive(uint8_t* Buf, uint32_t *Len)
   uint32_t rx_buf_length;
 
 
-  for( i=0; i<*Len; i++ )
+  for( i=0; i<*Len && bridge_ch == BRIDGE_NONE; i++ )
   {
     rxd_buffer[rxd_BufPtrIn] = Buf[i];
 
@@ -360,11 +398,18 @@ static int8_t CDC_Itf_Receive(uint8_t* Buf, uint32_t *Len)
   }
   */
 
+  if (bridge_ch != BRIDGE_NONE)
+  {
+    CDC_Itf_BridgeReceive(Buf, *Len);
+    return (USBD_OK);
+  }
+
   rx_buf_length = APP_RX_DATA_SIZE - CDC_Itf_RxAvailable() - 1;
 
   // 수신버퍼가 USB 전송 패킷 이상 남았을때만 수신하도록 함.
   if (rx_buf_length > CDC_DATA_FS_MAX_PACKET_SIZE)
   {
+    USBD_CDC_SetRxBuffer(&USBD_Device, UserRxBuffer);
     USBD_CDC_ReceivePacket(&USBD_Device);
   }
   else
@@ -553,4 +598,258 @@ uint32_t CDC_Itf_GetBaud(void)
 {
   return LineCoding.bitrate;
 }
+
+// Connect the CDC data endpoints to uart_ch, which has to be open with a
+// DMA rx mode and a tx dma. Called from a thread, the data moves in the
+// USB and uart interrupts after this.
+//
+bool CDC_Itf_BridgeBegin(uint8_t uart_ch)
+{
+  CDC_Itf_BridgeEnd();
+
+  uartFlush(uart_ch);
+  uartSetTxDoneISR(uart_ch, CDC_Itf_BridgeTxISR);
+
+  __disable_irq();
+  bridge_out_wr   = 0;
+  bridge_out_rd   = 0;
+  bridge_out_end  = BRIDGE_OUT_SIZE;
+  bridge_out_wrap = false;
+  bridge_out_dma  = 0;
+  bridge_in_len   = 0;
+  bridge_ch       = uart_ch;
+  __enable_irq();
+
+  return true;
+}
+
+void CDC_Itf_BridgeEnd(void)
+{
+  uint8_t  uart_ch = bridge_ch;
+  uint32_t pre_time;
+
+
+  if (uart_ch == BRIDGE_NONE)
+  {
+    return;
+  }
+
+  __disable_irq();
+  bridge_ch = BRIDGE_NONE;
+  __enable_irq();
+
+  uartSetTxDoneISR(uart_ch, NULL);
+
+  // the tx dma may still read bridge_out_buf.
+  pre_time = millis();
+  while(uartIsTxBusy(uart_ch) == true && millis()-pre_time < 100)
+  {
+    delay(1);
+  }
+}
+
+bool CDC_Itf_BridgeIsBusy(void)
+{
+  return bridge_ch != BRIDGE_NONE;
+}
+
+void CDC_Itf_BridgeGetStat(vcp_bridge_stat_t *p_stat)
+{
+  *p_stat = bridge_stat;
+}
+
+void CDC_Itf_BridgeClearStat(void)
+{
+  __disable_irq();
+  memset(&bridge_stat, 0, sizeof(bridge_stat));
+  __enable_irq();
+}
+
+static uint32_t CDC_Itf_BridgeOutLength(void)
+{
+  if (bridge_out_wrap == true)
+  {
+    return bridge_out_end - bridge_out_rd + bridge_out_wr;
+  }
+  else
+  {
+    return bridge_out_wr - bridge_out_rd;
+  }
+}
+
+static void CDC_Itf_BridgeISR(void)
+{
+  uint8_t  uart_ch = bridge_ch;
+  uint8_t *p_data;
+  uint32_t length;
+  USBD_CDC_HandleTypeDef *hcdc = USBD_Device.pClassData;
+
+
+  if (is_init != true || hcdc == NULL)
+  {
+    return;
+  }
+
+  if (usb_rx_full == true)
+  {
+    CDC_Itf_BridgeArm();
+  }
+
+  if (hcdc->TxState != 0)
+  {
+    return;
+  }
+
+  // the span of the last IN transfer is done now. If the rx dma was
+  // restarted by an error, the ring was flushed and there is nothing to skip.
+  if (bridge_in_len > 0)
+  {
+    if (uartGetErrCnt(uart_ch) == bridge_in_err)
+    {
+      uartReadSkip(uart_ch, bridge_in_len);
+    }
+    bridge_stat.up_bytes += bridge_in_len;
+    bridge_in_len = 0;
+  }
+
+  length = uartAvailable(uart_ch);
+  if (length > bridge_stat.rx_high)
+  {
+    bridge_stat.rx_high = length;
+  }
+
+  if (is_opened == false && is_reopen == false)
+  {
+    uartReadSkip(uart_ch, length);
+    return;
+  }
+
+  length = uartReadSpan(uart_ch, &p_data);
+  if (length == 0)
+  {
+    return;
+  }
+
+  bridge_in_len = length;
+  bridge_in_err = uartGetErrCnt(uart_ch);
+
+  USBD_CDC_SetTxBuffer(&USBD_Device, p_data, length);
+  USBD_CDC_TransmitPacket(&USBD_Device);
+}
+
+static void CDC_Itf_BridgeReceive(uint8_t *Buf, uint32_t Len)
+{
+  uint32_t length;
+
+
+  // a packet armed before the bridge began is still in UserRxBuffer.
+  if (Buf != &bridge_out_buf[bridge_out_wr])
+  {
+    memmove(&bridge_out_buf[bridge_out_wr], Buf, Len);
+  }
+  bridge_out_wr += Len;
+
+  length = CDC_Itf_BridgeOutLength();
+  if (length > bridge_stat.out_high)
+  {
+    bridge_stat.out_high = length;
+  }
+
+  CDC_Itf_BridgeKick();
+  CDC_Itf_BridgeArm();
+}
+
+// Receive the next packet if there is room for it, otherwise the OUT
+// endpoint NAKs the host until the uart tx dma frees the buffer.
+//
+static void CDC_Itf_BridgeArm(void)
+{
+  uint32_t wr = bridge_out_wr;
+
+
+  if (bridge_out_wrap != true)
+  {
+    if (BRIDGE_OUT_SIZE - wr < BRIDGE_OUT_PACKET)
+    {
+      if (bridge_out_rd <= BRIDGE_OUT_PACKET)
+      {
+        goto full;
+      }
+      bridge_out_end  = wr;
+      bridge_out_wrap = true;
+      wr = 0;
+    }
+  }
+  else
+  {
+    if (bridge_out_rd - wr <= BRIDGE_OUT_PACKET)
+    {
+      goto full;
+    }
+  }
+
+  bridge_out_wr = wr;
+  usb_rx_full   = false;
+
+  USBD_CDC_SetRxBuffer(&USBD_Device, &bridge_out_buf[wr]);
+  USBD_CDC_ReceivePacket(&USBD_Device);
+  return;
+
+full:
+  if (usb_rx_full != true)
+  {
+    usb_rx_full = true;
+    bridge_stat.hold_cnt++;
+  }
+}
+
+static void CDC_Itf_BridgeKick(void)
+{
+  uint32_t length;
+
+
+  if (bridge_out_dma > 0)
+  {
+    return;
+  }
+
+  if (bridge_out_wrap == true && bridge_out_rd >= bridge_out_end)
+  {
+    bridge_out_rd   = 0;
+    bridge_out_wrap = false;
+  }
+
+  if (bridge_out_wrap == true)
+  {
+    length = bridge_out_end - bridge_out_rd;
+  }
+  else
+  {
+    length = bridge_out_wr - bridge_out_rd;
+  }
+
+  if (length == 0)
+  {
+    return;
+  }
+
+  if (uartWriteDma(bridge_ch, &bridge_out_buf[bridge_out_rd], length) == true)
+  {
+    bridge_out_dma = length;
+  }
+}
+
+// uart tx dma done, the OUT endpoint is re-armed from the next SOF.
+//
+static void CDC_Itf_BridgeTxISR(void)
+{
+  bridge_out_rd += bridge_out_dma;
+  bridge_stat.down_bytes += bridge_out_dma;
+  bridge_out_dma = 0;
+
+  if (bridge_ch != BRIDGE_NONE)
+  {
+    CDC_Itf_BridgeKick();
+  }
+}
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -51,6 +51,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "usbd_cdc.h"
+#include "vcp.h"
 
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
@@ -72,6 +73,12 @@ uint32_t CDC_Itf_TxBufLengh( void );
 bool CDC_Itf_IsConnected(void);
 void CDC_Itf_Flush( void );
 
+bool CDC_Itf_BridgeBegin(uint8_t uart_ch);
+void CDC_Itf_BridgeEnd(void);
+bool CDC_Itf_BridgeIsBusy(void);
+void CDC_Itf_BridgeGetStat(vcp_bridge_stat_t *p_stat);
+void CDC_Itf_BridgeClearStat(void);
+
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 #endif /* __USBD_CDC_IF_H */
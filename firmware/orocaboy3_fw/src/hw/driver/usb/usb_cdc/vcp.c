@@ -206,5 +206,35 @@ uint32_t vcpGetTxRetryCount(void)
   return tx_retry_cnt;
 }
 
+// While the bridge is on, the CDC data goes to and from uart_ch and
+// vcpRead()/vcpWrite() see nothing.
+//
+bool vcpBridgeBegin(uint8_t uart_ch)
+{
+  if (is_init != true) return false;
+
+  return CDC_Itf_BridgeBegin(uart_ch);
+}
+
+void vcpBridgeEnd(void)
+{
+  CDC_Itf_BridgeEnd();
+}
+
+bool vcpBridgeIsBusy(void)
+{
+  return CDC_Itf_BridgeIsBusy();
+}
+
+void vcpBridgeGetStat(vcp_bridge_stat_t *p_stat)
+{
+  CDC_Itf_BridgeGetStat(p_stat);
+}
+
+void vcpBridgeClearStat(void)
+{
+  CDC_Itf_BridgeClearStat();
+}
+
 
 
@@ -18,6 +18,16 @@
 #include "hw_def.h"
 
 
+typedef struct
+{
+  uint32_t up_bytes;      // uart -> usb
+  uint32_t down_bytes;    // usb -> uart
+  uint32_t rx_high;       // max. bytes waiting in the uart rx ring
+  uint32_t out_high;      // max. bytes waiting in the usb out buffer
+  uint32_t hold_cnt;      // times the usb out endpoint was held off
+} vcp_bridge_stat_t;
+
+
 bool     vcpInit(void);
 bool     vcpFlush(void);
 uint32_t vcpAvailable(void);
@@ -32,6 +42,12 @@ uint32_t vcpGetTxRetryCount(void);
 bool     vcpIsConnected(void);
 uint32_t vcpGetBaud(void);
 
+bool     vcpBridgeBegin(uint8_t uart_ch);
+void     vcpBridgeEnd(void);
+bool     vcpBridgeIsBusy(void);
+void     vcpBridgeGetStat(vcp_bridge_stat_t *p_stat);
+void     vcpBridgeClearStat(void);
+
 int32_t  vcpPrintf( const char *fmt, ...);
 
 
@@ -48,6 +48,12 @@ extern "C" {
 #define MSC_MEDIA_PACKET             512U
 #endif /* MSC_MEDIA_PACKET */
 
+/* Read10/Write10 data goes through two buffers of this size, one on the
+   bus while the storage fills or drains the other one */
+#ifndef MSC_PIPE_PACKET
+#define MSC_PIPE_PACKET              (16U * 1024U)
+#endif /* MSC_PIPE_PACKET */
+
 #define MSC_MAX_FS_PACKET            0x40U
 #define MSC_MAX_HS_PACKET            0x200U
 
@@ -76,6 +82,9 @@ typedef struct _USBD_STORAGE
   int8_t (* Write)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
   int8_t (* GetMaxLun)(void);
   int8_t *pInquiry;
+  int8_t (* ReadStart)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);   /* 0: started, 1: try again, -1: error */
+  int8_t (* WriteStart)(uint8_t lun, uint8_t *buf, uint32_t blk_addr, uint16_t blk_len);
+  int8_t (* Poll)(uint8_t lun);   /* 1: busy, 0: done, -1: error */
 
 } USBD_StorageTypeDef;
 
@@ -100,6 +109,17 @@ typedef struct
 
   uint32_t                 scsi_blk_addr;
   uint32_t                 scsi_blk_len;
+
+  uint8_t                  pipe_sd_busy;
+  uint8_t                  pipe_usb_busy;
+  uint8_t                  pipe_sd_idx;
+  uint8_t                  pipe_usb_idx;
+  uint8_t                  pipe_cnt;
+  uint8_t                  pipe_err;
+  uint16_t                 pipe_len[2];
+  uint32_t                 pipe_blk_addr;
+  uint32_t                 pipe_blk_len;
+  uint32_t                 pipe_begin_us;
 }
 USBD_MSC_BOT_HandleTypeDef;
 
@@ -209,6 +209,31 @@ void MSC_BOT_DataOut(USBD_HandleTypeDef  *pdev,
   }
 }
 
+/**
+* @brief  MSC_BOT_Process
+*         Let a Read10/Write10 in the data stage move on once the storage
+*         is done, called from the USB interrupt
+* @param  pdev: device instance
+* @retval None
+*/
+void MSC_BOT_Process(USBD_HandleTypeDef  *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef  *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassData;
+
+  if (hmsc == NULL || pdev->dev_state != USBD_STATE_CONFIGURED)
+  {
+    return;
+  }
+
+  if ((hmsc->bot_state == USBD_BOT_DATA_IN) || (hmsc->bot_state == USBD_BOT_DATA_OUT))
+  {
+    if (SCSI_ProcessPipe(pdev, hmsc->cbw.bLUN) < 0)
+    {
+      MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_FAILED);
+    }
+  }
+}
+
 /**
 * @brief  MSC_BOT_CBW_Decode
 *         Decode the CBW command and set the BOT state machine accordingly
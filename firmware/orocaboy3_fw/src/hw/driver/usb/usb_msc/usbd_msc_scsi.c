@@ -28,6 +28,7 @@ EndBSPDependencies */
 #include "usbd_msc_scsi.h"
 #include "usbd_msc.h"
 #include "usbd_msc_data.h"
+#include "micros.h"
 
 
 
@@ -69,6 +70,10 @@ EndBSPDependencies */
 /** @defgroup MSC_SCSI_Private_Variables
   * @{
   */
+/* Ping-pong buffers for Read10/Write10, aligned for the SD DMA */
+static uint8_t SCSI_PipeBuf[2][MSC_PIPE_PACKET] __attribute__((aligned(32)));
+
+static USBD_SCSI_StatTypeDef SCSI_Stat;
 
 /**
   * @}
@@ -94,6 +99,10 @@ static int8_t SCSI_CheckAddressRange(USBD_HandleTypeDef *pdev, uint8_t lun,
 
 static int8_t SCSI_ProcessRead(USBD_HandleTypeDef *pdev, uint8_t lun);
 static int8_t SCSI_ProcessWrite(USBD_HandleTypeDef *pdev, uint8_t lun);
+
+static void   SCSI_PipeInit(USBD_HandleTypeDef *pdev);
+static int8_t SCSI_PipeRead(USBD_HandleTypeDef *pdev, uint8_t lun);
+static int8_t SCSI_PipeWrite(USBD_HandleTypeDef *pdev, uint8_t lun);
 /**
   * @}
   */
@@ -484,16 +493,26 @@ static int8_t SCSI_Read10(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *params
       return -1; /* error */
     }
 
-    hmsc->bot_state = USBD_BOT_DATA_IN;
-
     /* cases 4,5 : Hi <> Dn */
     if (hmsc->cbw.dDataLength != (hmsc->scsi_blk_len * hmsc->scsi_blk_size))
     {
+      hmsc->bot_state = USBD_BOT_DATA_IN;
       SCSI_SenseCode(pdev, hmsc->cbw.bLUN, ILLEGAL_REQUEST, INVALID_CDB);
       return -1;
     }
+
+    /* nothing to transfer, the CSW is sent right away */
+    if (hmsc->scsi_blk_len == 0U)
+    {
+      hmsc->bot_data_length = 0U;
+      return 0;
+    }
+
+    hmsc->bot_state = USBD_BOT_DATA_IN;
+    SCSI_PipeInit(pdev);
+
+    return SCSI_PipeRead(pdev, lun);
   }
-  hmsc->bot_data_length = MSC_MEDIA_PACKET;
 
   return SCSI_ProcessRead(pdev, lun);
 }
@@ -558,17 +577,23 @@ static int8_t SCSI_Write10(USBD_HandleTypeDef  *pdev, uint8_t lun, uint8_t *para
       return -1;
     }
 
-    len = MIN(len, MSC_MEDIA_PACKET);
+    /* nothing to transfer, the CSW is sent right away */
+    if (len == 0U)
+    {
+      hmsc->bot_data_length = 0U;
+      return 0;
+    }
 
     /* Prepare EP to receive first data packet */
     hmsc->bot_state = USBD_BOT_DATA_OUT;
-    USBD_LL_PrepareReceive(pdev, MSC_EPOUT_ADDR, hmsc->bot_data, len);
+    SCSI_PipeInit(pdev);
+
+    return SCSI_PipeWrite(pdev, lun);
   }
   else /* Write Process ongoing */
   {
     return SCSI_ProcessWrite(pdev, lun);
   }
-  return 0;
 }
 
 
@@ -622,44 +647,40 @@ static int8_t SCSI_CheckAddressRange(USBD_HandleTypeDef *pdev, uint8_t lun,
 
 /**
 * @brief  SCSI_ProcessRead
-*         Handle Read Process
+*         Handle the end of a Read10 IN transfer
 * @param  lun: Logical unit number
 * @retval status
 */
 static int8_t SCSI_ProcessRead(USBD_HandleTypeDef  *pdev, uint8_t lun)
 {
   USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *)pdev->pClassData;
-  uint32_t len = hmsc->scsi_blk_len * hmsc->scsi_blk_size;
-
-  len = MIN(len, MSC_MEDIA_PACKET);
-
-  if (((USBD_StorageTypeDef *)pdev->pUserData)->Read(lun,
-                                                     hmsc->bot_data,
-                                                     hmsc->scsi_blk_addr,
-                                                     (len / hmsc->scsi_blk_size)) < 0)
-  {
-    SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, UNRECOVERED_READ_ERROR);
-    return -1;
-  }
+  uint32_t blk_len = hmsc->pipe_len[hmsc->pipe_usb_idx];
 
-  USBD_LL_Transmit(pdev, MSC_EPIN_ADDR, hmsc->bot_data, len);
+  hmsc->pipe_usb_busy = 0U;
+  hmsc->pipe_usb_idx ^= 1U;
 
-  hmsc->scsi_blk_addr += (len / hmsc->scsi_blk_size);
-  hmsc->scsi_blk_len -= (len / hmsc->scsi_blk_size);
+  hmsc->scsi_blk_addr += blk_len;
+  hmsc->scsi_blk_len -= blk_len;
 
   /* case 6 : Hi = Di */
-  hmsc->csw.dDataResidue -= len;
+  hmsc->csw.dDataResidue -= blk_len * hmsc->scsi_blk_size;
 
-  if (hmsc->scsi_blk_len == 0U)
+  if ((hmsc->scsi_blk_len == 0U) && (hmsc->pipe_err == 0U))
   {
-    hmsc->bot_state = USBD_BOT_LAST_DATA_IN;
+    SCSI_Stat.rd_bytes += hmsc->cbw.dDataLength;
+    SCSI_Stat.rd_us += micros() - hmsc->pipe_begin_us;
+    SCSI_Stat.rd_cnt++;
+
+    MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+    return 0;
   }
-  return 0;
+
+  return SCSI_PipeRead(pdev, lun);
 }
 
 /**
 * @brief  SCSI_ProcessWrite
-*         Handle Write Process
+*         Handle the end of a Write10 OUT transfer
 * @param  lun: Logical unit number
 * @retval status
 */
@@ -667,38 +688,228 @@ static int8_t SCSI_ProcessRead(USBD_HandleTypeDef  *pdev, uint8_t lun)
 static int8_t SCSI_ProcessWrite(USBD_HandleTypeDef  *pdev, uint8_t lun)
 {
   USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *) pdev->pClassData;
-  uint32_t len = hmsc->scsi_blk_len * hmsc->scsi_blk_size;
 
-  len = MIN(len, MSC_MEDIA_PACKET);
+  hmsc->pipe_usb_busy = 0U;
+  hmsc->pipe_usb_idx ^= 1U;
+  hmsc->pipe_cnt++;
+
+  return SCSI_PipeWrite(pdev, lun);
+}
+
+/**
+* @brief  SCSI_ProcessPipe
+*         Move a Read10/Write10 on, called when the storage may have
+*         finished outside of an endpoint event
+* @param  lun: Logical unit number
+* @retval status
+*/
+int8_t SCSI_ProcessPipe(USBD_HandleTypeDef *pdev, uint8_t lun)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *) pdev->pClassData;
+
+  if (hmsc->bot_state == USBD_BOT_DATA_IN)
+  {
+    return SCSI_PipeRead(pdev, lun);
+  }
+  if (hmsc->bot_state == USBD_BOT_DATA_OUT)
+  {
+    return SCSI_PipeWrite(pdev, lun);
+  }
+  return 0;
+}
+
+/**
+* @brief  SCSI_PipeInit
+*         Reset the ping-pong buffers for a new Read10/Write10
+* @retval None
+*/
+static void SCSI_PipeInit(USBD_HandleTypeDef *pdev)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *) pdev->pClassData;
+
+  hmsc->pipe_sd_busy  = 0U;
+  hmsc->pipe_usb_busy = 0U;
+  hmsc->pipe_sd_idx   = 0U;
+  hmsc->pipe_usb_idx  = 0U;
+  hmsc->pipe_cnt      = 0U;
+  hmsc->pipe_err      = 0U;
+  hmsc->pipe_blk_addr = hmsc->scsi_blk_addr;
+  hmsc->pipe_blk_len  = hmsc->scsi_blk_len;
+  hmsc->pipe_begin_us = micros();
+}
+
+/**
+* @brief  SCSI_PipeRead
+*         Read the next packet from the storage into a free buffer while
+*         the other one is sent
+* @param  lun: Logical unit number
+* @retval status, -1 once a failed read has nothing left in flight
+*/
+static int8_t SCSI_PipeRead(USBD_HandleTypeDef *pdev, uint8_t lun)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *) pdev->pClassData;
+  USBD_StorageTypeDef *fops = (USBD_StorageTypeDef *)pdev->pUserData;
+  uint32_t blk_len;
+  int8_t status;
+
+  if (hmsc->pipe_sd_busy != 0U)
+  {
+    status = fops->Poll(lun);
+    if (status <= 0)
+    {
+      hmsc->pipe_sd_busy = 0U;
+
+      if (status < 0)
+      {
+        SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, UNRECOVERED_READ_ERROR);
+        hmsc->pipe_err = 1U;
+      }
+      else
+      {
+        hmsc->pipe_cnt++;
+        hmsc->pipe_sd_idx ^= 1U;
+      }
+    }
+  }
 
-  if (((USBD_StorageTypeDef *)pdev->pUserData)->Write(lun, hmsc->bot_data,
-                                                      hmsc->scsi_blk_addr,
-                                                      (len / hmsc->scsi_blk_size)) < 0)
+  if ((hmsc->pipe_err == 0U) && (hmsc->pipe_sd_busy == 0U) && (hmsc->pipe_blk_len > 0U) &&
+      (hmsc->pipe_cnt + hmsc->pipe_usb_busy < 2U))
   {
-    SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, WRITE_FAULT);
+    blk_len = MIN(hmsc->pipe_blk_len, MSC_PIPE_PACKET / hmsc->scsi_blk_size);
 
+    status = fops->ReadStart(lun, SCSI_PipeBuf[hmsc->pipe_sd_idx], hmsc->pipe_blk_addr, blk_len);
+    if (status < 0)
+    {
+      SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, UNRECOVERED_READ_ERROR);
+      hmsc->pipe_err = 1U;
+    }
+    else if (status == 0)
+    {
+      hmsc->pipe_len[hmsc->pipe_sd_idx] = blk_len;
+      hmsc->pipe_sd_busy = 1U;
+      hmsc->pipe_blk_addr += blk_len;
+      hmsc->pipe_blk_len -= blk_len;
+    }
+  }
+
+  if ((hmsc->pipe_err == 0U) && (hmsc->pipe_usb_busy == 0U) && (hmsc->pipe_cnt > 0U))
+  {
+    hmsc->pipe_cnt--;
+    hmsc->pipe_usb_busy = 1U;
+
+    USBD_LL_Transmit(pdev, MSC_EPIN_ADDR, SCSI_PipeBuf[hmsc->pipe_usb_idx],
+                     hmsc->pipe_len[hmsc->pipe_usb_idx] * hmsc->scsi_blk_size);
+  }
+
+  if ((hmsc->pipe_err != 0U) && (hmsc->pipe_sd_busy == 0U) && (hmsc->pipe_usb_busy == 0U))
+  {
     return -1;
   }
+  return 0;
+}
 
-  hmsc->scsi_blk_addr += (len / hmsc->scsi_blk_size);
-  hmsc->scsi_blk_len -= (len / hmsc->scsi_blk_size);
+/**
+* @brief  SCSI_PipeWrite
+*         Receive the next packet into a free buffer while the storage
+*         writes the other one
+* @param  lun: Logical unit number
+* @retval status, -1 once a failed write has nothing left in flight
+*/
+static int8_t SCSI_PipeWrite(USBD_HandleTypeDef *pdev, uint8_t lun)
+{
+  USBD_MSC_BOT_HandleTypeDef *hmsc = (USBD_MSC_BOT_HandleTypeDef *) pdev->pClassData;
+  USBD_StorageTypeDef *fops = (USBD_StorageTypeDef *)pdev->pUserData;
+  uint32_t blk_len;
+  int8_t status;
 
-  /* case 12 : Ho = Do */
-  hmsc->csw.dDataResidue -= len;
+  if (hmsc->pipe_sd_busy != 0U)
+  {
+    status = fops->Poll(lun);
+    if (status <= 0)
+    {
+      hmsc->pipe_sd_busy = 0U;
+
+      if (status < 0)
+      {
+        SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, WRITE_FAULT);
+        hmsc->pipe_err = 1U;
+      }
+      else
+      {
+        blk_len = hmsc->pipe_len[hmsc->pipe_sd_idx];
+        hmsc->pipe_sd_idx ^= 1U;
+
+        hmsc->scsi_blk_addr += blk_len;
+        hmsc->scsi_blk_len -= blk_len;
+
+        /* case 12 : Ho = Do */
+        hmsc->csw.dDataResidue -= blk_len * hmsc->scsi_blk_size;
+
+        if (hmsc->scsi_blk_len == 0U)
+        {
+          SCSI_Stat.wr_bytes += hmsc->cbw.dDataLength;
+          SCSI_Stat.wr_us += micros() - hmsc->pipe_begin_us;
+          SCSI_Stat.wr_cnt++;
+
+          MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+          return 0;
+        }
+      }
+    }
+  }
 
-  if (hmsc->scsi_blk_len == 0U)
+  if ((hmsc->pipe_err == 0U) && (hmsc->pipe_sd_busy == 0U) && (hmsc->pipe_cnt > 0U))
   {
-    MSC_BOT_SendCSW(pdev, USBD_CSW_CMD_PASSED);
+    status = fops->WriteStart(lun, SCSI_PipeBuf[hmsc->pipe_sd_idx], hmsc->scsi_blk_addr,
+                              hmsc->pipe_len[hmsc->pipe_sd_idx]);
+    if (status < 0)
+    {
+      SCSI_SenseCode(pdev, lun, HARDWARE_ERROR, WRITE_FAULT);
+      hmsc->pipe_err = 1U;
+    }
+    else if (status == 0)
+    {
+      hmsc->pipe_cnt--;
+      hmsc->pipe_sd_busy = 1U;
+    }
   }
-  else
+
+  if ((hmsc->pipe_err == 0U) && (hmsc->pipe_usb_busy == 0U) && (hmsc->pipe_blk_len > 0U) &&
+      (hmsc->pipe_cnt + hmsc->pipe_sd_busy < 2U))
   {
-    len = MIN((hmsc->scsi_blk_len * hmsc->scsi_blk_size), MSC_MEDIA_PACKET);
+    blk_len = MIN(hmsc->pipe_blk_len, MSC_PIPE_PACKET / hmsc->scsi_blk_size);
+
+    hmsc->pipe_len[hmsc->pipe_usb_idx] = blk_len;
+    hmsc->pipe_usb_busy = 1U;
+    hmsc->pipe_blk_len -= blk_len;
+
     /* Prepare EP to Receive next packet */
-    USBD_LL_PrepareReceive(pdev, MSC_EPOUT_ADDR, hmsc->bot_data, len);
+    USBD_LL_PrepareReceive(pdev, MSC_EPOUT_ADDR, SCSI_PipeBuf[hmsc->pipe_usb_idx],
+                           blk_len * hmsc->scsi_blk_size);
   }
 
+  if ((hmsc->pipe_err != 0U) && (hmsc->pipe_sd_busy == 0U) && (hmsc->pipe_usb_busy == 0U))
+  {
+    return -1;
+  }
   return 0;
 }
+
+/**
+* @brief  SCSI_GetStat
+*         Read10/Write10 throughput, time counted from the CBW to the CSW
+* @param  p_stat: copy of the counters
+* @retval None
+*/
+void SCSI_GetStat(USBD_SCSI_StatTypeDef *p_stat)
+{
+  *p_stat = SCSI_Stat;
+}
+
+void SCSI_ClearStat(void)
+{
+  USBD_memset(&SCSI_Stat, 0, sizeof(SCSI_Stat));
+}
 /**
   * @}
   */
@@ -140,6 +140,16 @@ typedef struct _SENSE_ITEM
     char *pData;
   } w;
 } USBD_SCSI_SenseTypeDef;
+
+typedef struct
+{
+  uint32_t rd_bytes;
+  uint32_t rd_cnt;
+  uint32_t rd_us;
+  uint32_t wr_bytes;
+  uint32_t wr_cnt;
+  uint32_t wr_us;
+} USBD_SCSI_StatTypeDef;
 /**
   * @}
   */
@@ -167,6 +177,10 @@ int8_t SCSI_ProcessCmd(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t *cmd);
 void SCSI_SenseCode(USBD_HandleTypeDef *pdev, uint8_t lun, uint8_t sKey,
                     uint8_t ASC);
 
+int8_t SCSI_ProcessPipe(USBD_HandleTypeDef *pdev, uint8_t lun);
+void SCSI_GetStat(USBD_SCSI_StatTypeDef *p_stat);
+void SCSI_ClearStat(void);
+
 /**
   * @}
   */
@@ -20,15 +20,22 @@
 /* Includes ------------------------------------------------------------------ */
 #include "usbd_storage.h"
 #include "sd.h"
+#include "usb.h"
 
 /* Private typedef ----------------------------------------------------------- */
 /* Private define ------------------------------------------------------------ */
 #define STORAGE_LUN_NBR                  1
 #define STORAGE_BLK_NBR                  0x10000
 #define STORAGE_BLK_SIZ                  0x200
+#define STORAGE_TIMEOUT                  1000
 
 /* Private macro ------------------------------------------------------------- */
 /* Private variables --------------------------------------------------------- */
+static volatile int8_t storage_status = 0;   /* 1: busy, 0: done, -1: error */
+static uint8_t  storage_is_write = 0;
+static uint32_t storage_pre_time;
+static uint32_t storage_check_time;
+
 /* USB Mass storage Standard Inquiry Data */
 int8_t STORAGE_Inquirydata[] = {  /* 36 */
   /* LUN 0 */
@@ -57,6 +64,13 @@ int8_t STORAGE_Read(uint8_t lun, uint8_t * buf, uint32_t blk_addr,
 int8_t STORAGE_Write(uint8_t lun, uint8_t * buf, uint32_t blk_addr,
                      uint16_t blk_len);
 int8_t STORAGE_GetMaxLun(void);
+int8_t STORAGE_ReadStart(uint8_t lun, uint8_t * buf, uint32_t blk_addr,
+                         uint16_t blk_len);
+int8_t STORAGE_WriteStart(uint8_t lun, uint8_t * buf, uint32_t blk_addr,
+                          uint16_t blk_len);
+int8_t STORAGE_Poll(uint8_t lun);
+
+static void STORAGE_Done(bool is_ok, void *arg);
 
 USBD_StorageTypeDef USBD_DISK_fops = {
   STORAGE_Init,
@@ -67,6 +81,9 @@ USBD_StorageTypeDef USBD_DISK_fops = {
   STORAGE_Write,
   STORAGE_GetMaxLun,
   STORAGE_Inquirydata,
+  STORAGE_ReadStart,
+  STORAGE_WriteStart,
+  STORAGE_Poll,
 };
 
 /* Private functions --------------------------------------------------------- */
@@ -214,4 +231,135 @@ int8_t STORAGE_GetMaxLun(void)
 }
 
 
+/**
+  * @brief  Starts a read, STORAGE_Poll() tells when it is done.
+  * @param  lun: Logical unit number
+  * @param  buf: 32 byte aligned buffer
+  * @param  blk_addr: Logical block address
+  * @param  blk_len: Blocks number
+  * @retval Status (0: OK / 1: card locked, not started / -1: Error)
+  */
+int8_t STORAGE_ReadStart(uint8_t lun, uint8_t * buf, uint32_t blk_addr,
+                         uint16_t blk_len)
+{
+  if (sdIsDetected() != true)
+  {
+    return -1;
+  }
+
+  /* A thread has the card, sdUnlockCallback() brings us back */
+  if (sdIsLocked() == true)
+  {
+    return 1;
+  }
+
+  storage_status   = 1;
+  storage_is_write = 0;
+
+  if (sdReadBlocksAsync(blk_addr, buf, blk_len, STORAGE_Done, NULL) != true)
+  {
+    storage_status = 0;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Starts a write, STORAGE_Poll() tells when the card is done
+  *         programming it.
+  * @param  lun: Logical unit number
+  * @param  buf: 32 byte aligned buffer
+  * @param  blk_addr: Logical block address
+  * @param  blk_len: Blocks number
+  * @retval Status (0: OK / 1: card locked, not started / -1: Error)
+  */
+int8_t STORAGE_WriteStart(uint8_t lun, uint8_t * buf, uint32_t blk_addr,
+                          uint16_t blk_len)
+{
+  if (sdIsDetected() != true)
+  {
+    return -1;
+  }
+
+  if (sdIsLocked() == true)
+  {
+    return 1;
+  }
+
+  storage_status   = 1;
+  storage_is_write = 1;
+
+  if (sdWriteBlocksAsync(blk_addr, buf, blk_len, STORAGE_Done, NULL) != true)
+  {
+    storage_status = 0;
+    return -1;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Checks the transfer started last.
+  * @param  lun: Logical unit number
+  * @retval Status (1: busy / 0: done / -1: error)
+  */
+int8_t STORAGE_Poll(uint8_t lun)
+{
+  if (storage_status != 0)
+  {
+    return storage_status;
+  }
+
+  if (storage_is_write == 1)
+  {
+    /* CMD13 at most once a ms, this runs on every USB interrupt */
+    if (millis() == storage_check_time)
+    {
+      return 1;
+    }
+    storage_check_time = millis();
+
+    if (sdIsBusy() == true)
+    {
+      if (millis() - storage_pre_time >= STORAGE_TIMEOUT)
+      {
+        storage_is_write = 0;
+        return -1;
+      }
+      return 1;
+    }
+    storage_is_write = 0;
+  }
+  return 0;
+}
+
+/**
+  * @brief  SD DMA done, called from the SDMMC1 interrupt.
+  * @param  is_ok: transfer status
+  * @param  arg: not used
+  * @retval None
+  */
+static void STORAGE_Done(bool is_ok, void *arg)
+{
+  storage_pre_time   = millis();
+  storage_check_time = storage_pre_time - 1;
+  storage_status     = (is_ok == true) ? 0 : -1;
+
+  /* The MSC state machine runs in the USB interrupt */
+  usbPendIrq();
+}
+
+/**
+  * @brief  A thread let go of the SD card, retry a start that found it
+  *         locked.
+  * @param  None
+  * @retval None
+  */
+void sdUnlockCallback(void)
+{
+  if (usbGetMode() == USB_MSC_MODE)
+  {
+    usbPendIrq();
+  }
+}
+
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
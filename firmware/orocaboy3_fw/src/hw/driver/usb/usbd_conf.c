@@ -412,7 +412,7 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
 #else  
   hpcd.Init.phy_itface = PCD_PHY_ULPI; 
 #endif 
-  hpcd.Init.Sof_enable = 0;
+  hpcd.Init.Sof_enable = 1;              // paces the MSC storage polling
   hpcd.Init.speed = PCD_SPEED_HIGH;
   hpcd.Init.vbus_sensing_enable = 1;
   
@@ -71,6 +71,7 @@ void hwInit(void)
   adcInit();
 
 
+  checksumInit();
   sdramInit();
   qspiInit();
   qspiEnableMemoryMappedMode();
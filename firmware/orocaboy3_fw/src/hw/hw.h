@@ -37,6 +37,7 @@
 #include "vcp.h"
 #include "adc.h"
 #include "ltdc.h"
+#include "checksum.h"
 #include "slot.h"
 #include "esp32.h"
 #include "battery.h"
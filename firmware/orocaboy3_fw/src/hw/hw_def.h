@@ -20,9 +20,15 @@
 
 #define _HW_DEF_RTOS_THREAD_PRI_MAIN          osPriorityNormal
 #define _HW_DEF_RTOS_THREAD_PRI_CMD           osPriorityNormal
+#define _HW_DEF_RTOS_THREAD_PRI_QSPI          osPriorityLow
+#define _HW_DEF_RTOS_THREAD_PRI_ESP32         osPriorityAboveNormal
+#define _HW_DEF_RTOS_THREAD_PRI_SLOT          osPriorityLow
 
 #define _HW_DEF_RTOS_THREAD_MEM_MAIN          _HW_DEF_RTOS_MEM_SIZE(6*1024)
 #define _HW_DEF_RTOS_THREAD_MEM_CMD           _HW_DEF_RTOS_MEM_SIZE(4*1024)
+#define _HW_DEF_RTOS_THREAD_MEM_QSPI          _HW_DEF_RTOS_MEM_SIZE(2*1024)
+#define _HW_DEF_RTOS_THREAD_MEM_ESP32         _HW_DEF_RTOS_MEM_SIZE(1*1024)
+#define _HW_DEF_RTOS_THREAD_MEM_SLOT          _HW_DEF_RTOS_MEM_SIZE(4*1024)
 
 
 
@@ -39,7 +45,6 @@
 #define _USE_HW_RESET
 #define _USE_HW_QSPI
 #define _USE_HW_TOUCHGFX
-#define _USE_HW_ESP32
 #define _USE_HW_BATTERY
 #define _USE_HW_JOYPAD
 #define _USE_HW_OSD
@@ -47,9 +52,13 @@
 #define _USE_HW_LCD
 
 
+#define _USE_HW_ESP32
+#define      HW_USE_CMDIF_ESP32     1
+
 #define _USE_HW_USB
 #define      HW_USE_CDC             1
 #define      HW_USE_MSC             1
+#define      HW_USE_CMDIF_USB       1
 
 
 #define _USE_HW_SDRAM
@@ -105,6 +114,9 @@
 #define _USE_HW_FATFS
 #define      HW_FATFS_USE_CMDIF     1
 
+#define _USE_HW_CHECKSUM
+#define      HW_USE_CMDIF_CHECKSUM  1
+
 #define _USE_HW_SLOT
 #define      HW_SLOT_MAX_CH         16
 
@@ -144,6 +156,7 @@
 #define QSPI_FW_TAG                   1024
 #define QSPI_FW_SIZE                  (2*1024*1024)
 #define QSPI_FW_ADDR(x)               ((x)*QSPI_FW_SIZE + QSPI_ADDR_START)
+#define QSPI_CAT_ADDR                 (QSPI_ADDR_START + 64*1024*1024 - 64*1024)  // slot catalog, 64KB
 
 
 
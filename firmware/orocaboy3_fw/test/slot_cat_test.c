@@ -0,0 +1,598 @@
+/*
+ * slot_cat_test.c
+ *
+ *  Host test for the slot catalog in slot.c : the catalog built from QSPI
+ *  at boot, the first check with a card, checks that find nothing new, a
+ *  changed image, USB MSC owning the card, the card taken out, the catalog
+ *  read back from QSPI after a reset and "slot cat". The card is a small
+ *  FatFs in RAM, QSPI a map below 4GB, the rest is stubbed.
+ *
+ *  Build and run from this directory :
+ *    gcc -O2 -I../src/common -I../src/common/core -I../src/common/hw/include \
+ *        -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *        -o slot_cat_test slot_cat_test.c && ./slot_cat_test
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+
+#include "def.h"
+#include "lz4.h"
+
+
+// Drivers stubbed below, slot.c gets nothing from their headers.
+//
+#define SRC_COMMON_HW_INCLUDE_SLOT_H_
+#define SRC_COMMON_HW_CMDIF_H_
+#define SRC_COMMON_HW_GPIO_H_
+#define SRC_COMMON_HW_INCLUDE_QSPI_H_
+#define SRC_COMMON_HW_INCLUDE_FLASH_H_
+#define SRC_COMMON_HW_INCLUDE_CHECKSUM_H_
+#define SD_H_
+#define UTIL_H_
+#define FATFS_H_
+#define SRC_HW_USB_CDC_USB_H_
+
+#define _USE_HW_SLOT
+#define HW_SLOT_MAX_CH          16
+#define SLOT_MAX_CH             HW_SLOT_MAX_CH
+
+#define QSPI_FW_SIZE            (64*1024)
+#define QSPI_ADDR_START         qspi_base
+#define QSPI_FW_ADDR(x)         ((x)*QSPI_FW_SIZE + QSPI_ADDR_START)
+#define QSPI_CAT_ADDR           (QSPI_ADDR_START + HW_SLOT_MAX_CH*QSPI_FW_SIZE)
+#define QSPI_MAP_SIZE           ((HW_SLOT_MAX_CH+1)*QSPI_FW_SIZE)
+#define SDRAM_ADDR_BUF          0
+
+#define _PIN_GPIO_LCD_BK_EN     0
+#define UNUSED(x)               ((void)(x))
+#define __IO                    volatile
+
+#define logPrintf(...)
+
+static uint32_t qspi_base;
+
+bool slotInit(void);
+bool slotIsAvailable(uint8_t slot_index);
+bool slotRun(uint8_t slot_index);
+bool slotRunFromFlash(uint8_t slot_index);
+bool slotRunFromFile(const char *file_name);
+bool slotDelFromFlash(uint8_t slot_index);
+bool slotRunFromFolder(uint8_t slot_index);
+bool slotGetTag(uint8_t slot_index, flash_tag_t *p_tag);
+bool slotGetTagFromFolder(uint8_t slot_index, flash_tag_t *p_tag);
+bool slotGetTagFromFlash(uint8_t slot_index, flash_tag_t *p_tag);
+bool slotCatalogRefresh(void);
+uint32_t slotCatalogGetVersion(void);
+void slotJumpToFw(uint32_t addr);
+
+
+//-- FatFs, one volume in RAM
+//
+typedef unsigned int UINT;
+typedef uint8_t      BYTE;
+typedef uint16_t     WORD;
+typedef uint32_t     DWORD;
+
+typedef enum
+{
+  FR_OK      = 0,
+  FR_NO_FILE = 4,
+  FR_NO_PATH = 5,
+} FRESULT;
+
+#define _MAX_SS                 512
+#define CREATE_LINKMAP          0xFFFFFFFF
+#define AM_DIR                  0x10
+#define FA_READ                 0x01
+#define FA_WRITE                0x02
+#define FA_OPEN_EXISTING        0x00
+#define FA_CREATE_ALWAYS        0x08
+
+typedef struct
+{
+  DWORD database;
+  BYTE  csize;
+} FATFS;
+
+typedef struct
+{
+  FATFS *fs;
+} FFOBJID;
+
+typedef struct
+{
+  FFOBJID obj;
+  DWORD  *cltbl;
+  int     node;
+  DWORD   fptr;
+} FIL;
+
+typedef struct
+{
+  int node;
+  int next;
+} DIR;
+
+typedef struct
+{
+  DWORD fsize;
+  WORD  fdate;
+  WORD  ftime;
+  BYTE  fattrib;
+  char  fname[256];
+} FILINFO;
+
+#define RAM_FS_MAX              32
+#define RAM_FS_FILE_MAX         (16*1024)
+
+typedef struct
+{
+  bool     is_dir;
+  char     path[128];
+  WORD     fdate;
+  WORD     ftime;
+  uint32_t size;
+  uint8_t  data[RAM_FS_FILE_MAX];
+} ram_node_t;
+
+static ram_node_t ram_fs[RAM_FS_MAX];
+static int        ram_fs_cnt = 0;
+static WORD       ram_fs_time = 1;
+static FATFS      ram_fatfs;
+static uint32_t   fs_calls = 0;         // every f_xxx() reaching the card
+static uint32_t   fs_writes = 0;
+
+#define f_size(fp)              (ram_fs[(fp)->node].size)
+
+static int ramFsFind(const char *path)
+{
+  int i;
+
+  for (i=0; i<ram_fs_cnt; i++)
+  {
+    if (strcmp(ram_fs[i].path, path) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int ramFsAdd(const char *path, bool is_dir)
+{
+  int i = ramFsFind(path);
+
+  if (i < 0)
+  {
+    i = ram_fs_cnt++;
+    memset(&ram_fs[i], 0, sizeof(ram_node_t));
+    strcpy(ram_fs[i].path, path);
+    ram_fs[i].is_dir = is_dir;
+  }
+  ram_fs[i].fdate = 0x5000;
+  ram_fs[i].ftime = ram_fs_time++;
+  return i;
+}
+
+static void ramFsStat(int i, FILINFO *fno)
+{
+  fno->fsize   = ram_fs[i].size;
+  fno->fdate   = ram_fs[i].fdate;
+  fno->ftime   = ram_fs[i].ftime;
+  fno->fattrib = ram_fs[i].is_dir == true ? AM_DIR : 0;
+  strcpy(fno->fname, strrchr(ram_fs[i].path, '/') + 1);
+}
+
+FRESULT f_stat(const char *path, FILINFO *fno)
+{
+  int i = ramFsFind(path);
+
+  fs_calls++;
+  if (i < 0)
+  {
+    return FR_NO_FILE;
+  }
+  ramFsStat(i, fno);
+  return FR_OK;
+}
+
+FRESULT f_opendir(DIR *dp, const char *path)
+{
+  int i = ramFsFind(path);
+
+  fs_calls++;
+  if (i < 0 || ram_fs[i].is_dir != true)
+  {
+    return FR_NO_PATH;
+  }
+  dp->node = i;
+  dp->next = 0;
+  return FR_OK;
+}
+
+FRESULT f_readdir(DIR *dp, FILINFO *fno)
+{
+  const char *dir = ram_fs[dp->node].path;
+  size_t len = strlen(dir);
+
+  fs_calls++;
+  fno->fname[0] = 0;
+  while (dp->next < ram_fs_cnt)
+  {
+    const char *path = ram_fs[dp->next++].path;
+
+    if (strncmp(path, dir, len) == 0 && path[len] == '/' && strchr(&path[len+1], '/') == NULL)
+    {
+      ramFsStat(dp->next-1, fno);
+      break;
+    }
+  }
+  return FR_OK;
+}
+
+FRESULT f_closedir(DIR *dp)
+{
+  fs_calls++;
+  return FR_OK;
+}
+
+FRESULT f_open(FIL *fp, const char *path, BYTE mode)
+{
+  int i;
+
+  fs_calls++;
+  if (mode & FA_CREATE_ALWAYS)
+  {
+    i = ramFsAdd(path, false);
+    ram_fs[i].size = 0;
+  }
+  else
+  {
+    i = ramFsFind(path);
+    if (i < 0 || ram_fs[i].is_dir == true)
+    {
+      return FR_NO_FILE;
+    }
+  }
+  fp->obj.fs = &ram_fatfs;
+  fp->cltbl  = NULL;
+  fp->node   = i;
+  fp->fptr   = 0;
+  return FR_OK;
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br)
+{
+  ram_node_t *p_node = &ram_fs[fp->node];
+
+  fs_calls++;
+  if (btr > p_node->size - fp->fptr)
+  {
+    btr = p_node->size - fp->fptr;
+  }
+  memcpy(buff, &p_node->data[fp->fptr], btr);
+  fp->fptr += btr;
+  *br = btr;
+  return FR_OK;
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw)
+{
+  ram_node_t *p_node = &ram_fs[fp->node];
+
+  fs_calls++;
+  fs_writes++;
+  memcpy(&p_node->data[fp->fptr], buff, btw);
+  fp->fptr += btw;
+  if (fp->fptr > p_node->size)
+  {
+    p_node->size = fp->fptr;
+  }
+  *bw = btw;
+  return FR_OK;
+}
+
+FRESULT f_lseek(FIL *fp, DWORD ofs)
+{
+  fs_calls++;
+  if (ofs == CREATE_LINKMAP)
+  {
+    return FR_NO_FILE;
+  }
+  fp->fptr = ofs;
+  return FR_OK;
+}
+
+FRESULT f_close(FIL *fp)
+{
+  fs_calls++;
+  return FR_OK;
+}
+
+
+//-- USB, SD, QSPI, cmdif and the rest
+//
+enum UsbMode
+{
+  USB_NON_MODE,
+  USB_CDC_MODE,
+  USB_MSC_MODE
+};
+
+static enum UsbMode usb_mode = USB_NON_MODE;
+static bool         sd_detected = false;
+static uint32_t     flash_erases = 0;
+static char         cmdif_out[4096];
+static const char  *cmdif_argv[2];
+static uint32_t     cmdif_argc = 0;
+
+static struct { uint32_t CTRL; } systick_stub;
+static struct { uint32_t VTOR; } scb_stub;
+#define SysTick (&systick_stub)
+#define SCB     (&scb_stub)
+
+enum UsbMode usbGetMode(void)  { return usb_mode; }
+bool sdIsDetected(void)        { return sd_detected; }
+bool sdReadBlocksStart(uint32_t block_addr, uint8_t *p_data, uint32_t num_of_blocks) { return false; }
+bool sdReadBlocksWait(uint32_t timeout_ms) { return false; }
+bool qspiMapBegin(void)        { return true; }
+void qspiMapEnd(void)          { }
+uint32_t millis(void)          { return 0; }
+uint32_t micros(void)          { return 0; }
+void gpioPinWrite(uint8_t ch, uint8_t value) { }
+void bspDeInit(void)           { }
+void __set_CONTROL(uint32_t value) { }
+void __set_MSP(uint32_t value) { }
+
+bool flashErase(uint32_t addr, uint32_t length)
+{
+  flash_erases++;
+  memset((void *)(uintptr_t)addr, 0xFF, length);
+  return true;
+}
+
+bool flashWrite(uint32_t addr, uint8_t *p_data, uint32_t length)
+{
+  memcpy((void *)(uintptr_t)addr, p_data, length);
+  return true;
+}
+
+uint32_t checksumCrc32(uint32_t crc, const uint8_t *p_data, uint32_t length)
+{
+  uint32_t i;
+  int b;
+
+  crc = ~crc;
+  for (i=0; i<length; i++)
+  {
+    crc ^= p_data[i];
+    for (b=0; b<8; b++)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+uint16_t checksumCrc16(uint16_t crc, const uint8_t *p_data, uint32_t length)
+{
+  return (uint16_t)checksumCrc32(crc, p_data, length);
+}
+
+uint32_t utilConvert8ToU32(uint8_t *p_data)
+{
+  return p_data[0] | (p_data[1]<<8) | (p_data[2]<<16) | ((uint32_t)p_data[3]<<24);
+}
+
+int32_t lz4DecompressBlock(const uint8_t *p_src, uint32_t src_len, uint8_t *p_dst, uint32_t dst_len)
+{
+  return -1;
+}
+
+void cmdifAdd(const char *cmd_str, void (*p_func)(void)) { }
+uint32_t cmdifGetParamCnt(void) { return cmdif_argc; }
+unsigned long cmdifGetParam(uint8_t index) { return 0; }
+
+bool cmdifHasString(const char *p_str, uint8_t index)
+{
+  return index < cmdif_argc && strcmp(cmdif_argv[index], p_str) == 0;
+}
+
+void cmdifPrintf(const char *fmt, ...)
+{
+  va_list args;
+  size_t len = strlen(cmdif_out);
+
+  va_start(args, fmt);
+  vsnprintf(&cmdif_out[len], sizeof(cmdif_out) - len, fmt, args);
+  va_end(args);
+}
+
+
+#include "../src/hw/driver/slot.c"
+
+
+
+
+static int test_fail = 0;
+
+#define CHECK(x)  do { if (!(x)) { printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #x); test_fail++; } } while (0)
+
+
+static void makeTag(flash_tag_t *p_tag, const char *name)
+{
+  memset(p_tag, 0, sizeof(flash_tag_t));
+  p_tag->magic_number = FLASH_MAGIC_NUMBER;
+  strcpy((char *)p_tag->name_str, name);
+  strcpy((char *)p_tag->version_str, "V1");
+}
+
+static void putFlash(uint8_t slot_index, const char *name)
+{
+  makeTag((flash_tag_t *)(uintptr_t)QSPI_FW_ADDR(slot_index), name);
+}
+
+static void putFile(uint8_t slot_index, const char *name)
+{
+  char path[64];
+  int i;
+
+  ramFsAdd("/slot", true);
+  sprintf(path, "/slot/%d", slot_index);
+  ramFsAdd(path, true);
+  sprintf(path, "/slot/%d/game.bin", slot_index);
+  i = ramFsAdd(path, false);
+  makeTag((flash_tag_t *)ram_fs[i].data, name);
+  ram_fs[i].size = sizeof(flash_tag_t) + 1024;
+}
+
+static bool hasTag(uint8_t slot_index, const char *name)
+{
+  flash_tag_t tag;
+
+  if (slotGetTag(slot_index, &tag) != true)
+  {
+    return name == NULL;
+  }
+  return name != NULL && strcmp((char *)tag.name_str, name) == 0;
+}
+
+static void reset(void)
+{
+  memset(&slot_cat, 0, sizeof(slot_cat));
+  memset(&slot_cat_work, 0, sizeof(slot_cat_work));
+  is_cat_valid  = false;
+  is_cat_loaded = false;
+  is_cat_msc    = false;
+  slotInit();
+}
+
+
+int main(void)
+{
+  uint8_t *p_qspi;
+  uint32_t ver;
+  uint32_t scans;
+  uint32_t erases;
+  uint32_t writes;
+  uint32_t i;
+
+
+  p_qspi = mmap(NULL, QSPI_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+  if (p_qspi == MAP_FAILED)
+  {
+    printf("mmap failed\n");
+    return 1;
+  }
+  qspi_base = (uint32_t)(uintptr_t)p_qspi;
+  memset(p_qspi, 0xFF, QSPI_MAP_SIZE);
+
+
+  // Nothing in QSPI but one image, no card.
+  putFlash(2, "FLASH2");
+  reset();
+  CHECK(is_cat_valid == false);
+  CHECK(hasTag(2, "FLASH2"));
+  CHECK(hasTag(1, NULL));
+  CHECK(fs_calls == 0);
+
+  // The first check with a card scans the folders and saves the catalog.
+  putFile(1, "CARD1");
+  putFile(2, "CARD2");
+  sd_detected = true;
+  ver = slotCatalogGetVersion();
+  slotCatalogRefresh();
+  CHECK(slotCatalogGetVersion() != ver);
+  CHECK(hasTag(1, "CARD1"));
+  CHECK(hasTag(2, "CARD2"));
+  CHECK(hasTag(3, NULL));
+  CHECK(ramFsFind(SLOT_CAT_FILE) >= 0);
+  CHECK(memcmp((void *)(uintptr_t)QSPI_CAT_ADDR, &slot_cat, sizeof(slot_cat_t)) == 0);
+  CHECK(slotCatIsValid((slot_cat_t *)(uintptr_t)QSPI_CAT_ADDR) == true);
+  CHECK(is_cat_valid == true);
+
+  // Nothing changed : no scan, nothing written.
+  ver    = slotCatalogGetVersion();
+  scans  = cat_scan_cnt;
+  erases = flash_erases;
+  writes = fs_writes;
+  slotCatalogRefresh();
+  CHECK(slotCatalogGetVersion() == ver);
+  CHECK(cat_scan_cnt == scans);
+  CHECK(flash_erases == erases);
+  CHECK(fs_writes == writes);
+
+  // A new image in one folder : only that slot is scanned.
+  putFile(1, "CARD1B");
+  slotCatalogRefresh();
+  CHECK(hasTag(1, "CARD1B"));
+  CHECK(cat_scan_cnt == scans + 1);
+  CHECK(flash_erases == erases + 1);
+  CHECK(fs_writes == writes + 1);
+
+  // USB MSC owns the card : the QSPI side is followed, the card is left
+  // alone and a folder entry keeps its tag.
+  usb_mode = USB_MSC_MODE;
+  putFlash(5, "FLASH5");
+  putFile(2, "CARD2B");
+  fs_calls = 0;
+  erases   = flash_erases;
+  slotCatalogRefresh();
+  CHECK(fs_calls == 0);
+  CHECK(hasTag(5, "FLASH5"));
+  CHECK(hasTag(2, "CARD2"));
+  CHECK(flash_erases == erases + 1);
+  CHECK(memcmp((void *)(uintptr_t)QSPI_CAT_ADDR, &slot_cat, sizeof(slot_cat_t)) == 0);
+
+  // MSC gone : every slot is scanned once more.
+  usb_mode = USB_NON_MODE;
+  scans    = cat_scan_cnt;
+  slotCatalogRefresh();
+  CHECK(cat_scan_cnt == scans + SLOT_MAX_CH);
+  CHECK(hasTag(2, "CARD2B"));
+  scans = cat_scan_cnt;
+  slotCatalogRefresh();
+  CHECK(cat_scan_cnt == scans);
+
+  // Card out : the flash slots are left, nothing is saved.
+  sd_detected = false;
+  fs_calls = 0;
+  erases   = flash_erases;
+  slotCatalogRefresh();
+  CHECK(fs_calls == 0);
+  CHECK(flash_erases == erases);
+  CHECK(hasTag(1, NULL));
+  CHECK(hasTag(2, "FLASH2"));
+  CHECK(hasTag(5, "FLASH5"));
+
+  // Reset with the card back in : the catalog comes from QSPI as saved
+  // with the card and the first check finds nothing to scan.
+  sd_detected = true;
+  reset();
+  CHECK(is_cat_valid == true);
+  CHECK(hasTag(1, "CARD1B"));
+  CHECK(hasTag(2, "CARD2B"));
+  CHECK(hasTag(5, "FLASH5"));
+  scans = cat_scan_cnt;
+  slotCatalogRefresh();
+  CHECK(cat_scan_cnt == scans);
+
+  // "slot cat" prints what slotGetTag() answers.
+  cmdif_argv[0] = "cat";
+  cmdif_argc    = 1;
+  cmdif_out[0]  = 0;
+  slotCmdif();
+  CHECK(strstr(cmdif_out, "01 sd   : CARD1B") != NULL);
+  CHECK(strstr(cmdif_out, "05 qspi : FLASH5") != NULL);
+  CHECK(strstr(cmdif_out, "03      : ") != NULL);
+
+  for (i=0; i<SLOT_MAX_CH; i++)
+  {
+    CHECK(slot_cat.entry[i].src <= SLOT_CAT_FLASH);
+  }
+
+  printf("%s\n", test_fail == 0 ? "slot_cat_test : OK" : "slot_cat_test : FAIL");
+
+  return test_fail == 0 ? 0 : 1;
+}
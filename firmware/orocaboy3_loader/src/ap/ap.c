@@ -10,6 +10,9 @@
 
 #include "ap.h"
 #include "util.h"
+#include "lz4.h"
+#include "crc.h"
+#include <string.h>
 #include <unistd.h>
 
 
@@ -24,7 +27,11 @@ flash_tag_t    fw_tag;
 
 
 int32_t getFileSize(char *file_name);
-bool addTagToBin(char *src_filename, char *dst_filename);
+bool compressBin(uint8_t *buf, size_t src_len, uint8_t **p_out_buf, size_t *p_out_len);
+bool addTagToBin(char *src_filename, char *dst_filename, bool is_lz4);
+uint8_t downloadLegacy(char *file_name, uint32_t flash_begin, uint32_t file_size);
+uint8_t downloadWindow(char *file_name, uint32_t flash_begin, uint32_t file_size, boot_caps_t *p_caps);
+void printProgress(uint32_t done, uint32_t total);
 
 
 
@@ -41,23 +48,14 @@ void apMain(int argc, char *argv[])
   char *file_type;
   int baud;
   int file_size;
-  uint8_t  block_buf[FLASH_TX_BLOCK_LENGTH];
   uint8_t  version_str[128];
   uint8_t  board_str[128];
-  static FILE *fp;
   uint8_t errcode;
-  uint32_t time_pre;
-  bool flash_write_done;
-  uint32_t addr;
-  size_t readbytes;
-  uint32_t percent;
-  uint32_t len;
-  uint32_t pre_percent = 100;
   uint32_t start_addr = 0;
   uint32_t file_run = 0;
+  boot_caps_t boot_caps;
 
   uint32_t flash_begin;
-  uint32_t flash_end;
   char dst_filename[256];
   int slot_number;
 
@@ -65,9 +63,18 @@ void apMain(int argc, char *argv[])
   setbuf(stdout, NULL);
 
 
+  if (argc == 2 && strcmp(argv[1], "crc") == 0)
+  {
+    printf("crc test : %s\n", crcTest() == true ? "OK" : "Fail");
+    return;
+  }
+
   if (argc != 7)
   {
-    printf("orocaboy3_loader.exe com1 115200 type[fw:image] 0x8040000 file_name run[0:1]\n");
+    printf("orocaboy3_loader.exe com1 115200 type[fw:fwz:image] 0x8040000 file_name run[0:1]\n");
+    printf("  fwz : fw with the image compressed (LZ4)\n");
+    printf("orocaboy3_loader.exe crc\n");
+    printf("  crc : check the CRC routines against the test vectors\n");
     return;
   }
 
@@ -89,13 +96,13 @@ void apMain(int argc, char *argv[])
     printf("     addr   : 0x%X\n", start_addr);
   }
 
-  if(strcmp(file_type, "fw") == 0)
+  if(strcmp(file_type, "fw") == 0 || strcmp(file_type, "fwz") == 0)
   {
     printf("\r\n@ Make binary (Add Tag)...\r\n");
     strcpy(dst_filename, file_name);
     strcat(dst_filename, ".fw");
 
-    if(addTagToBin(file_name, dst_filename) != true)
+    if(addTagToBin(file_name, dst_filename, strcmp(file_type, "fwz") == 0) != true)
     {
       fprintf( stderr, "  Add tag info to binary Fail! \n");
       exit( 1 );
@@ -122,6 +129,12 @@ void apMain(int argc, char *argv[])
       printf("MagicNumber Fail, Wrong Image.\n");
       return;
     }
+
+    if (fw_tag.tag_flash_type == FLASH_TAG_TYPE_XIP && fw_tag.addr_tag != start_addr)
+    {
+      printf("XIP image linked for 0x%X, slot %d.\n", fw_tag.addr_tag, (int)((fw_tag.addr_tag - 0x90000000) / 0x200000));
+      return;
+    }
   }
   else
   {
@@ -158,7 +171,6 @@ void apMain(int argc, char *argv[])
 
 
   flash_begin = start_addr;
-  flash_end   = start_addr + file_size;
 
 
   while(1)
@@ -209,135 +221,233 @@ void apMain(int argc, char *argv[])
     }
     */
 
-    //-- Flash Erase
+    //-- Flash Erase/Write
     //
-    printf("erase fw...\n");
-    time_pre = millis();
-    errcode = bootCmdFlashErase(flash_begin, flash_end - flash_begin);
-    if (errcode == OK)
+    errcode = bootCmdReadCaps(&boot_caps);
+    if (errcode == OK && boot_caps.version >= 1)
     {
-      printf("erase fw ret \t: OK (%d ms)\n", millis()-time_pre);
+      printf("boot caps \t: v%d, %d x %d B\n", boot_caps.version, boot_caps.window, boot_caps.block_length);
+      errcode = downloadWindow(dst_filename, flash_begin, file_size, &boot_caps);
     }
     else
     {
-      printf("bootCmdFlashEraseFw faild : %d\n", errcode);
-      break;
+      errcode = downloadLegacy(dst_filename, flash_begin, file_size);
     }
 
-
-    //-- Flash Write
-    //
-    if( ( fp = fopen( dst_filename, "rb" ) ) == NULL )
+    if (errcode != OK)
     {
-      fprintf( stderr, "Unable to open %s\n", file_name );
-      exit(1);
+      printf("Download \t: Fail\n");
+      return;
+    }
+    else
+    {
+      printf("Download \t: OK\n");
     }
 
 
-    flash_write_done = false;
-    addr = flash_begin;
-    time_pre = millis();
-    while(1)
+    errcode = bootCmdJumpToFw();
+    if (errcode == OK)
     {
-      if( !feof( fp ) )
-      {
-        readbytes = fread( block_buf, 1, FLASH_TX_BLOCK_LENGTH, fp );
-        percent = (addr+readbytes-flash_begin)*100/file_size;
-
-        if ((percent%10) == 0 && percent != pre_percent)
-        {
-          if (percent == 0)
-          {
-            printf("flash fw \t: %d%% ", percent);
-          }
-          else
-          {
-            printf("%d%% ", percent);
-          }
-          pre_percent = percent;
-        }
-      }
-      else
-      {
-        break;
-      }
+        printf("jump to fw \t: OK\n");
+    }
+    else
+    {
+      printf("jump to fw fail : %d\n", errcode);
+    }
 
-      if( readbytes == 0 )
-      {
-        break;
-      }
-      else
-      {
-        len = readbytes;
-      }
+    break;
+  }
 
 
-      for (int retry=0; retry<3; retry++)
-      {
-        errcode = bootCmdFlashWrite(addr, block_buf, len);
-        if( errcode == OK )
-        {
-          break;
-        }
-        else
-        {
-          printf("bootCmdFlashWrite Fail \t: %d \n", errcode);
-        }
-      }
-      if( errcode != OK )
-      {
-        break;
-      }
+  uartClose(_DEF_UART2);
+}
 
-      addr += len;
+// Old boot : erase everything, then one FLASH_TX_BLOCK_LENGTH write per ack.
+//
+uint8_t downloadLegacy(char *file_name, uint32_t flash_begin, uint32_t file_size)
+{
+  uint8_t  block_buf[FLASH_TX_BLOCK_LENGTH];
+  static FILE *fp;
+  uint8_t errcode;
+  uint32_t time_pre;
+  bool flash_write_done;
+  uint32_t addr;
+  size_t readbytes;
+  uint32_t len;
+
+
+  //-- Flash Erase
+  //
+  printf("erase fw...\n");
+  time_pre = millis();
+  errcode = bootCmdFlashErase(flash_begin, file_size);
+  if (errcode == OK)
+  {
+    printf("erase fw ret \t: OK (%d ms)\n", millis()-time_pre);
+  }
+  else
+  {
+    printf("bootCmdFlashEraseFw faild : %d\n", errcode);
+    return errcode;
+  }
 
-      if ((addr-flash_begin) == file_size)
-      {
-        flash_write_done = true;
-        break;
-      }
-    }
-    fclose(fp);
 
-    printf("\r\n");
+  //-- Flash Write
+  //
+  if( ( fp = fopen( file_name, "rb" ) ) == NULL )
+  {
+    fprintf( stderr, "Unable to open %s\n", file_name );
+    exit(1);
+  }
 
-    if( errcode != OK || flash_write_done == false )
+
+  flash_write_done = false;
+  addr = flash_begin;
+  time_pre = millis();
+  while(1)
+  {
+    if( !feof( fp ) )
+    {
+      readbytes = fread( block_buf, 1, FLASH_TX_BLOCK_LENGTH, fp );
+      printProgress(addr+readbytes-flash_begin, file_size);
+    }
+    else
+    {
+      break;
+    }
+
+    if( readbytes == 0 )
     {
-      printf("flash fw fail \t: %d\n", errcode);
       break;
     }
     else
     {
-      printf("flash fw ret \t: OK (%d ms) \n", millis()-time_pre);
+      len = readbytes;
     }
 
 
-    if( errcode != OK || flash_write_done == false )
+    for (int retry=0; retry<3; retry++)
     {
-      printf("Download \t: Fail\n");
-      return;
+      errcode = bootCmdFlashWrite(addr, block_buf, len);
+      if( errcode == OK )
+      {
+        break;
+      }
+      else
+      {
+        printf("bootCmdFlashWrite Fail \t: %d \n", errcode);
+      }
     }
-    else
+    if( errcode != OK )
     {
-      printf("Download \t: OK\n");
+      break;
     }
 
+    addr += len;
 
-    errcode = bootCmdJumpToFw();
-    if (errcode == OK)
+    if ((addr-flash_begin) == file_size)
     {
-        printf("jump to fw \t: OK\n");
+      flash_write_done = true;
+      break;
     }
-    else
+  }
+  fclose(fp);
+
+  printf("\r\n");
+
+  if( errcode != OK || flash_write_done == false )
+  {
+    printf("flash fw fail \t: %d\n", errcode);
+    return errcode != OK ? errcode : ERR_FLASH_WRITE;
+  }
+
+  printf("flash fw ret \t: OK (%d ms) \n", millis()-time_pre);
+
+  return OK;
+}
+
+// Boot with BOOT_CMD_READ_CAPS : large blocks with a window of acks, the boot
+// erases ahead of the writes. From version 2 only the changed sectors are sent.
+//
+uint8_t downloadWindow(char *file_name, uint32_t flash_begin, uint32_t file_size, boot_caps_t *p_caps)
+{
+  static FILE *fp;
+  uint8_t *buf;
+  uint8_t errcode;
+  uint32_t time_pre;
+  uint32_t sent;
+
+
+  buf = (uint8_t *)malloc(file_size);
+  if (buf == NULL)
+  {
+    fprintf( stderr, "  malloc Error \n");
+    return ERR_FLASH_SIZE;
+  }
+
+  if( ( fp = fopen( file_name, "rb" ) ) == NULL )
+  {
+    fprintf( stderr, "Unable to open %s\n", file_name );
+    exit(1);
+  }
+  if (fread(buf, 1, file_size, fp) != file_size)
+  {
+    fprintf( stderr, "Unable to read %s\n", file_name );
+    exit(1);
+  }
+  fclose(fp);
+
+
+  time_pre = millis();
+  if (p_caps->version >= 2)
+  {
+    errcode = bootFlashWriteDelta(flash_begin, buf, file_size, p_caps, printProgress, &sent);
+  }
+  else
+  {
+    errcode = bootCmdFlashBegin(flash_begin, file_size);
+    if (errcode == OK)
     {
-      printf("jump to fw fail : %d\n", errcode);
+      errcode = bootFlashWriteWindow(flash_begin, buf, file_size, p_caps, printProgress);
     }
+    sent = file_size;
+  }
+  free(buf);
 
-    break;
+  printf("\r\n");
+
+  if (errcode != OK)
+  {
+    printf("flash fw fail \t: %d\n", errcode);
+    return errcode;
   }
 
+  time_pre = millis() - time_pre;
+  printf("flash fw ret \t: OK (%d ms, %d KB of %d KB sent) \n", time_pre, sent/1024, file_size/1024);
 
-  uartClose(_DEF_UART2);
+  return OK;
+}
+
+void printProgress(uint32_t done, uint32_t total)
+{
+  static uint32_t pre_percent = 100;
+  uint32_t percent;
+
+
+  percent = done*100/total;
+
+  if ((percent%10) == 0 && percent != pre_percent)
+  {
+    if (pre_percent == 100)
+    {
+      printf("flash fw \t: %d%% ", percent);
+    }
+    else
+    {
+      printf("%d%% ", percent);
+    }
+    pre_percent = percent;
+  }
 }
 
 int32_t getFileSize(char *file_name)
@@ -364,11 +474,73 @@ int32_t getFileSize(char *file_name)
   return ret;
 }
 
-bool addTagToBin(char *src_filename, char *dst_filename)
+// Compress the image after the tag. The result is decoded again and
+// compared, so a broken file never gets written. If the image does not get
+// smaller it is left raw.
+//
+bool compressBin(uint8_t *buf, size_t src_len, uint8_t **p_out_buf, size_t *p_out_len)
+{
+  flash_tag_t *p_tag = (flash_tag_t *)buf;
+  uint8_t *out_buf;
+  uint8_t *chk_buf;
+  size_t   body_len = src_len - FLASH_TAG_SIZE;
+  int32_t  comp_len;
+  int32_t  chk_len;
+
+
+  out_buf = (uint8_t *)malloc(FLASH_TAG_SIZE + LZ4_STREAM_BOUND(body_len));
+  chk_buf = (uint8_t *)malloc(body_len + 1);
+  if (out_buf == NULL || chk_buf == NULL)
+  {
+    free(out_buf);
+    free(chk_buf);
+    fprintf( stderr, "  malloc Error \n");
+    return false;
+  }
+
+  comp_len = lz4CompressStream(&buf[FLASH_TAG_SIZE], body_len, &out_buf[FLASH_TAG_SIZE], LZ4_STREAM_BOUND(body_len));
+  if (comp_len < 0)
+  {
+    free(out_buf);
+    free(chk_buf);
+    fprintf( stderr, "  lz4 compress fail \n");
+    return false;
+  }
+
+  chk_len = lz4DecompressStream(&out_buf[FLASH_TAG_SIZE], comp_len, chk_buf, body_len + 1);
+  if (chk_len != (int32_t)body_len || memcmp(chk_buf, &buf[FLASH_TAG_SIZE], body_len) != 0)
+  {
+    free(out_buf);
+    free(chk_buf);
+    fprintf( stderr, "  lz4 verify fail \n");
+    return false;
+  }
+  free(chk_buf);
+
+  if ((size_t)comp_len >= body_len)
+  {
+    free(out_buf);
+    printf("  lz4           : no gain, stored raw\n");
+    return true;
+  }
+
+  p_tag->tag_flash_type  = FLASH_TAG_TYPE_LZ4;
+  p_tag->tag_comp_length = comp_len;
+  memcpy(out_buf, buf, FLASH_TAG_SIZE);
+
+  *p_out_buf = out_buf;
+  *p_out_len = FLASH_TAG_SIZE + comp_len;
+
+  return true;
+}
+
+bool addTagToBin(char *src_filename, char *dst_filename, bool is_lz4)
 {
   FILE    *p_fd;
   uint8_t *buf;
+  uint8_t *out_buf;
   size_t   src_len;
+  size_t   out_len;
   uint16_t t_crc = 0;
   flash_tag_t *p_tag;
 
@@ -411,11 +583,7 @@ bool addTagToBin(char *src_filename, char *dst_filename)
 
 
   /* Calculate CRC16 */
-  size_t i;
-  for (i = 0; i<src_len - FLASH_TAG_SIZE; i++)
-  {
-    utilUpdateCrc(&t_crc, buf[FLASH_TAG_SIZE + i]);
-  }
+  t_crc = crc16Update(t_crc, &buf[FLASH_TAG_SIZE], src_len - FLASH_TAG_SIZE);
 
   p_tag = (flash_tag_t *)buf;
 
@@ -441,6 +609,30 @@ bool addTagToBin(char *src_filename, char *dst_filename)
   strcpy((char *)p_tag->tag_date_str, __DATE__);
   strcpy((char *)p_tag->tag_time_str, __TIME__);
   p_tag->tag_flash_crc = t_crc;
+  p_tag->tag_flash_type  = FLASH_TAG_TYPE_RAW;
+  p_tag->tag_comp_length = 0;
+
+  // Linked to run in place from a QSPI slot (STM32H753II_QSPI.ld)
+  if (p_tag->addr_tag >= 0x90000000 && p_tag->addr_tag < 0x90000000 + 0x200000 * 16)
+  {
+    p_tag->tag_flash_type = FLASH_TAG_TYPE_XIP;
+  }
+
+  out_buf = buf;
+  out_len = src_len;
+
+  if (is_lz4 == true && p_tag->tag_flash_type == FLASH_TAG_TYPE_XIP)
+  {
+    printf("  lz4           : runs in place, stored raw\n");
+  }
+  else if (is_lz4 == true)
+  {
+    if (compressBin(buf, src_len, &out_buf, &out_len) != true)
+    {
+      free(buf);
+      return false;
+    }
+  }
 
 
   /* Store data to dst file */
@@ -451,23 +643,33 @@ bool addTagToBin(char *src_filename, char *dst_filename)
     exit( 1 );
   }
 
-  if(fwrite(buf, 1, src_len, p_fd) != src_len)
+  if(fwrite(out_buf, 1, out_len, p_fd) != out_len)
   {
     fclose(p_fd);
+    if (out_buf != buf) free(out_buf);
     free(buf);
     //_unlink(dst_filename);
     fprintf( stderr, "  total write fail! \n" );
     exit( 1 );
   }
 
-  printf("  created file  : %s (%d KB)\n", dst_filename, (int)((src_len)/1024) );
+  printf("  created file  : %s (%d KB)\n", dst_filename, (int)((out_len)/1024) );
   printf("  tag fw start  : 0x%08X \n", p_tag->tag_flash_start);
   printf("  tag fw end    : 0x%08X \n", p_tag->tag_flash_end);
   printf("  tag crc       : 0x%04X \n", p_tag->tag_flash_crc);
+  if (p_tag->tag_flash_type == FLASH_TAG_TYPE_XIP)
+  {
+    printf("  tag xip       : 0x%08X \n", p_tag->addr_tag);
+  }
   printf("  tag date      : %s \n", p_tag->tag_date_str);
   printf("  tag time      : %s \n", p_tag->tag_time_str);
+  if (p_tag->tag_flash_type == FLASH_TAG_TYPE_LZ4)
+  {
+    printf("  tag lz4       : %d KB -> %d KB\n", (int)(p_tag->tag_flash_length/1024), (int)(p_tag->tag_comp_length/1024));
+  }
 
   fclose(p_fd);
+  if (out_buf != buf) free(out_buf);
   free(buf);
 
   return true;
@@ -8,7 +8,11 @@
 
 
 
+#include <string.h>
+
 #include "boot.h"
+#include "util.h"
+#include "crc.h"
 
 
 
@@ -23,13 +27,48 @@
 #define BOOT_CMD_FLASH_VERIFY           0x06
 #define BOOT_CMD_FLASH_READ             0x07
 #define BOOT_CMD_JUMP_TO_FW             0x08
+#define BOOT_CMD_READ_CAPS              0x09
+#define BOOT_CMD_FLASH_BEGIN            0x0A
+#define BOOT_CMD_FLASH_BLOCK            0x0B
+#define BOOT_CMD_FLASH_HASH             0x0C
 
 
 #define BOOT_CMD_LED_ON                 0x10
 
 
+#define BOOT_BLOCK_HEADER               16
+#define BOOT_WINDOW_MAX                 32
+#define BOOT_BLOCK_RETRY_MAX            3
+#define BOOT_BLOCK_TIMEOUT              5000    // an erase step may run before the ack
+
+
+#define BOOT_HASH_SECTOR                (4*1024)
+#define BOOT_HASH_HEADER                8
+#define BOOT_HASH_MAX                   512         // sectors per BOOT_CMD_FLASH_HASH
+
+
+#define BOOT_BLOCK_LENGTH(n)            ((n) < block_cnt-1 ? block_length : length - (n)*block_length)
+
+
+#define BOOT_BLOCK_STATE_SEND           0
+#define BOOT_BLOCK_STATE_WAIT           1
+#define BOOT_BLOCK_STATE_DONE           2
+
+
+typedef struct
+{
+  uint8_t  state;
+  uint8_t  retry;
+  uint32_t tx_order;        // when it was last sent
+} boot_block_t;
+
+
 cmd_t cmd_boot;
 
+static void   (*delta_progress)(uint32_t done, uint32_t total);
+static uint32_t delta_done;
+static uint32_t delta_total;
+
 
 
 bool bootInit(uint8_t channel, char *port_name, uint32_t baud)
@@ -273,3 +312,463 @@ uint8_t bootCmdJumpToFw(void)
 
   return errcode;
 }
+
+uint8_t bootCmdReadCaps(boot_caps_t *p_caps)
+{
+  bool ret;
+  uint8_t errcode = OK;
+  cmd_t *p_cmd = &cmd_boot;
+
+
+  p_caps->version = 0;
+
+  ret = cmdSendCmdRxResp(p_cmd, BOOT_CMD_READ_CAPS, NULL, 0, 500);
+  if (ret == true && p_cmd->rx_packet.length >= 12)
+  {
+    p_caps->version      = p_cmd->rx_packet.data[0];
+    p_caps->window       = p_cmd->rx_packet.data[1];
+    p_caps->block_length = utilConvert8ToU32(&p_cmd->rx_packet.data[4]);
+    p_caps->erase_step   = utilConvert8ToU32(&p_cmd->rx_packet.data[8]);
+  }
+  else if (ret == true)
+  {
+    errcode = ERR_INVALID_LENGTH;
+  }
+  else
+  {
+    errcode = p_cmd->rx_packet.error;
+  }
+
+  return errcode;
+}
+
+uint8_t bootCmdFlashBegin(uint32_t addr, uint32_t length)
+{
+  bool ret;
+  uint8_t errcode = OK;
+  cmd_t *p_cmd = &cmd_boot;
+  uint8_t data[8];
+
+
+  data[0] = addr >> 0;
+  data[1] = addr >> 8;
+  data[2] = addr >> 16;
+  data[3] = addr >> 24;
+
+  data[4] = length >> 0;
+  data[5] = length >> 8;
+  data[6] = length >> 16;
+  data[7] = length >> 24;
+
+
+  ret = cmdSendCmdRxResp(p_cmd, BOOT_CMD_FLASH_BEGIN, data, 8, BOOT_BLOCK_TIMEOUT);
+  if (ret == false)
+  {
+    errcode = p_cmd->rx_packet.error;
+  }
+
+  return errcode;
+}
+
+static void bootSendBlock(uint32_t seq, uint32_t addr, uint8_t *p_data, uint32_t length)
+{
+  cmd_t *p_cmd = &cmd_boot;
+  uint8_t *data = p_cmd->tx_packet.data;
+  uint32_t crc;
+
+
+  crc = crc32Update(0, p_data, length);
+
+  data[0]  = addr >> 0;
+  data[1]  = addr >> 8;
+  data[2]  = addr >> 16;
+  data[3]  = addr >> 24;
+
+  data[4]  = length >> 0;
+  data[5]  = length >> 8;
+  data[6]  = length >> 16;
+  data[7]  = length >> 24;
+
+  data[8]  = crc >> 0;
+  data[9]  = crc >> 8;
+  data[10] = crc >> 16;
+  data[11] = crc >> 24;
+
+  data[12] = seq >> 0;
+  data[13] = seq >> 8;
+  data[14] = seq >> 16;
+  data[15] = seq >> 24;
+
+  memcpy(&data[BOOT_BLOCK_HEADER], p_data, length);
+
+  cmdSendCmd(p_cmd, BOOT_CMD_FLASH_BLOCK, data, BOOT_BLOCK_HEADER + length);
+}
+
+// Write p_data with up to p_caps->window BOOT_CMD_FLASH_BLOCK packets in
+// flight. The range must have been started with bootCmdFlashBegin().
+//
+// The block index is the sequence number. The boot handles blocks in the
+// order they arrive, so an ack for a block means every block sent before it
+// has either been acked too or got lost on the way; those are sent again
+// right away instead of after the timeout.
+//
+uint8_t bootFlashWriteWindow(uint32_t addr, uint8_t *p_data, uint32_t length, boot_caps_t *p_caps,
+                             void (*progress)(uint32_t done, uint32_t total))
+{
+  uint8_t errcode = OK;
+  cmd_t *p_cmd = &cmd_boot;
+  boot_block_t *p_block;
+  uint32_t block_length;
+  uint32_t block_cnt;
+  uint32_t window;
+  uint32_t in_flight = 0;
+  uint32_t done_cnt = 0;
+  uint32_t done_bytes = 0;
+  uint32_t tx_order = 0;
+  uint32_t send_index = 0;
+  uint32_t pre_time;
+  uint32_t seq;
+  uint32_t offset;
+  uint32_t i;
+
+
+  block_length = p_caps->block_length;
+  if (block_length == 0 || block_length > CMD_MAX_DATA_LENGTH - BOOT_BLOCK_HEADER)
+  {
+    block_length = CMD_MAX_DATA_LENGTH - BOOT_BLOCK_HEADER;
+  }
+  window = p_caps->window;
+  if (window == 0 || window > BOOT_WINDOW_MAX)
+  {
+    window = window == 0 ? 1 : BOOT_WINDOW_MAX;
+  }
+  block_cnt = (length + block_length - 1) / block_length;
+
+  p_block = (boot_block_t *)calloc(block_cnt, sizeof(boot_block_t));
+  if (p_block == NULL)
+  {
+    return ERR_FLASH_SIZE;
+  }
+
+  pre_time = millis();
+
+  while (done_cnt < block_cnt && errcode == OK)
+  {
+    //-- Fill the window, lowest block first
+    //
+    while (in_flight < window)
+    {
+      while (send_index < block_cnt && p_block[send_index].state != BOOT_BLOCK_STATE_SEND)
+      {
+        send_index++;
+      }
+      if (send_index >= block_cnt)
+      {
+        break;
+      }
+
+      offset = send_index * block_length;
+      bootSendBlock(send_index, addr + offset, &p_data[offset], BOOT_BLOCK_LENGTH(send_index));
+
+      p_block[send_index].state    = BOOT_BLOCK_STATE_WAIT;
+      p_block[send_index].tx_order = tx_order++;
+      in_flight++;
+    }
+
+
+    //-- Acks
+    //
+    seq = block_cnt;
+    if (cmdReceivePacket(p_cmd) == true &&
+        p_cmd->rx_packet.cmd == BOOT_CMD_FLASH_BLOCK && p_cmd->rx_packet.length >= 4)
+    {
+      seq = utilConvert8ToU32(&p_cmd->rx_packet.data[0]);
+    }
+
+    if (seq < block_cnt && p_block[seq].state == BOOT_BLOCK_STATE_WAIT)
+    {
+      pre_time = millis();
+
+      for (i=0; i<block_cnt; i++)
+      {
+        if (p_block[i].state == BOOT_BLOCK_STATE_WAIT && p_block[i].tx_order < p_block[seq].tx_order)
+        {
+          p_block[i].state = BOOT_BLOCK_STATE_SEND;
+          p_block[i].retry++;
+          in_flight--;
+          if (i < send_index) send_index = i;
+          if (p_block[i].retry > BOOT_BLOCK_RETRY_MAX) errcode = ERR_TIMEOUT;
+        }
+      }
+
+      in_flight--;
+      if (p_cmd->rx_packet.error == OK)
+      {
+        p_block[seq].state = BOOT_BLOCK_STATE_DONE;
+        done_cnt++;
+        done_bytes += BOOT_BLOCK_LENGTH(seq);
+
+        if (progress != NULL)
+        {
+          progress(done_bytes, length);
+        }
+      }
+      else if (p_block[seq].retry < BOOT_BLOCK_RETRY_MAX)
+      {
+        printf("\nflash block %d \t: retry, %d\n", seq, p_cmd->rx_packet.error);
+        p_block[seq].state = BOOT_BLOCK_STATE_SEND;
+        p_block[seq].retry++;
+        if (seq < send_index) send_index = seq;
+      }
+      else
+      {
+        errcode = p_cmd->rx_packet.error;
+      }
+    }
+
+
+    //-- Nothing came back, send everything in flight again
+    //
+    if (millis()-pre_time >= BOOT_BLOCK_TIMEOUT)
+    {
+      pre_time = millis();
+
+      for (i=0; i<block_cnt; i++)
+      {
+        if (p_block[i].state != BOOT_BLOCK_STATE_WAIT)
+        {
+          continue;
+        }
+        if (p_block[i].retry >= BOOT_BLOCK_RETRY_MAX)
+        {
+          errcode = ERR_TIMEOUT;
+          break;
+        }
+        p_block[i].state = BOOT_BLOCK_STATE_SEND;
+        p_block[i].retry++;
+        in_flight--;
+        if (i < send_index) send_index = i;
+      }
+    }
+  }
+
+  free(p_block);
+
+  return errcode;
+}
+
+// One CRC32 per BOOT_HASH_SECTOR of flash from addr, the last one over what
+// is left of length.
+//
+uint8_t bootCmdFlashHash(uint32_t addr, uint32_t length, uint32_t *p_hash, uint32_t *p_erase_unit)
+{
+  bool ret;
+  uint8_t errcode = OK;
+  cmd_t *p_cmd = &cmd_boot;
+  uint8_t data[8];
+  uint32_t offset;
+  uint32_t req_length;
+  uint32_t hash_cnt;
+  uint32_t i;
+
+
+  for (offset=0; offset<length && errcode == OK; offset+=req_length)
+  {
+    req_length = length - offset;
+    if (req_length > BOOT_HASH_MAX*BOOT_HASH_SECTOR)
+    {
+      req_length = BOOT_HASH_MAX*BOOT_HASH_SECTOR;
+    }
+    hash_cnt = (req_length + BOOT_HASH_SECTOR - 1) / BOOT_HASH_SECTOR;
+
+    data[0] = (addr + offset) >> 0;
+    data[1] = (addr + offset) >> 8;
+    data[2] = (addr + offset) >> 16;
+    data[3] = (addr + offset) >> 24;
+
+    data[4] = req_length >> 0;
+    data[5] = req_length >> 8;
+    data[6] = req_length >> 16;
+    data[7] = req_length >> 24;
+
+    ret = cmdSendCmdRxResp(p_cmd, BOOT_CMD_FLASH_HASH, data, 8, BOOT_BLOCK_TIMEOUT);
+    if (ret != true)
+    {
+      errcode = p_cmd->rx_packet.error;
+    }
+    else if (p_cmd->rx_packet.length != BOOT_HASH_HEADER + hash_cnt*4 ||
+             utilConvert8ToU32(&p_cmd->rx_packet.data[0]) != BOOT_HASH_SECTOR)
+    {
+      errcode = ERR_INVALID_LENGTH;
+    }
+    else
+    {
+      *p_erase_unit = utilConvert8ToU32(&p_cmd->rx_packet.data[4]);
+
+      for (i=0; i<hash_cnt; i++)
+      {
+        p_hash[offset/BOOT_HASH_SECTOR + i] = utilConvert8ToU32(&p_cmd->rx_packet.data[BOOT_HASH_HEADER + i*4]);
+      }
+    }
+  }
+
+  return errcode;
+}
+
+// Progress of one run, total is the run length. delta_done counts the runs
+// already acked, so a finished run moves it on.
+//
+static void bootDeltaProgress(uint32_t done, uint32_t total)
+{
+  if (delta_progress != NULL)
+  {
+    delta_progress(delta_done + done, delta_total);
+  }
+
+  if (done >= total)
+  {
+    delta_done += total;
+  }
+}
+
+// Read back the sector hashes and only rewrite the erase units that differ
+// from p_data, then read the hashes again to check the result. *p_sent is
+// the number of bytes sent, 0 if the flash was already up to date.
+//
+uint8_t bootFlashWriteDelta(uint32_t addr, uint8_t *p_data, uint32_t length, boot_caps_t *p_caps,
+                            void (*progress)(uint32_t done, uint32_t total), uint32_t *p_sent)
+{
+  uint8_t errcode;
+  uint32_t *p_hash;
+  uint8_t  *p_dirty;
+  uint32_t hash_cnt;
+  uint32_t erase_unit = BOOT_HASH_SECTOR;
+  uint32_t unit_cnt;
+  uint32_t unit_base;
+  uint32_t run_begin;
+  uint32_t run_end;
+  uint32_t sector_length;
+  uint32_t i;
+
+
+  *p_sent  = 0;
+  hash_cnt = (length + BOOT_HASH_SECTOR - 1) / BOOT_HASH_SECTOR;
+
+  p_hash = (uint32_t *)calloc(hash_cnt, sizeof(uint32_t));
+  if (p_hash == NULL)
+  {
+    return ERR_FLASH_SIZE;
+  }
+
+  errcode = bootCmdFlashHash(addr, length, p_hash, &erase_unit);
+  if (errcode != OK)
+  {
+    free(p_hash);
+    return errcode;
+  }
+
+
+  //-- Mark the erase units holding a changed sector
+  //
+  if (erase_unit < BOOT_HASH_SECTOR)
+  {
+    erase_unit = BOOT_HASH_SECTOR;
+  }
+  unit_base = addr - addr % erase_unit;
+  unit_cnt  = (addr + length - unit_base + erase_unit - 1) / erase_unit;
+
+  p_dirty = (uint8_t *)calloc(unit_cnt, 1);
+  if (p_dirty == NULL)
+  {
+    free(p_hash);
+    return ERR_FLASH_SIZE;
+  }
+
+  delta_total = 0;
+  for (i=0; i<hash_cnt; i++)
+  {
+    sector_length = length - i*BOOT_HASH_SECTOR;
+    if (sector_length > BOOT_HASH_SECTOR)
+    {
+      sector_length = BOOT_HASH_SECTOR;
+    }
+
+    // Unless addr is aligned the sector may straddle two erase units.
+    if (crc32Update(0, &p_data[i*BOOT_HASH_SECTOR], sector_length) != p_hash[i])
+    {
+      p_dirty[(addr + i*BOOT_HASH_SECTOR - unit_base) / erase_unit] = 1;
+      p_dirty[(addr + i*BOOT_HASH_SECTOR + sector_length - 1 - unit_base) / erase_unit] = 1;
+    }
+  }
+  for (i=0; i<unit_cnt; i++)
+  {
+    if (p_dirty[i])
+    {
+      run_begin = unit_base + i*erase_unit;
+      run_end   = run_begin + erase_unit;
+      if (run_begin < addr)         run_begin = addr;
+      if (run_end > addr + length)  run_end   = addr + length;
+
+      delta_total += run_end - run_begin;
+    }
+  }
+
+
+  //-- Write each run of changed units as one download
+  //
+  delta_progress = progress;
+  delta_done     = 0;
+
+  for (i=0; i<unit_cnt && errcode == OK; )
+  {
+    if (p_dirty[i] == 0)
+    {
+      i++;
+      continue;
+    }
+
+    run_begin = unit_base + i*erase_unit;
+    while (i < unit_cnt && p_dirty[i] != 0)
+    {
+      i++;
+    }
+    run_end = unit_base + i*erase_unit;
+
+    if (run_begin < addr)         run_begin = addr;
+    if (run_end > addr + length)  run_end   = addr + length;
+
+    errcode = bootCmdFlashBegin(run_begin, run_end - run_begin);
+    if (errcode == OK)
+    {
+      errcode = bootFlashWriteWindow(run_begin, &p_data[run_begin - addr], run_end - run_begin, p_caps, bootDeltaProgress);
+    }
+    *p_sent += run_end - run_begin;
+  }
+
+
+  //-- Verify
+  //
+  if (errcode == OK && *p_sent > 0)
+  {
+    errcode = bootCmdFlashHash(addr, length, p_hash, &erase_unit);
+
+    for (i=0; i<hash_cnt && errcode == OK; i++)
+    {
+      sector_length = length - i*BOOT_HASH_SECTOR;
+      if (sector_length > BOOT_HASH_SECTOR)
+      {
+        sector_length = BOOT_HASH_SECTOR;
+      }
+
+      if (crc32Update(0, &p_data[i*BOOT_HASH_SECTOR], sector_length) != p_hash[i])
+      {
+        errcode = ERR_FLASH_CRC;
+      }
+    }
+  }
+
+  free(p_dirty);
+  free(p_hash);
+
+  return errcode;
+}
@@ -15,6 +15,15 @@
 
 
 
+typedef struct
+{
+  uint8_t  version;         // 0 : old boot, only the commands below, 2 : BOOT_CMD_FLASH_HASH
+  uint8_t  window;          // blocks that may be in flight
+  uint32_t block_length;    // max. data per BOOT_CMD_FLASH_BLOCK
+  uint32_t erase_step;
+} boot_caps_t;
+
+
 bool bootInit(uint8_t channel, char *port_name, uint32_t baud);
 
 uint8_t bootCmdReadBootVersion(uint8_t *p_version);
@@ -27,5 +36,13 @@ uint8_t bootCmdFlashErase(uint32_t addr, uint32_t length);
 uint8_t bootCmdFlashWrite(uint32_t addr, uint8_t *p_data, uint32_t length);
 uint8_t bootCmdJumpToFw(void);
 
+uint8_t bootCmdReadCaps(boot_caps_t *p_caps);
+uint8_t bootCmdFlashBegin(uint32_t addr, uint32_t length);
+uint8_t bootFlashWriteWindow(uint32_t addr, uint8_t *p_data, uint32_t length, boot_caps_t *p_caps,
+                             void (*progress)(uint32_t done, uint32_t total));
+uint8_t bootCmdFlashHash(uint32_t addr, uint32_t length, uint32_t *p_hash, uint32_t *p_erase_unit);
+uint8_t bootFlashWriteDelta(uint32_t addr, uint8_t *p_data, uint32_t length, boot_caps_t *p_caps,
+                            void (*progress)(uint32_t done, uint32_t total), uint32_t *p_sent);
+
 
 #endif /* SRC_AP_BOOT_BOOT_H_ */
@@ -18,7 +18,7 @@
 
 
 
-#define CMD_MAX_DATA_LENGTH       2048
+#define CMD_MAX_DATA_LENGTH       (4*1024 + 64)
 
 
 
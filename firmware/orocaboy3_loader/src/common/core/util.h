@@ -34,8 +34,6 @@ bool utilGetRange(data_range_t *p_range);
 uint32_t utilConvert8ToU32 (uint8_t *p_data);
 uint16_t utilConvert8ToU16 (uint8_t *p_data);
 
-void utilUpdateCrc(uint16_t *p_crc_cur, uint8_t data_in);
-
 #ifdef __cplusplus
 }
 #endif
@@ -60,9 +60,17 @@ typedef struct
   uint32_t tag_length;
   uint8_t  tag_date_str[32];
   uint8_t  tag_time_str[32];
+  uint32_t tag_comp_length;   // FLASH_TAG_TYPE_LZ4 : bytes of compressed data after the tag
 } flash_tag_t;
 
 
+#define FLASH_MAGIC_NUMBER      0x5555AAAA
+
+#define FLASH_TAG_TYPE_RAW      0           // image follows the tag as is
+#define FLASH_TAG_TYPE_LZ4      1           // image follows the tag as LZ4 blocks
+#define FLASH_TAG_TYPE_XIP      2           // raw image run in place from the QSPI slot at addr_tag
+
+
 
 #define _DEF_UART1        0
 #define _DEF_UART2        1
@@ -11,6 +11,10 @@
 
 #define OK    0
 
+#define ERR_INVALID_CMD               100
+#define ERR_INVALID_LENGTH            239
+#define ERR_FLASH_INVALID_CHECK_SUM   240
+
 #define ERR_INVALID_FW                242
 #define ERR_FLASH_ADDR_ALIGN          243
 #define ERR_FLASH_INVALID_ADDR        244
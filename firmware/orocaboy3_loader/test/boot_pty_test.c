@@ -0,0 +1,742 @@
+/*
+ * boot_pty_test.c
+ *
+ *  Host test for the windowed download : the loader (ap/boot/boot.c,
+ *  common/cmd/cmd.c) talks over a pty to the boot (orocaboy3_boot
+ *  ap/boot/boot.cpp, hw/core/cmd.c) running in a child process.
+ *  The boot flash is shared memory, so the parent checks the image, that
+ *  every sector of the range is erased once and none outside it, and that
+ *  no byte is programmed twice. The erase takes a while, like the real one.
+ *
+ *  The download runs on _DEF_UART2, the vcp with a window of blocks in
+ *  flight, and on _DEF_UART1 with one block at a time. On the way a block
+ *  is damaged past the packet checksum, so only its CRC32 catches it, and
+ *  on the vcp an ack is lost, so the block is sent again after it was
+ *  written.
+ *
+ *  Then bootFlashWriteDelta() on a flash that already holds the image : no
+ *  change sends nothing, a few edits send and erase only the 128 KB units
+ *  around them, and the progress ends on the bytes sent.
+ *
+ *  This file is built twice, once with BOOT_SIDE for the boot :
+ *    B=../../orocaboy3_boot/src
+ *    gcc -O2 -DBOOT_SIDE -I$B/common -I$B/common/core -I$B/common/hw/include \
+ *        -I$B/hw -I$B/ap/boot -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *        -c boot_pty_test.c -o boot_side.o
+ *    gcc -O2 -I../src -I../src/ap -I../src/bsp -I../src/common \
+ *        -I../src/common/core -I../src/hw -o boot_pty_test \
+ *        boot_pty_test.c boot_side.o && ./boot_pty_test
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+
+
+#define TEST_FLASH_START      0x08040000
+#define TEST_FLASH_END        0x08200000
+#define TEST_FLASH_SIZE       (TEST_FLASH_END - TEST_FLASH_START)
+#define TEST_SECTOR           (128*1024)
+#define TEST_SECTOR_CNT       (TEST_FLASH_SIZE / TEST_SECTOR)
+#define TEST_ERASE_US         30000       // per sector, under the 100ms byte timeout of the boot
+
+
+// Shared between the boot child and the parent.
+//
+typedef struct
+{
+  uint8_t  flash[TEST_FLASH_SIZE];
+  uint32_t erase_cnt[TEST_SECTOR_CNT];
+  uint32_t write_twice;                 // bytes programmed while not erased
+  uint32_t crc_fail;                    // blocks damaged on the way
+  uint32_t ack_drop;                    // acks lost on the way
+} test_flash_t;
+
+void bootSideMain(int fd, uint8_t ch, test_flash_t *p_flash);
+
+
+
+#ifdef BOOT_SIDE
+
+//-- The boot, with its names moved out of the way of the loader
+//
+#define cmdInit               b_cmdInit
+#define cmdBegin              b_cmdBegin
+#define cmdReceivePacket      b_cmdReceivePacket
+#define cmdSendCmd            b_cmdSendCmd
+#define cmdSendResp           b_cmdSendResp
+#define cmdSendCmdRxResp      b_cmdSendCmdRxResp
+#define uartOpen              b_uartOpen
+#define uartAvailable         b_uartAvailable
+#define uartRead              b_uartRead
+#define uartWrite             b_uartWrite
+#define millis                b_millis
+#define delay                 b_delay
+#define utilGetRange          b_utilGetRange
+#define utilConvert8ToU32     b_utilConvert8ToU32
+#define utilConvert8ToU16     b_utilConvert8ToU16
+#define crc16Update           b_crc16Update
+#define crc32Update           b_crc32Update
+#define crcTest               b_crcTest
+#define bootInit              b_bootInit
+#define bootProcessCmd        b_bootProcessCmd
+#define bootJumpToFw          b_bootJumpToFw
+#define bootVerifyFw          b_bootVerifyFw
+#define bootVerifyCrc         b_bootVerifyCrc
+
+
+#include "def.h"
+
+// hw.h, hw_def.h and uart.h pull in the whole board, the boot only needs these.
+//
+#define SRC_HW_HW_H_
+#define SRC_HW_HW_DEF_H_
+#define SRC_COMMON_HW_UART_H_
+
+#define _USE_HW_CMD
+#define      HW_CMD_MAX_DATA_LENGTH         (4*1024 + 64)
+
+#define FLASH_ADDR_TAG                0x08040000
+#define FLASH_ADDR_FW                 0x08040400
+#define FLASH_ADDR_START              TEST_FLASH_START
+#define FLASH_ADDR_END                TEST_FLASH_END
+
+#include "cmd.h"
+
+
+uint32_t millis(void);
+void     delay(uint32_t ms);
+void     logPrintf(const char *fmt, ...);
+void     bspDeInit(void);
+bool     flashErase(uint32_t addr, uint32_t length);
+bool     flashWrite(uint32_t addr, uint8_t *p_data, uint32_t length);
+bool     flashRead(uint32_t addr, uint8_t *p_data, uint32_t length);
+uint32_t qspiGetAddr(void);
+uint32_t qspiGetLength(void);
+bool     uartOpen(uint8_t channel, uint32_t baud);
+uint32_t uartAvailable(uint8_t channel);
+uint8_t  uartRead(uint8_t channel);
+int32_t  uartWrite(uint8_t channel, uint8_t *p_data, uint32_t length);
+
+#include "../../orocaboy3_boot/src/hw/core/cmd.c"
+#include "../../orocaboy3_boot/src/common/core/util.c"
+#include "../../orocaboy3_boot/src/common/core/crc.c"
+#include "../../orocaboy3_boot/src/ap/boot/boot.cpp"
+
+const __attribute__((section(".version"))) uint8_t boot_ver[32]  = "B200101R1";
+const __attribute__((section(".version"))) uint8_t boot_name[32] = "OROCABOY3";
+
+
+static int           boot_fd;
+static test_flash_t *p_test;
+static uint8_t       rx_buf[64*1024];
+static uint32_t      rx_in;
+static uint32_t      rx_out;
+static bool          tx_drop;
+
+
+uint32_t millis(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+void delay(uint32_t ms)
+{
+  usleep(ms*1000);
+}
+
+void logPrintf(const char *fmt, ...)
+{
+}
+
+void bspDeInit(void)
+{
+}
+
+uint32_t qspiGetAddr(void)
+{
+  return 0x90000000;
+}
+
+uint32_t qspiGetLength(void)
+{
+  return 0;
+}
+
+static bool flashIsRange(uint32_t addr, uint32_t length)
+{
+  return addr >= TEST_FLASH_START && length <= TEST_FLASH_END - addr;
+}
+
+// Like the internal flash : every 128 KB sector touched by the range.
+//
+bool flashErase(uint32_t addr, uint32_t length)
+{
+  uint32_t sector;
+
+
+  if (length == 0 || flashIsRange(addr, length) != true)
+  {
+    return false;
+  }
+
+  for (sector = (addr - TEST_FLASH_START) / TEST_SECTOR;
+       sector <= (addr + length - 1 - TEST_FLASH_START) / TEST_SECTOR;
+       sector++)
+  {
+    memset(&p_test->flash[sector*TEST_SECTOR], 0xFF, TEST_SECTOR);
+    p_test->erase_cnt[sector]++;
+    usleep(TEST_ERASE_US);
+  }
+
+  return true;
+}
+
+bool flashWrite(uint32_t addr, uint8_t *p_data, uint32_t length)
+{
+  uint8_t *p_dst;
+  uint32_t i;
+
+
+  if (flashIsRange(addr, length) != true)
+  {
+    return false;
+  }
+
+  p_dst = &p_test->flash[addr - TEST_FLASH_START];
+  for (i=0; i<length; i++)
+  {
+    if (p_dst[i] != 0xFF)
+    {
+      p_test->write_twice++;
+    }
+    p_dst[i] = p_data[i];
+  }
+
+  return true;
+}
+
+bool flashRead(uint32_t addr, uint8_t *p_data, uint32_t length)
+{
+  if (flashIsRange(addr, length) != true)
+  {
+    return false;
+  }
+
+  memcpy(p_data, &p_test->flash[addr - TEST_FLASH_START], length);
+  return true;
+}
+
+bool uartOpen(uint8_t channel, uint32_t baud)
+{
+  return true;
+}
+
+uint32_t uartAvailable(uint8_t channel)
+{
+  int len;
+
+
+  if (rx_in == rx_out)
+  {
+    rx_in  = 0;
+    rx_out = 0;
+
+    len = read(boot_fd, rx_buf, sizeof(rx_buf));
+    if (len > 0)
+    {
+      rx_in = len;
+    }
+    else if (len == 0 || (errno != EAGAIN && errno != EINTR))
+    {
+      _exit(0);                         // the loader has closed the pty
+    }
+  }
+
+  return rx_in - rx_out;
+}
+
+uint8_t uartRead(uint8_t channel)
+{
+  return rx_buf[rx_out++];
+}
+
+int32_t uartWrite(uint8_t channel, uint8_t *p_data, uint32_t length)
+{
+  uint32_t index = 0;
+  int len;
+
+
+  if (tx_drop == true)
+  {
+    tx_drop = false;
+    return length;
+  }
+
+  while (index < length)
+  {
+    len = write(boot_fd, &p_data[index], length - index);
+    if (len > 0)
+    {
+      index += len;
+    }
+    else if (errno != EAGAIN && errno != EINTR)
+    {
+      _exit(0);
+    }
+  }
+
+  return length;
+}
+
+
+// Block 2 gets two bits flipped in the same position, which the xor checksum
+// of the packet does not see. On the vcp the ack of block 5 is lost. Both
+// only the first time they come in.
+//
+void bootSideMain(int fd, uint8_t ch, test_flash_t *p_flash)
+{
+  static cmd_t cmd;
+  bool is_hit[8] = {false, };
+  uint32_t seq;
+
+
+  boot_fd = fd;
+  p_test  = p_flash;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  cmdInit(&cmd);
+  cmdBegin(&cmd, ch, 115200);
+
+  while (1)
+  {
+    if (cmdReceivePacket(&cmd) != true)
+    {
+      continue;
+    }
+
+    if (cmd.rx_packet.cmd == BOOT_CMD_FLASH_BLOCK && cmd.rx_packet.length > BOOT_BLOCK_HEADER + 1)
+    {
+      seq = utilConvert8ToU32(&cmd.rx_packet.data[12]);
+
+      if (seq == 2 && is_hit[2] != true)
+      {
+        cmd.rx_packet.data[BOOT_BLOCK_HEADER + 0] ^= 0x01;
+        cmd.rx_packet.data[BOOT_BLOCK_HEADER + 1] ^= 0x01;
+        p_test->crc_fail++;
+        is_hit[2] = true;
+      }
+      if (seq == 5 && is_hit[5] != true && ch == BOOT_CH_VCP)
+      {
+        tx_drop = true;
+        p_test->ack_drop++;
+        is_hit[5] = true;
+      }
+    }
+
+    bootProcessCmd(&cmd);
+  }
+}
+
+#else
+
+//-- The loader
+//
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+#include "ap.h"
+
+#include "../src/ap/boot/boot.c"
+#include "../src/common/cmd/cmd.c"
+#include "../src/common/core/util.c"
+#include "../src/common/core/crc.c"
+
+
+static char  uart_port_name[UART_MAX_CH][128];
+static int   uart_fd[UART_MAX_CH] = {-1, -1, -1, -1, -1, -1, -1, -1};
+
+static int   test_fail = 0;
+static uint32_t progress_done;
+static uint32_t progress_total;
+
+#define CHECK(x)  do { if (!(x)) { printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #x); test_fail++; } } while (0)
+
+
+uint32_t millis(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+void delay(uint32_t time_ms)
+{
+  usleep(time_ms*1000);
+}
+
+
+// hw/core/uart.c only knows Windows, this is the same api on a pty.
+//
+void uartInit(void)
+{
+}
+
+bool uartOpen(uint8_t channel, uint32_t baud)
+{
+  struct termios tio;
+
+
+  uartClose(channel);
+
+  uart_fd[channel] = open(uart_port_name[channel], O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (uart_fd[channel] < 0)
+  {
+    return false;
+  }
+
+  tcgetattr(uart_fd[channel], &tio);
+  cfmakeraw(&tio);
+  tcsetattr(uart_fd[channel], TCSANOW, &tio);
+
+  return true;
+}
+
+bool uartClose(uint8_t channel)
+{
+  if (uart_fd[channel] >= 0)
+  {
+    close(uart_fd[channel]);
+    uart_fd[channel] = -1;
+  }
+  return true;
+}
+
+void uartSetPortName(uint8_t channel, char *port_name)
+{
+  snprintf(uart_port_name[channel], sizeof(uart_port_name[channel]), "%s", port_name);
+}
+
+uint32_t uartAvailable(uint8_t channel)
+{
+  int length = 0;
+
+
+  if (ioctl(uart_fd[channel], FIONREAD, &length) < 0)
+  {
+    return 0;
+  }
+  return length;
+}
+
+void uartFlush(uint8_t channel)
+{
+  tcflush(uart_fd[channel], TCIOFLUSH);
+}
+
+void uartPutch(uint8_t channel, uint8_t ch)
+{
+  uartWrite(channel, &ch, 1);
+}
+
+uint8_t uartGetch(uint8_t channel)
+{
+  while (uartAvailable(channel) == 0);
+  return uartRead(channel);
+}
+
+int32_t uartWrite(uint8_t channel, uint8_t *p_data, uint32_t length)
+{
+  uint32_t index = 0;
+  int len;
+
+
+  while (index < length)
+  {
+    len = write(uart_fd[channel], &p_data[index], length - index);
+    if (len > 0)
+    {
+      index += len;
+    }
+    else if (errno != EAGAIN && errno != EINTR)
+    {
+      return -1;
+    }
+  }
+
+  return length;
+}
+
+uint8_t uartRead(uint8_t channel)
+{
+  uint8_t ch = 0;
+
+  if (read(uart_fd[channel], &ch, 1) != 1)
+  {
+    ch = 0;
+  }
+  return ch;
+}
+
+int32_t uartPrintf(uint8_t channel, const char *fmt, ...)
+{
+  char buf[256];
+  va_list arg;
+  int len;
+
+
+  va_start(arg, fmt);
+  len = vsnprintf(buf, sizeof(buf), fmt, arg);
+  va_end(arg);
+
+  return uartWrite(channel, (uint8_t *)buf, len);
+}
+
+
+
+static void testProgress(uint32_t done, uint32_t total)
+{
+  CHECK(done > progress_done && done <= total);
+  progress_done  = done;
+  progress_total = total;
+}
+
+static uint32_t rnd_seed = 1;
+
+static uint32_t rnd(void)
+{
+  rnd_seed ^= rnd_seed << 13;
+  rnd_seed ^= rnd_seed >> 17;
+  rnd_seed ^= rnd_seed << 5;
+  return rnd_seed;
+}
+
+// Starts the boot on a fresh pty and opens the other end as the loader.
+//
+static pid_t testBegin(uint8_t ch, test_flash_t *p_flash)
+{
+  int   fd;
+  pid_t pid;
+
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+  {
+    printf("no pty\n");
+    exit(1);
+  }
+
+  // Skip bootInit(), which asks a running firmware to reset into the boot.
+  // The loader end is open before the boot runs, the boot takes a closed
+  // one for the end of the test.
+  cmdInit(&cmd_boot);
+  uartSetPortName(ch, ptsname(fd));
+  CHECK(cmdBegin(&cmd_boot, ch, 115200) == true);
+
+  pid = fork();
+  if (pid == 0)
+  {
+    uartClose(ch);
+    bootSideMain(fd, ch, p_flash);
+    _exit(0);
+  }
+  close(fd);
+
+  return pid;
+}
+
+static void testEnd(uint8_t ch, pid_t pid)
+{
+  uartClose(ch);
+  kill(pid, SIGTERM);
+  waitpid(pid, NULL, 0);
+}
+
+static void testDownload(const char *name, uint8_t ch, uint32_t addr, uint32_t length, uint8_t window, test_flash_t *p_flash)
+{
+  boot_caps_t caps;
+  uint8_t *p_image;
+  uint32_t sector_begin;
+  uint32_t sector_end;
+  uint32_t i;
+  pid_t pid;
+  uint32_t pre_time;
+
+
+  p_image = malloc(length);
+  for (i=0; i<length; i++)
+  {
+    p_image[i] = rnd();
+  }
+
+  memset(p_flash, 0, sizeof(test_flash_t));
+  for (i=0; i<TEST_FLASH_SIZE; i++)
+  {
+    p_flash->flash[i] = rnd();          // whatever was there before
+  }
+  progress_done  = 0;
+  progress_total = 0;
+
+  pid = testBegin(ch, p_flash);
+  pre_time = millis();
+
+  CHECK(bootCmdReadCaps(&caps) == OK);
+  CHECK(caps.version >= 2);
+  CHECK(caps.window == window);
+  CHECK(caps.block_length == 4*1024);
+  CHECK(caps.erase_step == TEST_SECTOR);
+
+  CHECK(bootCmdFlashBegin(addr, length) == OK);
+  CHECK(bootFlashWriteWindow(addr, p_image, length, &caps, testProgress) == OK);
+  CHECK(progress_done == length && progress_total == length);
+
+  testEnd(ch, pid);
+
+
+  CHECK(memcmp(&p_flash->flash[addr - TEST_FLASH_START], p_image, length) == 0);
+  CHECK(p_flash->write_twice == 0);
+  CHECK(p_flash->crc_fail == 1);
+  CHECK(p_flash->ack_drop == (ch == _DEF_UART2 ? 1 : 0));
+
+  sector_begin = (addr - TEST_FLASH_START) / TEST_SECTOR;
+  sector_end   = (addr + length - 1 - TEST_FLASH_START) / TEST_SECTOR;
+  for (i=0; i<TEST_SECTOR_CNT; i++)
+  {
+    CHECK(p_flash->erase_cnt[i] == (i >= sector_begin && i <= sector_end ? 1 : 0));
+  }
+
+  printf("%-10s: %d KB, window %d, %d ms, %s\n", name, length/1024, caps.window, millis() - pre_time,
+         test_fail == 0 ? "ok" : "FAIL");
+
+  free(p_image);
+}
+
+// The flash already holds p_image but for the bytes at p_edit. The delta
+// must send and erase only the 128 KB units holding an edit, and nothing
+// when there is none. With addr off the 4 KB grid a hash sector straddles
+// two units and both go.
+//
+static void testDelta(const char *name, uint8_t ch, uint32_t addr, uint32_t length,
+                      const uint32_t *p_edit, uint32_t edit_cnt, test_flash_t *p_flash)
+{
+  boot_caps_t caps;
+  uint8_t *p_image;
+  uint8_t  is_dirty[TEST_SECTOR_CNT] = {0, };
+  uint32_t sent = 0;
+  uint32_t expect_sent = 0;
+  uint32_t run_begin;
+  uint32_t run_end;
+  uint32_t i;
+  pid_t pid;
+  uint32_t pre_time;
+
+
+  p_image = malloc(length);
+  for (i=0; i<length; i++)
+  {
+    p_image[i] = rnd();
+  }
+
+  memset(p_flash, 0, sizeof(test_flash_t));
+  for (i=0; i<TEST_FLASH_SIZE; i++)
+  {
+    p_flash->flash[i] = rnd();
+  }
+  memcpy(&p_flash->flash[addr - TEST_FLASH_START], p_image, length);
+
+  // The boot hashes 4 KB sectors from addr, so an edit dirties the units
+  // under its whole hash sector.
+  for (i=0; i<edit_cnt; i++)
+  {
+    run_begin = addr + p_edit[i] - p_edit[i] % 4096;
+    run_end   = run_begin + 4096;
+    if (run_end > addr + length)  run_end = addr + length;
+
+    p_image[p_edit[i]] ^= 0x5A;
+    is_dirty[(run_begin - TEST_FLASH_START) / TEST_SECTOR] = 1;
+    is_dirty[(run_end - 1 - TEST_FLASH_START) / TEST_SECTOR] = 1;
+  }
+  for (i=0; i<TEST_SECTOR_CNT; i++)
+  {
+    if (is_dirty[i])
+    {
+      run_begin = TEST_FLASH_START + i*TEST_SECTOR;
+      run_end   = run_begin + TEST_SECTOR;
+      if (run_begin < addr)         run_begin = addr;
+      if (run_end > addr + length)  run_end   = addr + length;
+
+      expect_sent += run_end - run_begin;
+    }
+  }
+  progress_done  = 0;
+  progress_total = 0;
+
+  pid = testBegin(ch, p_flash);
+  pre_time = millis();
+
+  CHECK(bootCmdReadCaps(&caps) == OK);
+  CHECK(bootFlashWriteDelta(addr, p_image, length, &caps, testProgress, &sent) == OK);
+
+  testEnd(ch, pid);
+
+
+  CHECK(sent == expect_sent);
+  CHECK(progress_done == expect_sent);
+  CHECK(progress_total == expect_sent);
+  CHECK(memcmp(&p_flash->flash[addr - TEST_FLASH_START], p_image, length) == 0);
+  CHECK(p_flash->write_twice == 0);
+  CHECK(p_flash->crc_fail == (edit_cnt > 0 ? 1 : 0));
+
+  for (i=0; i<TEST_SECTOR_CNT; i++)
+  {
+    CHECK(p_flash->erase_cnt[i] == is_dirty[i]);
+  }
+
+  printf("%-10s: %d KB, %d KB sent, %d ms, %s\n", name, length/1024, sent/1024, millis() - pre_time,
+         test_fail == 0 ? "ok" : "FAIL");
+
+  free(p_image);
+}
+
+
+int main(void)
+{
+  const uint32_t edit_none[] = { 0 };
+  const uint32_t edit_vcp[]  = { 100, 2*TEST_SECTOR + 7, 3*TEST_SECTOR + 4096, 5*TEST_SECTOR + 1233 };
+  const uint32_t edit_uart[] = { 2*TEST_SECTOR - 0x400 + 5 };
+  test_flash_t *p_flash;
+
+
+  p_flash = mmap(NULL, sizeof(test_flash_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (p_flash == MAP_FAILED)
+  {
+    return 1;
+  }
+
+  testDownload("vcp",   _DEF_UART2, 0x08040000, 5*TEST_SECTOR + 1234, 8, p_flash);
+  testDownload("uart",  _DEF_UART1, 0x08040400, 2*TEST_SECTOR + 4096*3 + 17, 1, p_flash);
+
+  testDelta("vcp same",   _DEF_UART2, 0x08040000, 5*TEST_SECTOR + 1234, edit_none, 0, p_flash);
+  testDelta("vcp delta",  _DEF_UART2, 0x08040000, 5*TEST_SECTOR + 1234, edit_vcp, 4, p_flash);
+  testDelta("uart delta", _DEF_UART1, 0x08040400, 2*TEST_SECTOR + 4096*3 + 17, edit_uart, 1, p_flash);
+
+  printf("%s\n", test_fail == 0 ? "boot_pty_test : OK" : "boot_pty_test : FAIL");
+
+  return test_fail == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * crc_test.c
+ *
+ *  Host test for the slice-by-8 CRC16/CRC32 (common/core/crc.c, the same
+ *  file in the firmware and the boot). Runs crcTest(), checks published
+ *  check values, then random lengths, alignments and chunk splits against
+ *  a bit by bit reference. Prints the speed against the reference.
+ *
+ *  Build and run from this directory :
+ *    gcc -O2 -I../src -I../src/ap -I../src/bsp -I../src/common \
+ *        -I../src/common/core -I../src/hw -o crc_test crc_test.c && ./crc_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/common/core/crc.c"
+
+
+
+#define RND_LENGTH    (70*1024)
+#define SPEED_LENGTH  (2*1024*1024)
+
+typedef struct
+{
+  const char *str;
+  uint16_t    crc16;
+  uint32_t    crc32;
+} check_t;
+
+// CRC-16/UMTS (poly 0x8005, init 0) and CRC-32/ISO-HDLC (zlib).
+//
+static const check_t check_tbl[] =
+{
+  {"",                                             0x0000, 0x00000000},
+  {"a",                                            0x8145, 0xE8B7BE43},
+  {"abc",                                          0xCADB, 0x352441C2},
+  {"123456789",                                    0xFEE8, 0xCBF43926},
+  {"The quick brown fox jumps over the lazy dog",  0x60AE, 0x414FA339},
+};
+
+static int test_fail = 0;
+static uint32_t rnd_seed = 1;
+
+#define CHECK(x)  do { if (!(x)) { printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #x); test_fail++; } } while (0)
+
+
+static uint32_t rnd(void)
+{
+  rnd_seed ^= rnd_seed << 13;
+  rnd_seed ^= rnd_seed >> 17;
+  rnd_seed ^= rnd_seed << 5;
+  return rnd_seed;
+}
+
+static uint16_t refCrc16(uint16_t crc, const uint8_t *p_data, uint32_t length)
+{
+  uint32_t i;
+  uint32_t k;
+
+  for (i=0; i<length; i++)
+  {
+    crc ^= p_data[i] << 8;
+    for (k=0; k<8; k++)
+    {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : (crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+static uint32_t refCrc32(uint32_t crc, const uint8_t *p_data, uint32_t length)
+{
+  uint32_t i;
+  uint32_t k;
+
+  crc = ~crc;
+  for (i=0; i<length; i++)
+  {
+    crc ^= p_data[i];
+    for (k=0; k<8; k++)
+    {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+    }
+  }
+
+  return ~crc;
+}
+
+static double seconds(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void testCheck(void)
+{
+  uint32_t i;
+  const uint8_t *p_str;
+  uint32_t length;
+
+
+  CHECK(crcTest() == true);
+
+  for (i=0; i<sizeof(check_tbl)/sizeof(check_t); i++)
+  {
+    p_str  = (const uint8_t *)check_tbl[i].str;
+    length = strlen(check_tbl[i].str);
+
+    CHECK(crc16Update(0, p_str, length) == check_tbl[i].crc16);
+    CHECK(crc32Update(0, p_str, length) == check_tbl[i].crc32);
+    CHECK(refCrc16(0, p_str, length) == check_tbl[i].crc16);
+    CHECK(refCrc32(0, p_str, length) == check_tbl[i].crc32);
+  }
+}
+
+// Random offset and length, then the same data in up to 8 random chunks.
+//
+static void testRandom(uint8_t *p_buf)
+{
+  uint32_t run;
+  uint32_t ofs;
+  uint32_t length;
+  uint32_t done;
+  uint32_t chunk;
+  uint16_t crc16;
+  uint32_t crc32;
+  uint16_t part16;
+  uint32_t part32;
+  int i;
+
+
+  for (i=0; i<RND_LENGTH; i++)
+  {
+    p_buf[i] = rnd();
+  }
+
+  for (run=0; run<2000; run++)
+  {
+    ofs    = rnd() % 64;
+    length = run < 200 ? run : rnd() % (RND_LENGTH - ofs);
+
+    crc16 = refCrc16(0, &p_buf[ofs], length);
+    crc32 = refCrc32(0, &p_buf[ofs], length);
+
+    CHECK(crc16Update(0, &p_buf[ofs], length) == crc16);
+    CHECK(crc32Update(0, &p_buf[ofs], length) == crc32);
+
+    part16 = 0;
+    part32 = 0;
+    for (done=0, i=0; done < length; i++)
+    {
+      chunk = i < 7 ? rnd() % (length - done + 1) : length - done;
+
+      part16 = crc16Update(part16, &p_buf[ofs + done], chunk);
+      part32 = crc32Update(part32, &p_buf[ofs + done], chunk);
+      done  += chunk;
+    }
+    CHECK(part16 == crc16);
+    CHECK(part32 == crc32);
+  }
+}
+
+static void testSpeed(void)
+{
+  uint8_t *p_buf = malloc(SPEED_LENGTH);
+  volatile uint32_t sink = 0;
+  double t[3];
+  int i;
+
+
+  for (i=0; i<SPEED_LENGTH; i++)
+  {
+    p_buf[i] = rnd();
+  }
+
+  t[0] = seconds();
+  sink += crc32Update(0, p_buf, SPEED_LENGTH);
+  sink += crc16Update(0, p_buf, SPEED_LENGTH);
+  t[1] = seconds();
+  sink += refCrc32(0, p_buf, SPEED_LENGTH);
+  sink += refCrc16(0, p_buf, SPEED_LENGTH);
+  t[2] = seconds();
+
+  printf("2MB crc16+crc32 : slice-by-8 %.2f ms, bit by bit %.2f ms\n",
+         (t[1] - t[0]) * 1000, (t[2] - t[1]) * 1000);
+
+  free(p_buf);
+}
+
+
+int main(void)
+{
+  static uint8_t buf[RND_LENGTH];
+
+
+  testCheck();
+  printf("vectors   : %s\n", test_fail == 0 ? "ok" : "FAIL");
+
+  testRandom(buf);
+  printf("random    : %s\n", test_fail == 0 ? "ok" : "FAIL");
+
+  testSpeed();
+
+  printf("%s\n", test_fail == 0 ? "crc_test : OK" : "crc_test : FAIL");
+
+  return test_fail == 0 ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+/*
+ * lz4_test.c
+ *
+ *  Host test for the LZ4 slot image format (common/core/lz4.c) and the
+ *  "fwz" path of the loader (compressBin(), addTagToBin() in ap/ap.c).
+ *  Streams are checked block by block : compressed and raw blocks, a
+ *  short tail block of either kind, sizes on and next to LZ4_BLOCK_SIZE,
+ *  truncated and damaged streams. Images go through addTagToBin() into a
+ *  file and are decoded back against the source.
+ *
+ *  Build and run from this directory :
+ *    gcc -O2 -I../src -I../src/ap -I../src/bsp -I../src/common \
+ *        -I../src/common/core -I../src/hw -o lz4_test lz4_test.c && ./lz4_test
+ */
+
+#include <string.h>
+
+#include "../src/ap/ap.c"
+#include "../src/common/core/lz4.c"
+#include "../src/common/core/crc.c"
+
+
+
+// ap.c talks to the board through these, nothing here gets that far.
+//
+uint32_t millis(void) { return 0; }
+bool uartClose(uint8_t channel) { return true; }
+bool bootInit(uint8_t channel, char *port_name, uint32_t baud) { return false; }
+uint8_t bootCmdReadBootVersion(uint8_t *p_version) { return 1; }
+uint8_t bootCmdReadBootName(uint8_t *p_str) { return 1; }
+uint8_t bootCmdReadFirmVersion(uint8_t *p_version) { return 1; }
+uint8_t bootCmdReadCaps(boot_caps_t *p_caps) { return 1; }
+uint8_t bootCmdFlashErase(uint32_t addr, uint32_t length) { return 1; }
+uint8_t bootCmdFlashWrite(uint32_t addr, uint8_t *p_data, uint32_t length) { return 1; }
+uint8_t bootCmdFlashBegin(uint32_t addr, uint32_t length) { return 1; }
+uint8_t bootCmdJumpToFw(void) { return 1; }
+uint8_t bootFlashWriteWindow(uint32_t addr, uint8_t *p_data, uint32_t length, boot_caps_t *p_caps,
+                             void (*progress)(uint32_t done, uint32_t total)) { return 1; }
+uint8_t bootFlashWriteDelta(uint32_t addr, uint8_t *p_data, uint32_t length, boot_caps_t *p_caps,
+                            void (*progress)(uint32_t done, uint32_t total), uint32_t *p_sent) { return 1; }
+
+
+
+#define PAT_ZERO    0     // every block compresses
+#define PAT_RANDOM  1     // every block is stored raw
+#define PAT_MIXED   2     // even blocks compress, odd blocks are raw
+
+static int test_fail = 0;
+static uint32_t rnd_seed = 1;
+
+#define CHECK(x)  do { if (!(x)) { printf("FAIL %s:%d : %s\n", __FILE__, __LINE__, #x); test_fail++; } } while (0)
+
+
+static uint32_t rnd(void)
+{
+  rnd_seed ^= rnd_seed << 13;
+  rnd_seed ^= rnd_seed >> 17;
+  rnd_seed ^= rnd_seed << 5;
+  return rnd_seed;
+}
+
+static void fill(uint8_t *p_buf, uint32_t length, int pattern)
+{
+  uint32_t i;
+
+  for (i=0; i<length; i++)
+  {
+    switch (pattern)
+    {
+      case PAT_ZERO:
+        p_buf[i] = (i / 100) & 0x03;
+        break;
+
+      case PAT_RANDOM:
+        p_buf[i] = rnd();
+        break;
+
+      default:
+        p_buf[i] = ((i / LZ4_BLOCK_SIZE) & 1) ? rnd() : "orocaboy"[i % 8];
+        break;
+    }
+  }
+}
+
+// Walks the headers : each block but the last decodes to LZ4_BLOCK_SIZE,
+// the tail to what is left, and only blocks that did not shrink are raw.
+//
+static bool checkBlocks(const uint8_t *p_src, uint32_t src_len, const uint8_t *p_comp, uint32_t comp_len, int pattern)
+{
+  uint32_t ip = 0;
+  uint32_t done = 0;
+  uint32_t block = 0;
+  uint32_t header;
+  uint32_t length;
+  uint32_t out_len;
+  bool     is_raw;
+  bool     ret = true;
+  static uint8_t out[LZ4_BLOCK_SIZE];
+
+
+  while (ip < comp_len)
+  {
+    header  = lz4Read32(&p_comp[ip]);
+    length  = header & ~LZ4_BLOCK_RAW;
+    is_raw  = (header & LZ4_BLOCK_RAW) ? true : false;
+    out_len = src_len - done < LZ4_BLOCK_SIZE ? src_len - done : LZ4_BLOCK_SIZE;
+    ip += LZ4_BLOCK_HEADER;
+
+    if (is_raw == true)
+    {
+      ret &= length == out_len;
+      ret &= memcmp(&p_comp[ip], &p_src[done], length) == 0;
+    }
+    else
+    {
+      ret &= length < out_len;
+      ret &= lz4DecompressBlock(&p_comp[ip], length, out, out_len) == (int32_t)out_len;
+      ret &= memcmp(out, &p_src[done], out_len) == 0;
+    }
+
+    if (pattern == PAT_RANDOM || (pattern == PAT_MIXED && (block & 1)))
+    {
+      ret &= is_raw == true;
+    }
+    else if (out_len >= 64)
+    {
+      ret &= is_raw == false;
+    }
+
+    ip   += length;
+    done += out_len;
+    block++;
+  }
+
+  ret &= ip == comp_len;
+  ret &= done == src_len;
+  ret &= block == (src_len + LZ4_BLOCK_SIZE - 1) / LZ4_BLOCK_SIZE;
+
+  return ret;
+}
+
+static void testStream(uint32_t length, int pattern)
+{
+  uint8_t *p_src  = malloc(length + 1);
+  uint8_t *p_comp = malloc(LZ4_STREAM_BOUND(length));
+  uint8_t *p_out  = malloc(length + 1);
+  int32_t comp_len;
+  int32_t out_len;
+  int i;
+
+
+  fill(p_src, length, pattern);
+
+  comp_len = lz4CompressStream(p_src, length, p_comp, LZ4_STREAM_BOUND(length));
+  CHECK(comp_len >= 0);
+  CHECK(comp_len <= (int32_t)LZ4_STREAM_BOUND(length));
+  CHECK(checkBlocks(p_src, length, p_comp, comp_len, pattern) == true);
+
+  out_len = lz4DecompressStream(p_comp, comp_len, p_out, length);
+  CHECK(out_len == (int32_t)length);
+  CHECK(memcmp(p_src, p_out, length) == 0);
+
+  // Too small for the stream, for the output or cut in a block.
+  if (length > 0)
+  {
+    CHECK(lz4CompressStream(p_src, length, p_comp, comp_len - 1) < 0);
+    CHECK(lz4DecompressStream(p_comp, comp_len - 1, p_out, length) != (int32_t)length);
+    CHECK(lz4DecompressStream(p_comp, comp_len, p_out, length - 1) < 0);
+  }
+
+  // A damaged stream is an error or wrong data, never a write past p_out.
+  for (i=0; i<100 && comp_len > LZ4_BLOCK_HEADER; i++)
+  {
+    uint8_t *p_bad = malloc(comp_len);
+
+    memcpy(p_bad, p_comp, comp_len);
+    p_bad[rnd() % comp_len] ^= 1 << (rnd() % 8);
+    out_len = lz4DecompressStream(p_bad, comp_len, p_out, length);
+    CHECK(out_len <= (int32_t)length);
+    free(p_bad);
+  }
+
+  free(p_src);
+  free(p_comp);
+  free(p_out);
+}
+
+static void writeBin(const char *file_name, uint32_t body_len, int pattern, uint8_t *p_body)
+{
+  FILE *fp;
+  flash_tag_t tag;
+  uint8_t pad[FLASH_TAG_SIZE];
+
+
+  memset(pad, 0, sizeof(pad));
+  memset(&tag, 0, sizeof(tag));
+  tag.magic_number = 0xAAAA5555;
+  tag.addr_tag     = 0x24000000;
+  tag.addr_fw      = 0x24000400;
+  memcpy(pad, &tag, sizeof(tag));
+
+  fill(p_body, body_len, pattern);
+
+  fp = fopen(file_name, "wb");
+  fwrite(pad, 1, FLASH_TAG_SIZE, fp);
+  fwrite(p_body, 1, body_len, fp);
+  fclose(fp);
+}
+
+static uint8_t *readFile(const char *file_name, uint32_t *p_length)
+{
+  FILE *fp;
+  uint8_t *p_buf;
+  long length;
+
+
+  fp = fopen(file_name, "rb");
+  fseek(fp, 0, SEEK_END);
+  length = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  p_buf = malloc(length);
+  if (fread(p_buf, 1, length, fp) != (size_t)length)
+  {
+    length = 0;
+  }
+  fclose(fp);
+
+  *p_length = length;
+  return p_buf;
+}
+
+// addTagToBin() into a file, then decoded back like slot.c does.
+//
+static void testImage(uint32_t body_len, int pattern, bool is_lz4, uint32_t expect_type)
+{
+  const char *src_name = "lz4_test_src.bin";
+  const char *dst_name = "lz4_test_dst.bin";
+  uint8_t *p_body = malloc(body_len);
+  uint8_t *p_out  = malloc(body_len + 1);
+  uint8_t *p_file;
+  uint32_t file_len;
+  flash_tag_t *p_tag;
+
+
+  writeBin(src_name, body_len, pattern, p_body);
+  CHECK(addTagToBin((char *)src_name, (char *)dst_name, is_lz4) == true);
+
+  p_file = readFile(dst_name, &file_len);
+  p_tag  = (flash_tag_t *)p_file;
+
+  CHECK(p_tag->magic_number == 0x5555AAAA);
+  CHECK(p_tag->tag_flash_type == expect_type);
+  CHECK(p_tag->tag_flash_length == body_len);
+  CHECK(p_tag->tag_flash_crc == crc16Update(0, p_body, body_len));
+
+  if (expect_type == FLASH_TAG_TYPE_LZ4)
+  {
+    CHECK(file_len == FLASH_TAG_SIZE + p_tag->tag_comp_length);
+    CHECK(p_tag->tag_comp_length < body_len);
+    CHECK(checkBlocks(p_body, body_len, &p_file[FLASH_TAG_SIZE], p_tag->tag_comp_length, pattern) == true);
+    CHECK(lz4DecompressStream(&p_file[FLASH_TAG_SIZE], p_tag->tag_comp_length, p_out, body_len) == (int32_t)body_len);
+    CHECK(memcmp(p_out, p_body, body_len) == 0);
+  }
+  else
+  {
+    CHECK(p_tag->tag_comp_length == 0);
+    CHECK(file_len == FLASH_TAG_SIZE + body_len);
+    CHECK(memcmp(&p_file[FLASH_TAG_SIZE], p_body, body_len) == 0);
+  }
+
+  remove(src_name);
+  remove(dst_name);
+  free(p_file);
+  free(p_body);
+  free(p_out);
+}
+
+
+int main(void)
+{
+  const uint32_t lengths[] =
+  {
+    0, 1, 15, 100,
+    LZ4_BLOCK_SIZE - 1, LZ4_BLOCK_SIZE, LZ4_BLOCK_SIZE + 1,
+    3*LZ4_BLOCK_SIZE + 123, 4*LZ4_BLOCK_SIZE + 40, 2*1024*1024 - 1024,
+  };
+  uint32_t i;
+  int pattern;
+
+
+  for (i=0; i<sizeof(lengths)/sizeof(lengths[0]); i++)
+  {
+    for (pattern=PAT_ZERO; pattern<=PAT_MIXED; pattern++)
+    {
+      testStream(lengths[i], pattern);
+    }
+  }
+  printf("streams   : %s\n", test_fail == 0 ? "ok" : "FAIL");
+
+  // Mixed with a raw tail, then a compressed tail.
+  testImage(3*LZ4_BLOCK_SIZE + 777, PAT_MIXED, true, FLASH_TAG_TYPE_LZ4);
+  testImage(4*LZ4_BLOCK_SIZE + 777, PAT_MIXED, true, FLASH_TAG_TYPE_LZ4);
+  testImage(LZ4_BLOCK_SIZE, PAT_ZERO, true, FLASH_TAG_TYPE_LZ4);
+  testImage(5*LZ4_BLOCK_SIZE + 1, PAT_RANDOM, true, FLASH_TAG_TYPE_RAW);
+  testImage(3*LZ4_BLOCK_SIZE + 777, PAT_MIXED, false, FLASH_TAG_TYPE_RAW);
+  printf("images    : %s\n", test_fail == 0 ? "ok" : "FAIL");
+
+  printf("%s\n", test_fail == 0 ? "lz4_test : OK" : "lz4_test : FAIL");
+
+  return test_fail == 0 ? 0 : 1;
+}